@@ -319,12 +319,41 @@ extern __typeof (gdk_pixbuf_loader_new_with_mime_type) IA__gdk_pixbuf_loader_new
 extern __typeof (gdk_pixbuf_loader_new_with_type) IA__gdk_pixbuf_loader_new_with_type __attribute((visibility("hidden")));
 #define gdk_pixbuf_loader_new_with_type IA__gdk_pixbuf_loader_new_with_type
 
+extern __typeof (gdk_pixbuf_loader_set_prefer_speed) IA__gdk_pixbuf_loader_set_prefer_speed __attribute((visibility("hidden")));
+#define gdk_pixbuf_loader_set_prefer_speed IA__gdk_pixbuf_loader_set_prefer_speed
+
 extern __typeof (gdk_pixbuf_loader_set_size) IA__gdk_pixbuf_loader_set_size __attribute((visibility("hidden")));
 #define gdk_pixbuf_loader_set_size IA__gdk_pixbuf_loader_set_size
 
 extern __typeof (gdk_pixbuf_loader_write) IA__gdk_pixbuf_loader_write __attribute((visibility("hidden")));
 #define gdk_pixbuf_loader_write IA__gdk_pixbuf_loader_write
 
+#endif
+#endif
+#if IN_HEADER(GDK_PIXBUF_IO_H)
+#if IN_FILE(__GDK_PIXBUF_LOADER_C__)
+extern __typeof (gdk_pixbuf_module_get_prefer_speed) IA__gdk_pixbuf_module_get_prefer_speed __attribute((visibility("hidden")));
+#define gdk_pixbuf_module_get_prefer_speed IA__gdk_pixbuf_module_get_prefer_speed
+
+#endif
+#endif
+#if IN_HEADER(GDK_PIXBUF_BATCH_LOADER_H)
+#if IN_FILE(__GDK_PIXBUF_BATCH_LOADER_C__)
+extern __typeof (gdk_pixbuf_batch_loader_add) IA__gdk_pixbuf_batch_loader_add __attribute((visibility("hidden")));
+#define gdk_pixbuf_batch_loader_add IA__gdk_pixbuf_batch_loader_add
+
+extern __typeof (gdk_pixbuf_batch_loader_cancel) IA__gdk_pixbuf_batch_loader_cancel __attribute((visibility("hidden")));
+#define gdk_pixbuf_batch_loader_cancel IA__gdk_pixbuf_batch_loader_cancel
+
+extern __typeof (gdk_pixbuf_batch_loader_get_n_pending) IA__gdk_pixbuf_batch_loader_get_n_pending __attribute((visibility("hidden")));
+#define gdk_pixbuf_batch_loader_get_n_pending IA__gdk_pixbuf_batch_loader_get_n_pending
+
+extern __typeof (gdk_pixbuf_batch_loader_get_type) IA__gdk_pixbuf_batch_loader_get_type __attribute((visibility("hidden"))) G_GNUC_CONST;
+#define gdk_pixbuf_batch_loader_get_type IA__gdk_pixbuf_batch_loader_get_type
+
+extern __typeof (gdk_pixbuf_batch_loader_new) IA__gdk_pixbuf_batch_loader_new __attribute((visibility("hidden")));
+#define gdk_pixbuf_batch_loader_new IA__gdk_pixbuf_batch_loader_new
+
 #endif
 #endif
 #if IN_HEADER(__GDK_PIXBUF_ENUM_TYPES_H__)
@@ -351,6 +380,9 @@ extern __typeof (gdk_pixbuf_error_get_type) IA__gdk_pixbuf_error_get_type __attr
 extern __typeof (gdk_pixbuf_from_pixdata) IA__gdk_pixbuf_from_pixdata __attribute((visibility("hidden")));
 #define gdk_pixbuf_from_pixdata IA__gdk_pixbuf_from_pixdata
 
+extern __typeof (gdk_pixbuf_new_from_mapped_pixdata) IA__gdk_pixbuf_new_from_mapped_pixdata __attribute((visibility("hidden")));
+#define gdk_pixbuf_new_from_mapped_pixdata IA__gdk_pixbuf_new_from_mapped_pixdata
+
 extern __typeof (gdk_pixdata_deserialize) IA__gdk_pixdata_deserialize __attribute((visibility("hidden")));
 #define gdk_pixdata_deserialize IA__gdk_pixdata_deserialize
 
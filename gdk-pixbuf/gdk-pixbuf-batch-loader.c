@@ -0,0 +1,499 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* GdkPixbuf library - Loading many images in parallel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gdk-pixbuf-private.h"
+#include "gdk-pixbuf-batch-loader.h"
+#include "gdk-pixbuf-alias.h"
+
+#define MAX_THREADS 8
+
+/* The part of a batch loader that is shared with the jobs. It
+ * outlives the GdkPixbufBatchLoader if jobs are still running when
+ * that is finalized.
+ */
+typedef struct _BatchState BatchState;
+struct _BatchState
+{
+        gint ref_count;
+
+        /* Whether the jobs run in worker threads or in the main loop */
+        gboolean threaded;
+
+        /* Protects done, todo and idle_id */
+        GMutex *mutex;
+
+        /* Only touched in the main thread; NULL after finalization */
+        GdkPixbufBatchLoader *batch_loader;
+
+        /* Jobs from an older generation have been cancelled */
+        gint generation;
+
+        /* Finished jobs, in the order they finished */
+        GQueue *done;
+
+        /* Jobs to run in the main loop, when there are no threads */
+        GQueue *todo;
+
+        guint idle_id;
+};
+
+typedef struct _BatchJob BatchJob;
+struct _BatchJob
+{
+        BatchState *state;
+        gint generation;
+
+        gchar *filename;
+        gint width;
+        gint height;
+
+        GdkPixbuf *pixbuf;
+        GError *error;
+};
+
+struct _GdkPixbufBatchLoaderClass
+{
+        GObjectClass parent_class;
+};
+
+/* Private part of the GdkPixbufBatchLoader structure */
+struct _GdkPixbufBatchLoader
+{
+        GObject parent_instance;
+
+        BatchState *state;
+
+        gint n_pending;
+
+        GdkPixbufBatchLoaderFunc func;
+        gpointer data;
+        GDestroyNotify destroy;
+};
+
+/* Shared by all batch loaders. Images whose loader is not thread
+ * safe go to serial_pool, so that they don't block the threads
+ * of parallel_pool while waiting for the loader lock.
+ */
+G_LOCK_DEFINE_STATIC (pools);
+static GThreadPool *parallel_pool = NULL;
+static GThreadPool *serial_pool = NULL;
+
+static void gdk_pixbuf_batch_loader_finalize (GObject *object);
+
+G_DEFINE_TYPE (GdkPixbufBatchLoader, gdk_pixbuf_batch_loader, G_TYPE_OBJECT)
+
+static BatchState *
+batch_state_ref (BatchState *state)
+{
+        g_atomic_int_inc (&state->ref_count);
+
+        return state;
+}
+
+static void
+batch_state_unref (gpointer data)
+{
+        BatchState *state = data;
+
+        if (g_atomic_int_dec_and_test (&state->ref_count)) {
+                if (state->mutex)
+                        g_mutex_free (state->mutex);
+                g_queue_free (state->done);
+                g_queue_free (state->todo);
+                g_free (state);
+        }
+}
+
+static void
+batch_job_free (BatchJob *job)
+{
+        if (job->pixbuf)
+                g_object_unref (job->pixbuf);
+        if (job->error)
+                g_error_free (job->error);
+        g_free (job->filename);
+        batch_state_unref (job->state);
+        g_free (job);
+}
+
+static gboolean
+batch_job_is_cancelled (BatchJob *job)
+{
+        return job->generation != g_atomic_int_get (&job->state->generation);
+}
+
+static void
+batch_job_run (BatchJob *job)
+{
+        if (job->width <= 0 && job->height <= 0)
+                job->pixbuf = gdk_pixbuf_new_from_file (job->filename, &job->error);
+        else
+                job->pixbuf = gdk_pixbuf_new_from_file_at_scale (job->filename,
+                                                                 job->width > 0 ? job->width : -1,
+                                                                 job->height > 0 ? job->height : -1,
+                                                                 TRUE,
+                                                                 &job->error);
+}
+
+/* Finds out whether the loader for the file may run in parallel
+ * with others; files which can't be loaded at all are left to
+ * batch_job_run() to report the error.
+ */
+static gboolean
+batch_job_is_threadsafe (BatchJob *job)
+{
+        GdkPixbufModule *image_module;
+        guchar buffer[1024];
+        FILE *f;
+        gint size;
+
+        f = g_fopen (job->filename, "rb");
+        if (!f)
+                return TRUE;
+
+        size = fread (&buffer, 1, sizeof (buffer), f);
+        fclose (f);
+
+        if (size <= 0)
+                return TRUE;
+
+        image_module = _gdk_pixbuf_get_module (buffer, size, job->filename, NULL);
+        if (image_module == NULL)
+                return TRUE;
+
+        return (image_module->info->flags & GDK_PIXBUF_FORMAT_THREADSAFE) != 0;
+}
+
+static gboolean
+deliver_jobs (gpointer data)
+{
+        BatchState *state = data;
+        GQueue *jobs;
+        BatchJob *job;
+        gboolean more;
+
+        g_mutex_lock (state->mutex);
+
+        jobs = state->done;
+        state->done = g_queue_new ();
+
+        if (!g_queue_is_empty (state->todo)) {
+                /* No threads; load one file per main loop iteration */
+                job = g_queue_pop_head (state->todo);
+                batch_job_run (job);
+                g_queue_push_tail (jobs, job);
+        }
+
+        more = !g_queue_is_empty (state->todo);
+        if (!more)
+                state->idle_id = 0;
+
+        g_mutex_unlock (state->mutex);
+
+        while ((job = g_queue_pop_head (jobs)) != NULL) {
+                GdkPixbufBatchLoader *batch_loader = state->batch_loader;
+
+                if (batch_loader != NULL && !batch_job_is_cancelled (job)) {
+                        batch_loader->n_pending--;
+
+                        g_object_ref (batch_loader);
+                        (* batch_loader->func) (batch_loader,
+                                                job->filename,
+                                                job->pixbuf,
+                                                job->error,
+                                                batch_loader->data);
+                        g_object_unref (batch_loader);
+                }
+
+                batch_job_free (job);
+        }
+
+        g_queue_free (jobs);
+
+        return more;
+}
+
+/* Called with state->mutex held */
+static void
+schedule_delivery (BatchState *state)
+{
+        if (state->idle_id == 0)
+                state->idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                                                  deliver_jobs,
+                                                  batch_state_ref (state),
+                                                  batch_state_unref);
+}
+
+static void
+batch_job_finish (BatchJob *job)
+{
+        BatchState *state = job->state;
+
+        g_mutex_lock (state->mutex);
+        g_queue_push_tail (state->done, job);
+        schedule_delivery (state);
+        g_mutex_unlock (state->mutex);
+}
+
+static void
+serial_thread_func (gpointer data,
+                    gpointer user_data)
+{
+        BatchJob *job = data;
+
+        if (batch_job_is_cancelled (job)) {
+                batch_job_free (job);
+                return;
+        }
+
+        batch_job_run (job);
+        batch_job_finish (job);
+}
+
+static void
+parallel_thread_func (gpointer data,
+                      gpointer user_data)
+{
+        BatchJob *job = data;
+
+        if (batch_job_is_cancelled (job)) {
+                batch_job_free (job);
+                return;
+        }
+
+        if (!batch_job_is_threadsafe (job)) {
+                g_thread_pool_push (serial_pool, job, NULL);
+                return;
+        }
+
+        batch_job_run (job);
+        batch_job_finish (job);
+}
+
+static gint
+get_n_threads (void)
+{
+        gint n_threads = 2;
+
+#if defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+        n_threads = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+
+        return CLAMP (n_threads, 1, MAX_THREADS);
+}
+
+static void
+ensure_pools (void)
+{
+        G_LOCK (pools);
+
+        if (parallel_pool == NULL) {
+                parallel_pool = g_thread_pool_new (parallel_thread_func, NULL,
+                                                   get_n_threads (), FALSE, NULL);
+                serial_pool = g_thread_pool_new (serial_thread_func, NULL,
+                                                 1, FALSE, NULL);
+        }
+
+        G_UNLOCK (pools);
+}
+
+static void
+gdk_pixbuf_batch_loader_init (GdkPixbufBatchLoader *batch_loader)
+{
+        BatchState *state;
+
+        state = g_new0 (BatchState, 1);
+        state->ref_count = 1;
+        state->threaded = g_thread_supported ();
+        if (state->threaded)
+                state->mutex = g_mutex_new ();
+        state->batch_loader = batch_loader;
+        state->done = g_queue_new ();
+        state->todo = g_queue_new ();
+
+        batch_loader->state = state;
+}
+
+static void
+gdk_pixbuf_batch_loader_class_init (GdkPixbufBatchLoaderClass *klass)
+{
+        GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+        object_class->finalize = gdk_pixbuf_batch_loader_finalize;
+}
+
+static void
+gdk_pixbuf_batch_loader_finalize (GObject *object)
+{
+        GdkPixbufBatchLoader *batch_loader = GDK_PIXBUF_BATCH_LOADER (object);
+        BatchState *state = batch_loader->state;
+
+        gdk_pixbuf_batch_loader_cancel (batch_loader);
+        state->batch_loader = NULL;
+        batch_state_unref (state);
+
+        if (batch_loader->destroy)
+                (* batch_loader->destroy) (batch_loader->data);
+
+        G_OBJECT_CLASS (gdk_pixbuf_batch_loader_parent_class)->finalize (object);
+}
+
+/**
+ * gdk_pixbuf_batch_loader_new:
+ * @func: function to call for each loaded file
+ * @data: user data to pass to @func
+ * @destroy: function to call on @data when the batch loader is
+ *   finalized, or %NULL
+ *
+ * Creates a new batch loader, which loads image files in the
+ * background. If the thread system is initialized, the files are
+ * loaded by a pool of worker threads, with images whose loader is
+ * not thread safe loaded one after the other; otherwise they are
+ * loaded one per main loop iteration.
+ *
+ * @func is called from the default main loop for every file, in the
+ * order in which the files have been loaded.
+ *
+ * Return value: A new #GdkPixbufBatchLoader.
+ *
+ * Since: 2.12
+ **/
+GdkPixbufBatchLoader *
+gdk_pixbuf_batch_loader_new (GdkPixbufBatchLoaderFunc func,
+                             gpointer                 data,
+                             GDestroyNotify           destroy)
+{
+        GdkPixbufBatchLoader *batch_loader;
+
+        g_return_val_if_fail (func != NULL, NULL);
+
+        batch_loader = g_object_new (GDK_TYPE_PIXBUF_BATCH_LOADER, NULL);
+
+        batch_loader->func = func;
+        batch_loader->data = data;
+        batch_loader->destroy = destroy;
+
+        return batch_loader;
+}
+
+/**
+ * gdk_pixbuf_batch_loader_add:
+ * @batch_loader: a #GdkPixbufBatchLoader
+ * @filename: name of the file to load, in the GLib file name encoding
+ * @width: the width the image should have, or -1
+ * @height: the height the image should have, or -1
+ *
+ * Adds a file to the files loaded by @batch_loader. If @width or
+ * @height are positive, the image is scaled to fit into them at
+ * load time, preserving its aspect ratio, as with
+ * gdk_pixbuf_new_from_file_at_size(); otherwise it is loaded at its
+ * original size.
+ *
+ * Since: 2.12
+ **/
+void
+gdk_pixbuf_batch_loader_add (GdkPixbufBatchLoader *batch_loader,
+                             const gchar          *filename,
+                             gint                  width,
+                             gint                  height)
+{
+        BatchState *state;
+        BatchJob *job;
+
+        g_return_if_fail (GDK_IS_PIXBUF_BATCH_LOADER (batch_loader));
+        g_return_if_fail (filename != NULL);
+
+        state = batch_loader->state;
+
+        job = g_new0 (BatchJob, 1);
+        job->state = batch_state_ref (state);
+        job->generation = g_atomic_int_get (&state->generation);
+        job->filename = g_strdup (filename);
+        job->width = width;
+        job->height = height;
+
+        batch_loader->n_pending++;
+
+        if (state->threaded) {
+                ensure_pools ();
+                g_thread_pool_push (parallel_pool, job, NULL);
+        }
+        else {
+                g_queue_push_tail (state->todo, job);
+                schedule_delivery (state);
+        }
+}
+
+/**
+ * gdk_pixbuf_batch_loader_get_n_pending:
+ * @batch_loader: a #GdkPixbufBatchLoader
+ *
+ * Returns the number of files which have been added to
+ * @batch_loader and not been delivered yet.
+ *
+ * Return value: the number of pending files
+ *
+ * Since: 2.12
+ **/
+gint
+gdk_pixbuf_batch_loader_get_n_pending (GdkPixbufBatchLoader *batch_loader)
+{
+        g_return_val_if_fail (GDK_IS_PIXBUF_BATCH_LOADER (batch_loader), 0);
+
+        return batch_loader->n_pending;
+}
+
+/**
+ * gdk_pixbuf_batch_loader_cancel:
+ * @batch_loader: a #GdkPixbufBatchLoader
+ *
+ * Cancels loading the files that have been added to @batch_loader.
+ * Files which are being loaded when this is called are finished,
+ * but none of the pending files is passed to the callback anymore.
+ * Files added afterwards are loaded as usual.
+ *
+ * Since: 2.12
+ **/
+void
+gdk_pixbuf_batch_loader_cancel (GdkPixbufBatchLoader *batch_loader)
+{
+        BatchState *state;
+        BatchJob *job;
+
+        g_return_if_fail (GDK_IS_PIXBUF_BATCH_LOADER (batch_loader));
+
+        state = batch_loader->state;
+
+        g_atomic_int_inc (&state->generation);
+        batch_loader->n_pending = 0;
+
+        while ((job = g_queue_pop_head (state->todo)) != NULL)
+                batch_job_free (job);
+}
+
+#define __GDK_PIXBUF_BATCH_LOADER_C__
+#include "gdk-pixbuf-aliasdef.c"
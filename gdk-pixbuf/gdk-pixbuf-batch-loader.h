@@ -0,0 +1,74 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* GdkPixbuf library - Loading many images in parallel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GDK_PIXBUF_BATCH_LOADER_H
+#define GDK_PIXBUF_BATCH_LOADER_H
+
+#include <glib-object.h>
+#include <gdk-pixbuf/gdk-pixbuf-core.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GdkPixbufBatchLoader GdkPixbufBatchLoader;
+typedef struct _GdkPixbufBatchLoaderClass GdkPixbufBatchLoaderClass;
+
+#define GDK_TYPE_PIXBUF_BATCH_LOADER              (gdk_pixbuf_batch_loader_get_type ())
+#define GDK_PIXBUF_BATCH_LOADER(object)           (G_TYPE_CHECK_INSTANCE_CAST ((object), GDK_TYPE_PIXBUF_BATCH_LOADER, GdkPixbufBatchLoader))
+#define GDK_IS_PIXBUF_BATCH_LOADER(object)        (G_TYPE_CHECK_INSTANCE_TYPE ((object), GDK_TYPE_PIXBUF_BATCH_LOADER))
+
+#define GDK_PIXBUF_BATCH_LOADER_CLASS(klass)      (G_TYPE_CHECK_CLASS_CAST ((klass), GDK_TYPE_PIXBUF_BATCH_LOADER, GdkPixbufBatchLoaderClass))
+#define GDK_IS_PIXBUF_BATCH_LOADER_CLASS(klass)   (G_TYPE_CHECK_CLASS_TYPE ((klass), GDK_TYPE_PIXBUF_BATCH_LOADER))
+#define GDK_PIXBUF_BATCH_LOADER_GET_CLASS(obj)    (G_TYPE_INSTANCE_GET_CLASS ((obj), GDK_TYPE_PIXBUF_BATCH_LOADER, GdkPixbufBatchLoaderClass))
+
+/**
+ * GdkPixbufBatchLoaderFunc:
+ * @batch_loader: the #GdkPixbufBatchLoader
+ * @filename: the name of the file that was loaded
+ * @pixbuf: the loaded pixbuf, or %NULL if loading failed
+ * @error: the reason why loading failed, or %NULL
+ * @data: user data passed to gdk_pixbuf_batch_loader_new()
+ *
+ * Specifies the type of the function which is called in the main
+ * loop for each file that a #GdkPixbufBatchLoader has finished.
+ * The function must ref @pixbuf if it wants to keep it.
+ *
+ * Since: 2.12
+ */
+typedef void (* GdkPixbufBatchLoaderFunc) (GdkPixbufBatchLoader *batch_loader,
+                                           const gchar          *filename,
+                                           GdkPixbuf            *pixbuf,
+                                           const GError         *error,
+                                           gpointer              data);
+
+GType gdk_pixbuf_batch_loader_get_type (void) G_GNUC_CONST;
+
+GdkPixbufBatchLoader *gdk_pixbuf_batch_loader_new    (GdkPixbufBatchLoaderFunc  func,
+                                                      gpointer                  data,
+                                                      GDestroyNotify            destroy);
+void                  gdk_pixbuf_batch_loader_add    (GdkPixbufBatchLoader     *batch_loader,
+                                                      const gchar              *filename,
+                                                      gint                      width,
+                                                      gint                      height);
+gint                  gdk_pixbuf_batch_loader_get_n_pending (GdkPixbufBatchLoader *batch_loader);
+void                  gdk_pixbuf_batch_loader_cancel (GdkPixbufBatchLoader     *batch_loader);
+
+G_END_DECLS
+
+
+#endif  /* GDK_PIXBUF_BATCH_LOADER_H */
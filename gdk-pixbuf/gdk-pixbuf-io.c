@@ -38,6 +38,8 @@
 #include "gdk-pixbuf-alias.h"
 
 #include <glib/gstdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #ifdef G_OS_WIN32
 #define STRICT
@@ -282,6 +284,180 @@ gdk_pixbuf_get_module_file (void)
   return result;
 }
 
+static const gchar *
+cache_string (const gchar *data,
+	      gsize        size,
+	      guint32      offset)
+{
+	if (offset == 0 || offset >= size)
+		return NULL;
+
+	return data + offset;
+}
+
+static gchar **
+cache_string_array (const gchar *data,
+		    gsize        size,
+		    guint32      offset,
+		    gboolean    *ok)
+{
+	const guint32 *offsets;
+	gchar **strv;
+	gint n, i;
+
+	if (offset == 0 || offset % 4 != 0 || offset >= size) {
+		*ok = FALSE;
+		return NULL;
+	}
+
+	offsets = (const guint32 *) (data + offset);
+	for (n = 0; offset + (n + 1) * 4 <= size && offsets[n] != 0; n++)
+		;
+
+	if (offset + (n + 1) * 4 > size) {
+		*ok = FALSE;
+		return NULL;
+	}
+
+	strv = g_new (gchar *, n + 1);
+	for (i = 0; i < n; i++) {
+		strv[i] = (gchar *) cache_string (data, size, offsets[i]);
+		if (strv[i] == NULL)
+			*ok = FALSE;
+	}
+	strv[n] = NULL;
+
+	return strv;
+}
+
+static void
+free_cached_module (GdkPixbufModule *module)
+{
+	g_free (module->info->mime_types);
+	g_free (module->info->extensions);
+	g_free (module->info->signature);
+	g_free (module->info);
+	g_free (module);
+}
+
+/* Reads the binary loader cache written by gdk-pixbuf-query-loaders
+ * next to the text file, if it is at least as new as that. The cache
+ * stays mapped, and the module information points into the mapping
+ * instead of copying the strings.
+ */
+static gboolean
+gdk_pixbuf_io_init_from_cache (const gchar *filename)
+{
+	gchar *cache_file;
+	struct stat loaders_st, cache_st;
+	GMappedFile *map;
+	const gchar *data;
+	gsize size;
+	const GdkPixbufLoaderCacheHeader *header;
+	const GdkPixbufLoaderCacheModule *records;
+	GSList *modules = NULL;
+	gboolean ok = TRUE;
+	guint i, j;
+#ifdef G_OS_WIN32
+	GSList *l;
+#endif
+
+	cache_file = g_strconcat (filename, ".cache", NULL);
+
+	if (g_stat (filename, &loaders_st) < 0 ||
+	    g_stat (cache_file, &cache_st) < 0 ||
+	    cache_st.st_mtime < loaders_st.st_mtime) {
+		g_free (cache_file);
+		return FALSE;
+	}
+
+	map = g_mapped_file_new (cache_file, FALSE, NULL);
+	g_free (cache_file);
+
+	if (!map)
+		return FALSE;
+
+	data = g_mapped_file_get_contents (map);
+	size = g_mapped_file_get_length (map);
+	header = (const GdkPixbufLoaderCacheHeader *) data;
+	records = (const GdkPixbufLoaderCacheModule *) (header + 1);
+
+	if (size < sizeof (GdkPixbufLoaderCacheHeader) + 1 ||
+	    header->magic != GDK_PIXBUF_LOADER_CACHE_MAGIC ||
+	    header->version != GDK_PIXBUF_LOADER_CACHE_VERSION ||
+	    header->loaders_size != loaders_st.st_size ||
+	    header->n_modules > (size - sizeof (GdkPixbufLoaderCacheHeader)) / sizeof (GdkPixbufLoaderCacheModule) ||
+	    data[size - 1] != '\0') {
+		g_mapped_file_free (map);
+		return FALSE;
+	}
+
+	for (i = 0; ok && i < header->n_modules; i++) {
+		const GdkPixbufLoaderCacheModule *record = &records[i];
+		const GdkPixbufLoaderCachePattern *patterns;
+		GdkPixbufModule *module;
+
+		module = g_new0 (GdkPixbufModule, 1);
+		module->info = g_new0 (GdkPixbufFormat, 1);
+		modules = g_slist_prepend (modules, module);
+
+		module->module_path = (gchar *) cache_string (data, size, record->path);
+		module->info->name = (gchar *) cache_string (data, size, record->name);
+		module->module_name = module->info->name;
+		module->info->domain = (gchar *) cache_string (data, size, record->domain);
+		module->info->description = (gchar *) cache_string (data, size, record->description);
+		module->info->flags = record->flags;
+		module->info->mime_types = cache_string_array (data, size, record->mime_types, &ok);
+		module->info->extensions = cache_string_array (data, size, record->extensions, &ok);
+
+		if (module->module_path == NULL ||
+		    module->info->name == NULL ||
+		    module->info->description == NULL ||
+		    record->signature % 4 != 0 ||
+		    record->signature > size ||
+		    record->n_patterns > (size - record->signature) / sizeof (GdkPixbufLoaderCachePattern)) {
+			ok = FALSE;
+			break;
+		}
+
+		patterns = (const GdkPixbufLoaderCachePattern *) (data + record->signature);
+		module->info->signature = g_new0 (GdkPixbufModulePattern, record->n_patterns + 1);
+		for (j = 0; j < record->n_patterns; j++) {
+			GdkPixbufModulePattern *pattern = &module->info->signature[j];
+
+			pattern->prefix = (gchar *) cache_string (data, size, patterns[j].prefix);
+			pattern->mask = (gchar *) cache_string (data, size, patterns[j].mask);
+			pattern->relevance = patterns[j].relevance;
+
+			if (pattern->prefix == NULL)
+				ok = FALSE;
+		}
+	}
+
+	if (!ok) {
+		g_warning ("Invalid pixbuf loader cache for '%s'", filename);
+		g_slist_foreach (modules, (GFunc) free_cached_module, NULL);
+		g_slist_free (modules);
+		g_mapped_file_free (map);
+
+		return FALSE;
+	}
+
+#ifdef G_OS_WIN32
+	for (l = modules; l; l = l->next) {
+		GdkPixbufModule *module = l->data;
+
+		module->module_path = g_strdup (module->module_path);
+		correct_prefix (&module->module_path);
+	}
+#endif
+
+	/* The mapping is never freed, like the module list itself */
+	file_formats = modules;
+
+	return TRUE;
+}
+
 static void 
 gdk_pixbuf_io_init (void)
 {
@@ -297,6 +473,12 @@ gdk_pixbuf_io_init (void)
 	GdkPixbufModulePattern *pattern;
 	GError *error = NULL;
 
+	if (gdk_pixbuf_io_init_from_cache (filename)) {
+		g_string_free (tmp_buf, TRUE);
+		g_free (filename);
+		return;
+	}
+
 	channel = g_io_channel_new_file (filename, "r",  &error);
 	if (!channel) {
 		g_warning ("Cannot open pixbuf loader module file '%s': %s",
@@ -956,6 +1138,8 @@ size_prepared_cb (GdkPixbufLoader *loader,
 		gint height;
 		gboolean preserve_aspect_ratio;
 	} *info = data;
+	gint orig_width = width;
+	gint orig_height = height;
 
 	g_return_if_fail (width > 0 && height > 0);
 
@@ -985,6 +1169,12 @@ size_prepared_cb (GdkPixbufLoader *loader,
 		if (info->height > 0)
 			height = info->height;
 	}
+
+	/* Reducing the image this much hides the difference, so decode
+	 * it the fast way.
+	 */
+	if (width * 2 <= orig_width && height * 2 <= orig_height)
+		gdk_pixbuf_loader_set_prefer_speed (loader, TRUE);
 	
 	gdk_pixbuf_loader_set_size (loader, width, height);
 }
@@ -1002,6 +1192,9 @@ size_prepared_cb (GdkPixbufLoader *loader,
  * The image will be scaled to fit in the requested size, preserving
  * the image's aspect ratio.
  *
+ * Since 2.12, an image that is reduced to half its size or less is
+ * loaded as if gdk_pixbuf_loader_set_prefer_speed() had been called.
+ *
  * Return value: A newly-created pixbuf with a reference count of 1, or 
  * %NULL if any of several error conditions occurred:  the file could not 
  * be opened, there was no loader for the file's format, there was not 
@@ -1069,6 +1262,9 @@ gdk_pixbuf_new_from_file_at_size (const char *filename,
  * at all in that dimension. Negative values for @width and @height are 
  * allowed since 2.8.
  *
+ * Since 2.12, an image that is reduced to half its size or less is
+ * loaded as if gdk_pixbuf_loader_set_prefer_speed() had been called.
+ *
  * Return value: A newly-created pixbuf with a reference count of 1, or %NULL 
  * if any of several error conditions occurred:  the file could not be opened,
  * there was no loader for the file's format, there was not enough memory to
@@ -141,6 +141,9 @@ gboolean gdk_pixbuf_set_option  (GdkPixbuf   *pixbuf,
                                  const gchar *key,
                                  const gchar *value);
 
+gboolean gdk_pixbuf_module_get_prefer_speed (GdkPixbufModuleSizeFunc size_func,
+                                             gpointer                user_data);
+
 typedef enum /*< skip >*/
 {
   GDK_PIXBUF_FORMAT_WRITABLE = 1 << 0,
@@ -64,6 +64,7 @@ typedef struct
         gint height;
         gboolean size_fixed;
         gboolean needs_scale;
+        gboolean prefer_speed;
 } GdkPixbufLoaderPrivate;
 
 G_DEFINE_TYPE (GdkPixbufLoader, gdk_pixbuf_loader, G_TYPE_OBJECT)
@@ -230,6 +231,37 @@ gdk_pixbuf_loader_set_size (GdkPixbufLoader *loader,
                 }
 }
 
+/**
+ * gdk_pixbuf_loader_set_prefer_speed:
+ * @loader: A pixbuf loader.
+ * @prefer_speed: whether to trade image quality for loading speed
+ *
+ * Asks the loader to favor speed over quality when the image is
+ * scaled while it is loaded, see gdk_pixbuf_loader_set_size().
+ * Loaders which support it decode the image directly at a reduced
+ * size with less precise methods, and the remaining scaling is done
+ * with a box filter instead of a bilinear one. This is useful for
+ * thumbnails and previews.
+ *
+ * Like gdk_pixbuf_loader_set_size(), this has no effect after the
+ * emission of the ::size_prepared signal.
+ *
+ * Since: 2.12
+ */
+void
+gdk_pixbuf_loader_set_prefer_speed (GdkPixbufLoader *loader,
+                                    gboolean         prefer_speed)
+{
+        GdkPixbufLoaderPrivate *priv;
+
+        g_return_if_fail (GDK_IS_PIXBUF_LOADER (loader));
+
+        priv = loader->priv;
+
+        if (!priv->size_fixed)
+                priv->prefer_speed = prefer_speed != FALSE;
+}
+
 static void
 gdk_pixbuf_loader_size_func (gint *width, gint *height, gpointer loader)
 {
@@ -249,6 +281,30 @@ gdk_pixbuf_loader_size_func (gint *width, gint *height, gpointer loader)
         *height = priv->height;
 }
 
+/**
+ * gdk_pixbuf_module_get_prefer_speed:
+ * @size_func: the size function passed to the module's begin_load function
+ * @user_data: the user data passed along with it
+ *
+ * Lets an image loading module find out whether the image is being
+ * loaded by a #GdkPixbufLoader on which gdk_pixbuf_loader_set_prefer_speed()
+ * has been called. Modules can then use faster, less precise methods
+ * when decoding the image at a reduced size.
+ *
+ * Return value: %TRUE if speed should be preferred over quality
+ *
+ * Since: 2.12
+ */
+gboolean
+gdk_pixbuf_module_get_prefer_speed (GdkPixbufModuleSizeFunc size_func,
+                                    gpointer                user_data)
+{
+        if (size_func != gdk_pixbuf_loader_size_func || user_data == NULL)
+                return FALSE;
+
+        return GDK_PIXBUF_LOADER (user_data)->priv->prefer_speed;
+}
+
 static void
 gdk_pixbuf_loader_prepare (GdkPixbuf          *pixbuf,
                            GdkPixbufAnimation *anim,
@@ -744,7 +800,7 @@ gdk_pixbuf_loader_close (GdkPixbufLoader *loader,
                         gdk_pixbuf_scale (tmp, pixbuf, 0, 0, priv->width, priv->height, 0, 0,
                                           (double) priv->width / tmp->width,
                                           (double) priv->height / tmp->height,
-                                          GDK_INTERP_BILINEAR); 
+                                          priv->prefer_speed ? GDK_INTERP_TILES : GDK_INTERP_BILINEAR);
                         g_object_unref (tmp);
                         
                         g_signal_emit (loader, pixbuf_loader_signals[AREA_UPDATED], 0, 
@@ -81,6 +81,8 @@ GdkPixbufLoader *    gdk_pixbuf_loader_new_with_mime_type (const char *mime_type
 void                 gdk_pixbuf_loader_set_size (GdkPixbufLoader  *loader,
                                                  int               width,
 						 int               height);
+void                 gdk_pixbuf_loader_set_prefer_speed (GdkPixbufLoader *loader,
+                                                         gboolean         prefer_speed);
 gboolean             gdk_pixbuf_loader_write         (GdkPixbufLoader *loader,
 						      const guchar    *buf,
 						      gsize            count,
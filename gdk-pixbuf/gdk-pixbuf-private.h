@@ -77,6 +77,41 @@ struct _GdkPixbufClass {
 
 };
 
+/* Binary version of gdk-pixbuf.loaders, written by
+ * gdk-pixbuf-query-loaders --cache and mapped by gdk_pixbuf_io_init().
+ * The header is followed by n_modules module records. All offsets are
+ * relative to the start of the file, and all values are in host byte
+ * order; the file ends with a nul byte, so that any string offset
+ * inside the file points to a terminated string.
+ */
+#define GDK_PIXBUF_LOADER_CACHE_MAGIC   0x47504c43 /* "GPLC" */
+#define GDK_PIXBUF_LOADER_CACHE_VERSION 1
+
+typedef struct {
+	guint32 magic;
+	guint32 version;
+	guint32 loaders_size;   /* size of the text file it was made with */
+	guint32 n_modules;
+} GdkPixbufLoaderCacheHeader;
+
+typedef struct {
+	guint32 path;
+	guint32 name;
+	guint32 domain;
+	guint32 description;
+	guint32 flags;
+	guint32 mime_types;     /* 0-terminated array of string offsets */
+	guint32 extensions;     /* 0-terminated array of string offsets */
+	guint32 signature;      /* n_patterns pattern records */
+	guint32 n_patterns;
+} GdkPixbufLoaderCacheModule;
+
+typedef struct {
+	guint32 prefix;
+	guint32 mask;           /* 0 if the pattern has no mask */
+	gint32 relevance;
+} GdkPixbufLoaderCachePattern;
+
 #ifdef GDK_PIXBUF_ENABLE_BACKEND
 
 gboolean _gdk_pixbuf_lock (GdkPixbufModule *image_module);
@@ -36,6 +36,7 @@
 #include <gdk-pixbuf/gdk-pixbuf-simple-anim.h>
 #include <gdk-pixbuf/gdk-pixbuf-io.h>
 #include <gdk-pixbuf/gdk-pixbuf-loader.h>
+#include <gdk-pixbuf/gdk-pixbuf-batch-loader.h>
 #include <gdk-pixbuf/gdk-pixbuf-enum-types.h>
 
 
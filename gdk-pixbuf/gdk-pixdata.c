@@ -922,5 +922,93 @@ gdk_pixbuf_new_from_inline (gint          data_length,
   return gdk_pixbuf_from_pixdata (&pixdata, copy_pixels, error);
 }
 
+static void
+free_mapped_file (guchar  *pixels,
+		  gpointer data)
+{
+  g_mapped_file_free (data);
+}
+
+/**
+ * gdk_pixbuf_new_from_mapped_pixdata:
+ * @filename: name of a file containing a #GdkPixdata serialized with
+ *   gdk_pixdata_serialize().
+ * @error: return location for an error, or %NULL
+ *
+ * Creates a new pixbuf from a file containing a serialized #GdkPixdata,
+ * without reading the file. For raw pixel data, the file is mapped into
+ * memory and the pixbuf uses the mapped pixels directly; the mapping is
+ * kept until the pixbuf is finalized. Since the pages of the mapping are
+ * shared through the page cache, several processes using the same large
+ * image only need one copy of it in memory, and creating the pixbuf does
+ * not touch the pixel data at all.
+ *
+ * The pixels of the returned pixbuf must not be modified, use
+ * gdk_pixbuf_copy() if you need to change them. Run-length encoded
+ * pixel data is decoded into newly-allocated memory, as in
+ * gdk_pixbuf_from_pixdata().
+ *
+ * Return value: A newly-created #GdkPixbuf, or %NULL if an error
+ *   occurred. Possible errors are in the #GDK_PIXBUF_ERROR and
+ *   #G_FILE_ERROR domains.
+ *
+ * Since: 2.12
+ **/
+GdkPixbuf *
+gdk_pixbuf_new_from_mapped_pixdata (const gchar *filename,
+				    GError     **error)
+{
+  GMappedFile *map;
+  const guint8 *stream;
+  gsize length;
+  GdkPixdata pixdata;
+  GdkPixbuf *pixbuf;
+  guint bpp;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+
+  map = g_mapped_file_new (filename, FALSE, error);
+  if (!map)
+    return NULL;
+
+  stream = (const guint8 *) g_mapped_file_get_contents (map);
+  length = g_mapped_file_get_length (map);
+
+  if (length > G_MAXINT ||
+      !gdk_pixdata_deserialize (&pixdata, length, stream, error))
+    {
+      if (length > G_MAXINT)
+	g_set_error (error, GDK_PIXBUF_ERROR,
+		     GDK_PIXBUF_ERROR_CORRUPT_IMAGE, _("Image header corrupt"));
+      g_mapped_file_free (map);
+      return NULL;
+    }
+
+  if ((pixdata.pixdata_type & GDK_PIXDATA_ENCODING_MASK) == GDK_PIXDATA_ENCODING_RLE)
+    {
+      pixbuf = gdk_pixbuf_from_pixdata (&pixdata, TRUE, error);
+      g_mapped_file_free (map);
+      return pixbuf;
+    }
+
+  /* Make sure the pixels are all inside the mapping before
+   * handing them out
+   */
+  bpp = (pixdata.pixdata_type & GDK_PIXDATA_COLOR_TYPE_MASK) == GDK_PIXDATA_COLOR_TYPE_RGB ? 3 : 4;
+  if (pixdata.rowstride / bpp < pixdata.width ||
+      pixdata.height > (length - GDK_PIXDATA_HEADER_LENGTH) / pixdata.rowstride)
+    {
+      g_set_error (error, GDK_PIXBUF_ERROR,
+		   GDK_PIXBUF_ERROR_CORRUPT_IMAGE, _("Image pixel data corrupt"));
+      g_mapped_file_free (map);
+      return NULL;
+    }
+
+  return gdk_pixbuf_new_from_data (pixdata.pixel_data, GDK_COLORSPACE_RGB,
+				   bpp == 4, 8,
+				   pixdata.width, pixdata.height, pixdata.rowstride,
+				   free_mapped_file, map);
+}
+
 #define __GDK_PIXDATA_C__
 #include "gdk-pixbuf-aliasdef.c"
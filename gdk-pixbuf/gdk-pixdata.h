@@ -116,6 +116,8 @@ gpointer	gdk_pixdata_from_pixbuf	(GdkPixdata		*pixdata,
 GdkPixbuf*	gdk_pixbuf_from_pixdata	(const GdkPixdata	*pixdata,
 					 gboolean		 copy_pixels,
 					 GError		       **error);
+GdkPixbuf*	gdk_pixbuf_new_from_mapped_pixdata (const gchar	*filename,
+						    GError	       **error);
 /** 
  * GdkPixdataDumpType:
  * @GDK_PIXDATA_DUMP_PIXDATA_STREAM: Generate pixbuf data stream (a single 
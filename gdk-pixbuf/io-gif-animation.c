@@ -24,6 +24,7 @@
 
 #include <config.h>
 #include <errno.h>
+#include <stdlib.h>
 #include "gdk-pixbuf-private.h"
 #include "io-gif-animation.h"
 
@@ -105,6 +106,7 @@ gdk_pixbuf_gif_anim_finalize (GObject *object)
         }
         
         g_list_free (gif_anim->frames);
+        g_list_free (gif_anim->composited_frames);
         
         G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -250,6 +252,9 @@ gdk_pixbuf_gif_anim_iter_finalize (GObject *object)
 
         iter_clear (iter);
 
+        if (iter->last_pixbuf)
+                g_object_unref (iter->last_pixbuf);
+
         g_object_unref (iter->gif_anim);
         
         G_OBJECT_CLASS (iter_parent_class)->finalize (object);
@@ -352,6 +357,124 @@ gdk_pixbuf_gif_anim_iter_get_delay_time (GdkPixbufAnimationIter *anim_iter)
                 return -1; /* show last frame forever */
 }
 
+/* Composite images are kept for a bounded number of frames. Frames
+ * at regular intervals are keyframes, whose composite image is kept
+ * preferentially so that any frame can be recomposited from a nearby
+ * one; other frames hand their composite image on to the next frame,
+ * which only needs to update the areas that change.
+ *
+ * The memory used for composite images can be set in kilobytes with
+ * the GDK_PIXBUF_ANIMATION_CACHE_SIZE environment variable.
+ */
+#define COMPOSITE_CACHE_SIZE (16 * 1024 * 1024)
+#define KEYFRAME_MIN_INTERVAL 4
+
+static gsize
+get_composite_cache_size (void)
+{
+        static gsize cache_size = 0;
+
+        if (cache_size == 0) {
+                const gchar *env = g_getenv ("GDK_PIXBUF_ANIMATION_CACHE_SIZE");
+
+                if (env != NULL && atoi (env) > 0)
+                        cache_size = (gsize) atoi (env) * 1024;
+                else
+                        cache_size = COMPOSITE_CACHE_SIZE;
+        }
+
+        return cache_size;
+}
+
+static gboolean
+frame_is_keyframe (GdkPixbufGifAnim *gif_anim,
+                   GdkPixbufFrame   *frame)
+{
+        gsize frame_size;
+        gint n_slots;
+        gint interval;
+
+        if (frame->index == 0)
+                return TRUE;
+
+        frame_size = (gsize) MAX (gif_anim->width, 1) * MAX (gif_anim->height, 1) * 4;
+
+        /* Leave room for the frame being displayed and the one
+         * it is composited from
+         */
+        n_slots = get_composite_cache_size () / frame_size - 2;
+        if (n_slots <= 0)
+                return FALSE;
+
+        interval = MAX (KEYFRAME_MIN_INTERVAL, (gif_anim->n_frames + n_slots - 1) / n_slots);
+
+        return frame->index % interval == 0;
+}
+
+static gsize
+composited_size (GdkPixbuf *composited)
+{
+        return (gsize) gdk_pixbuf_get_rowstride (composited) * gdk_pixbuf_get_height (composited);
+}
+
+static void
+frame_set_composited (GdkPixbufGifAnim *gif_anim,
+                      GdkPixbufFrame   *frame,
+                      GdkPixbuf        *composited)
+{
+        gdk_pixbuf_gif_anim_frame_clear_composited (gif_anim, frame);
+
+        frame->composited = composited;
+        gif_anim->composited_frames = g_list_prepend (gif_anim->composited_frames, frame);
+        gif_anim->composited_size += composited_size (composited);
+}
+
+static GdkPixbuf *
+frame_steal_composited (GdkPixbufGifAnim *gif_anim,
+                        GdkPixbufFrame   *frame)
+{
+        GdkPixbuf *composited = frame->composited;
+
+        gif_anim->composited_frames = g_list_remove (gif_anim->composited_frames, frame);
+        gif_anim->composited_size -= composited_size (composited);
+        frame->composited = NULL;
+
+        return composited;
+}
+
+void
+gdk_pixbuf_gif_anim_frame_clear_composited (GdkPixbufGifAnim *gif_anim,
+                                            GdkPixbufFrame   *frame)
+{
+        if (frame->composited != NULL)
+                g_object_unref (frame_steal_composited (gif_anim, frame));
+}
+
+/* Drops cached composite images, least recently used first, until
+ * they fit into the cache size again; keyframes go last.
+ */
+static void
+trim_composite_cache (GdkPixbufGifAnim *gif_anim,
+                      GdkPixbufFrame   *keep)
+{
+        gsize cache_size = get_composite_cache_size ();
+        gint pass;
+
+        for (pass = 0; pass < 2; pass++) {
+                GList *l = g_list_last (gif_anim->composited_frames);
+
+                while (l != NULL && gif_anim->composited_size > cache_size) {
+                        GList *prev = l->prev;
+                        GdkPixbufFrame *f = l->data;
+
+                        if (f != keep && (pass == 1 || !frame_is_keyframe (gif_anim, f)))
+                                gdk_pixbuf_gif_anim_frame_clear_composited (gif_anim, f);
+
+                        l = prev;
+                }
+        }
+}
+
 void
 gdk_pixbuf_gif_anim_frame_composite (GdkPixbufGifAnim *gif_anim,
                                      GdkPixbufFrame   *frame)
@@ -362,22 +485,16 @@ gdk_pixbuf_gif_anim_frame_composite (GdkPixbufGifAnim *gif_anim,
         link = g_list_find (gif_anim->frames, frame);
         
         if (frame->need_recomposite || frame->composited == NULL) {
-                /* For now, to composite we start with the last
-                 * composited frame and composite everything up to
-                 * here.
+                /* Rewind to the closest frame which still has its
+                 * composite image, usually a keyframe, and composite
+                 * everything from there up to here.
                  */
-
-                /* Rewind to last composited frame. */
                 tmp = link;
                 while (tmp != NULL) {
                         GdkPixbufFrame *f = tmp->data;
                         
-                        if (f->need_recomposite) {
-                                if (f->composited) {
-                                        g_object_unref (f->composited);
-                                        f->composited = NULL;
-                                }
-                        }
+                        if (f->need_recomposite)
+                                gdk_pixbuf_gif_anim_frame_clear_composited (gif_anim, f);
 
                         if (f->composited != NULL)
                                 break;
@@ -391,6 +508,7 @@ gdk_pixbuf_gif_anim_frame_composite (GdkPixbufGifAnim *gif_anim,
                 
                 while (tmp != NULL) {
                         GdkPixbufFrame *f = tmp->data;
+                        GdkPixbuf *composited;
                         gint clipped_width, clipped_height;
 
                         if (f->pixbuf == NULL)
@@ -399,12 +517,8 @@ gdk_pixbuf_gif_anim_frame_composite (GdkPixbufGifAnim *gif_anim,
                         clipped_width = MIN (gif_anim->width - f->x_offset, gdk_pixbuf_get_width (f->pixbuf));
                         clipped_height = MIN (gif_anim->height - f->y_offset, gdk_pixbuf_get_height (f->pixbuf));
   
-                        if (f->need_recomposite) {
-                                if (f->composited) {
-                                        g_object_unref (f->composited);
-                                        f->composited = NULL;
-                                }
-                        }
+                        if (f->need_recomposite)
+                                gdk_pixbuf_gif_anim_frame_clear_composited (gif_anim, f);
                         
                         if (f->composited != NULL)
                                 goto next;
@@ -415,13 +529,15 @@ gdk_pixbuf_gif_anim_frame_composite (GdkPixbufGifAnim *gif_anim,
                                  * image has alpha, and background color otherwise.
                                  * GIF spec doesn't actually say what to do about this.
                                  */
-                                f->composited = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
-                                                                TRUE,
-                                                                8, gif_anim->width, gif_anim->height);
+                                composited = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
+                                                             TRUE,
+                                                             8, gif_anim->width, gif_anim->height);
 
-                                if (f->composited == NULL)
+                                if (composited == NULL)
                                         return;
 
+                                frame_set_composited (gif_anim, f, composited);
+
                                 /* alpha gets dumped if f->composited has no alpha */
                                 
                                 gdk_pixbuf_fill (f->composited,
@@ -455,22 +571,26 @@ gdk_pixbuf_gif_anim_frame_composite (GdkPixbufGifAnim *gif_anim,
                                 prev_clipped_width = MIN (gif_anim->width - prev_frame->x_offset, gdk_pixbuf_get_width (prev_frame->pixbuf));
                                 prev_clipped_height = MIN (gif_anim->height - prev_frame->y_offset, gdk_pixbuf_get_height (prev_frame->pixbuf));
 
-                                /* Init f->composited with what we should have after the previous
-                                 * frame
+                                /* Init f->composited with what we should have after the
+                                 * previous frame. Unless the previous composite image is
+                                 * worth keeping (or somebody else holds on to it), take
+                                 * it over, so that only the areas touched by the previous
+                                 * frame's disposal and by this frame need updating.
                                  */
+                                if (!frame_is_keyframe (gif_anim, prev_frame) &&
+                                    G_OBJECT (prev_frame->composited)->ref_count == 1)
+                                        composited = frame_steal_composited (gif_anim, prev_frame);
+                                else
+                                        composited = gdk_pixbuf_copy (prev_frame->composited);
+
+                                if (composited == NULL)
+                                        return;
+
+                                frame_set_composited (gif_anim, f, composited);
                                 
                                 if (prev_frame->action == GDK_PIXBUF_FRAME_RETAIN) {
-                                        f->composited = gdk_pixbuf_copy (prev_frame->composited);
-
-                                        if (f->composited == NULL)
-                                                return;
-                                        
+                                        /* Nothing to undo */
                                 } else if (prev_frame->action == GDK_PIXBUF_FRAME_DISPOSE) {
-                                        f->composited = gdk_pixbuf_copy (prev_frame->composited);
-
-                                        if (f->composited == NULL)
-                                                return;
-
                                         if (prev_clipped_width > 0 && prev_clipped_height > 0) {
                                                 /* Clear area of previous frame to background */
                                                 GdkPixbuf *area;
@@ -492,11 +612,6 @@ gdk_pixbuf_gif_anim_frame_composite (GdkPixbufGifAnim *gif_anim,
                                                 g_object_unref (area);
                                         }                                        
                                 } else if (prev_frame->action == GDK_PIXBUF_FRAME_REVERT) {
-                                        f->composited = gdk_pixbuf_copy (prev_frame->composited);
-
-                                        if (f->composited == NULL)
-                                                return;
-
                                         if (prev_frame->revert != NULL &&
                                             prev_clipped_width > 0 && prev_clipped_height > 0) {
                                                 /* Copy in the revert frame */
@@ -560,7 +675,13 @@ gdk_pixbuf_gif_anim_frame_composite (GdkPixbufGifAnim *gif_anim,
                         
                         tmp = tmp->next;
                 }
+        } else {
+                /* Mark as most recently used */
+                gif_anim->composited_frames = g_list_remove (gif_anim->composited_frames, frame);
+                gif_anim->composited_frames = g_list_prepend (gif_anim->composited_frames, frame);
         }
+
+        trim_composite_cache (gif_anim, frame);
 }
 
 GdkPixbuf*
@@ -587,6 +708,18 @@ gdk_pixbuf_gif_anim_iter_get_pixbuf (GdkPixbufAnimationIter *anim_iter)
                 return NULL;
 
         gdk_pixbuf_gif_anim_frame_composite (iter->gif_anim, frame);
+
+        /* Holding a reference keeps the composite from being taken
+         * over by the next frame or dropped by trim_composite_cache()
+         * until this iter moves on.
+         */
+        if (frame->composited != iter->last_pixbuf) {
+                if (iter->last_pixbuf)
+                        g_object_unref (iter->last_pixbuf);
+                iter->last_pixbuf = frame->composited;
+                if (iter->last_pixbuf)
+                        g_object_ref (iter->last_pixbuf);
+        }
         
         return frame->composited;
 }
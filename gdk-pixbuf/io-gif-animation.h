@@ -79,6 +79,12 @@ struct _GdkPixbufGifAnim {
         
         int loop;
         gboolean loading;
+
+        /* Frames whose composite image is currently cached, most
+         * recently used first, and the memory used by those images
+         */
+        GList *composited_frames;
+        gsize composited_size;
 };
 
 struct _GdkPixbufGifAnimClass {
@@ -116,6 +122,12 @@ struct _GdkPixbufGifAnimIter {
         GList              *current_frame;
         
         gint                first_loop_slowness;
+
+        /* The composite image last handed out by get_pixbuf; we hold a
+         * reference on it so that the composite cache can neither free
+         * nor reuse it while the caller may still be looking at it.
+         */
+        GdkPixbuf          *last_pixbuf;
 };
 
 struct _GdkPixbufGifAnimIterClass {
@@ -151,13 +163,14 @@ struct _GdkPixbufFrame {
 
         /* TRUE if the background for this frame is transparent */
         gboolean bg_transparent;
-        
-        /* The below reflects the "use hell of a lot of RAM"
-         * philosophy of coding
-         */
+
+        /* Position of this frame in the animation */
+        int index;
         
         /* Cached composite image (the image you actually display
-         * for this frame)
+         * for this frame). Only a bounded number of these is kept,
+         * see gdk_pixbuf_gif_anim_frame_composite(); use
+         * gdk_pixbuf_gif_anim_frame_clear_composited() to drop it.
          */
         GdkPixbuf *composited;
 
@@ -171,5 +184,7 @@ struct _GdkPixbufFrame {
 
 void gdk_pixbuf_gif_anim_frame_composite (GdkPixbufGifAnim *gif_anim,
                                           GdkPixbufFrame   *frame);
+void gdk_pixbuf_gif_anim_frame_clear_composited (GdkPixbufGifAnim *gif_anim,
+                                                 GdkPixbufFrame   *frame);
 
 #endif
@@ -903,6 +903,7 @@ gif_get_lzw (GifContext *context)
 
                 context->frame->bg_transparent = (context->gif89.transparent == context->background_index);
                 
+                context->frame->index = context->animation->n_frames;
                 context->animation->n_frames ++;
                 context->animation->frames = g_list_append (context->animation->frames, context->frame);
 
@@ -949,6 +950,9 @@ gif_get_lzw (GifContext *context)
                                 
                                 g_list_free (context->animation->frames);
                                 context->animation->frames = NULL;
+                                g_list_free (context->animation->composited_frames);
+                                context->animation->composited_frames = NULL;
+                                context->animation->composited_size = 0;
                                 
                                 g_set_error (context->error,
                                              GDK_PIXBUF_ERROR,
@@ -735,6 +735,16 @@ gdk_pixbuf__jpeg_image_load_increment (gpointer data,
 				}
 			}
 			jpeg_calc_output_dimensions (cinfo);
+
+			/* When asked to load quickly, e.g. for a thumbnail,
+			 * use the fast integer DCT and plain chroma upsampling;
+			 * any remaining scaling will be coarse anyway.
+			 */
+			if (gdk_pixbuf_module_get_prefer_speed (context->size_func,
+								context->user_data)) {
+				cinfo->dct_method = JDCT_IFAST;
+				cinfo->do_fancy_upsampling = FALSE;
+			}
 			
 			context->pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, 
 							  cinfo->output_components == 4 ? TRUE : FALSE,
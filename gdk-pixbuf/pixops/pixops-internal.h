@@ -16,6 +16,27 @@
  * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
  * Boston, MA 02111-1307, USA.
  */
+#define SUBSAMPLE_BITS 4
+#define SUBSAMPLE (1 << SUBSAMPLE_BITS)
+#define SUBSAMPLE_MASK ((1 << SUBSAMPLE_BITS)-1)
+#define SCALE_SHIFT 16
+
+/* SSE2 is part of the base instruction set on x86-64; on 32-bit x86
+ * the kernels are compiled for it separately and only used after a
+ * runtime check.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || defined(__x86_64__) || \
+    (defined(__i386__) && defined(__GNUC__) && __GNUC__ >= 5)
+#define USE_SSE2 1
+#endif
+
+/* NEON is part of the base instruction set on AArch64; on 32-bit ARM
+ * it is only used when the compiler is told to target it.
+ */
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__)
+#define USE_NEON 1
+#endif
+
 #ifdef USE_MMX
 guchar *_pixops_scale_line_22_33_mmx (guint32 weights[16][8], guchar *p, guchar *q1, guchar *q2, int x_step, guchar *p_stop, int x_init);
 guchar *_pixops_composite_line_22_4a4_mmx (guint32 weights[16][8], guchar *p, guchar *q1, guchar *q2, int x_step, guchar *p_stop, int x_init);
@@ -23,3 +44,35 @@ guchar *_pixops_composite_line_color_22_4a4_mmx (guint32 weights[16][8], guchar
 int _pixops_have_mmx (void);
 #endif
 
+#ifdef USE_SSE2
+guchar *_pixops_scale_line_sse2 (int *weights, int n_x, int n_y,
+				 guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha,
+				 guchar **src, int src_channels, gboolean src_has_alpha,
+				 int x_init, int x_step, int src_width,
+				 int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_composite_line_sse2 (int *weights, int n_x, int n_y,
+				     guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha,
+				     guchar **src, int src_channels, gboolean src_has_alpha,
+				     int x_init, int x_step, int src_width,
+				     int check_size, guint32 color1, guint32 color2);
+gboolean _pixops_have_sse2 (void);
+#endif
+
+#ifdef USE_NEON
+guchar *_pixops_scale_line_neon (int *weights, int n_x, int n_y,
+				 guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha,
+				 guchar **src, int src_channels, gboolean src_has_alpha,
+				 int x_init, int x_step, int src_width,
+				 int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_composite_line_neon (int *weights, int n_x, int n_y,
+				     guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha,
+				     guchar **src, int src_channels, gboolean src_has_alpha,
+				     int x_init, int x_step, int src_width,
+				     int check_size, guint32 color1, guint32 color2);
+gboolean _pixops_have_neon (void);
+#endif
+
+/* Used by the test and benchmark programs to compare the SIMD line
+ * functions with the C ones.
+ */
+void _pixops_set_use_simd (gboolean use_simd);
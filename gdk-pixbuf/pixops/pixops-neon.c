@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2000 Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+
+#include "pixops.h"
+#include "pixops-internal.h"
+
+#ifdef USE_NEON
+
+#include <arm_neon.h>
+
+/* NEON versions of the generic scale_line() and composite_line().
+ *
+ * They follow the SSE2 versions in pixops-sse2.c: each destination
+ * pixel is computed in a single register, with the channels of a
+ * filter tap widened to 16 bit lanes (r g b a) and multiplied with
+ * its weight by vmlal, which adds the products to four 32 bit sums.
+ * The weights are reduced to 14 bits and the premultiplied color of
+ * pixels with alpha is halved in the same way, so that both give the
+ * same results, within +/-1 of the C versions.
+ */
+
+#define WEIGHT_SHIFT 2			/* 16 bit weights -> 14 bit weights */
+#define MAX_STACK_WEIGHTS 2048
+
+/* Converts the weights for one row of subpixel offsets into 14 bit
+ * weights, n_y * n_x per offset. The sum of the reduced weights is
+ * kept equal to the rounded sum of the original ones.
+ */
+static void
+pack_weights (const int *weights, int n_x, int n_y, gint16 *packed)
+{
+  int offset, i;
+
+  for (offset = 0; offset < SUBSAMPLE; offset++)
+    {
+      const int *pixel_weights = weights + offset * n_x * n_y;
+      gint16 *pixel_packed = packed + offset * n_x * n_y;
+      int total = 0, reduced_total = 0;
+      int max_i = 0;
+
+      for (i = 0; i < n_x * n_y; i++)
+	{
+	  int wt = pixel_weights[i];
+
+	  total += wt;
+	  reduced_total += (wt + (1 << (WEIGHT_SHIFT - 1))) >> WEIGHT_SHIFT;
+	  if (wt > pixel_weights[max_i])
+	    max_i = i;
+	}
+
+      for (i = 0; i < n_x * n_y; i++)
+	{
+	  int w = (pixel_weights[i] + (1 << (WEIGHT_SHIFT - 1))) >> WEIGHT_SHIFT;
+
+	  if (i == max_i)
+	    w += ((total + (1 << (WEIGHT_SHIFT - 1))) >> WEIGHT_SHIFT) - reduced_total;
+
+	  pixel_packed[i] = CLAMP (w, -32768, 32767);
+	}
+    }
+}
+
+/* Returns the channels of the pixel at q as 16 bit lanes; the alpha
+ * lane is 0 for sources without alpha.
+ */
+static inline uint16x4_t
+load_pixel (const guchar *q, int src_channels)
+{
+  guint32 p;
+
+  if (src_channels == 4)
+    memcpy (&p, q, 4);
+  else
+    p = q[0] | (q[1] << 8) | (q[2] << 16);
+
+  return vget_low_u16 (vmovl_u8 (vreinterpret_u8_u32 (vdup_n_u32 (p))));
+}
+
+/* Accumulates, for one destination pixel, sum (w * c) in colors when
+ * the source has no alpha, or sum (w * a * c / 2) in colors and
+ * sum (w * a) in alphas when it has.
+ */
+static inline void
+accumulate_pixel (const gint16 *pixel_packed, int n_x, int n_y,
+		  guchar **src, int src_offset, int src_channels, gboolean src_has_alpha,
+		  int32x4_t *colors, int32x4_t *alphas)
+{
+  int32x4_t c = vdupq_n_s32 (0);
+  int32x4_t a = vdupq_n_s32 (0);
+  uint16x4_t one = vdup_n_u16 (1);
+  int i, j;
+
+  for (i = 0; i < n_y; i++)
+    {
+      const guchar *q = src[i] + src_offset;
+      const gint16 *line_packed = pixel_packed + i * n_x;
+
+      for (j = 0; j < n_x; j++)
+	{
+	  gint16 w = line_packed[j];
+	  uint16x4_t p = load_pixel (q, src_channels);
+
+	  if (src_has_alpha)
+	    {
+	      uint16x4_t pa = vdup_lane_u16 (p, 3);
+	      uint16x4_t pc = vshr_n_u16 (vadd_u16 (vmul_u16 (p, pa), one), 1);
+
+	      c = vmlal_n_s16 (c, vreinterpret_s16_u16 (pc), w);
+	      a = vmlal_n_s16 (a, vreinterpret_s16_u16 (p), w);
+	    }
+	  else
+	    c = vmlal_n_s16 (c, vreinterpret_s16_u16 (p), w);
+
+	  q += src_channels;
+	}
+    }
+
+  *colors = c;
+  *alphas = a;
+}
+
+static inline guchar *
+scale_line_neon_n (int *weights, int n_x, int n_y,
+		   guchar *dest, guchar *dest_end, int dest_channels, int dest_has_alpha,
+		   guchar **src, int src_channels, gboolean src_has_alpha,
+		   int x_init, int x_step)
+{
+  gint16 stack_packed[MAX_STACK_WEIGHTS];
+  gint16 *packed = stack_packed;
+  int n_packed = SUBSAMPLE * n_y * n_x;
+  int x = x_init;
+
+  if (n_packed > MAX_STACK_WEIGHTS)
+    packed = g_new (gint16, n_packed);
+  pack_weights (weights, n_x, n_y, packed);
+
+  while (dest < dest_end)
+    {
+      int x_scaled = x >> SCALE_SHIFT;
+      const gint16 *pixel_packed = packed + ((x >> (SCALE_SHIFT - SUBSAMPLE_BITS)) & SUBSAMPLE_MASK) * n_y * n_x;
+      guint32 sums[4];
+      int32x4_t colors, alphas;
+
+      accumulate_pixel (pixel_packed, n_x, n_y, src, x_scaled * src_channels,
+			src_channels, src_has_alpha, &colors, &alphas);
+
+      if (src_has_alpha)
+	{
+	  guint32 a = vgetq_lane_u32 (vreinterpretq_u32_s32 (alphas), 3);
+
+	  vst1q_u32 (sums, vreinterpretq_u32_s32 (colors));
+
+	  if (a)
+	    {
+	      dest[0] = MIN (2 * sums[0] / a, 0xff);
+	      dest[1] = MIN (2 * sums[1] / a, 0xff);
+	      dest[2] = MIN (2 * sums[2] / a, 0xff);
+	      dest[3] = a >> (SCALE_SHIFT - WEIGHT_SHIFT);
+	    }
+	  else
+	    {
+	      dest[0] = 0;
+	      dest[1] = 0;
+	      dest[2] = 0;
+	      dest[3] = 0;
+	    }
+	}
+      else
+	{
+	  const int round = (1 << (SCALE_SHIFT - WEIGHT_SHIFT)) - 1;
+
+	  vst1q_u32 (sums, vreinterpretq_u32_s32 (colors));
+
+	  dest[0] = (sums[0] + round) >> (SCALE_SHIFT - WEIGHT_SHIFT);
+	  dest[1] = (sums[1] + round) >> (SCALE_SHIFT - WEIGHT_SHIFT);
+	  dest[2] = (sums[2] + round) >> (SCALE_SHIFT - WEIGHT_SHIFT);
+
+	  if (dest_has_alpha)
+	    dest[3] = 0xff;
+	}
+
+      dest += dest_channels;
+      x += x_step;
+    }
+
+  if (packed != stack_packed)
+    g_free (packed);
+
+  return dest;
+}
+
+guchar *
+_pixops_scale_line_neon (int *weights, int n_x, int n_y,
+			 guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha,
+			 guchar **src, int src_channels, gboolean src_has_alpha,
+			 int x_init, int x_step, int src_width,
+			 int check_size, guint32 color1, guint32 color2)
+{
+  /* Separate instances for the common filter sizes, so that the
+   * compiler can unroll the loops over the filter taps.
+   */
+  if (n_x == 2 && n_y == 2)
+    return scale_line_neon_n (weights, 2, 2, dest, dest_end, dest_channels, dest_has_alpha,
+			      src, src_channels, src_has_alpha, x_init, x_step);
+  else if (n_x == 3 && n_y == 3)
+    return scale_line_neon_n (weights, 3, 3, dest, dest_end, dest_channels, dest_has_alpha,
+			      src, src_channels, src_has_alpha, x_init, x_step);
+  else if (n_x == 4 && n_y == 4)
+    return scale_line_neon_n (weights, 4, 4, dest, dest_end, dest_channels, dest_has_alpha,
+			      src, src_channels, src_has_alpha, x_init, x_step);
+  else
+    return scale_line_neon_n (weights, n_x, n_y, dest, dest_end, dest_channels, dest_has_alpha,
+			      src, src_channels, src_has_alpha, x_init, x_step);
+}
+
+static inline guchar *
+composite_line_neon_n (int *weights, int n_x, int n_y,
+		       guchar *dest, guchar *dest_end, int dest_channels, int dest_has_alpha,
+		       guchar **src, int x_init, int x_step)
+{
+  gint16 stack_packed[MAX_STACK_WEIGHTS];
+  gint16 *packed = stack_packed;
+  int n_packed = SUBSAMPLE * n_y * n_x;
+  int x = x_init;
+
+  if (n_packed > MAX_STACK_WEIGHTS)
+    packed = g_new (gint16, n_packed);
+  pack_weights (weights, n_x, n_y, packed);
+
+  while (dest < dest_end)
+    {
+      int x_scaled = x >> SCALE_SHIFT;
+      const gint16 *pixel_packed = packed + ((x >> (SCALE_SHIFT - SUBSAMPLE_BITS)) & SUBSAMPLE_MASK) * n_y * n_x;
+      guint32 sums[4];
+      unsigned int r, g, b, a;
+      int32x4_t colors, alphas;
+
+      accumulate_pixel (pixel_packed, n_x, n_y, src, x_scaled * 4,
+			4, TRUE, &colors, &alphas);
+
+      /* Bring the sums to the scale used by composite_line() */
+      a = vgetq_lane_u32 (vreinterpretq_u32_s32 (alphas), 3) << WEIGHT_SHIFT;
+      vst1q_u32 (sums, vreinterpretq_u32_s32 (colors));
+      r = sums[0] << (WEIGHT_SHIFT + 1);
+      g = sums[1] << (WEIGHT_SHIFT + 1);
+      b = sums[2] << (WEIGHT_SHIFT + 1);
+
+      if (a > 0xff0000)
+	a = 0xff0000;
+
+      if (dest_has_alpha)
+	{
+	  unsigned int w0 = a - (a >> 8);
+	  unsigned int w1 = ((0xff0000 - a) >> 8) * dest[3];
+	  unsigned int w = w0 + w1;
+
+	  if (w != 0)
+	    {
+	      dest[0] = MIN ((r - (r >> 8) + w1 * dest[0]) / w, 0xff);
+	      dest[1] = MIN ((g - (g >> 8) + w1 * dest[1]) / w, 0xff);
+	      dest[2] = MIN ((b - (b >> 8) + w1 * dest[2]) / w, 0xff);
+	      dest[3] = w / 0xff00;
+	    }
+	  else
+	    {
+	      dest[0] = 0;
+	      dest[1] = 0;
+	      dest[2] = 0;
+	      dest[3] = 0;
+	    }
+	}
+      else
+	{
+	  dest[0] = MIN ((r + (0xff0000 - a) * dest[0]) / 0xff0000, 0xff);
+	  dest[1] = MIN ((g + (0xff0000 - a) * dest[1]) / 0xff0000, 0xff);
+	  dest[2] = MIN ((b + (0xff0000 - a) * dest[2]) / 0xff0000, 0xff);
+	}
+
+      dest += dest_channels;
+      x += x_step;
+    }
+
+  if (packed != stack_packed)
+    g_free (packed);
+
+  return dest;
+}
+
+/* Only handles sources with alpha; composite_line() is used otherwise */
+guchar *
+_pixops_composite_line_neon (int *weights, int n_x, int n_y,
+			     guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha,
+			     guchar **src, int src_channels, gboolean src_has_alpha,
+			     int x_init, int x_step, int src_width,
+			     int check_size, guint32 color1, guint32 color2)
+{
+  g_return_val_if_fail (src_channels == 4 && src_has_alpha, dest);
+
+  if (n_x == 2 && n_y == 2)
+    return composite_line_neon_n (weights, 2, 2, dest, dest_end, dest_channels, dest_has_alpha,
+				  src, x_init, x_step);
+  else if (n_x == 3 && n_y == 3)
+    return composite_line_neon_n (weights, 3, 3, dest, dest_end, dest_channels, dest_has_alpha,
+				  src, x_init, x_step);
+  else if (n_x == 4 && n_y == 4)
+    return composite_line_neon_n (weights, 4, 4, dest, dest_end, dest_channels, dest_has_alpha,
+				  src, x_init, x_step);
+  else
+    return composite_line_neon_n (weights, n_x, n_y, dest, dest_end, dest_channels, dest_has_alpha,
+				  src, x_init, x_step);
+}
+
+/* NEON is part of AArch64, and USE_NEON is only defined on 32-bit ARM
+ * when the compiler may use it everywhere anyway.
+ */
+gboolean
+_pixops_have_neon (void)
+{
+  return TRUE;
+}
+
+#endif /* USE_NEON */
@@ -0,0 +1,391 @@
+/*
+ * Copyright (C) 2000 Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+
+#include "pixops.h"
+#include "pixops-internal.h"
+
+#ifdef USE_SSE2
+
+#if defined(__i386__) && !defined(__SSE2__)
+#pragma GCC target ("sse2")
+#include <cpuid.h>
+#endif
+
+#include <emmintrin.h>
+
+/* SSE2 versions of the generic scale_line() and composite_line().
+ *
+ * Each destination pixel is computed in a single register: two
+ * horizontally adjacent filter taps are interleaved as 16 bit values
+ * (r0 r1 g0 g1 b0 b1 a0 a1) and multiplied with a pair of weights by
+ * pmaddwd, which leaves the weighted sums of the two taps in the four
+ * 32 bit lanes.
+ *
+ * pmaddwd works on signed 16 bit values, so the 16.16 fixed point
+ * weights are reduced to 14 bits (summing to 1 << 14 for an opaque
+ * filter), and the premultiplied color a * c of pixels with alpha is
+ * halved to fit into 15 bits. Results are within +/-1 of the C
+ * versions.
+ */
+
+#define WEIGHT_SHIFT 2			/* 16 bit weights -> 14 bit weights */
+#define MAX_STACK_WEIGHTS 1024
+
+/* Converts the weights for one row of subpixel offsets into packed
+ * pairs of 14 bit weights, n_y * n_pairs per offset. The sum of the
+ * reduced weights is kept equal to the rounded sum of the original ones.
+ */
+static void
+pack_weights (const int *weights, int n_x, int n_y, guint32 *packed)
+{
+  int n_pairs = (n_x + 1) / 2;
+  int offset, i, j;
+  int w[2];
+
+  for (offset = 0; offset < SUBSAMPLE; offset++)
+    {
+      const int *pixel_weights = weights + offset * n_x * n_y;
+      guint32 *pixel_packed = packed + offset * n_y * n_pairs;
+      int total = 0, reduced_total = 0;
+      int max_i = 0, max_j = 0;
+
+      for (i = 0; i < n_y; i++)
+	for (j = 0; j < n_x; j++)
+	  {
+	    int wt = pixel_weights[i * n_x + j];
+
+	    total += wt;
+	    reduced_total += (wt + (1 << (WEIGHT_SHIFT - 1))) >> WEIGHT_SHIFT;
+	    if (wt > pixel_weights[max_i * n_x + max_j])
+	      {
+		max_i = i;
+		max_j = j;
+	      }
+	  }
+
+      for (i = 0; i < n_y; i++)
+	for (j = 0; j < n_pairs; j++)
+	  {
+	    int k;
+
+	    for (k = 0; k < 2; k++)
+	      {
+		int x = 2 * j + k;
+
+		if (x < n_x)
+		  {
+		    int wt = pixel_weights[i * n_x + x];
+
+		    w[k] = (wt + (1 << (WEIGHT_SHIFT - 1))) >> WEIGHT_SHIFT;
+		    if (i == max_i && x == max_j)
+		      w[k] += ((total + (1 << (WEIGHT_SHIFT - 1))) >> WEIGHT_SHIFT) - reduced_total;
+		    w[k] = CLAMP (w[k], -32768, 32767);
+		  }
+		else
+		  w[k] = 0;
+	      }
+
+	    pixel_packed[i * n_pairs + j] = (w[0] & 0xffff) | ((guint32)w[1] << 16);
+	  }
+    }
+}
+
+static inline __m128i
+load_pixel (const guchar *q, int src_channels)
+{
+  guint32 p;
+
+  if (src_channels == 4)
+    memcpy (&p, q, 4);
+  else
+    p = q[0] | (q[1] << 8) | (q[2] << 16);
+
+  return _mm_cvtsi32_si128 (p);
+}
+
+/* Returns the interleaved 16 bit channels of the taps at q and q + 1;
+ * the second tap is skipped when it lies past the end of the filter.
+ */
+static inline __m128i
+load_pair (const guchar *q, int src_channels, gboolean second)
+{
+  __m128i zero = _mm_setzero_si128 ();
+  __m128i p0 = load_pixel (q, src_channels);
+  __m128i p1 = second ? load_pixel (q + src_channels, src_channels) : zero;
+
+  return _mm_unpacklo_epi8 (_mm_unpacklo_epi8 (p0, p1), zero);
+}
+
+/* Accumulates, for one destination pixel, sum (w * c) in colors when
+ * the source has no alpha, or sum (w * a * c / 2) in colors and
+ * sum (w * a) in alphas when it has.
+ */
+static inline void
+accumulate_pixel (const guint32 *pixel_packed, int n_x, int n_y,
+		  guchar **src, int src_offset, int src_channels, gboolean src_has_alpha,
+		  __m128i *colors, __m128i *alphas)
+{
+  int n_pairs = (n_x + 1) / 2;
+  __m128i c = _mm_setzero_si128 ();
+  __m128i a = _mm_setzero_si128 ();
+  __m128i one = _mm_set1_epi16 (1);
+  int i, j;
+
+  for (i = 0; i < n_y; i++)
+    {
+      const guchar *q = src[i] + src_offset;
+      const guint32 *line_packed = pixel_packed + i * n_pairs;
+
+      for (j = 0; j < n_pairs; j++)
+	{
+	  __m128i w = _mm_set1_epi32 (line_packed[j]);
+	  __m128i p = load_pair (q, src_channels, 2 * j + 1 < n_x);
+
+	  if (src_has_alpha)
+	    {
+	      __m128i pa = _mm_shuffle_epi32 (p, _MM_SHUFFLE (3, 3, 3, 3));
+	      __m128i pc = _mm_srli_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (p, pa), one), 1);
+
+	      c = _mm_add_epi32 (c, _mm_madd_epi16 (pc, w));
+	      a = _mm_add_epi32 (a, _mm_madd_epi16 (p, w));
+	    }
+	  else
+	    c = _mm_add_epi32 (c, _mm_madd_epi16 (p, w));
+
+	  q += 2 * src_channels;
+	}
+    }
+
+  *colors = c;
+  *alphas = a;
+}
+
+static inline guchar *
+scale_line_sse2_n (int *weights, int n_x, int n_y,
+		   guchar *dest, guchar *dest_end, int dest_channels, int dest_has_alpha,
+		   guchar **src, int src_channels, gboolean src_has_alpha,
+		   int x_init, int x_step)
+{
+  guint32 stack_packed[MAX_STACK_WEIGHTS];
+  guint32 *packed = stack_packed;
+  int n_packed = SUBSAMPLE * n_y * ((n_x + 1) / 2);
+  int x = x_init;
+
+  if (n_packed > MAX_STACK_WEIGHTS)
+    packed = g_new (guint32, n_packed);
+  pack_weights (weights, n_x, n_y, packed);
+
+  while (dest < dest_end)
+    {
+      int x_scaled = x >> SCALE_SHIFT;
+      const guint32 *pixel_packed = packed + ((x >> (SCALE_SHIFT - SUBSAMPLE_BITS)) & SUBSAMPLE_MASK) * n_y * ((n_x + 1) / 2);
+      guint32 sums[4];
+      __m128i colors, alphas;
+
+      accumulate_pixel (pixel_packed, n_x, n_y, src, x_scaled * src_channels,
+			src_channels, src_has_alpha, &colors, &alphas);
+
+      if (src_has_alpha)
+	{
+	  guint32 a;
+
+	  _mm_storeu_si128 ((__m128i *)sums, alphas);
+	  a = sums[3];
+	  _mm_storeu_si128 ((__m128i *)sums, colors);
+
+	  if (a)
+	    {
+	      dest[0] = MIN (2 * sums[0] / a, 0xff);
+	      dest[1] = MIN (2 * sums[1] / a, 0xff);
+	      dest[2] = MIN (2 * sums[2] / a, 0xff);
+	      dest[3] = a >> (SCALE_SHIFT - WEIGHT_SHIFT);
+	    }
+	  else
+	    {
+	      dest[0] = 0;
+	      dest[1] = 0;
+	      dest[2] = 0;
+	      dest[3] = 0;
+	    }
+	}
+      else
+	{
+	  const int round = (1 << (SCALE_SHIFT - WEIGHT_SHIFT)) - 1;
+
+	  _mm_storeu_si128 ((__m128i *)sums, colors);
+
+	  dest[0] = (sums[0] + round) >> (SCALE_SHIFT - WEIGHT_SHIFT);
+	  dest[1] = (sums[1] + round) >> (SCALE_SHIFT - WEIGHT_SHIFT);
+	  dest[2] = (sums[2] + round) >> (SCALE_SHIFT - WEIGHT_SHIFT);
+
+	  if (dest_has_alpha)
+	    dest[3] = 0xff;
+	}
+
+      dest += dest_channels;
+      x += x_step;
+    }
+
+  if (packed != stack_packed)
+    g_free (packed);
+
+  return dest;
+}
+
+guchar *
+_pixops_scale_line_sse2 (int *weights, int n_x, int n_y,
+			 guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha,
+			 guchar **src, int src_channels, gboolean src_has_alpha,
+			 int x_init, int x_step, int src_width,
+			 int check_size, guint32 color1, guint32 color2)
+{
+  /* Separate instances for the common filter sizes, so that the
+   * compiler can unroll the loops over the filter taps.
+   */
+  if (n_x == 2 && n_y == 2)
+    return scale_line_sse2_n (weights, 2, 2, dest, dest_end, dest_channels, dest_has_alpha,
+			      src, src_channels, src_has_alpha, x_init, x_step);
+  else if (n_x == 3 && n_y == 3)
+    return scale_line_sse2_n (weights, 3, 3, dest, dest_end, dest_channels, dest_has_alpha,
+			      src, src_channels, src_has_alpha, x_init, x_step);
+  else if (n_x == 4 && n_y == 4)
+    return scale_line_sse2_n (weights, 4, 4, dest, dest_end, dest_channels, dest_has_alpha,
+			      src, src_channels, src_has_alpha, x_init, x_step);
+  else
+    return scale_line_sse2_n (weights, n_x, n_y, dest, dest_end, dest_channels, dest_has_alpha,
+			      src, src_channels, src_has_alpha, x_init, x_step);
+}
+
+static inline guchar *
+composite_line_sse2_n (int *weights, int n_x, int n_y,
+		       guchar *dest, guchar *dest_end, int dest_channels, int dest_has_alpha,
+		       guchar **src, int x_init, int x_step)
+{
+  guint32 stack_packed[MAX_STACK_WEIGHTS];
+  guint32 *packed = stack_packed;
+  int n_packed = SUBSAMPLE * n_y * ((n_x + 1) / 2);
+  int x = x_init;
+
+  if (n_packed > MAX_STACK_WEIGHTS)
+    packed = g_new (guint32, n_packed);
+  pack_weights (weights, n_x, n_y, packed);
+
+  while (dest < dest_end)
+    {
+      int x_scaled = x >> SCALE_SHIFT;
+      const guint32 *pixel_packed = packed + ((x >> (SCALE_SHIFT - SUBSAMPLE_BITS)) & SUBSAMPLE_MASK) * n_y * ((n_x + 1) / 2);
+      guint32 sums[4];
+      unsigned int r, g, b, a;
+      __m128i colors, alphas;
+
+      accumulate_pixel (pixel_packed, n_x, n_y, src, x_scaled * 4,
+			4, TRUE, &colors, &alphas);
+
+      /* Bring the sums to the scale used by composite_line() */
+      _mm_storeu_si128 ((__m128i *)sums, alphas);
+      a = sums[3] << WEIGHT_SHIFT;
+      _mm_storeu_si128 ((__m128i *)sums, colors);
+      r = sums[0] << (WEIGHT_SHIFT + 1);
+      g = sums[1] << (WEIGHT_SHIFT + 1);
+      b = sums[2] << (WEIGHT_SHIFT + 1);
+
+      if (a > 0xff0000)
+	a = 0xff0000;
+
+      if (dest_has_alpha)
+	{
+	  unsigned int w0 = a - (a >> 8);
+	  unsigned int w1 = ((0xff0000 - a) >> 8) * dest[3];
+	  unsigned int w = w0 + w1;
+
+	  if (w != 0)
+	    {
+	      dest[0] = MIN ((r - (r >> 8) + w1 * dest[0]) / w, 0xff);
+	      dest[1] = MIN ((g - (g >> 8) + w1 * dest[1]) / w, 0xff);
+	      dest[2] = MIN ((b - (b >> 8) + w1 * dest[2]) / w, 0xff);
+	      dest[3] = w / 0xff00;
+	    }
+	  else
+	    {
+	      dest[0] = 0;
+	      dest[1] = 0;
+	      dest[2] = 0;
+	      dest[3] = 0;
+	    }
+	}
+      else
+	{
+	  dest[0] = MIN ((r + (0xff0000 - a) * dest[0]) / 0xff0000, 0xff);
+	  dest[1] = MIN ((g + (0xff0000 - a) * dest[1]) / 0xff0000, 0xff);
+	  dest[2] = MIN ((b + (0xff0000 - a) * dest[2]) / 0xff0000, 0xff);
+	}
+
+      dest += dest_channels;
+      x += x_step;
+    }
+
+  if (packed != stack_packed)
+    g_free (packed);
+
+  return dest;
+}
+
+/* Only handles sources with alpha; composite_line() is used otherwise */
+guchar *
+_pixops_composite_line_sse2 (int *weights, int n_x, int n_y,
+			     guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha,
+			     guchar **src, int src_channels, gboolean src_has_alpha,
+			     int x_init, int x_step, int src_width,
+			     int check_size, guint32 color1, guint32 color2)
+{
+  g_return_val_if_fail (src_channels == 4 && src_has_alpha, dest);
+
+  if (n_x == 2 && n_y == 2)
+    return composite_line_sse2_n (weights, 2, 2, dest, dest_end, dest_channels, dest_has_alpha,
+				  src, x_init, x_step);
+  else if (n_x == 3 && n_y == 3)
+    return composite_line_sse2_n (weights, 3, 3, dest, dest_end, dest_channels, dest_has_alpha,
+				  src, x_init, x_step);
+  else if (n_x == 4 && n_y == 4)
+    return composite_line_sse2_n (weights, 4, 4, dest, dest_end, dest_channels, dest_has_alpha,
+				  src, x_init, x_step);
+  else
+    return composite_line_sse2_n (weights, n_x, n_y, dest, dest_end, dest_channels, dest_has_alpha,
+				  src, x_init, x_step);
+}
+
+gboolean
+_pixops_have_sse2 (void)
+{
+#if defined(__i386__) && !defined(__SSE2__)
+  unsigned int eax, ebx, ecx, edx;
+
+  if (!__get_cpuid (1, &eax, &ebx, &ecx, &edx))
+    return FALSE;
+
+  return (edx & bit_SSE2) != 0;
+#else
+  return TRUE;
+#endif
+}
+
+#endif /* USE_SSE2 */
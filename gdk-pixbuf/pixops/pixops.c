@@ -18,15 +18,17 @@
  */
 #include <config.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 #include <glib.h>
 
 #include "pixops.h"
 #include "pixops-internal.h"
 
-#define SUBSAMPLE_BITS 4
-#define SUBSAMPLE (1 << SUBSAMPLE_BITS)
-#define SUBSAMPLE_MASK ((1 << SUBSAMPLE_BITS)-1)
-#define SCALE_SHIFT 16
+static gboolean pixops_use_simd = TRUE;
 
 typedef struct _PixopsFilter PixopsFilter;
 typedef struct _PixopsFilterDimension PixopsFilterDimension;
@@ -1032,40 +1034,214 @@ make_filter_table (PixopsFilter *filter)
   return weights;
 }
 
+/* Scaling is split in bands of destination rows that are processed
+ * independently, possibly on several threads. A PixopsJob holds
+ * everything the band functions need; it is only read while the bands
+ * are being processed.
+ */
+typedef struct _PixopsJob PixopsJob;
+typedef struct _PixopsBand PixopsBand;
+
+typedef void (*PixopsBandFunc) (PixopsJob *job, int band_y0, int band_y1);
+
+struct _PixopsJob
+{
+  PixopsBandFunc  band_func;
+
+  guchar         *dest_buf;
+  int             render_x0;
+  int             render_y0;
+  int             render_x1;
+  int             render_y1;
+  int             dest_rowstride;
+  int             dest_channels;
+  gboolean        dest_has_alpha;
+  const guchar   *src_buf;
+  int             src_width;
+  int             src_height;
+  int             src_rowstride;
+  int             src_channels;
+  gboolean        src_has_alpha;
+  double          scale_x;
+  double          scale_y;
+  int             check_x;
+  int             check_y;
+  int             check_size;
+  guint32         color1;
+  guint32         color2;
+  PixopsFilter   *filter;
+  PixopsLineFunc  line_func;
+  PixopsPixelFunc pixel_func;
+
+  int            *filter_weights;	/* n_x * n_y weights per subpixel offset pair */
+  int            *x_weights;		/* n_x weights per subpixel offset */
+  int            *y_weights;		/* n_y weights per subpixel offset */
+
+  GMutex         *mutex;
+  GCond          *cond;
+  int             n_pending;
+};
+
+struct _PixopsBand
+{
+  PixopsJob *job;
+  int        y0;
+  int        y1;
+};
+
+/* Don't bother with threads for less than this many filter taps in
+ * total, or for bands of less than PIXOPS_MIN_BAND_ROWS rows.
+ */
+#define PIXOPS_MIN_THREADED_WORK (1 << 20)
+#define PIXOPS_MIN_BAND_ROWS     16
+
+G_LOCK_DEFINE_STATIC (pixops_pool);
+static GThreadPool *pixops_pool = NULL;
+static int pixops_n_threads = 0;
+
+static int
+pixops_get_n_threads (void)
+{
+  if (pixops_n_threads == 0)
+    {
+      const char *env = g_getenv ("PIXOPS_THREADS");
+
+      if (env)
+	pixops_n_threads = atoi (env);
+#ifdef _SC_NPROCESSORS_ONLN
+      else
+	pixops_n_threads = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+
+      pixops_n_threads = CLAMP (pixops_n_threads, 1, 16);
+    }
+
+  return pixops_n_threads;
+}
+
 static void
-pixops_process (guchar         *dest_buf,
-		int             render_x0,
-		int             render_y0,
-		int             render_x1,
-		int             render_y1,
-		int             dest_rowstride,
-		int             dest_channels,
-		gboolean        dest_has_alpha,
-		const guchar   *src_buf,
-		int             src_width,
-		int             src_height,
-		int             src_rowstride,
-		int             src_channels,
-		gboolean        src_has_alpha,
-		double          scale_x,
-		double          scale_y,
-		int             check_x,
-		int             check_y,
-		int             check_size,
-		guint32         color1,
-		guint32         color2,
-		PixopsFilter   *filter,
-		PixopsLineFunc  line_func,
-		PixopsPixelFunc pixel_func)
+pixops_band_worker (gpointer data,
+		    gpointer user_data)
+{
+  PixopsBand *band = data;
+  PixopsJob *job = band->job;
+
+  (*job->band_func) (job, band->y0, band->y1);
+
+  g_mutex_lock (job->mutex);
+  if (--job->n_pending == 0)
+    g_cond_signal (job->cond);
+  g_mutex_unlock (job->mutex);
+}
+
+static GThreadPool *
+pixops_get_pool (void)
+{
+  GThreadPool *pool;
+
+  G_LOCK (pixops_pool);
+
+  if (!pixops_pool && pixops_get_n_threads () > 1)
+    pixops_pool = g_thread_pool_new (pixops_band_worker, NULL,
+				     pixops_get_n_threads () - 1,
+				     FALSE, NULL);
+  pool = pixops_pool;
+
+  G_UNLOCK (pixops_pool);
+
+  return pool;
+}
+
+static void
+pixops_run_job (PixopsJob *job)
+{
+  int n_rows = job->render_y1 - job->render_y0;
+  int n_bands = 1;
+  GThreadPool *pool = NULL;
+  PixopsBand *bands;
+  int i;
+
+  if (g_thread_supported ())
+    {
+      double work = (double) n_rows * (job->render_x1 - job->render_x0) *
+	            job->filter->x.n * job->filter->y.n;
+
+      if (work >= PIXOPS_MIN_THREADED_WORK)
+	{
+	  n_bands = MIN (pixops_get_n_threads (), n_rows / PIXOPS_MIN_BAND_ROWS);
+	  if (n_bands > 1)
+	    pool = pixops_get_pool ();
+	}
+    }
+
+  if (!pool || n_bands <= 1)
+    {
+      (*job->band_func) (job, 0, n_rows);
+      return;
+    }
+
+  bands = g_new (PixopsBand, n_bands);
+  for (i = 0; i < n_bands; i++)
+    {
+      bands[i].job = job;
+      bands[i].y0 = (n_rows * i) / n_bands;
+      bands[i].y1 = (n_rows * (i + 1)) / n_bands;
+    }
+
+  job->mutex = g_mutex_new ();
+  job->cond = g_cond_new ();
+  job->n_pending = n_bands - 1;
+
+  for (i = 1; i < n_bands; i++)
+    g_thread_pool_push (pool, &bands[i], NULL);
+
+  /* The calling thread takes care of the first band */
+  (*job->band_func) (job, bands[0].y0, bands[0].y1);
+
+  g_mutex_lock (job->mutex);
+  while (job->n_pending > 0)
+    g_cond_wait (job->cond, job->mutex);
+  g_mutex_unlock (job->mutex);
+
+  g_mutex_free (job->mutex);
+  g_cond_free (job->cond);
+  g_free (bands);
+}
+
+static void
+pixops_process_band (PixopsJob *job,
+		     int        band_y0,
+		     int        band_y1)
 {
+  PixopsFilter *filter = job->filter;
+  int *filter_weights = job->filter_weights;
+  guchar *dest_buf = job->dest_buf;
+  int render_x0 = job->render_x0;
+  int render_y0 = job->render_y0;
+  int render_x1 = job->render_x1;
+  int dest_rowstride = job->dest_rowstride;
+  int dest_channels = job->dest_channels;
+  gboolean dest_has_alpha = job->dest_has_alpha;
+  const guchar *src_buf = job->src_buf;
+  int src_width = job->src_width;
+  int src_height = job->src_height;
+  int src_rowstride = job->src_rowstride;
+  int src_channels = job->src_channels;
+  gboolean src_has_alpha = job->src_has_alpha;
+  int check_x = job->check_x;
+  int check_y = job->check_y;
+  int check_size = job->check_size;
+  guint32 color1 = job->color1;
+  guint32 color2 = job->color2;
+  PixopsLineFunc line_func = job->line_func;
+  PixopsPixelFunc pixel_func = job->pixel_func;
   int i, j;
   int x, y;			/* X and Y position in source (fixed_point) */
   
   guchar **line_bufs = g_new (guchar *, filter->y.n);
-  int *filter_weights = make_filter_table (filter);
 
-  int x_step = (1 << SCALE_SHIFT) / scale_x; /* X step in source (fixed point) */
-  int y_step = (1 << SCALE_SHIFT) / scale_y; /* Y step in source (fixed point) */
+  int x_step = (1 << SCALE_SHIFT) / job->scale_x; /* X step in source (fixed point) */
+  int y_step = (1 << SCALE_SHIFT) / job->scale_y; /* Y step in source (fixed point) */
 
   int check_shift = check_size ? get_check_shift (check_size) : 0;
 
@@ -1087,8 +1263,8 @@ pixops_process (guchar         *dest_buf,
   int run_end_index = MYDIV (run_end_x + x_step - 1, x_step) - render_x0;
   run_end_index = MIN (run_end_index, render_x1 - render_x0);
 
-  y = render_y0 * y_step + floor (filter->y.offset * (1 << SCALE_SHIFT));
-  for (i = 0; i < (render_y1 - render_y0); i++)
+  y = (render_y0 + band_y0) * y_step + floor (filter->y.offset * (1 << SCALE_SHIFT));
+  for (i = band_y0; i < band_y1; i++)
     {
       int dest_x;
       int y_start = y >> SCALE_SHIFT;
@@ -1172,7 +1348,337 @@ pixops_process (guchar         *dest_buf,
     }
 
   g_free (line_bufs);
-  g_free (filter_weights);
+}
+
+static void
+pixops_process (guchar         *dest_buf,
+		int             render_x0,
+		int             render_y0,
+		int             render_x1,
+		int             render_y1,
+		int             dest_rowstride,
+		int             dest_channels,
+		gboolean        dest_has_alpha,
+		const guchar   *src_buf,
+		int             src_width,
+		int             src_height,
+		int             src_rowstride,
+		int             src_channels,
+		gboolean        src_has_alpha,
+		double          scale_x,
+		double          scale_y,
+		int             check_x,
+		int             check_y,
+		int             check_size,
+		guint32         color1,
+		guint32         color2,
+		PixopsFilter   *filter,
+		PixopsLineFunc  line_func,
+		PixopsPixelFunc pixel_func)
+{
+  PixopsJob job;
+
+  job.band_func = pixops_process_band;
+  job.dest_buf = dest_buf;
+  job.render_x0 = render_x0;
+  job.render_y0 = render_y0;
+  job.render_x1 = render_x1;
+  job.render_y1 = render_y1;
+  job.dest_rowstride = dest_rowstride;
+  job.dest_channels = dest_channels;
+  job.dest_has_alpha = dest_has_alpha;
+  job.src_buf = src_buf;
+  job.src_width = src_width;
+  job.src_height = src_height;
+  job.src_rowstride = src_rowstride;
+  job.src_channels = src_channels;
+  job.src_has_alpha = src_has_alpha;
+  job.scale_x = scale_x;
+  job.scale_y = scale_y;
+  job.check_x = check_x;
+  job.check_y = check_y;
+  job.check_size = check_size;
+  job.color1 = color1;
+  job.color2 = color2;
+  job.filter = filter;
+  job.line_func = line_func;
+  job.pixel_func = pixel_func;
+  job.filter_weights = make_filter_table (filter);
+  job.x_weights = NULL;
+  job.y_weights = NULL;
+
+  pixops_run_job (&job);
+
+  g_free (job.filter_weights);
+}
+
+/* Separable scaling. Each source row is filtered horizontally once
+ * into an intermediate row of destination width, which is kept in a
+ * small ring for as long as destination rows need it; destination
+ * rows are then computed by filtering the intermediate rows
+ * vertically. When source rows are shared by several destination rows,
+ * this does close to n_x + n_y instead of n_x * n_y multiplications per
+ * channel and pixel.
+ *
+ * Intermediate values keep 16 significant bits so that the vertical
+ * sums fit in 32 bits:
+ *
+ *  no alpha: H = (sum (wx * C) + 0x80) >> 8
+ *  alpha:    Ha = sum (wx * A) >> 8, Hc = sum (wx * A * C) >> 16
+ */
+static int *
+make_weights_1d (PixopsFilterDimension *dim,
+		 double                 overall_alpha)
+{
+  int *weights = g_new (int, SUBSAMPLE * dim->n);
+  int offset, i;
+
+  for (offset = 0; offset < SUBSAMPLE; offset++)
+    {
+      int *pixel_weights = weights + offset * dim->n;
+      int total = 0;
+
+      for (i = 0; i < dim->n; i++)
+	{
+	  pixel_weights[i] = dim->weights[offset * dim->n + i] * overall_alpha * 65536 + 0.5;
+	  total += pixel_weights[i];
+	}
+
+      correct_total (pixel_weights, dim->n, 1, total, overall_alpha);
+    }
+
+  return weights;
+}
+
+static void
+filter_row_horizontal (PixopsJob    *job,
+		       const guchar *src,
+		       guint32      *out)
+{
+  int n_x = job->filter->x.n;
+  int src_width = job->src_width;
+  int src_channels = job->src_channels;
+  gboolean src_has_alpha = job->src_has_alpha;
+  int x_step = (1 << SCALE_SHIFT) / job->scale_x;
+  int x = job->render_x0 * x_step + floor (job->filter->x.offset * (1 << SCALE_SHIFT));
+  int dest_width = job->render_x1 - job->render_x0;
+  int i, j;
+
+  for (i = 0; i < dest_width; i++)
+    {
+      int x_start = x >> SCALE_SHIFT;
+      int *pixel_weights = job->x_weights + ((x >> (SCALE_SHIFT - SUBSAMPLE_BITS)) & SUBSAMPLE_MASK) * n_x;
+      guint32 r = 0, g = 0, b = 0, a = 0;
+
+      if (x_start >= 0 && x_start + n_x <= src_width)
+	{
+	  const guchar *q = src + x_start * src_channels;
+
+	  if (src_has_alpha)
+	    for (j = 0; j < n_x; j++)
+	      {
+		guint32 ta = pixel_weights[j] * q[3];
+
+		r += ta * q[0];
+		g += ta * q[1];
+		b += ta * q[2];
+		a += ta;
+		q += src_channels;
+	      }
+	  else
+	    for (j = 0; j < n_x; j++)
+	      {
+		guint32 w = pixel_weights[j];
+
+		r += w * q[0];
+		g += w * q[1];
+		b += w * q[2];
+		q += src_channels;
+	      }
+	}
+      else
+	{
+	  for (j = 0; j < n_x; j++)
+	    {
+	      const guchar *q = src + CLAMP (x_start + j, 0, src_width - 1) * src_channels;
+	      guint32 w = pixel_weights[j];
+
+	      if (src_has_alpha)
+		{
+		  guint32 ta = w * q[3];
+
+		  r += ta * q[0];
+		  g += ta * q[1];
+		  b += ta * q[2];
+		  a += ta;
+		}
+	      else
+		{
+		  r += w * q[0];
+		  g += w * q[1];
+		  b += w * q[2];
+		}
+	    }
+	}
+
+      if (src_has_alpha)
+	{
+	  out[0] = r >> 16;
+	  out[1] = g >> 16;
+	  out[2] = b >> 16;
+	  out[3] = a >> 8;
+	  out += 4;
+	}
+      else
+	{
+	  out[0] = (r + 0x80) >> 8;
+	  out[1] = (g + 0x80) >> 8;
+	  out[2] = (b + 0x80) >> 8;
+	  out += 3;
+	}
+
+      x += x_step;
+    }
+}
+
+static void
+pixops_scale_separable_band (PixopsJob *job,
+			     int        band_y0,
+			     int        band_y1)
+{
+  int n_y = job->filter->y.n;
+  int n_components = job->src_has_alpha ? 4 : 3;
+  int dest_width = job->render_x1 - job->render_x0;
+  int row_length = dest_width * n_components;
+  int y_step = (1 << SCALE_SHIFT) / job->scale_y;
+  int y;
+  guint32 *ring = g_new (guint32, n_y * row_length);
+  guint32 *sums = g_new (guint32, row_length);
+  int *ring_rows = g_new (int, n_y);
+  int i, j, k;
+
+  for (j = 0; j < n_y; j++)
+    ring_rows[j] = -1;
+
+  y = (job->render_y0 + band_y0) * y_step + floor (job->filter->y.offset * (1 << SCALE_SHIFT));
+  for (i = band_y0; i < band_y1; i++)
+    {
+      int y_start = y >> SCALE_SHIFT;
+      int *line_weights = job->y_weights + ((y >> (SCALE_SHIFT - SUBSAMPLE_BITS)) & SUBSAMPLE_MASK) * n_y;
+      guchar *dest = job->dest_buf + job->dest_rowstride * i;
+      guint32 *q;
+
+      memset (sums, 0, row_length * sizeof (guint32));
+
+      for (j = 0; j < n_y; j++)
+	{
+	  int src_y = CLAMP (y_start + j, 0, job->src_height - 1);
+	  int slot = ((y_start + j) % n_y + n_y) % n_y;
+	  guint32 w = line_weights[j];
+	  guint32 *row = ring + slot * row_length;
+
+	  if (ring_rows[slot] != src_y)
+	    {
+	      filter_row_horizontal (job, job->src_buf + src_y * job->src_rowstride, row);
+	      ring_rows[slot] = src_y;
+	    }
+
+	  for (k = 0; k < row_length; k++)
+	    sums[k] += w * row[k];
+	}
+
+      q = sums;
+      for (k = 0; k < dest_width; k++)
+	{
+	  if (job->src_has_alpha)
+	    {
+	      guint32 a16 = q[3] >> 8;
+
+	      if (a16)
+		{
+		  dest[0] = MIN (q[0] / a16, 0xff);
+		  dest[1] = MIN (q[1] / a16, 0xff);
+		  dest[2] = MIN (q[2] / a16, 0xff);
+		  dest[3] = q[3] >> 24;
+		}
+	      else
+		{
+		  dest[0] = 0;
+		  dest[1] = 0;
+		  dest[2] = 0;
+		  dest[3] = 0;
+		}
+	    }
+	  else
+	    {
+	      dest[0] = (q[0] + 0x800000) >> 24;
+	      dest[1] = (q[1] + 0x800000) >> 24;
+	      dest[2] = (q[2] + 0x800000) >> 24;
+
+	      if (job->dest_has_alpha)
+		dest[3] = 0xff;
+	    }
+
+	  q += n_components;
+	  dest += job->dest_channels;
+	}
+
+      y += y_step;
+    }
+
+  g_free (ring_rows);
+  g_free (sums);
+  g_free (ring);
+}
+
+static void
+pixops_scale_separable (guchar        *dest_buf,
+			int            render_x0,
+			int            render_y0,
+			int            render_x1,
+			int            render_y1,
+			int            dest_rowstride,
+			int            dest_channels,
+			gboolean       dest_has_alpha,
+			const guchar  *src_buf,
+			int            src_width,
+			int            src_height,
+			int            src_rowstride,
+			int            src_channels,
+			gboolean       src_has_alpha,
+			double         scale_x,
+			double         scale_y,
+			PixopsFilter  *filter)
+{
+  PixopsJob job;
+
+  memset (&job, 0, sizeof (job));
+
+  job.band_func = pixops_scale_separable_band;
+  job.dest_buf = dest_buf;
+  job.render_x0 = render_x0;
+  job.render_y0 = render_y0;
+  job.render_x1 = render_x1;
+  job.render_y1 = render_y1;
+  job.dest_rowstride = dest_rowstride;
+  job.dest_channels = dest_channels;
+  job.dest_has_alpha = dest_has_alpha;
+  job.src_buf = src_buf;
+  job.src_width = src_width;
+  job.src_height = src_height;
+  job.src_rowstride = src_rowstride;
+  job.src_channels = src_channels;
+  job.src_has_alpha = src_has_alpha;
+  job.scale_x = scale_x;
+  job.scale_y = scale_y;
+  job.filter = filter;
+  job.x_weights = make_weights_1d (&filter->x, 1.0);
+  job.y_weights = make_weights_1d (&filter->y, filter->overall_alpha);
+
+  pixops_run_job (&job);
+
+  g_free (job.x_weights);
+  g_free (job.y_weights);
 }
 
 /* Compute weights for reconstruction by replication followed by
@@ -1413,7 +1919,7 @@ _pixops_composite_color (guchar         *dest_buf,
   PixopsLineFunc line_func;
   
 #ifdef USE_MMX
-  gboolean found_mmx = _pixops_have_mmx ();
+  gboolean found_mmx = pixops_use_simd && _pixops_have_mmx ();
 #endif
 
   g_return_if_fail (!(dest_channels == 3 && dest_has_alpha));
@@ -1510,7 +2016,7 @@ _pixops_composite (guchar        *dest_buf,
   PixopsLineFunc line_func;
   
 #ifdef USE_MMX
-  gboolean found_mmx = _pixops_have_mmx ();
+  gboolean found_mmx = pixops_use_simd && _pixops_have_mmx ();
 #endif
 
   g_return_if_fail (!(dest_channels == 3 && dest_has_alpha));
@@ -1552,6 +2058,17 @@ _pixops_composite (guchar        *dest_buf,
     }
   else
     line_func = composite_line;
+
+#ifdef USE_SSE2
+  if (line_func == composite_line && src_channels == 4 && src_has_alpha &&
+      pixops_use_simd && _pixops_have_sse2 ())
+    line_func = _pixops_composite_line_sse2;
+#endif
+#ifdef USE_NEON
+  if (line_func == composite_line && src_channels == 4 && src_has_alpha &&
+      pixops_use_simd && _pixops_have_neon ())
+    line_func = _pixops_composite_line_neon;
+#endif
   
   pixops_process (dest_buf, render_x0, render_y0, render_x1, render_y1,
 		  dest_rowstride, dest_channels, dest_has_alpha,
@@ -1586,7 +2103,7 @@ _pixops_scale (guchar        *dest_buf,
   PixopsLineFunc line_func;
 
 #ifdef USE_MMX
-  gboolean found_mmx = _pixops_have_mmx ();
+  gboolean found_mmx = pixops_use_simd && _pixops_have_mmx ();
 #endif
 
   g_return_if_fail (!(dest_channels == 3 && dest_has_alpha));
@@ -1608,6 +2125,22 @@ _pixops_scale (guchar        *dest_buf,
   filter.overall_alpha = 1.0;
   make_weights (&filter, interp_type, scale_x, scale_y);
 
+  /* Filters larger than 2x2 are cheaper to apply in two passes, as
+   * long as each horizontally filtered source row ends up being used
+   * for a couple of destination rows.
+   */
+  if (filter.x.n * filter.y.n > 4 && filter.y.n * scale_y >= 2)
+    {
+      pixops_scale_separable (dest_buf, render_x0, render_y0, render_x1, render_y1,
+			      dest_rowstride, dest_channels, dest_has_alpha,
+			      src_buf, src_width, src_height, src_rowstride, src_channels,
+			      src_has_alpha, scale_x, scale_y, &filter);
+
+      g_free (filter.x.weights);
+      g_free (filter.y.weights);
+      return;
+    }
+
   if (filter.x.n == 2 && filter.y.n == 2 && dest_channels == 3 && src_channels == 3)
     {
 #ifdef USE_MMX
@@ -1619,6 +2152,15 @@ _pixops_scale (guchar        *dest_buf,
     }
   else
     line_func = scale_line;
+
+#ifdef USE_SSE2
+  if (line_func == scale_line && pixops_use_simd && _pixops_have_sse2 ())
+    line_func = _pixops_scale_line_sse2;
+#endif
+#ifdef USE_NEON
+  if (line_func == scale_line && pixops_use_simd && _pixops_have_neon ())
+    line_func = _pixops_scale_line_neon;
+#endif
   
   pixops_process (dest_buf, render_x0, render_y0, render_x1, render_y1,
 		  dest_rowstride, dest_channels, dest_has_alpha,
@@ -1630,3 +2172,8 @@ _pixops_scale (guchar        *dest_buf,
   g_free (filter.y.weights);
 }
 
+void
+_pixops_set_use_simd (gboolean use_simd)
+{
+  pixops_use_simd = use_simd;
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2000 Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Compares the SIMD line functions with the C ones, and times both.
+ *
+ * Usage: testsimd [iterations]
+ */
+#include <config.h>
+#include <glib.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "pixops.h"
+#include "pixops-internal.h"
+
+#define ITERS 10
+
+static const char *interp_names[] = { "NEAREST", "TILES", "BILINEAR", "HYPER" };
+
+typedef struct
+{
+  int src_channels;
+  gboolean src_has_alpha;
+  int dest_channels;
+  gboolean dest_has_alpha;
+} Format;
+
+static const Format formats[] = {
+  { 3, FALSE, 3, FALSE },
+  { 3, FALSE, 4, TRUE },
+  { 4, FALSE, 4, FALSE },
+  { 4, TRUE,  4, FALSE },
+  { 4, TRUE,  4, TRUE }
+};
+
+static void
+fill_random (guchar *buf, int len)
+{
+  int i;
+
+  for (i = 0; i < len; i++)
+    buf[i] = g_random_int_range (0, 256);
+}
+
+static void
+run (gboolean composite, const Format *format, guchar *dest_buf, int dest_width, int dest_height, int dest_rowstride,
+     const guchar *src_buf, int src_width, int src_height, int src_rowstride,
+     double scale_x, double scale_y, PixopsInterpType interp_type)
+{
+  if (composite)
+    _pixops_composite (dest_buf, 0, 0, dest_width, dest_height, dest_rowstride,
+		       format->dest_channels, format->dest_has_alpha,
+		       src_buf, src_width, src_height, src_rowstride,
+		       format->src_channels, format->src_has_alpha,
+		       scale_x, scale_y, interp_type, 200);
+  else
+    _pixops_scale (dest_buf, 0, 0, dest_width, dest_height, dest_rowstride,
+		   format->dest_channels, format->dest_has_alpha,
+		   src_buf, src_width, src_height, src_rowstride,
+		   format->src_channels, format->src_has_alpha,
+		   scale_x, scale_y, interp_type);
+}
+
+/* Returns the largest difference of a channel between the C and the
+ * SIMD result for one random scaling operation.
+ */
+static int
+compare (gboolean composite, const Format *format, PixopsInterpType interp_type)
+{
+  int src_width = g_random_int_range (1, 200);
+  int src_height = g_random_int_range (1, 200);
+  double scale_x = g_random_double_range (0.05, 4.0);
+  double scale_y = g_random_double_range (0.05, 4.0);
+  int dest_width = MAX (1, src_width * scale_x);
+  int dest_height = MAX (1, src_height * scale_y);
+  int src_rowstride = (format->src_channels * src_width + 3) & ~3;
+  int dest_rowstride = (format->dest_channels * dest_width + 3) & ~3;
+  guchar *src_buf = g_malloc (src_rowstride * src_height);
+  guchar *c_buf = g_malloc (dest_rowstride * dest_height);
+  guchar *simd_buf = g_malloc (dest_rowstride * dest_height);
+  int max_diff = 0;
+  int x, y;
+
+  fill_random (src_buf, src_rowstride * src_height);
+  fill_random (c_buf, dest_rowstride * dest_height);
+  memcpy (simd_buf, c_buf, dest_rowstride * dest_height);
+
+  _pixops_set_use_simd (FALSE);
+  run (composite, format, c_buf, dest_width, dest_height, dest_rowstride,
+       src_buf, src_width, src_height, src_rowstride, scale_x, scale_y, interp_type);
+  _pixops_set_use_simd (TRUE);
+  run (composite, format, simd_buf, dest_width, dest_height, dest_rowstride,
+       src_buf, src_width, src_height, src_rowstride, scale_x, scale_y, interp_type);
+
+  for (y = 0; y < dest_height; y++)
+    for (x = 0; x < dest_width * format->dest_channels; x++)
+      {
+	int diff = ABS (c_buf[y * dest_rowstride + x] - simd_buf[y * dest_rowstride + x]);
+
+	max_diff = MAX (max_diff, diff);
+      }
+
+  g_free (src_buf);
+  g_free (c_buf);
+  g_free (simd_buf);
+
+  return max_diff;
+}
+
+static double
+time_run (gboolean composite, gboolean use_simd, const Format *format, PixopsInterpType interp_type,
+	  double scale)
+{
+  int src_width = 640, src_height = 480;
+  int dest_width = src_width * scale, dest_height = src_height * scale;
+  int src_rowstride = (format->src_channels * src_width + 3) & ~3;
+  int dest_rowstride = (format->dest_channels * dest_width + 3) & ~3;
+  guchar *src_buf = g_malloc (src_rowstride * src_height);
+  guchar *dest_buf = g_malloc (dest_rowstride * dest_height);
+  GTimer *timer;
+  double secs;
+  int i;
+
+  fill_random (src_buf, src_rowstride * src_height);
+  memset (dest_buf, 0x80, dest_rowstride * dest_height);
+
+  _pixops_set_use_simd (use_simd);
+
+  timer = g_timer_new ();
+  for (i = 0; i < ITERS; i++)
+    run (composite, format, dest_buf, dest_width, dest_height, dest_rowstride,
+	 src_buf, src_width, src_height, src_rowstride, scale, scale, interp_type);
+  secs = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  _pixops_set_use_simd (TRUE);
+
+  g_free (src_buf);
+  g_free (dest_buf);
+
+  return (double)dest_width * dest_height * ITERS / (1000000 * secs);
+}
+
+int
+main (int argc, char **argv)
+{
+  static const double scales[] = { 0.3, 0.7, 1.7 };
+  int iterations = 50;
+  int failures = 0;
+  int composite, f, interp, i;
+
+  if (argc == 2)
+    iterations = atoi (argv[1]);
+
+#ifdef USE_SSE2
+  printf ("SSE2: %s\n", _pixops_have_sse2 () ? "yes" : "no");
+#else
+  printf ("SSE2: not compiled in\n");
+#endif
+#ifdef USE_NEON
+  printf ("NEON: %s\n", _pixops_have_neon () ? "yes" : "no");
+#endif
+#ifdef USE_MMX
+  printf ("MMX: %s\n", _pixops_have_mmx () ? "yes" : "no");
+#endif
+  printf ("\n");
+
+  for (composite = 0; composite < 2; composite++)
+    for (f = 0; f < G_N_ELEMENTS (formats); f++)
+      {
+	const Format *format = &formats[f];
+
+	if (!composite && format->src_has_alpha && !format->dest_has_alpha)
+	  continue;
+
+	for (interp = PIXOPS_INTERP_TILES; interp <= PIXOPS_INTERP_HYPER; interp++)
+	  {
+	    int max_diff = 0;
+
+	    for (i = 0; i < iterations; i++)
+	      max_diff = MAX (max_diff, compare (composite, format, interp));
+
+	    printf ("%-9s %d%s -> %d%s  %-8s  max diff %d%s\n",
+		    composite ? "composite" : "scale",
+		    format->src_channels, format->src_has_alpha ? "a" : " ",
+		    format->dest_channels, format->dest_has_alpha ? "a" : " ",
+		    interp_names[interp], max_diff,
+		    max_diff > 1 ? "  FAILED" : "");
+
+	    if (max_diff > 1)
+	      failures++;
+	  }
+      }
+
+  printf ("\n\t\t\t\t\tscale\tC Mpixels/sec\tSIMD Mpixels/sec\n");
+
+  for (composite = 0; composite < 2; composite++)
+    for (f = 0; f < G_N_ELEMENTS (formats); f++)
+      {
+	const Format *format = &formats[f];
+
+	if (!composite && format->src_has_alpha && !format->dest_has_alpha)
+	  continue;
+
+	for (interp = PIXOPS_INTERP_TILES; interp <= PIXOPS_INTERP_HYPER; interp++)
+	  for (i = 0; i < G_N_ELEMENTS (scales); i++)
+	    printf ("%-9s %d%s -> %d%s  %-8s\t\t%.1f\t%.2f\t\t%.2f\n",
+		    composite ? "composite" : "scale",
+		    format->src_channels, format->src_has_alpha ? "a" : " ",
+		    format->dest_channels, format->dest_has_alpha ? "a" : " ",
+		    interp_names[interp], scales[i],
+		    time_run (composite, FALSE, format, interp, scales[i]),
+		    time_run (composite, TRUE, format, interp, scales[i]));
+      }
+
+  return failures ? 1 : 0;
+}
@@ -33,6 +33,8 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "gdk-pixbuf/gdk-pixbuf.h"
 #include "gdk-pixbuf/gdk-pixbuf-private.h"
@@ -49,6 +51,15 @@
 #include <windows.h>
 #endif
 
+typedef struct {
+	gchar *path;
+	GdkPixbufFormat *info;
+} CachedLoader;
+
+/* Binary cache to write in addition to the text output, if any */
+static const char *cache_file = NULL;
+static GSList *cached_loaders = NULL;
+
 static void
 print_escaped (const char *str)
 {
@@ -146,6 +157,166 @@ write_loader_info (const char *path, GdkPixbufFormat *info)
 	g_printf ("\n");
 }
 
+static void
+cache_loader_info (const char *path, GdkPixbufFormat *info)
+{
+	CachedLoader *loader;
+	GdkPixbufFormat *copy;
+	gint n_patterns;
+	gint i;
+
+	copy = g_new0 (GdkPixbufFormat, 1);
+	copy->name = g_strdup (info->name);
+	copy->domain = g_strdup (info->domain ? info->domain : GETTEXT_PACKAGE);
+	copy->description = g_strdup (info->description);
+	copy->flags = info->flags;
+	copy->mime_types = g_strdupv (info->mime_types);
+	copy->extensions = g_strdupv (info->extensions);
+
+	for (n_patterns = 0; info->signature[n_patterns].prefix; n_patterns++)
+		;
+	copy->signature = g_new0 (GdkPixbufModulePattern, n_patterns + 1);
+	for (i = 0; i < n_patterns; i++) {
+		copy->signature[i].prefix = g_strdup (info->signature[i].prefix);
+		copy->signature[i].mask = g_strdup (info->signature[i].mask);
+		copy->signature[i].relevance = info->signature[i].relevance;
+	}
+
+	loader = g_new0 (CachedLoader, 1);
+	loader->path = g_strdup (path);
+	loader->info = copy;
+
+	cached_loaders = g_slist_prepend (cached_loaders, loader);
+}
+
+static guint32
+cache_add_string (GByteArray *data, const char *str)
+{
+	guint32 offset = data->len;
+
+	g_byte_array_append (data, (const guint8 *) str, strlen (str) + 1);
+
+	return offset;
+}
+
+static void
+cache_align (GByteArray *data)
+{
+	static const guint8 zeros[4] = { 0, 0, 0, 0 };
+
+	if (data->len % 4 != 0)
+		g_byte_array_append (data, zeros, 4 - data->len % 4);
+}
+
+static guint32
+cache_add_string_array (GByteArray *data, char **strv)
+{
+	guint32 *offsets;
+	guint32 offset;
+	gint n;
+
+	n = g_strv_length (strv);
+	offsets = g_new0 (guint32, n + 1);
+	for (n = 0; strv[n]; n++)
+		offsets[n] = cache_add_string (data, strv[n]);
+
+	cache_align (data);
+	offset = data->len;
+	g_byte_array_append (data, (const guint8 *) offsets, (n + 1) * sizeof (guint32));
+	g_free (offsets);
+
+	return offset;
+}
+
+/* Writes the loaders collected by cache_loader_info() in the format
+ * described in gdk-pixbuf-private.h. It must be called after the text
+ * file has been written, since the cache records the size of that and
+ * is only used while it is at least as new.
+ */
+static gboolean
+write_loader_cache (const char *filename)
+{
+	GdkPixbufLoaderCacheHeader header;
+	GdkPixbufLoaderCacheModule *records;
+	GByteArray *data;
+	GSList *l;
+	struct stat st;
+	GError *error = NULL;
+	gint n_modules;
+	gint i, j;
+	gboolean retval;
+
+	fflush (stdout);
+	if (fstat (fileno (stdout), &st) < 0 || !S_ISREG (st.st_mode)) {
+		g_fprintf (stderr, "Not writing loader cache %s: "
+			   "the loader information must be written to a file\n",
+			   filename);
+		return FALSE;
+	}
+
+	cached_loaders = g_slist_reverse (cached_loaders);
+	n_modules = g_slist_length (cached_loaders);
+
+	data = g_byte_array_new ();
+	g_byte_array_set_size (data, sizeof (header) + n_modules * sizeof (GdkPixbufLoaderCacheModule));
+	records = g_new0 (GdkPixbufLoaderCacheModule, n_modules);
+
+	for (l = cached_loaders, i = 0; l; l = l->next, i++) {
+		CachedLoader *loader = l->data;
+		GdkPixbufFormat *info = loader->info;
+		GdkPixbufLoaderCachePattern *patterns;
+		gint n_patterns;
+
+		records[i].path = cache_add_string (data, loader->path);
+		records[i].name = cache_add_string (data, info->name);
+		records[i].domain = cache_add_string (data, info->domain);
+		records[i].description = cache_add_string (data, info->description);
+		records[i].flags = info->flags;
+		records[i].mime_types = cache_add_string_array (data, info->mime_types);
+		records[i].extensions = cache_add_string_array (data, info->extensions);
+
+		for (n_patterns = 0; info->signature[n_patterns].prefix; n_patterns++)
+			;
+		patterns = g_new0 (GdkPixbufLoaderCachePattern, n_patterns + 1);
+		for (j = 0; j < n_patterns; j++) {
+			patterns[j].prefix = cache_add_string (data, info->signature[j].prefix);
+			if (info->signature[j].mask)
+				patterns[j].mask = cache_add_string (data, info->signature[j].mask);
+			patterns[j].relevance = info->signature[j].relevance;
+		}
+
+		cache_align (data);
+		records[i].signature = data->len;
+		records[i].n_patterns = n_patterns;
+		g_byte_array_append (data, (const guint8 *) patterns,
+				     n_patterns * sizeof (GdkPixbufLoaderCachePattern));
+		g_free (patterns);
+	}
+
+	/* Terminate the last string, see gdk-pixbuf-private.h */
+	g_byte_array_append (data, (const guint8 *) "", 1);
+
+	header.magic = GDK_PIXBUF_LOADER_CACHE_MAGIC;
+	header.version = GDK_PIXBUF_LOADER_CACHE_VERSION;
+	header.loaders_size = st.st_size;
+	header.n_modules = n_modules;
+	memcpy (data->data, &header, sizeof (header));
+	memcpy (data->data + sizeof (header), records,
+		n_modules * sizeof (GdkPixbufLoaderCacheModule));
+	g_free (records);
+
+	retval = g_file_set_contents (filename, (const gchar *) data->data, data->len, &error);
+	if (!retval) {
+		g_fprintf (stderr, "Cannot write loader cache %s: %s\n",
+			   filename, error->message);
+		g_error_free (error);
+	}
+
+	g_byte_array_free (data, TRUE);
+
+	return retval;
+}
+
 static void
 query_module (const char *dir, const char *file)
 {
@@ -187,8 +358,11 @@ query_module (const char *dir, const char *file)
 		(*fill_info) (info);
 		(*fill_vtable) (vtable);
 		
-		if (loader_sanity_check (path, info, vtable)) 
+		if (loader_sanity_check (path, info, vtable)) {
 			write_loader_info (path, info);
+			if (cache_file)
+				cache_loader_info (path, info);
+		}
 		
 		g_free (info);
 		g_free (vtable);
@@ -208,6 +382,7 @@ query_module (const char *dir, const char *file)
 int main (int argc, char **argv)
 {
 	gint i;
+	gint first_arg;
 	gchar *prgname;
 
 #ifdef G_OS_WIN32
@@ -255,6 +430,13 @@ int main (int argc, char **argv)
 #define PIXBUF_LIBDIR libdir
 
 #endif
+	for (first_arg = 1; first_arg < argc; first_arg++) {
+		if (g_str_has_prefix (argv[first_arg], "--cache="))
+			cache_file = argv[first_arg] + strlen ("--cache=");
+		else
+			break;
+	}
+
 	prgname = g_get_prgname ();
 	g_printf ("# GdkPixbuf Image Loader Modules file\n"
 		  "# Automatically generated file, do not edit\n"
@@ -263,7 +445,7 @@ int main (int argc, char **argv)
 		  (prgname ? prgname : "gdk-pixbuf-query-loaders"),
 		  GDK_PIXBUF_VERSION);
   
-	if (argc == 1) {
+	if (first_arg == argc) {
 #ifdef USE_GMODULE
 		const char *path;
 		GDir *dir;
@@ -298,7 +480,7 @@ int main (int argc, char **argv)
 	else {
 		char *cwd = g_get_current_dir ();
 
-		for (i = 1; i < argc; i++) {
+		for (i = first_arg; i < argc; i++) {
 			char *infilename = argv[i];
 #ifdef G_OS_WIN32
 			infilename = g_locale_to_utf8 (infilename,
@@ -309,5 +491,8 @@ int main (int argc, char **argv)
 		g_free (cwd);
 	}
 
+	if (cache_file && !write_loader_cache (cache_file))
+		return 1;
+
 	return 0;
 }
@@ -171,6 +171,8 @@ gdk_pre_parse_libgtk_only (void)
   }
 #endif	/* G_ENABLE_DEBUG */
 
+  _gdk_profile_init ();
+
   g_type_init ();
 
   /* Do any setup particular to the windowing system
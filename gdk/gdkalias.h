@@ -1321,6 +1321,12 @@ extern __typeof (gdk_window_get_toplevels) IA__gdk_window_get_toplevels __attrib
 extern __typeof (gdk_window_get_update_area) IA__gdk_window_get_update_area __attribute((visibility("hidden")));
 #define gdk_window_get_update_area IA__gdk_window_get_update_area
 
+extern __typeof (gdk_window_get_update_budget) IA__gdk_window_get_update_budget __attribute((visibility("hidden")));
+#define gdk_window_get_update_budget IA__gdk_window_get_update_budget
+
+extern __typeof (gdk_window_get_update_stats) IA__gdk_window_get_update_stats __attribute((visibility("hidden")));
+#define gdk_window_get_update_stats IA__gdk_window_get_update_stats
+
 extern __typeof (gdk_window_get_user_data) IA__gdk_window_get_user_data __attribute((visibility("hidden")));
 #define gdk_window_get_user_data IA__gdk_window_get_user_data
 
@@ -1360,6 +1366,9 @@ extern __typeof (gdk_window_remove_filter) IA__gdk_window_remove_filter __attrib
 extern __typeof (gdk_window_set_debug_updates) IA__gdk_window_set_debug_updates __attribute((visibility("hidden")));
 #define gdk_window_set_debug_updates IA__gdk_window_set_debug_updates
 
+extern __typeof (gdk_window_set_update_budget) IA__gdk_window_set_update_budget __attribute((visibility("hidden")));
+#define gdk_window_set_update_budget IA__gdk_window_set_update_budget
+
 extern __typeof (gdk_window_set_user_data) IA__gdk_window_set_user_data __attribute((visibility("hidden")));
 #define gdk_window_set_user_data IA__gdk_window_set_user_data
 
@@ -1324,6 +1324,12 @@ extern __typeof (gdk_window_get_toplevels) gdk_window_get_toplevels __attribute(
 #undef gdk_window_get_update_area 
 extern __typeof (gdk_window_get_update_area) gdk_window_get_update_area __attribute((alias("IA__gdk_window_get_update_area"), visibility("default")));
 
+#undef gdk_window_get_update_budget 
+extern __typeof (gdk_window_get_update_budget) gdk_window_get_update_budget __attribute((alias("IA__gdk_window_get_update_budget"), visibility("default")));
+
+#undef gdk_window_get_update_stats 
+extern __typeof (gdk_window_get_update_stats) gdk_window_get_update_stats __attribute((alias("IA__gdk_window_get_update_stats"), visibility("default")));
+
 #undef gdk_window_get_user_data 
 extern __typeof (gdk_window_get_user_data) gdk_window_get_user_data __attribute((alias("IA__gdk_window_get_user_data"), visibility("default")));
 
@@ -1363,6 +1369,9 @@ extern __typeof (gdk_window_remove_filter) gdk_window_remove_filter __attribute(
 #undef gdk_window_set_debug_updates 
 extern __typeof (gdk_window_set_debug_updates) gdk_window_set_debug_updates __attribute((alias("IA__gdk_window_set_debug_updates"), visibility("default")));
 
+#undef gdk_window_set_update_budget 
+extern __typeof (gdk_window_set_update_budget) gdk_window_set_update_budget __attribute((alias("IA__gdk_window_set_update_budget"), visibility("default")));
+
 #undef gdk_window_set_user_data 
 extern __typeof (gdk_window_set_user_data) gdk_window_set_user_data __attribute((alias("IA__gdk_window_set_user_data"), visibility("default")));
 
@@ -26,6 +26,12 @@
 
 #include <config.h>
 #include <math.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <pango/pangocairo.h>
 #include "gdkcairo.h"
 #include "gdkdrawable.h"
@@ -315,6 +321,7 @@ gdk_draw_point (GdkDrawable *drawable,
                 gint         y)
 {
   GdkPoint point;
+  guint64 profile_start;
 
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
   g_return_if_fail (GDK_IS_GC (gc));
@@ -322,7 +329,9 @@ gdk_draw_point (GdkDrawable *drawable,
   point.x = x;
   point.y = y;
   
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_points (drawable, gc, &point, 1);
+  GDK_PROFILE_STOP (GDK_PROFILE_POINTS, profile_start, 1);
 }
 
 /**
@@ -346,6 +355,7 @@ gdk_draw_line (GdkDrawable *drawable,
 	       gint         y2)
 {
   GdkSegment segment;
+  guint64 profile_start;
 
   g_return_if_fail (drawable != NULL);
   g_return_if_fail (gc != NULL);
@@ -356,7 +366,10 @@ gdk_draw_line (GdkDrawable *drawable,
   segment.y1 = y1;
   segment.x2 = x2;
   segment.y2 = y2;
+
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_segments (drawable, gc, &segment, 1);
+  GDK_PROFILE_STOP (GDK_PROFILE_SEGMENTS, profile_start, 0);
 }
 
 /**
@@ -389,6 +402,8 @@ gdk_draw_rectangle (GdkDrawable *drawable,
 		    gint         width,
 		    gint         height)
 {  
+  guint64 profile_start;
+
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
   g_return_if_fail (GDK_IS_GC (gc));
 
@@ -405,8 +420,12 @@ gdk_draw_rectangle (GdkDrawable *drawable,
         height = real_height;
     }
 
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_rectangle (drawable, gc, filled, x, y,
                                                      width, height);
+  GDK_PROFILE_STOP (filled ? GDK_PROFILE_FILL_RECTANGLE : GDK_PROFILE_RECTANGLE,
+                    profile_start,
+                    filled ? (guint64)width * height : 2 * ((guint64)width + height));
 }
 
 /**
@@ -438,6 +457,8 @@ gdk_draw_arc (GdkDrawable *drawable,
 	      gint         angle1,
 	      gint         angle2)
 {  
+  guint64 profile_start;
+
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
   g_return_if_fail (GDK_IS_GC (gc));
 
@@ -454,8 +475,10 @@ gdk_draw_arc (GdkDrawable *drawable,
         height = real_height;
     }
 
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_arc (drawable, gc, filled,
                                                x, y, width, height, angle1, angle2);
+  GDK_PROFILE_STOP (GDK_PROFILE_ARC, profile_start, 0);
 }
 
 /**
@@ -478,11 +501,15 @@ gdk_draw_polygon (GdkDrawable *drawable,
 		  GdkPoint    *points,
 		  gint         npoints)
 {
+  guint64 profile_start;
+
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
   g_return_if_fail (GDK_IS_GC (gc));
 
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_polygon (drawable, gc, filled,
                                                    points, npoints);
+  GDK_PROFILE_STOP (GDK_PROFILE_POLYGON, profile_start, 0);
 }
 
 /* gdk_draw_string
@@ -544,12 +571,16 @@ gdk_draw_text (GdkDrawable *drawable,
 	       const gchar *text,
 	       gint         text_length)
 {
+  guint64 profile_start;
+
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
   g_return_if_fail (font != NULL);
   g_return_if_fail (GDK_IS_GC (gc));
   g_return_if_fail (text != NULL);
 
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_text (drawable, font, gc, x, y, text, text_length);
+  GDK_PROFILE_STOP (GDK_PROFILE_TEXT, profile_start, 0);
 }
 
 /**
@@ -577,12 +608,16 @@ gdk_draw_text_wc (GdkDrawable	 *drawable,
 		  const GdkWChar *text,
 		  gint		  text_length)
 {
+  guint64 profile_start;
+
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
   g_return_if_fail (font != NULL);
   g_return_if_fail (GDK_IS_GC (gc));
   g_return_if_fail (text != NULL);
 
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_text_wc (drawable, font, gc, x, y, text, text_length);
+  GDK_PROFILE_STOP (GDK_PROFILE_TEXT, profile_start, 0);
 }
 
 /**
@@ -627,6 +662,7 @@ gdk_draw_drawable (GdkDrawable *drawable,
   GdkDrawable *composite;
   gint composite_x_offset = 0;
   gint composite_y_offset = 0;
+  guint64 profile_start;
 
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
   g_return_if_fail (src != NULL);
@@ -654,11 +690,14 @@ gdk_draw_drawable (GdkDrawable *drawable,
                                                           &composite_y_offset);
 
   
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_drawable (drawable, gc, composite,
                                                     xsrc - composite_x_offset,
                                                     ysrc - composite_y_offset,
                                                     xdest, ydest,
                                                     width, height);
+  GDK_PROFILE_STOP (_gdk_profile_drawable_counter (gdk_drawable_get_depth (composite)),
+                    profile_start, (guint64)width * height);
   
   g_object_unref (composite);
 }
@@ -691,6 +730,8 @@ gdk_draw_image (GdkDrawable *drawable,
 		gint         width,
 		gint         height)
 {
+  guint64 profile_start;
+
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
   g_return_if_fail (image != NULL);
   g_return_if_fail (GDK_IS_GC (gc));
@@ -700,8 +741,10 @@ gdk_draw_image (GdkDrawable *drawable,
   if (height == -1)
     height = image->height;
 
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_image (drawable, gc, image, xsrc, ysrc,
                                                  xdest, ydest, width, height);
+  GDK_PROFILE_STOP (GDK_PROFILE_DRAW_IMAGE, profile_start, (guint64)width * height);
 }
 
 /**
@@ -747,6 +790,8 @@ gdk_draw_pixbuf (GdkDrawable     *drawable,
 		  gint             x_dither,
 		  gint             y_dither)
 {
+  guint64 profile_start;
+
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
   g_return_if_fail (gc == NULL || GDK_IS_GC (gc));
   g_return_if_fail (GDK_IS_PIXBUF (pixbuf));
@@ -759,10 +804,12 @@ gdk_draw_pixbuf (GdkDrawable     *drawable,
   if (height == -1)
     height = gdk_pixbuf_get_height (pixbuf);
 
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_pixbuf (drawable, gc, pixbuf,
 						  src_x, src_y, dest_x, dest_y,
                                                   width, height,
 						  dither, x_dither, y_dither);
+  GDK_PROFILE_STOP (GDK_PROFILE_DRAW_PIXBUF, profile_start, (guint64)width * height);
 }
 
 /**
@@ -781,6 +828,8 @@ gdk_draw_points (GdkDrawable *drawable,
 		 GdkPoint    *points,
 		 gint         npoints)
 {
+  guint64 profile_start;
+
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
   g_return_if_fail ((points != NULL) && (npoints > 0));
   g_return_if_fail (GDK_IS_GC (gc));
@@ -789,7 +838,9 @@ gdk_draw_points (GdkDrawable *drawable,
   if (npoints == 0)
     return;
 
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_points (drawable, gc, points, npoints);
+  GDK_PROFILE_STOP (GDK_PROFILE_POINTS, profile_start, npoints);
 }
 
 /**
@@ -809,6 +860,8 @@ gdk_draw_segments (GdkDrawable *drawable,
 		   GdkSegment  *segs,
 		   gint         nsegs)
 {
+  guint64 profile_start;
+
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
 
   if (nsegs == 0)
@@ -818,7 +871,9 @@ gdk_draw_segments (GdkDrawable *drawable,
   g_return_if_fail (GDK_IS_GC (gc));
   g_return_if_fail (nsegs >= 0);
 
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_segments (drawable, gc, segs, nsegs);
+  GDK_PROFILE_STOP (GDK_PROFILE_SEGMENTS, profile_start, 0);
 }
 
 /**
@@ -839,6 +894,8 @@ gdk_draw_lines (GdkDrawable *drawable,
 		GdkPoint    *points,
 		gint         npoints)
 {
+  guint64 profile_start;
+
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
   g_return_if_fail (points != NULL);
   g_return_if_fail (GDK_IS_GC (gc));
@@ -847,7 +904,9 @@ gdk_draw_lines (GdkDrawable *drawable,
   if (npoints == 0)
     return;
 
+  profile_start = GDK_PROFILE_START ();
   GDK_DRAWABLE_GET_CLASS (drawable)->draw_lines (drawable, gc, points, npoints);
+  GDK_PROFILE_STOP (GDK_PROFILE_LINES, profile_start, 0);
 }
 
 static void
@@ -860,6 +919,9 @@ real_draw_glyphs (GdkDrawable      *drawable,
 		  PangoGlyphString *glyphs)
 {
   cairo_t *cr;
+  guint64 profile_start;
+
+  profile_start = GDK_PROFILE_START ();
 
   cr = gdk_cairo_create (drawable);
   _gdk_gc_update_context (gc, cr, NULL, NULL, TRUE);
@@ -882,6 +944,8 @@ real_draw_glyphs (GdkDrawable      *drawable,
   pango_cairo_show_glyph_string (cr, font, glyphs);
 
   cairo_destroy (cr);
+
+  GDK_PROFILE_STOP (GDK_PROFILE_GLYPHS, profile_start, 0);
 }
 
 /**
@@ -980,11 +1044,14 @@ gdk_draw_trapezoids (GdkDrawable    *drawable,
 {
   cairo_t *cr;
   int i;
+  guint64 profile_start;
 
   g_return_if_fail (GDK_IS_DRAWABLE (drawable));
   g_return_if_fail (GDK_IS_GC (gc));
   g_return_if_fail (n_trapezoids == 0 || trapezoids != NULL);
 
+  profile_start = GDK_PROFILE_START ();
+
   cr = gdk_cairo_create (drawable);
   _gdk_gc_update_context (gc, cr, NULL, NULL, TRUE);
   
@@ -1000,6 +1067,8 @@ gdk_draw_trapezoids (GdkDrawable    *drawable,
   cairo_fill (cr);
 
   cairo_destroy (cr);
+
+  GDK_PROFILE_STOP (GDK_PROFILE_TRAPEZOIDS, profile_start, 0);
 }
 
 /**
@@ -1715,5 +1784,291 @@ _gdk_drawable_get_scratch_gc (GdkDrawable *drawable,
     }
 }
 
+/* Drawing profile
+ *
+ * With GDK_DRAW_PROFILE set in the environment, the number of calls,
+ * the number of pixels touched and the time spent are accumulated for
+ * each kind of drawing primitive. The value of the variable selects
+ * the output format and optionally a file, as in "csv", "json" or
+ * "json:/tmp/draw.json"; the counters are written to stderr or to
+ * the file when the process exits.
+ *
+ * If GDK_DRAW_PROFILE_SIGNAL names a signal as well, e.g. "USR1",
+ * they are also written about a second after the process receives
+ * it.  Writing from the handler itself is not safe, so it only sets
+ * a flag that a timeout in the main loop checks.
+ */
+typedef struct _GdkProfileEntry GdkProfileEntry;
+
+struct _GdkProfileEntry
+{
+  guint64 calls;
+  guint64 pixels;
+  guint64 nsecs;
+};
+
+static const gchar *const profile_counter_names[GDK_PROFILE_LAST] = {
+  "points",
+  "segments",
+  "lines",
+  "rectangle",
+  "fill_rectangle",
+  "arc",
+  "polygon",
+  "text",
+  "glyphs",
+  "trapezoids",
+  "draw_drawable_1bpp",
+  "draw_drawable_8bpp",
+  "draw_drawable_16bpp",
+  "draw_drawable_24bpp",
+  "draw_drawable_32bpp",
+  "draw_image",
+  "draw_pixbuf",
+  "spans",
+  "shadow_flush",
+  "cursor_hide",
+  "cursor_unhide"
+};
+
+gboolean _gdk_profile_enabled = FALSE;
+
+static GdkProfileEntry profile_entries[GDK_PROFILE_LAST];
+static gboolean profile_json = FALSE;
+static gchar *profile_filename = NULL;
+
+/* Only written from signal handlers, see _gdk_profile_add_async() */
+static volatile GdkProfileEntry profile_async_entries[GDK_PROFILE_LAST];
+
+#ifdef SIGUSR1
+static volatile sig_atomic_t profile_dump_requested = 0;
+#endif
+
+guint64
+_gdk_profile_now (void)
+{
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_MONOTONIC)
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return (guint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+  GTimeVal tv;
+
+  g_get_current_time (&tv);
+
+  return (guint64)tv.tv_sec * 1000000000 + (guint64)tv.tv_usec * 1000;
+#endif
+}
+
+void
+_gdk_profile_add (GdkProfileCounter counter,
+		  guint64           start,
+		  guint64           pixels)
+{
+  GdkProfileEntry *entry = &profile_entries[counter];
+
+  entry->calls++;
+  entry->pixels += pixels;
+  entry->nsecs += _gdk_profile_now () - start;
+}
+
+/* Unlike _gdk_profile_now(), safe to call from a signal handler;
+ * returns 0 where that can't be done without clock_gettime().
+ */
+guint64
+_gdk_profile_now_async (void)
+{
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_MONOTONIC)
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return (guint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+  return 0;
+#endif
+}
+
+/* For primitives run from a signal handler.  These are kept apart
+ * from the counters the main code updates, so that an interrupted
+ * _gdk_profile_add() can't be clobbered, and only summed up when
+ * dumping.
+ */
+void
+_gdk_profile_add_async (GdkProfileCounter counter,
+			guint64           start,
+			guint64           pixels)
+{
+  volatile GdkProfileEntry *entry = &profile_async_entries[counter];
+
+  entry->calls++;
+  entry->pixels += pixels;
+  if (start)
+    entry->nsecs += _gdk_profile_now_async () - start;
+}
+
+GdkProfileCounter
+_gdk_profile_drawable_counter (gint depth)
+{
+  if (depth <= 1)
+    return GDK_PROFILE_DRAW_DRAWABLE_1;
+  else if (depth <= 8)
+    return GDK_PROFILE_DRAW_DRAWABLE_8;
+  else if (depth <= 16)
+    return GDK_PROFILE_DRAW_DRAWABLE_16;
+  else if (depth <= 24)
+    return GDK_PROFILE_DRAW_DRAWABLE_24;
+  else
+    return GDK_PROFILE_DRAW_DRAWABLE_32;
+}
+
+static void
+gdk_profile_dump (void)
+{
+  FILE *file = stderr;
+  gint i;
+
+  if (profile_filename)
+    {
+      file = fopen (profile_filename, "w");
+      if (!file)
+	{
+	  g_warning ("Could not write drawing profile to '%s': %s",
+		     profile_filename, g_strerror (errno));
+	  return;
+	}
+    }
+
+  if (profile_json)
+    fprintf (file, "{\n  \"counters\": [\n");
+  else
+    fprintf (file, "primitive,calls,pixels,nsecs\n");
+
+  for (i = 0; i < GDK_PROFILE_LAST; i++)
+    {
+      GdkProfileEntry entry;
+
+      entry.calls = profile_entries[i].calls + profile_async_entries[i].calls;
+      entry.pixels = profile_entries[i].pixels + profile_async_entries[i].pixels;
+      entry.nsecs = profile_entries[i].nsecs + profile_async_entries[i].nsecs;
+
+      if (profile_json)
+	fprintf (file,
+		 "    { \"primitive\": \"%s\", \"calls\": %" G_GUINT64_FORMAT
+		 ", \"pixels\": %" G_GUINT64_FORMAT ", \"nsecs\": %" G_GUINT64_FORMAT " }%s\n",
+		 profile_counter_names[i], entry.calls, entry.pixels, entry.nsecs,
+		 i < GDK_PROFILE_LAST - 1 ? "," : "");
+      else
+	fprintf (file, "%s,%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT "\n",
+		 profile_counter_names[i], entry.calls, entry.pixels, entry.nsecs);
+    }
+
+  if (profile_json)
+    fprintf (file, "  ]\n}\n");
+
+  if (file != stderr)
+    fclose (file);
+  else
+    fflush (file);
+}
+
+#ifdef SIGUSR1
+static void
+gdk_profile_request_dump (int signum)
+{
+  profile_dump_requested = 1;
+}
+
+static gboolean
+gdk_profile_check_dump (gpointer data)
+{
+  if (profile_dump_requested)
+    {
+      profile_dump_requested = 0;
+      gdk_profile_dump ();
+    }
+
+  return TRUE;
+}
+
+/* Installs the handler for GDK_DRAW_PROFILE_SIGNAL, which is either a
+ * signal number or one of USR1 and USR2, optionally prefixed by SIG.
+ * A handler the application installed already is left alone.
+ */
+static void
+gdk_profile_init_signal (const gchar *value)
+{
+  struct sigaction action;
+  gchar *end;
+  gint signum;
+
+  if (g_ascii_strncasecmp (value, "SIG", 3) == 0)
+    value += 3;
+
+  if (g_ascii_strcasecmp (value, "USR1") == 0)
+    signum = SIGUSR1;
+  else if (g_ascii_strcasecmp (value, "USR2") == 0)
+    signum = SIGUSR2;
+  else
+    {
+      signum = strtol (value, &end, 10);
+      if (end == value || *end != '\0' || signum <= 0)
+	{
+	  g_warning ("Unknown signal '%s' in GDK_DRAW_PROFILE_SIGNAL", value);
+	  return;
+	}
+    }
+
+  if (sigaction (signum, NULL, &action) < 0)
+    {
+      g_warning ("Cannot use signal %d for the drawing profile: %s",
+		 signum, g_strerror (errno));
+      return;
+    }
+
+  if (action.sa_handler != SIG_DFL && action.sa_handler != SIG_IGN)
+    {
+      g_warning ("Signal %d already has a handler, "
+		 "not using it for the drawing profile", signum);
+      return;
+    }
+
+  action.sa_handler = gdk_profile_request_dump;
+  sigemptyset (&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  sigaction (signum, &action, NULL);
+
+  g_timeout_add (1000, gdk_profile_check_dump, NULL);
+}
+#endif
+
+void
+_gdk_profile_init (void)
+{
+  const gchar *value;
+  const gchar *colon;
+
+  value = g_getenv ("GDK_DRAW_PROFILE");
+  if (!value || _gdk_profile_enabled)
+    return;
+
+  colon = strchr (value, ':');
+  if (colon && colon[1])
+    profile_filename = g_strdup (colon + 1);
+
+  profile_json = g_ascii_strncasecmp (value, "json", 4) == 0;
+  _gdk_profile_enabled = TRUE;
+
+  g_atexit (gdk_profile_dump);
+
+#ifdef SIGUSR1
+  value = g_getenv ("GDK_DRAW_PROFILE_SIGNAL");
+  if (value)
+    gdk_profile_init_signal (value);
+#endif
+}
+
 #define __GDK_DRAW_C__
 #include "gdkaliasdef.c"
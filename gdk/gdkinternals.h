@@ -223,6 +223,61 @@ void _gdk_gc_update_context (GdkGC     *gc,
 			     GdkBitmap *override_stipple,
 			     gboolean   gc_changed);
 
+/* Drawing profile counters, enabled with the GDK_DRAW_PROFILE
+ * environment variable. Backends may account for their own
+ * primitives with GDK_PROFILE_START()/GDK_PROFILE_STOP().
+ */
+typedef enum {
+  GDK_PROFILE_POINTS,
+  GDK_PROFILE_SEGMENTS,
+  GDK_PROFILE_LINES,
+  GDK_PROFILE_RECTANGLE,
+  GDK_PROFILE_FILL_RECTANGLE,
+  GDK_PROFILE_ARC,
+  GDK_PROFILE_POLYGON,
+  GDK_PROFILE_TEXT,
+  GDK_PROFILE_GLYPHS,
+  GDK_PROFILE_TRAPEZOIDS,
+  GDK_PROFILE_DRAW_DRAWABLE_1,
+  GDK_PROFILE_DRAW_DRAWABLE_8,
+  GDK_PROFILE_DRAW_DRAWABLE_16,
+  GDK_PROFILE_DRAW_DRAWABLE_24,
+  GDK_PROFILE_DRAW_DRAWABLE_32,
+  GDK_PROFILE_DRAW_IMAGE,
+  GDK_PROFILE_DRAW_PIXBUF,
+  GDK_PROFILE_SPANS,
+  GDK_PROFILE_SHADOW_FLUSH,
+  GDK_PROFILE_CURSOR_HIDE,
+  GDK_PROFILE_CURSOR_UNHIDE,
+  GDK_PROFILE_LAST
+} GdkProfileCounter;
+
+extern gboolean _gdk_profile_enabled;
+
+void              _gdk_profile_init            (void);
+guint64           _gdk_profile_now             (void);
+void              _gdk_profile_add             (GdkProfileCounter counter,
+						guint64           start,
+						guint64           pixels);
+GdkProfileCounter _gdk_profile_drawable_counter (gint              depth);
+guint64           _gdk_profile_now_async       (void);
+void              _gdk_profile_add_async       (GdkProfileCounter counter,
+						guint64           start,
+						guint64           pixels);
+
+#define GDK_PROFILE_START() (_gdk_profile_enabled ? _gdk_profile_now () : 0)
+#define GDK_PROFILE_STOP(counter,start,pixels) G_STMT_START { \
+    if (_gdk_profile_enabled)					 \
+      _gdk_profile_add ((counter), (start), (pixels));		 \
+  } G_STMT_END
+
+/* The same, for code running in a signal handler */
+#define GDK_PROFILE_START_ASYNC() (_gdk_profile_enabled ? _gdk_profile_now_async () : 0)
+#define GDK_PROFILE_STOP_ASYNC(counter,start,pixels) G_STMT_START { \
+    if (_gdk_profile_enabled)					       \
+      _gdk_profile_add_async ((counter), (start), (pixels));	       \
+  } G_STMT_END
+
 /*************************************
  * Interfaces used by windowing code *
  *************************************/
@@ -2251,12 +2251,16 @@ gdk_window_ref_cairo_surface (GdkDrawable *drawable)
 static GSList *update_windows = NULL;
 static guint update_idle = 0;
 static gboolean debug_updates = FALSE;
+static guint update_budget = 0;
+static GdkWindowUpdateStats update_stats = { 0, };
+
+static void gdk_window_process_update_queue (guint budget);
 
 static gboolean
 gdk_window_update_idle (gpointer data)
 {
   GDK_THREADS_ENTER ();
-  gdk_window_process_all_updates ();
+  gdk_window_process_update_queue (update_budget);
   GDK_THREADS_LEAVE ();
   
   return FALSE;
@@ -2275,6 +2279,124 @@ gdk_window_schedule_update (GdkWindow *window)
     }
 }
 
+static gint
+gdk_window_get_depth (GdkWindowObject *window)
+{
+  gint depth = 0;
+
+  while (window->parent)
+    {
+      window = window->parent;
+      depth++;
+    }
+
+  return depth;
+}
+
+/* Records the position of @window and each of its ancestors among
+ * their siblings, so that sorting doesn't have to search the
+ * children lists on every comparison.
+ */
+static void
+gdk_window_index_stacking (GHashTable      *stacking,
+			   GdkWindowObject *window)
+{
+  GList *children;
+  gint i;
+
+  for (; window->parent; window = window->parent)
+    {
+      /* Its ancestors were indexed together with it */
+      if (g_hash_table_lookup_extended (stacking, window, NULL, NULL))
+	break;
+
+      /* The children list is ordered from the top of the stack down */
+      for (children = window->parent->children, i = 0;
+	   children;
+	   children = children->next, i++)
+	g_hash_table_insert (stacking, children->data, GINT_TO_POINTER (i));
+    }
+}
+
+/* Sort function for the update queue. Ancestors come before their
+ * descendants and lower stacked siblings before the siblings above
+ * them, so a window that repaints its background never paints over
+ * something that was already updated in the same pass.
+ */
+static gint
+gdk_window_update_compare (gconstpointer a,
+			   gconstpointer b,
+			   gpointer      data)
+{
+  GHashTable *stacking = data;
+  GdkWindowObject *window_a = (GdkWindowObject *)a;
+  GdkWindowObject *window_b = (GdkWindowObject *)b;
+  gint depth_a = gdk_window_get_depth (window_a);
+  gint depth_b = gdk_window_get_depth (window_b);
+  gint depth_diff = depth_a - depth_b;
+
+  while (depth_a > depth_b)
+    {
+      window_a = window_a->parent;
+      depth_a--;
+    }
+  while (depth_b > depth_a)
+    {
+      window_b = window_b->parent;
+      depth_b--;
+    }
+
+  /* One window is an ancestor of the other */
+  if (window_a == window_b)
+    return depth_diff;
+
+  while (window_a->parent != window_b->parent)
+    {
+      window_a = window_a->parent;
+      window_b = window_b->parent;
+    }
+
+  /* Unrelated hierarchies, keep the queue order */
+  if (!window_a->parent)
+    return 0;
+
+  return (GPOINTER_TO_INT (g_hash_table_lookup (stacking, window_b)) -
+	  GPOINTER_TO_INT (g_hash_table_lookup (stacking, window_a)));
+}
+
+static guint64
+gdk_window_region_get_area (GdkRegion *region,
+			    gint      *n_rectangles)
+{
+  GdkRectangle *rectangles;
+  guint64 area = 0;
+  gint i;
+
+  gdk_region_get_rectangles (region, &rectangles, n_rectangles);
+
+  for (i = 0; i < *n_rectangles; i++)
+    area += (guint64)rectangles[i].width * rectangles[i].height;
+
+  g_free (rectangles);
+
+  return area;
+}
+
+static void
+gdk_window_update_stats_add (GdkRegion *region)
+{
+  gint n_rectangles;
+  guint64 area;
+
+  area = gdk_window_region_get_area (region, &n_rectangles);
+
+  update_stats.n_windows++;
+  update_stats.n_rectangles += n_rectangles;
+  update_stats.n_pixels += area;
+  update_stats.total_windows++;
+  update_stats.total_pixels += area;
+}
+
 static void
 gdk_window_process_updates_internal (GdkWindow *window)
 {
@@ -2327,6 +2449,8 @@ gdk_window_process_updates_internal (GdkWindow *window)
 	      (private->event_mask & GDK_EXPOSURE_MASK))
 	    {
 	      GdkEvent event;
+
+	      gdk_window_update_stats_add (expose_region);
 	      
 	      event.expose.type = GDK_EXPOSE;
 	      event.expose.window = g_object_ref (window);
@@ -2370,35 +2494,67 @@ flush_all_displays (void)
  * displays and call the mehod.
  */
 
-/**
- * gdk_window_process_all_updates:
- *
- * Calls gdk_window_process_updates() for all windows (see #GdkWindow)
- * in the application.
- * 
- **/
-void
-gdk_window_process_all_updates (void)
+static void
+gdk_window_process_update_queue (guint budget)
 {
-  GSList *old_update_windows = update_windows;
-  GSList *tmp_list = update_windows;
+  GSList *old_update_windows;
+  GSList *tmp_list;
+  GHashTable *stacking;
+  GTimeVal start_time;
+  gboolean over_budget = FALSE;
 
   if (update_idle)
     g_source_remove (update_idle);
-  
+
+  stacking = g_hash_table_new (NULL, NULL);
+  for (tmp_list = update_windows; tmp_list; tmp_list = tmp_list->next)
+    gdk_window_index_stacking (stacking, tmp_list->data);
+
+  old_update_windows = g_slist_sort_with_data (update_windows,
+					       gdk_window_update_compare,
+					       stacking);
+  g_hash_table_destroy (stacking);
   update_windows = NULL;
   update_idle = 0;
 
+  update_stats.n_windows = 0;
+  update_stats.n_rectangles = 0;
+  update_stats.n_pixels = 0;
+  update_stats.n_deferred = 0;
+
+  if (budget)
+    g_get_current_time (&start_time);
+
   g_slist_foreach (old_update_windows, (GFunc)g_object_ref, NULL);
   
+  tmp_list = old_update_windows;
   while (tmp_list)
     {
       GdkWindowObject *private = (GdkWindowObject *)tmp_list->data;
       
       if (private->update_freeze_count)
 	update_windows = g_slist_prepend (update_windows, private);
+      else if (over_budget)
+	{
+	  if (private->update_area)
+	    {
+	      update_windows = g_slist_prepend (update_windows, private);
+	      update_stats.n_deferred++;
+	    }
+	}
       else
-	gdk_window_process_updates_internal (tmp_list->data);
+	{
+	  gdk_window_process_updates_internal (tmp_list->data);
+
+	  if (budget)
+	    {
+	      GTimeVal now;
+
+	      g_get_current_time (&now);
+	      over_budget = ((now.tv_sec - start_time.tv_sec) * G_USEC_PER_SEC +
+			     (now.tv_usec - start_time.tv_usec)) >= budget;
+	    }
+	}
       
       g_object_unref (tmp_list->data);
       tmp_list = tmp_list->next;
@@ -2406,9 +2562,30 @@ gdk_window_process_all_updates (void)
 
   g_slist_free (old_update_windows);
 
+  /* Let pending input be handled before painting the rest */
+  if (update_stats.n_deferred)
+    gdk_window_schedule_update (NULL);
+
   flush_all_displays ();
 }
 
+/**
+ * gdk_window_process_all_updates:
+ *
+ * Calls gdk_window_process_updates() for all windows (see #GdkWindow)
+ * in the application.
+ *
+ * Windows are processed in stacking order, parents before their
+ * children. Unlike the idle handler GDK installs for you, this
+ * function ignores the budget set with gdk_window_set_update_budget()
+ * and always processes every pending update.
+ **/
+void
+gdk_window_process_all_updates (void)
+{
+  gdk_window_process_update_queue (0);
+}
+
 /**
  * gdk_window_process_updates:
  * @window: a #GdkWindow
@@ -2817,6 +2994,68 @@ gdk_window_set_debug_updates (gboolean setting)
   debug_updates = setting;
 }
 
+/**
+ * gdk_window_set_update_budget:
+ * @usecs: the time budget in microseconds, or 0 for no limit
+ *
+ * Limits the time GDK spends sending expose events each time it
+ * processes the update queue from the main loop. Once the budget is
+ * exceeded, the remaining windows keep their update areas and are
+ * processed in a later main loop iteration, after pending input
+ * has been handled. At least one window is updated per iteration.
+ *
+ * Explicit calls to gdk_window_process_all_updates() and
+ * gdk_window_process_updates() are not affected.
+ *
+ * On the linux-fb target with a shadow framebuffer, the budget
+ * defaults to the interval at which the shadow framebuffer is
+ * copied to the screen.
+ *
+ * Since: 2.12
+ **/
+void
+gdk_window_set_update_budget (guint usecs)
+{
+  update_budget = usecs;
+}
+
+/**
+ * gdk_window_get_update_budget:
+ *
+ * Returns the budget set with gdk_window_set_update_budget().
+ *
+ * Return value: the time budget in microseconds, 0 if there is no limit
+ *
+ * Since: 2.12
+ **/
+guint
+gdk_window_get_update_budget (void)
+{
+  return update_budget;
+}
+
+/**
+ * gdk_window_get_update_stats:
+ * @stats: a #GdkWindowUpdateStats to fill in
+ *
+ * Retrieves counters describing the expose events sent by GDK.
+ * The @n_windows, @n_rectangles and @n_pixels fields cover the
+ * exposes sent since the update queue was last processed; 
+ * @n_deferred is the number of windows that were postponed to the
+ * next iteration because of the update budget. The @total_windows
+ * and @total_pixels fields accumulate over the lifetime of the
+ * process.
+ *
+ * Since: 2.12
+ **/
+void
+gdk_window_get_update_stats (GdkWindowUpdateStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  *stats = update_stats;
+}
+
 /**
  * gdk_window_constrain_size:
  * @geometry: a #GdkGeometry structure
@@ -36,6 +36,7 @@ G_BEGIN_DECLS
 typedef struct _GdkGeometry           GdkGeometry;
 typedef struct _GdkWindowAttr	      GdkWindowAttr;
 typedef struct _GdkPointerHooks	      GdkPointerHooks;
+typedef struct _GdkWindowUpdateStats  GdkWindowUpdateStats;
 
 /* Classes of windows.
  *   InputOutput: Almost every window should be of this type. Such windows
@@ -243,6 +244,19 @@ struct _GdkPointerHooks
                                    gint            *win_y);
 };
 
+/* Counters describing the most recent pass over the update queue,
+ * see gdk_window_get_update_stats().
+ */
+struct _GdkWindowUpdateStats
+{
+  guint   n_windows;
+  guint   n_rectangles;
+  guint64 n_pixels;
+  guint   n_deferred;
+  guint64 total_windows;
+  guint64 total_pixels;
+};
+
 typedef struct _GdkWindowObject GdkWindowObject;
 typedef struct _GdkWindowObjectClass GdkWindowObjectClass;
 
@@ -604,6 +618,10 @@ void       gdk_window_process_updates     (GdkWindow    *window,
 /* Enable/disable flicker, so you can tell if your code is inefficient. */
 void       gdk_window_set_debug_updates   (gboolean      setting);
 
+void       gdk_window_set_update_budget   (guint                 usecs);
+guint      gdk_window_get_update_budget   (void);
+void       gdk_window_get_update_stats    (GdkWindowUpdateStats *stats);
+
 void       gdk_window_constrain_size      (GdkGeometry  *geometry,
                                            guint         flags,
                                            gint          width,
@@ -318,6 +318,7 @@ void
 gdk_fb_cursor_hide (void)
 {
   GdkFBDrawingContext *mydc = gdk_fb_cursor_dc;
+  guint64 profile_start;
 
   cursor_visibility_count--;
   g_assert (cursor_visibility_count <= 0);
@@ -330,6 +331,8 @@ gdk_fb_cursor_hide (void)
 
   if (last_contents)
     {
+      profile_start = GDK_PROFILE_START ();
+
       gdk_gc_set_clip_mask (cursor_gc, NULL);
       /* Restore old picture */
       gdk_fb_draw_drawable_3 (GDK_DRAWABLE_IMPL(_gdk_parent_root),
@@ -344,6 +347,9 @@ gdk_fb_cursor_hide (void)
       gdk_shadow_fb_update (last_location.x, last_location.y,
 			    last_location.x + last_contents_size.x,
 			    last_location.y + last_contents_size.y);
+
+      GDK_PROFILE_STOP (GDK_PROFILE_CURSOR_HIDE, profile_start,
+			(guint64)last_contents_size.x * last_contents_size.y);
     }
 }
 
@@ -363,6 +369,7 @@ gdk_fb_cursor_unhide (void)
   GdkFBDrawingContext *mydc = gdk_fb_cursor_dc;
   GdkCursorPrivateFB *last_private;
   GdkDrawableFBData *pixmap_last;
+  guint64 profile_start;
   
   last_private = GDK_CURSOR_FB (last_cursor);
   cursor_visibility_count++;
@@ -375,6 +382,8 @@ gdk_fb_cursor_unhide (void)
 
   if (last_cursor)
     {
+      profile_start = GDK_PROFILE_START ();
+
       pixmap_last = GDK_DRAWABLE_IMPL_FBDATA (last_private->cursor);
       
       if (!last_contents ||
@@ -420,6 +429,9 @@ gdk_fb_cursor_unhide (void)
       gdk_shadow_fb_update (last_location.x, last_location.y,
 			    last_location.x + pixmap_last->width,
 			    last_location.y + pixmap_last->height);
+
+      GDK_PROFILE_STOP (GDK_PROFILE_CURSOR_UNHIDE, profile_start,
+			(guint64)pixmap_last->width * pixmap_last->height);
     }
   else
     gdk_fb_cursor_invalidate ();
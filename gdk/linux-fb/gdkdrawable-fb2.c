@@ -529,6 +529,8 @@ gdk_fb_fill_spans (GdkDrawable *real_drawable,
   gboolean handle_cursor = FALSE;
   GdkDrawable *drawable;
   GdkDrawableFBData *private;
+  guint64 profile_start;
+  guint64 pixels = 0;
   
   drawable = real_drawable;
   private = GDK_DRAWABLE_FBDATA (drawable);
@@ -540,6 +542,8 @@ gdk_fb_fill_spans (GdkDrawable *real_drawable,
   if (GDK_IS_WINDOW (private->wrapper) && GDK_WINDOW_P (private->wrapper)->input_only)
     g_error ("Drawing on the evil input-only!");
 
+  profile_start = GDK_PROFILE_START ();
+
   info.drawable = drawable;
   info.gc = gc;
   
@@ -584,6 +588,8 @@ gdk_fb_fill_spans (GdkDrawable *real_drawable,
 
       if (cur->width <= 0)
 	cur->width = 0;
+
+      pixels += cur->width;
     }
 
   gdk_region_spans_intersect_foreach (real_clip_region,
@@ -596,6 +602,8 @@ gdk_fb_fill_spans (GdkDrawable *real_drawable,
   gdk_region_destroy (real_clip_region);
   if (handle_cursor)
     gdk_fb_cursor_unhide ();
+
+  GDK_PROFILE_STOP (GDK_PROFILE_SPANS, profile_start, pixels);
 }
 
 void
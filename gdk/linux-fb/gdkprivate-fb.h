@@ -401,6 +401,9 @@ void       gdk_fb_pointer_ungrab           (guint32 time,
 
 guint32    gdk_fb_get_time                 (void);
 
+/* Interval at which the shadow framebuffer is copied to the screen */
+#define GDK_SHADOW_FB_REFRESH_INTERVAL 20000 /* 20 ms => 50 fps */
+
 void       gdk_shadow_fb_update            (gint                 minx,
 					    gint                 miny,
 					    gint                 maxx,
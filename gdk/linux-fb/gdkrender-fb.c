@@ -1413,6 +1413,7 @@ static void
 gdk_shadow_fb_refresh (int signum)
 {
   gint minx, miny, maxx, maxy;
+  guint64 profile_start;
 
   if (!refresh_queued)
     {
@@ -1452,7 +1453,11 @@ gdk_shadow_fb_refresh (int signum)
     miny = MIN (miny, maxy);
   }
   
+  /* we are in the SIGALRM handler */
+  profile_start = GDK_PROFILE_START_ASYNC ();
   (*shadow_copy_rect[_gdk_fb_screen_angle]) (minx, miny, maxx - minx + 1, maxy - miny + 1);
+  GDK_PROFILE_STOP_ASYNC (GDK_PROFILE_SHADOW_FLUSH, profile_start,
+			  (guint64)(maxx - minx + 1) * (maxy - miny + 1));
 }
 
 void
@@ -1487,6 +1492,9 @@ gdk_shadow_fb_init (void)
   shadow_copy_rect[GDK_FB_90_DEGREES] = gdk_shadow_fb_copy_rect_90;
   shadow_copy_rect[GDK_FB_180_DEGREES] = gdk_shadow_fb_copy_rect_180;
   shadow_copy_rect[GDK_FB_270_DEGREES] = gdk_shadow_fb_copy_rect_270;
+
+  /* Painting more than fits between two refreshes only delays input */
+  gdk_window_set_update_budget (GDK_SHADOW_FB_REFRESH_INTERVAL);
 }
 
 /* maxx and maxy are included */
@@ -1521,9 +1529,9 @@ gdk_shadow_fb_update (gint minx, gint miny, gint maxx, gint maxy)
       if (timeout.it_value.tv_usec == 0)
 	{
 	  timeout.it_value.tv_sec = 0;
-	  timeout.it_value.tv_usec = 20000; /* 20 ms => 50 fps */
+	  timeout.it_value.tv_usec = GDK_SHADOW_FB_REFRESH_INTERVAL;
 	  timeout.it_interval.tv_sec = 0;
-	  timeout.it_interval.tv_usec = 20000; /* 20 ms => 50 fps */
+	  timeout.it_interval.tv_usec = GDK_SHADOW_FB_REFRESH_INTERVAL;
 	  setitimer (ITIMER_REAL, &timeout, NULL);
 	}
     }
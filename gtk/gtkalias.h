@@ -1833,6 +1833,49 @@ extern __typeof (gtk_color_selection_dialog_get_type) IA__gtk_color_selection_di
 extern __typeof (gtk_color_selection_dialog_new) IA__gtk_color_selection_dialog_new __attribute((visibility("hidden")));
 #define gtk_color_selection_dialog_new IA__gtk_color_selection_dialog_new
 
+#endif
+#endif
+#if IN_HEADER(__GTK_COLUMN_STORE_H__)
+#if IN_FILE(__GTK_COLUMN_STORE_C__)
+extern __typeof (gtk_column_store_append) IA__gtk_column_store_append __attribute((visibility("hidden")));
+#define gtk_column_store_append IA__gtk_column_store_append
+
+extern __typeof (gtk_column_store_append_rows) IA__gtk_column_store_append_rows __attribute((visibility("hidden")));
+#define gtk_column_store_append_rows IA__gtk_column_store_append_rows
+
+extern __typeof (gtk_column_store_clear) IA__gtk_column_store_clear __attribute((visibility("hidden")));
+#define gtk_column_store_clear IA__gtk_column_store_clear
+
+extern __typeof (gtk_column_store_get_type) IA__gtk_column_store_get_type __attribute((visibility("hidden"))) G_GNUC_CONST;
+#define gtk_column_store_get_type IA__gtk_column_store_get_type
+
+extern __typeof (gtk_column_store_insert) IA__gtk_column_store_insert __attribute((visibility("hidden")));
+#define gtk_column_store_insert IA__gtk_column_store_insert
+
+extern __typeof (gtk_column_store_iter_is_valid) IA__gtk_column_store_iter_is_valid __attribute((visibility("hidden")));
+#define gtk_column_store_iter_is_valid IA__gtk_column_store_iter_is_valid
+
+extern __typeof (gtk_column_store_new) IA__gtk_column_store_new __attribute((visibility("hidden")));
+#define gtk_column_store_new IA__gtk_column_store_new
+
+extern __typeof (gtk_column_store_newv) IA__gtk_column_store_newv __attribute((visibility("hidden")));
+#define gtk_column_store_newv IA__gtk_column_store_newv
+
+extern __typeof (gtk_column_store_remove) IA__gtk_column_store_remove __attribute((visibility("hidden")));
+#define gtk_column_store_remove IA__gtk_column_store_remove
+
+extern __typeof (gtk_column_store_set) IA__gtk_column_store_set __attribute((visibility("hidden")));
+#define gtk_column_store_set IA__gtk_column_store_set
+
+extern __typeof (gtk_column_store_set_column_from_array) IA__gtk_column_store_set_column_from_array __attribute((visibility("hidden")));
+#define gtk_column_store_set_column_from_array IA__gtk_column_store_set_column_from_array
+
+extern __typeof (gtk_column_store_set_valist) IA__gtk_column_store_set_valist __attribute((visibility("hidden")));
+#define gtk_column_store_set_valist IA__gtk_column_store_set_valist
+
+extern __typeof (gtk_column_store_set_value) IA__gtk_column_store_set_value __attribute((visibility("hidden")));
+#define gtk_column_store_set_value IA__gtk_column_store_set_value
+
 #endif
 #endif
 #if IN_HEADER(__GTK_COMBO_BOX_H__)
@@ -4365,6 +4408,18 @@ extern __typeof (gtk_icon_view_set_reorderable) IA__gtk_icon_view_set_reorderabl
 extern __typeof (gtk_icon_view_get_reorderable) IA__gtk_icon_view_get_reorderable __attribute((visibility("hidden")));
 #define gtk_icon_view_get_reorderable IA__gtk_icon_view_get_reorderable
 
+extern __typeof (gtk_icon_view_set_fixed_item_size) IA__gtk_icon_view_set_fixed_item_size __attribute((visibility("hidden")));
+#define gtk_icon_view_set_fixed_item_size IA__gtk_icon_view_set_fixed_item_size
+
+extern __typeof (gtk_icon_view_get_fixed_item_size) IA__gtk_icon_view_get_fixed_item_size __attribute((visibility("hidden")));
+#define gtk_icon_view_get_fixed_item_size IA__gtk_icon_view_get_fixed_item_size
+
+extern __typeof (gtk_icon_view_set_incremental_layout) IA__gtk_icon_view_set_incremental_layout __attribute((visibility("hidden")));
+#define gtk_icon_view_set_incremental_layout IA__gtk_icon_view_set_incremental_layout
+
+extern __typeof (gtk_icon_view_get_incremental_layout) IA__gtk_icon_view_get_incremental_layout __attribute((visibility("hidden")));
+#define gtk_icon_view_get_incremental_layout IA__gtk_icon_view_get_incremental_layout
+
 extern __typeof (gtk_icon_view_set_drag_dest_item) IA__gtk_icon_view_set_drag_dest_item __attribute((visibility("hidden")));
 #define gtk_icon_view_set_drag_dest_item IA__gtk_icon_view_set_drag_dest_item
 
@@ -8220,6 +8275,9 @@ extern __typeof (gtk_text_thaw) IA__gtk_text_thaw __attribute((visibility("hidde
 extern __typeof (gtk_text_buffer_add_selection_clipboard) IA__gtk_text_buffer_add_selection_clipboard __attribute((visibility("hidden")));
 #define gtk_text_buffer_add_selection_clipboard IA__gtk_text_buffer_add_selection_clipboard
 
+extern __typeof (gtk_text_buffer_append_lines) IA__gtk_text_buffer_append_lines __attribute((visibility("hidden")));
+#define gtk_text_buffer_append_lines IA__gtk_text_buffer_append_lines
+
 extern __typeof (gtk_text_buffer_apply_tag) IA__gtk_text_buffer_apply_tag __attribute((visibility("hidden")));
 #define gtk_text_buffer_apply_tag IA__gtk_text_buffer_apply_tag
 
@@ -8307,6 +8365,9 @@ extern __typeof (gtk_text_buffer_get_line_count) IA__gtk_text_buffer_get_line_co
 extern __typeof (gtk_text_buffer_get_mark) IA__gtk_text_buffer_get_mark __attribute((visibility("hidden")));
 #define gtk_text_buffer_get_mark IA__gtk_text_buffer_get_mark
 
+extern __typeof (gtk_text_buffer_get_max_lines) IA__gtk_text_buffer_get_max_lines __attribute((visibility("hidden")));
+#define gtk_text_buffer_get_max_lines IA__gtk_text_buffer_get_max_lines
+
 extern __typeof (gtk_text_buffer_get_modified) IA__gtk_text_buffer_get_modified __attribute((visibility("hidden")));
 #define gtk_text_buffer_get_modified IA__gtk_text_buffer_get_modified
 
@@ -8394,6 +8455,9 @@ extern __typeof (gtk_text_buffer_remove_tag_by_name) IA__gtk_text_buffer_remove_
 extern __typeof (gtk_text_buffer_select_range) IA__gtk_text_buffer_select_range __attribute((visibility("hidden")));
 #define gtk_text_buffer_select_range IA__gtk_text_buffer_select_range
 
+extern __typeof (gtk_text_buffer_set_max_lines) IA__gtk_text_buffer_set_max_lines __attribute((visibility("hidden")));
+#define gtk_text_buffer_set_max_lines IA__gtk_text_buffer_set_max_lines
+
 extern __typeof (gtk_text_buffer_set_modified) IA__gtk_text_buffer_set_modified __attribute((visibility("hidden")));
 #define gtk_text_buffer_set_modified IA__gtk_text_buffer_set_modified
 
@@ -8522,6 +8586,9 @@ extern __typeof (gtk_text_iter_forward_lines) IA__gtk_text_iter_forward_lines __
 extern __typeof (gtk_text_iter_forward_search) IA__gtk_text_iter_forward_search __attribute((visibility("hidden")));
 #define gtk_text_iter_forward_search IA__gtk_text_iter_forward_search
 
+extern __typeof (gtk_text_iter_forward_search_all) IA__gtk_text_iter_forward_search_all __attribute((visibility("hidden")));
+#define gtk_text_iter_forward_search_all IA__gtk_text_iter_forward_search_all
+
 extern __typeof (gtk_text_iter_forward_sentence_end) IA__gtk_text_iter_forward_sentence_end __attribute((visibility("hidden")));
 #define gtk_text_iter_forward_sentence_end IA__gtk_text_iter_forward_sentence_end
 
@@ -9812,9 +9879,15 @@ extern __typeof (gtk_tree_model_filter_get_type) IA__gtk_tree_model_filter_get_t
 extern __typeof (gtk_tree_model_filter_new) IA__gtk_tree_model_filter_new __attribute((visibility("hidden")));
 #define gtk_tree_model_filter_new IA__gtk_tree_model_filter_new
 
+extern __typeof (gtk_tree_model_filter_queue_refilter) IA__gtk_tree_model_filter_queue_refilter __attribute((visibility("hidden")));
+#define gtk_tree_model_filter_queue_refilter IA__gtk_tree_model_filter_queue_refilter
+
 extern __typeof (gtk_tree_model_filter_refilter) IA__gtk_tree_model_filter_refilter __attribute((visibility("hidden")));
 #define gtk_tree_model_filter_refilter IA__gtk_tree_model_filter_refilter
 
+extern __typeof (gtk_tree_model_filter_refilter_rows) IA__gtk_tree_model_filter_refilter_rows __attribute((visibility("hidden")));
+#define gtk_tree_model_filter_refilter_rows IA__gtk_tree_model_filter_refilter_rows
+
 extern __typeof (gtk_tree_model_filter_set_modify_func) IA__gtk_tree_model_filter_set_modify_func __attribute((visibility("hidden")));
 #define gtk_tree_model_filter_set_modify_func IA__gtk_tree_model_filter_set_modify_func
 
@@ -1836,6 +1836,49 @@ extern __typeof (gtk_color_selection_dialog_get_type) gtk_color_selection_dialog
 #undef gtk_color_selection_dialog_new 
 extern __typeof (gtk_color_selection_dialog_new) gtk_color_selection_dialog_new __attribute((alias("IA__gtk_color_selection_dialog_new"), visibility("default")));
 
+#endif
+#endif
+#if IN_HEADER(__GTK_COLUMN_STORE_H__)
+#if IN_FILE(__GTK_COLUMN_STORE_C__)
+#undef gtk_column_store_append 
+extern __typeof (gtk_column_store_append) gtk_column_store_append __attribute((alias("IA__gtk_column_store_append"), visibility("default")));
+
+#undef gtk_column_store_append_rows 
+extern __typeof (gtk_column_store_append_rows) gtk_column_store_append_rows __attribute((alias("IA__gtk_column_store_append_rows"), visibility("default")));
+
+#undef gtk_column_store_clear 
+extern __typeof (gtk_column_store_clear) gtk_column_store_clear __attribute((alias("IA__gtk_column_store_clear"), visibility("default")));
+
+#undef gtk_column_store_get_type 
+extern __typeof (gtk_column_store_get_type) gtk_column_store_get_type __attribute((alias("IA__gtk_column_store_get_type"), visibility("default")));
+
+#undef gtk_column_store_insert 
+extern __typeof (gtk_column_store_insert) gtk_column_store_insert __attribute((alias("IA__gtk_column_store_insert"), visibility("default")));
+
+#undef gtk_column_store_iter_is_valid 
+extern __typeof (gtk_column_store_iter_is_valid) gtk_column_store_iter_is_valid __attribute((alias("IA__gtk_column_store_iter_is_valid"), visibility("default")));
+
+#undef gtk_column_store_new 
+extern __typeof (gtk_column_store_new) gtk_column_store_new __attribute((alias("IA__gtk_column_store_new"), visibility("default")));
+
+#undef gtk_column_store_newv 
+extern __typeof (gtk_column_store_newv) gtk_column_store_newv __attribute((alias("IA__gtk_column_store_newv"), visibility("default")));
+
+#undef gtk_column_store_remove 
+extern __typeof (gtk_column_store_remove) gtk_column_store_remove __attribute((alias("IA__gtk_column_store_remove"), visibility("default")));
+
+#undef gtk_column_store_set 
+extern __typeof (gtk_column_store_set) gtk_column_store_set __attribute((alias("IA__gtk_column_store_set"), visibility("default")));
+
+#undef gtk_column_store_set_column_from_array 
+extern __typeof (gtk_column_store_set_column_from_array) gtk_column_store_set_column_from_array __attribute((alias("IA__gtk_column_store_set_column_from_array"), visibility("default")));
+
+#undef gtk_column_store_set_valist 
+extern __typeof (gtk_column_store_set_valist) gtk_column_store_set_valist __attribute((alias("IA__gtk_column_store_set_valist"), visibility("default")));
+
+#undef gtk_column_store_set_value 
+extern __typeof (gtk_column_store_set_value) gtk_column_store_set_value __attribute((alias("IA__gtk_column_store_set_value"), visibility("default")));
+
 #endif
 #endif
 #if IN_HEADER(__GTK_COMBO_BOX_H__)
@@ -4368,6 +4411,18 @@ extern __typeof (gtk_icon_view_set_reorderable) gtk_icon_view_set_reorderable __
 #undef gtk_icon_view_get_reorderable 
 extern __typeof (gtk_icon_view_get_reorderable) gtk_icon_view_get_reorderable __attribute((alias("IA__gtk_icon_view_get_reorderable"), visibility("default")));
 
+#undef gtk_icon_view_set_fixed_item_size 
+extern __typeof (gtk_icon_view_set_fixed_item_size) gtk_icon_view_set_fixed_item_size __attribute((alias("IA__gtk_icon_view_set_fixed_item_size"), visibility("default")));
+
+#undef gtk_icon_view_get_fixed_item_size 
+extern __typeof (gtk_icon_view_get_fixed_item_size) gtk_icon_view_get_fixed_item_size __attribute((alias("IA__gtk_icon_view_get_fixed_item_size"), visibility("default")));
+
+#undef gtk_icon_view_set_incremental_layout 
+extern __typeof (gtk_icon_view_set_incremental_layout) gtk_icon_view_set_incremental_layout __attribute((alias("IA__gtk_icon_view_set_incremental_layout"), visibility("default")));
+
+#undef gtk_icon_view_get_incremental_layout 
+extern __typeof (gtk_icon_view_get_incremental_layout) gtk_icon_view_get_incremental_layout __attribute((alias("IA__gtk_icon_view_get_incremental_layout"), visibility("default")));
+
 #undef gtk_icon_view_set_drag_dest_item 
 extern __typeof (gtk_icon_view_set_drag_dest_item) gtk_icon_view_set_drag_dest_item __attribute((alias("IA__gtk_icon_view_set_drag_dest_item"), visibility("default")));
 
@@ -8223,6 +8278,9 @@ extern __typeof (gtk_text_thaw) gtk_text_thaw __attribute((alias("IA__gtk_text_t
 #undef gtk_text_buffer_add_selection_clipboard 
 extern __typeof (gtk_text_buffer_add_selection_clipboard) gtk_text_buffer_add_selection_clipboard __attribute((alias("IA__gtk_text_buffer_add_selection_clipboard"), visibility("default")));
 
+#undef gtk_text_buffer_append_lines 
+extern __typeof (gtk_text_buffer_append_lines) gtk_text_buffer_append_lines __attribute((alias("IA__gtk_text_buffer_append_lines"), visibility("default")));
+
 #undef gtk_text_buffer_apply_tag 
 extern __typeof (gtk_text_buffer_apply_tag) gtk_text_buffer_apply_tag __attribute((alias("IA__gtk_text_buffer_apply_tag"), visibility("default")));
 
@@ -8310,6 +8368,9 @@ extern __typeof (gtk_text_buffer_get_line_count) gtk_text_buffer_get_line_count
 #undef gtk_text_buffer_get_mark 
 extern __typeof (gtk_text_buffer_get_mark) gtk_text_buffer_get_mark __attribute((alias("IA__gtk_text_buffer_get_mark"), visibility("default")));
 
+#undef gtk_text_buffer_get_max_lines 
+extern __typeof (gtk_text_buffer_get_max_lines) gtk_text_buffer_get_max_lines __attribute((alias("IA__gtk_text_buffer_get_max_lines"), visibility("default")));
+
 #undef gtk_text_buffer_get_modified 
 extern __typeof (gtk_text_buffer_get_modified) gtk_text_buffer_get_modified __attribute((alias("IA__gtk_text_buffer_get_modified"), visibility("default")));
 
@@ -8397,6 +8458,9 @@ extern __typeof (gtk_text_buffer_remove_tag_by_name) gtk_text_buffer_remove_tag_
 #undef gtk_text_buffer_select_range 
 extern __typeof (gtk_text_buffer_select_range) gtk_text_buffer_select_range __attribute((alias("IA__gtk_text_buffer_select_range"), visibility("default")));
 
+#undef gtk_text_buffer_set_max_lines 
+extern __typeof (gtk_text_buffer_set_max_lines) gtk_text_buffer_set_max_lines __attribute((alias("IA__gtk_text_buffer_set_max_lines"), visibility("default")));
+
 #undef gtk_text_buffer_set_modified 
 extern __typeof (gtk_text_buffer_set_modified) gtk_text_buffer_set_modified __attribute((alias("IA__gtk_text_buffer_set_modified"), visibility("default")));
 
@@ -8525,6 +8589,9 @@ extern __typeof (gtk_text_iter_forward_lines) gtk_text_iter_forward_lines __attr
 #undef gtk_text_iter_forward_search 
 extern __typeof (gtk_text_iter_forward_search) gtk_text_iter_forward_search __attribute((alias("IA__gtk_text_iter_forward_search"), visibility("default")));
 
+#undef gtk_text_iter_forward_search_all 
+extern __typeof (gtk_text_iter_forward_search_all) gtk_text_iter_forward_search_all __attribute((alias("IA__gtk_text_iter_forward_search_all"), visibility("default")));
+
 #undef gtk_text_iter_forward_sentence_end 
 extern __typeof (gtk_text_iter_forward_sentence_end) gtk_text_iter_forward_sentence_end __attribute((alias("IA__gtk_text_iter_forward_sentence_end"), visibility("default")));
 
@@ -9815,9 +9882,15 @@ extern __typeof (gtk_tree_model_filter_get_type) gtk_tree_model_filter_get_type
 #undef gtk_tree_model_filter_new 
 extern __typeof (gtk_tree_model_filter_new) gtk_tree_model_filter_new __attribute((alias("IA__gtk_tree_model_filter_new"), visibility("default")));
 
+#undef gtk_tree_model_filter_queue_refilter 
+extern __typeof (gtk_tree_model_filter_queue_refilter) gtk_tree_model_filter_queue_refilter __attribute((alias("IA__gtk_tree_model_filter_queue_refilter"), visibility("default")));
+
 #undef gtk_tree_model_filter_refilter 
 extern __typeof (gtk_tree_model_filter_refilter) gtk_tree_model_filter_refilter __attribute((alias("IA__gtk_tree_model_filter_refilter"), visibility("default")));
 
+#undef gtk_tree_model_filter_refilter_rows 
+extern __typeof (gtk_tree_model_filter_refilter_rows) gtk_tree_model_filter_refilter_rows __attribute((alias("IA__gtk_tree_model_filter_refilter_rows"), visibility("default")));
+
 #undef gtk_tree_model_filter_set_modify_func 
 extern __typeof (gtk_tree_model_filter_set_modify_func) gtk_tree_model_filter_set_modify_func __attribute((alias("IA__gtk_tree_model_filter_set_modify_func"), visibility("default")));
 
@@ -19,6 +19,7 @@
 
 #include <config.h>
 #include <stdlib.h>
+#include <string.h>
 #include "gtkcellrenderertext.h"
 #include "gtkeditable.h"
 #include "gtkentry.h"
@@ -61,6 +62,15 @@ static GtkCellEditable *gtk_cell_renderer_text_start_editing (GtkCellRenderer
 							      GdkRectangle         *cell_area,
 							      GtkCellRendererState  flags);
 
+typedef struct _LayoutCacheEntry LayoutCacheEntry;
+typedef struct _LayoutCacheWidget LayoutCacheWidget;
+
+static guint    layout_cache_entry_hash  (gconstpointer     key);
+static gboolean layout_cache_entry_equal (gconstpointer     a,
+					  gconstpointer     b);
+static void     layout_cache_entry_free  (LayoutCacheEntry *entry);
+static void     layout_cache_widget_free (LayoutCacheWidget *cw);
+
 enum {
   EDITED,
   LAST_SIGNAL
@@ -124,6 +134,64 @@ static guint text_cell_renderer_signals [LAST_SIGNAL];
 
 #define GTK_CELL_RENDERER_TEXT_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_CELL_RENDERER_TEXT, GtkCellRendererTextPrivate))
 
+/* The number of layouts each renderer keeps around; enough for the
+ * visible rows of a large tree view column.
+ */
+#define LAYOUT_CACHE_SIZE 128
+
+/* Everything besides the text that goes into a layout.  The struct is
+ * cleared before it is filled in, so that it can be compared with
+ * memcmp().
+ */
+typedef struct _LayoutParams LayoutParams;
+struct _LayoutParams
+{
+  PangoContext *context;
+  PangoDirection base_dir;
+  gdouble resolution;
+  PangoLanguage *language;
+  gdouble font_scale;
+  PangoColor foreground;
+  gint has_foreground;
+  gint strikethrough;
+  gint underline;
+  gint rise_set;
+  gint rise;
+  gint single_paragraph;
+  PangoEllipsizeMode ellipsize;
+  PangoWrapMode wrap_mode;
+  PangoAlignment align;
+  gint width;
+};
+
+struct _LayoutCacheEntry
+{
+  LayoutParams params;
+  gchar *text;
+  gchar *markup;	/* the text and attributes come from it if set */
+  PangoAttrList *attrs;
+  PangoFontDescription *font;
+  PangoFontDescription *context_font;
+  cairo_font_options_t *font_options;
+  guint hash;
+
+  PangoLayout *layout;
+};
+
+/* A widget whose pango context is used by cached layouts.  The
+ * layouts keep the context alive, so entries are dropped when the
+ * widget goes away, and when the widget changes its context in
+ * place on style or direction changes.
+ */
+struct _LayoutCacheWidget
+{
+  GtkCellRendererText *celltext;
+  GtkWidget *widget;
+  PangoContext *context;
+  gulong style_set_id;
+  gulong direction_changed_id;
+};
+
 typedef struct _GtkCellRendererTextPrivate GtkCellRendererTextPrivate;
 struct _GtkCellRendererTextPrivate
 {
@@ -147,6 +215,15 @@ struct _GtkCellRendererTextPrivate
   gint wrap_width;
   
   GtkWidget *entry;
+
+  gchar *markup;
+
+  /* LayoutCacheEntry -> GList link in layout_lru, most recent first */
+  GHashTable *layout_cache;
+  GQueue *layout_lru;
+  GSList *layout_cache_widgets;
+  guint layout_cache_hits;
+  guint layout_cache_misses;
 };
 
 G_DEFINE_TYPE (GtkCellRendererText, gtk_cell_renderer_text, GTK_TYPE_CELL_RENDERER)
@@ -169,6 +246,10 @@ gtk_cell_renderer_text_init (GtkCellRendererText *celltext)
   priv->wrap_width = -1;
   priv->align = PANGO_ALIGN_LEFT;
   priv->align_set = FALSE;
+
+  priv->layout_cache = g_hash_table_new (layout_cache_entry_hash,
+					 layout_cache_entry_equal);
+  priv->layout_lru = g_queue_new ();
 }
 
 static void
@@ -596,6 +677,19 @@ gtk_cell_renderer_text_finalize (GObject *object)
   if (priv->language)
     g_object_unref (priv->language);
 
+  g_free (priv->markup);
+
+  GTK_NOTE (TREE,
+	    g_message ("GtkCellRendererText %p: %u layout cache hits, %u misses",
+		       object, priv->layout_cache_hits, priv->layout_cache_misses));
+
+  g_slist_foreach (priv->layout_cache_widgets, (GFunc) layout_cache_widget_free, NULL);
+  g_slist_free (priv->layout_cache_widgets);
+
+  g_queue_foreach (priv->layout_lru, (GFunc) layout_cache_entry_free, NULL);
+  g_queue_free (priv->layout_lru);
+  g_hash_table_destroy (priv->layout_cache);
+
   (* G_OBJECT_CLASS (gtk_cell_renderer_text_parent_class)->finalize) (object);
 }
 
@@ -1009,6 +1103,8 @@ gtk_cell_renderer_text_set_property (GObject      *object,
             pango_attr_list_unref (celltext->extra_attrs);
           celltext->extra_attrs = NULL;
           priv->markup_set = FALSE;
+          g_free (priv->markup);
+          priv->markup = NULL;
         }
 
       celltext->text = g_strdup (g_value_get_string (value));
@@ -1022,6 +1118,9 @@ gtk_cell_renderer_text_set_property (GObject      *object,
       celltext->extra_attrs = g_value_get_boxed (value);
       if (celltext->extra_attrs)
         pango_attr_list_ref (celltext->extra_attrs);
+
+      g_free (priv->markup);
+      priv->markup = NULL;
       break;
     case PROP_MARKUP:
       {
@@ -1054,6 +1153,9 @@ gtk_cell_renderer_text_set_property (GObject      *object,
 	celltext->text = text;
 	celltext->extra_attrs = attrs;
         priv->markup_set = TRUE;
+
+        g_free (priv->markup);
+        priv->markup = g_strdup (str);
       }
       break;
 
@@ -1344,10 +1446,11 @@ add_attr (PangoAttrList  *attr_list,
 }
 
 static PangoLayout*
-get_layout (GtkCellRendererText *celltext,
-            GtkWidget           *widget,
-            gboolean             will_render,
-            GtkCellRendererState flags)
+create_layout (GtkCellRendererText *celltext,
+               GtkWidget           *widget,
+               gboolean             will_render,
+               GtkCellRendererState flags,
+               gint                 width)
 {
   PangoAttrList *attr_list;
   PangoLayout *layout;
@@ -1431,16 +1534,12 @@ get_layout (GtkCellRendererText *celltext,
   else
     pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_NONE);
 
+  pango_layout_set_width (layout, width);
+
   if (priv->wrap_width != -1)
-    {
-      pango_layout_set_width (layout, priv->wrap_width * PANGO_SCALE);
-      pango_layout_set_wrap (layout, priv->wrap_mode);
-    }
+    pango_layout_set_wrap (layout, priv->wrap_mode);
   else
-    {
-      pango_layout_set_width (layout, -1);
-      pango_layout_set_wrap (layout, PANGO_WRAP_CHAR);
-    }
+    pango_layout_set_wrap (layout, PANGO_WRAP_CHAR);
 
   if (priv->align_set)
     pango_layout_set_alignment (layout, priv->align);
@@ -1463,6 +1562,339 @@ get_layout (GtkCellRendererText *celltext,
   return layout;
 }
 
+/* The width of the layout before ellipsizing */
+static gint
+get_layout_width (GtkCellRendererText *celltext)
+{
+  GtkCellRendererTextPrivate *priv;
+
+  priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (celltext);
+
+  if (priv->wrap_width != -1)
+    return priv->wrap_width * PANGO_SCALE;
+  else
+    return -1;
+}
+
+static gboolean
+str_equal (const gchar *a,
+           const gchar *b)
+{
+  if (a == b)
+    return TRUE;
+  if (a == NULL || b == NULL)
+    return FALSE;
+
+  return strcmp (a, b) == 0;
+}
+
+static guint
+layout_cache_entry_hash (gconstpointer key)
+{
+  const LayoutCacheEntry *entry = key;
+
+  return entry->hash;
+}
+
+static gboolean
+layout_cache_entry_equal (gconstpointer a,
+                          gconstpointer b)
+{
+  const LayoutCacheEntry *ea = a;
+  const LayoutCacheEntry *eb = b;
+
+  return ea->hash == eb->hash &&
+         memcmp (&ea->params, &eb->params, sizeof (LayoutParams)) == 0 &&
+         ea->attrs == eb->attrs &&
+         str_equal (ea->markup, eb->markup) &&
+         str_equal (ea->text, eb->text) &&
+         pango_font_description_equal (ea->font, eb->font) &&
+         pango_font_description_equal (ea->context_font, eb->context_font) &&
+         (ea->font_options == eb->font_options ||
+          (ea->font_options != NULL && eb->font_options != NULL &&
+           cairo_font_options_equal (ea->font_options, eb->font_options)));
+}
+
+static void
+layout_cache_entry_free (LayoutCacheEntry *entry)
+{
+  g_free (entry->text);
+  g_free (entry->markup);
+  if (entry->attrs)
+    pango_attr_list_unref (entry->attrs);
+  pango_font_description_free (entry->font);
+  pango_font_description_free (entry->context_font);
+  if (entry->font_options)
+    cairo_font_options_destroy (entry->font_options);
+  g_object_unref (entry->layout);
+
+  g_slice_free (LayoutCacheEntry, entry);
+}
+
+/* Drops the cached layouts that use @context */
+static void
+layout_cache_flush_context (GtkCellRendererText *celltext,
+                            PangoContext        *context)
+{
+  GtkCellRendererTextPrivate *priv;
+  GList *link;
+
+  priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (celltext);
+
+  link = priv->layout_lru->head;
+  while (link)
+    {
+      GList *next = link->next;
+      LayoutCacheEntry *entry = link->data;
+
+      if (entry->params.context == context)
+        {
+          g_hash_table_remove (priv->layout_cache, entry);
+          g_queue_delete_link (priv->layout_lru, link);
+          layout_cache_entry_free (entry);
+        }
+
+      link = next;
+    }
+}
+
+static void
+layout_cache_widget_style_set (GtkWidget         *widget,
+                               GtkStyle          *previous_style,
+                               LayoutCacheWidget *cw)
+{
+  layout_cache_flush_context (cw->celltext, cw->context);
+}
+
+static void
+layout_cache_widget_direction_changed (GtkWidget         *widget,
+                                       GtkTextDirection   previous_direction,
+                                       LayoutCacheWidget *cw)
+{
+  layout_cache_flush_context (cw->celltext, cw->context);
+}
+
+static void
+layout_cache_widget_finalized (gpointer  data,
+                               GObject  *where_the_object_was)
+{
+  LayoutCacheWidget *cw = data;
+  GtkCellRendererTextPrivate *priv;
+
+  priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (cw->celltext);
+
+  layout_cache_flush_context (cw->celltext, cw->context);
+
+  priv->layout_cache_widgets = g_slist_remove (priv->layout_cache_widgets, cw);
+  g_slice_free (LayoutCacheWidget, cw);
+}
+
+static void
+layout_cache_widget_free (LayoutCacheWidget *cw)
+{
+  g_signal_handler_disconnect (cw->widget, cw->style_set_id);
+  g_signal_handler_disconnect (cw->widget, cw->direction_changed_id);
+  g_object_weak_unref (G_OBJECT (cw->widget), layout_cache_widget_finalized, cw);
+
+  g_slice_free (LayoutCacheWidget, cw);
+}
+
+/* Starts watching @widget, unless we do already */
+static void
+layout_cache_watch_widget (GtkCellRendererText *celltext,
+                           GtkWidget           *widget,
+                           PangoContext        *context)
+{
+  GtkCellRendererTextPrivate *priv;
+  LayoutCacheWidget *cw;
+  GSList *l;
+
+  priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (celltext);
+
+  for (l = priv->layout_cache_widgets; l; l = l->next)
+    {
+      cw = l->data;
+      if (cw->widget == widget)
+        return;
+    }
+
+  cw = g_slice_new (LayoutCacheWidget);
+  cw->celltext = celltext;
+  cw->widget = widget;
+  cw->context = context;
+  cw->style_set_id =
+    g_signal_connect (widget, "style-set",
+                      G_CALLBACK (layout_cache_widget_style_set), cw);
+  cw->direction_changed_id =
+    g_signal_connect (widget, "direction-changed",
+                      G_CALLBACK (layout_cache_widget_direction_changed), cw);
+  g_object_weak_ref (G_OBJECT (widget), layout_cache_widget_finalized, cw);
+
+  priv->layout_cache_widgets = g_slist_prepend (priv->layout_cache_widgets, cw);
+}
+
+/* Fills in @key with everything create_layout() looks at, without
+ * copying anything.
+ */
+static void
+get_layout_cache_key (GtkCellRendererText *celltext,
+                      GtkWidget           *widget,
+                      gboolean             will_render,
+                      GtkCellRendererState flags,
+                      gint                 width,
+                      LayoutCacheEntry    *key)
+{
+  GtkCellRendererTextPrivate *priv;
+  LayoutParams *params = &key->params;
+  PangoUnderline uline;
+  const guchar *p;
+  guint hash;
+  guint i;
+
+  priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (celltext);
+
+  memset (params, 0, sizeof (LayoutParams));
+
+  params->context = gtk_widget_get_pango_context (widget);
+  params->base_dir = pango_context_get_base_dir (params->context);
+  params->resolution = pango_cairo_context_get_resolution (params->context);
+
+  if (will_render)
+    {
+      if (celltext->foreground_set
+	  && (flags & GTK_CELL_RENDERER_SELECTED) == 0)
+        {
+          params->has_foreground = TRUE;
+          params->foreground = celltext->foreground;
+        }
+
+      if (celltext->strikethrough_set)
+        params->strikethrough = celltext->strikethrough ? 2 : 1;
+    }
+
+  if (celltext->scale_set)
+    params->font_scale = celltext->font_scale;
+  else
+    params->font_scale = 1.0;
+
+  if (celltext->underline_set)
+    uline = celltext->underline_style;
+  else
+    uline = PANGO_UNDERLINE_NONE;
+
+  if ((flags & GTK_CELL_RENDERER_PRELIT) == GTK_CELL_RENDERER_PRELIT &&
+      (uline == PANGO_UNDERLINE_NONE || uline == PANGO_UNDERLINE_SINGLE))
+    uline++;
+
+  /* create_layout() adds underline_style if there is any underline */
+  if (uline != PANGO_UNDERLINE_NONE)
+    params->underline = celltext->underline_style + 1;
+
+  if (priv->language_set)
+    params->language = priv->language;
+
+  params->rise_set = celltext->rise_set;
+  if (celltext->rise_set)
+    params->rise = celltext->rise;
+
+  params->single_paragraph = priv->single_paragraph;
+  params->ellipsize = priv->ellipsize_set ? priv->ellipsize : PANGO_ELLIPSIZE_NONE;
+  params->wrap_mode = priv->wrap_width != -1 ? priv->wrap_mode : PANGO_WRAP_CHAR;
+
+  if (priv->align_set)
+    params->align = priv->align;
+  else if (gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL)
+    params->align = PANGO_ALIGN_RIGHT;
+  else
+    params->align = PANGO_ALIGN_LEFT;
+
+  params->width = width;
+
+  key->text = celltext->text;
+  key->markup = priv->markup;
+  key->attrs = priv->markup ? NULL : celltext->extra_attrs;
+  key->font = celltext->font;
+  key->context_font = pango_context_get_font_description (params->context);
+  key->font_options = (cairo_font_options_t *) pango_cairo_context_get_font_options (params->context);
+  key->layout = NULL;
+
+  hash = key->text ? g_str_hash (key->text) : 0;
+  if (key->markup)
+    hash ^= g_str_hash (key->markup);
+  hash ^= GPOINTER_TO_UINT (key->attrs);
+  hash ^= pango_font_description_hash (key->font);
+  if (key->font_options)
+    hash ^= cairo_font_options_hash (key->font_options);
+
+  p = (const guchar *) params;
+  for (i = 0; i < sizeof (LayoutParams); i++)
+    hash = (hash << 5) - hash + p[i];
+
+  key->hash = hash;
+}
+
+/* Returns a new reference to a layout for the current properties of
+ * @celltext.  Layouts are shared through a cache, so they must not be
+ * modified.
+ */
+static PangoLayout*
+get_layout (GtkCellRendererText *celltext,
+            GtkWidget           *widget,
+            gboolean             will_render,
+            GtkCellRendererState flags,
+            gint                 width)
+{
+  GtkCellRendererTextPrivate *priv;
+  LayoutCacheEntry key;
+  LayoutCacheEntry *entry;
+  GList *link;
+
+  priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (celltext);
+
+  get_layout_cache_key (celltext, widget, will_render, flags, width, &key);
+
+  link = g_hash_table_lookup (priv->layout_cache, &key);
+  if (link)
+    {
+      priv->layout_cache_hits++;
+
+      g_queue_unlink (priv->layout_lru, link);
+      g_queue_push_head_link (priv->layout_lru, link);
+
+      entry = link->data;
+      return g_object_ref (entry->layout);
+    }
+
+  priv->layout_cache_misses++;
+
+  entry = g_slice_new (LayoutCacheEntry);
+  *entry = key;
+  entry->text = g_strdup (key.text);
+  entry->markup = g_strdup (key.markup);
+  if (entry->attrs)
+    pango_attr_list_ref (entry->attrs);
+  entry->font = pango_font_description_copy (key.font);
+  entry->context_font = pango_font_description_copy (key.context_font);
+  if (key.font_options)
+    entry->font_options = cairo_font_options_copy (key.font_options);
+  entry->layout = create_layout (celltext, widget, will_render, flags, width);
+
+  layout_cache_watch_widget (celltext, widget, key.params.context);
+
+  g_queue_push_head (priv->layout_lru, entry);
+  g_hash_table_insert (priv->layout_cache, entry, priv->layout_lru->head);
+
+  while (priv->layout_lru->length > LAYOUT_CACHE_SIZE)
+    {
+      LayoutCacheEntry *old = g_queue_pop_tail (priv->layout_lru);
+
+      g_hash_table_remove (priv->layout_cache, old);
+      layout_cache_entry_free (old);
+    }
+
+  return g_object_ref (entry->layout);
+}
+
 static void
 get_size (GtkCellRenderer *cell,
 	  GtkWidget       *widget,
@@ -1521,7 +1953,8 @@ get_size (GtkCellRenderer *cell,
   if (layout)
     g_object_ref (layout);
   else
-    layout = get_layout (celltext, widget, FALSE, 0);
+    layout = get_layout (celltext, widget, FALSE, 0,
+                         get_layout_width (celltext));
 
   pango_layout_get_pixel_extents (layout, NULL, &rect);
 
@@ -1602,12 +2035,22 @@ gtk_cell_renderer_text_render (GtkCellRenderer      *cell,
   GtkStateType state;
   gint x_offset;
   gint y_offset;
+  gint width;
   GtkCellRendererTextPrivate *priv;
 
   priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (cell);
 
-  layout = get_layout (celltext, widget, TRUE, flags);
-  get_size (cell, widget, cell_area, layout, &x_offset, &y_offset, NULL, NULL);
+  /* the layout that was measured when the view was validated; this
+   * doesn't include the attributes that only affect appearance.
+   */
+  get_size (cell, widget, cell_area, NULL, &x_offset, &y_offset, NULL, NULL);
+
+  if (priv->ellipsize_set && priv->ellipsize != PANGO_ELLIPSIZE_NONE)
+    width = (cell_area->width - x_offset - 2 * cell->xpad) * PANGO_SCALE;
+  else
+    width = get_layout_width (celltext);
+
+  layout = get_layout (celltext, widget, TRUE, flags, width);
 
   if (!cell->sensitive) 
     {
@@ -1654,12 +2097,6 @@ gtk_cell_renderer_text_render (GtkCellRenderer      *cell,
       cairo_destroy (cr);
     }
 
-  if (priv->ellipsize_set && priv->ellipsize != PANGO_ELLIPSIZE_NONE)
-    pango_layout_set_width (layout, 
-			    (cell_area->width - x_offset - 2 * cell->xpad) * PANGO_SCALE);
-  else if (priv->wrap_width == -1)
-    pango_layout_set_width (layout, -1);
-
   gtk_paint_layout (widget->style,
                     window,
                     state,
@@ -0,0 +1,1754 @@
+/* gtkcolumnstore.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <gobject/gvaluecollector.h>
+#include "gtktreemodel.h"
+#include "gtkcolumnstore.h"
+#include "gtktreedatalist.h"
+#include "gtkintl.h"
+#include "gtkalias.h"
+
+/* STORAGE FORMAT:
+ *
+ * Every column keeps the values of all rows in one array, in the
+ * C type that g_value_get_<type>() returns for the fundamental type
+ * of the column; row i of a column is at data + i * elt_size.
+ * Strings are interned in a hash table that belongs to the store and
+ * counts the cells pointing to each of them, so equal strings are
+ * kept once and freed with the last cell; objects and boxed values
+ * hold a reference or a copy.
+ *
+ * An iter is the index of its row; user_data is GINT_TO_POINTER (row).
+ * Since removing or reordering rows moves the rows after them, the
+ * stamp changes whenever that happens and iters don't persist.
+ */
+
+typedef struct _ColumnData ColumnData;
+
+struct _ColumnData
+{
+  GType type;
+  GType fundamental;
+  guint elt_size;
+  guchar *data;
+};
+
+struct _GtkColumnStorePrivate
+{
+  gint stamp;
+
+  gint n_columns;
+  ColumnData *columns;
+
+  gint n_rows;
+  gint n_allocated;
+
+  GHashTable *strings;	/* string -> number of cells using it; the
+			 * strings are freed with the last cell */
+
+  GList *sort_list;
+  gint sort_column_id;
+  GtkSortType order;
+
+  GtkTreeIterCompareFunc default_sort_func;
+  gpointer default_sort_data;
+  GtkDestroyNotify default_sort_destroy;
+};
+
+#define GTK_COLUMN_STORE_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_COLUMN_STORE, GtkColumnStorePrivate))
+
+#define GTK_COLUMN_STORE_IS_SORTED(store) (((GtkColumnStore*)(store))->priv->sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+#define ITER_ROW(iter) (GPOINTER_TO_INT ((iter)->user_data))
+#define VALID_ITER(iter, store) ((iter) != NULL && (store)->priv->stamp == (iter)->stamp && ITER_ROW (iter) >= 0 && ITER_ROW (iter) < (store)->priv->n_rows)
+#define CELL(col, row) ((col)->data + (gsize) (row) * (col)->elt_size)
+
+static void         gtk_column_store_tree_model_init (GtkTreeModelIface *iface);
+static void         gtk_column_store_sortable_init   (GtkTreeSortableIface *iface);
+static void         gtk_column_store_finalize        (GObject           *object);
+static GtkTreeModelFlags gtk_column_store_get_flags  (GtkTreeModel      *tree_model);
+static gint         gtk_column_store_get_n_columns   (GtkTreeModel      *tree_model);
+static GType        gtk_column_store_get_column_type (GtkTreeModel      *tree_model,
+						      gint               index);
+static gboolean     gtk_column_store_get_iter        (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter,
+						      GtkTreePath       *path);
+static GtkTreePath *gtk_column_store_get_path        (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter);
+static void         gtk_column_store_get_value       (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter,
+						      gint               column,
+						      GValue            *value);
+static gboolean     gtk_column_store_iter_next       (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter);
+static gboolean     gtk_column_store_iter_children   (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter,
+						      GtkTreeIter       *parent);
+static gboolean     gtk_column_store_iter_has_child  (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter);
+static gint         gtk_column_store_iter_n_children (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter);
+static gboolean     gtk_column_store_iter_nth_child  (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter,
+						      GtkTreeIter       *parent,
+						      gint               n);
+static gboolean     gtk_column_store_iter_parent     (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter,
+						      GtkTreeIter       *child);
+
+static void gtk_column_store_increment_stamp (GtkColumnStore *column_store);
+
+
+/* sortable */
+static void     gtk_column_store_sort                  (GtkColumnStore         *column_store);
+static void     gtk_column_store_sort_iter_changed     (GtkColumnStore         *column_store,
+							GtkTreeIter            *iter);
+static gboolean gtk_column_store_get_sort_column_id    (GtkTreeSortable        *sortable,
+							gint                   *sort_column_id,
+							GtkSortType            *order);
+static void     gtk_column_store_set_sort_column_id    (GtkTreeSortable        *sortable,
+							gint                    sort_column_id,
+							GtkSortType             order);
+static void     gtk_column_store_set_sort_func         (GtkTreeSortable        *sortable,
+							gint                    sort_column_id,
+							GtkTreeIterCompareFunc  func,
+							gpointer                data,
+							GtkDestroyNotify        destroy);
+static void     gtk_column_store_set_default_sort_func (GtkTreeSortable        *sortable,
+							GtkTreeIterCompareFunc  func,
+							gpointer                data,
+							GtkDestroyNotify        destroy);
+static gboolean gtk_column_store_has_default_sort_func (GtkTreeSortable        *sortable);
+
+
+G_DEFINE_TYPE_WITH_CODE (GtkColumnStore, gtk_column_store, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
+						gtk_column_store_tree_model_init)
+			 G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_SORTABLE,
+						gtk_column_store_sortable_init))
+
+static void
+gtk_column_store_class_init (GtkColumnStoreClass *class)
+{
+  GObjectClass *object_class;
+
+  object_class = (GObjectClass*) class;
+
+  object_class->finalize = gtk_column_store_finalize;
+
+  g_type_class_add_private (object_class, sizeof (GtkColumnStorePrivate));
+}
+
+static void
+gtk_column_store_tree_model_init (GtkTreeModelIface *iface)
+{
+  iface->get_flags = gtk_column_store_get_flags;
+  iface->get_n_columns = gtk_column_store_get_n_columns;
+  iface->get_column_type = gtk_column_store_get_column_type;
+  iface->get_iter = gtk_column_store_get_iter;
+  iface->get_path = gtk_column_store_get_path;
+  iface->get_value = gtk_column_store_get_value;
+  iface->iter_next = gtk_column_store_iter_next;
+  iface->iter_children = gtk_column_store_iter_children;
+  iface->iter_has_child = gtk_column_store_iter_has_child;
+  iface->iter_n_children = gtk_column_store_iter_n_children;
+  iface->iter_nth_child = gtk_column_store_iter_nth_child;
+  iface->iter_parent = gtk_column_store_iter_parent;
+}
+
+static void
+gtk_column_store_sortable_init (GtkTreeSortableIface *iface)
+{
+  iface->get_sort_column_id = gtk_column_store_get_sort_column_id;
+  iface->set_sort_column_id = gtk_column_store_set_sort_column_id;
+  iface->set_sort_func = gtk_column_store_set_sort_func;
+  iface->set_default_sort_func = gtk_column_store_set_default_sort_func;
+  iface->has_default_sort_func = gtk_column_store_has_default_sort_func;
+}
+
+static void
+gtk_column_store_init (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv;
+
+  priv = column_store->priv = GTK_COLUMN_STORE_GET_PRIVATE (column_store);
+
+  priv->stamp = g_random_int ();
+  priv->sort_column_id = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
+  priv->strings = g_hash_table_new (g_str_hash, g_str_equal);
+}
+
+static GType
+get_fundamental_type (GType type)
+{
+  GType result;
+
+  result = G_TYPE_FUNDAMENTAL (type);
+
+  if (result == G_TYPE_INTERFACE)
+    {
+      if (g_type_is_a (type, G_TYPE_OBJECT))
+	result = G_TYPE_OBJECT;
+    }
+
+  return result;
+}
+
+static guint
+get_element_size (GType fundamental)
+{
+  switch (fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      return sizeof (gboolean);
+    case G_TYPE_CHAR:
+      return sizeof (gchar);
+    case G_TYPE_UCHAR:
+      return sizeof (guchar);
+    case G_TYPE_INT:
+    case G_TYPE_ENUM:
+      return sizeof (gint);
+    case G_TYPE_UINT:
+    case G_TYPE_FLAGS:
+      return sizeof (guint);
+    case G_TYPE_LONG:
+      return sizeof (glong);
+    case G_TYPE_ULONG:
+      return sizeof (gulong);
+    case G_TYPE_INT64:
+      return sizeof (gint64);
+    case G_TYPE_UINT64:
+      return sizeof (guint64);
+    case G_TYPE_FLOAT:
+      return sizeof (gfloat);
+    case G_TYPE_DOUBLE:
+      return sizeof (gdouble);
+    case G_TYPE_STRING:
+    case G_TYPE_POINTER:
+    case G_TYPE_BOXED:
+    case G_TYPE_OBJECT:
+    default:
+      return sizeof (gpointer);
+    }
+}
+
+static gboolean
+gtk_column_store_set_columns (GtkColumnStore *column_store,
+			      gint            n_columns,
+			      GType          *types)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  for (i = 0; i < n_columns; i++)
+    if (! _gtk_tree_data_list_check_type (types[i]))
+      {
+	g_warning ("%s: Invalid type %s\n", G_STRLOC, g_type_name (types[i]));
+	return FALSE;
+      }
+
+  priv->n_columns = n_columns;
+  priv->columns = g_new0 (ColumnData, n_columns);
+
+  for (i = 0; i < n_columns; i++)
+    {
+      priv->columns[i].type = types[i];
+      priv->columns[i].fundamental = get_fundamental_type (types[i]);
+      priv->columns[i].elt_size = get_element_size (priv->columns[i].fundamental);
+    }
+
+  priv->sort_list = _gtk_tree_data_list_header_new (n_columns, types);
+
+  return TRUE;
+}
+
+/**
+ * gtk_column_store_new:
+ * @n_columns: number of columns in the column store
+ * @Varargs: all #GType types for the columns, from first to last
+ *
+ * Creates a new column store with @n_columns columns each of the types
+ * passed in.  The same types as for #GtkListStore are supported.
+ *
+ * Unlike #GtkListStore, a #GtkColumnStore keeps the values of each
+ * column in one array, so that large tables of numbers and strings
+ * take little memory and are quick to read and to sort.
+ * Inserting or removing rows anywhere but at the end has to move
+ * the rows after them, and iters don't persist across such changes.
+ *
+ * Return value: a new #GtkColumnStore
+ *
+ * Since: 2.12
+ **/
+GtkColumnStore *
+gtk_column_store_new (gint n_columns,
+		      ...)
+{
+  GtkColumnStore *retval;
+  GType *types;
+  va_list args;
+  gint i;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+
+  types = g_new (GType, n_columns);
+
+  va_start (args, n_columns);
+
+  for (i = 0; i < n_columns; i++)
+    types[i] = va_arg (args, GType);
+
+  va_end (args);
+
+  retval = gtk_column_store_newv (n_columns, types);
+  g_free (types);
+
+  return retval;
+}
+
+/**
+ * gtk_column_store_newv:
+ * @n_columns: number of columns in the column store
+ * @types: an array of #GType types for the columns, from first to last
+ *
+ * Non-vararg creation function.  Used primarily by language bindings.
+ *
+ * Return value: a new #GtkColumnStore
+ *
+ * Since: 2.12
+ **/
+GtkColumnStore *
+gtk_column_store_newv (gint   n_columns,
+		       GType *types)
+{
+  GtkColumnStore *retval;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+
+  retval = g_object_new (GTK_TYPE_COLUMN_STORE, NULL);
+
+  if (!gtk_column_store_set_columns (retval, n_columns, types))
+    {
+      g_object_unref (retval);
+      return NULL;
+    }
+
+  return retval;
+}
+
+/* Returns the store's copy of @str, for one more cell */
+static gchar *
+gtk_column_store_intern (GtkColumnStore *column_store,
+			 const gchar    *str)
+{
+  GHashTable *strings = column_store->priv->strings;
+  gpointer key, count;
+
+  if (!str)
+    return NULL;
+
+  if (g_hash_table_lookup_extended (strings, str, &key, &count))
+    g_hash_table_insert (strings, key, GUINT_TO_POINTER (GPOINTER_TO_UINT (count) + 1));
+  else
+    {
+      key = g_strdup (str);
+      g_hash_table_insert (strings, key, GUINT_TO_POINTER (1));
+    }
+
+  return key;
+}
+
+static void
+gtk_column_store_unintern (GtkColumnStore *column_store,
+			   gchar          *str)
+{
+  GHashTable *strings = column_store->priv->strings;
+  guint count;
+
+  count = GPOINTER_TO_UINT (g_hash_table_lookup (strings, str));
+  g_assert (count > 0);
+
+  if (count == 1)
+    {
+      g_hash_table_remove (strings, str);
+      g_free (str);
+    }
+  else
+    g_hash_table_insert (strings, str, GUINT_TO_POINTER (count - 1));
+}
+
+/* Drops the reference or copy held by a cell */
+static void
+gtk_column_store_release_cell (GtkColumnStore *column_store,
+			       ColumnData     *col,
+			       gint            row)
+{
+  gpointer *cell;
+
+  if (col->fundamental != G_TYPE_STRING &&
+      col->fundamental != G_TYPE_OBJECT &&
+      col->fundamental != G_TYPE_BOXED)
+    return;
+
+  cell = (gpointer *) CELL (col, row);
+  if (*cell)
+    {
+      if (col->fundamental == G_TYPE_STRING)
+	gtk_column_store_unintern (column_store, *cell);
+      else if (col->fundamental == G_TYPE_OBJECT)
+	g_object_unref (*cell);
+      else
+	g_boxed_free (col->type, *cell);
+      *cell = NULL;
+    }
+}
+
+static void
+gtk_column_store_release_rows (GtkColumnStore *column_store,
+			       gint            first_row,
+			       gint            n_rows)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i, row;
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      ColumnData *col = &priv->columns[i];
+
+      if (col->fundamental != G_TYPE_STRING &&
+	  col->fundamental != G_TYPE_OBJECT &&
+	  col->fundamental != G_TYPE_BOXED)
+	continue;
+
+      for (row = first_row; row < first_row + n_rows; row++)
+	gtk_column_store_release_cell (column_store, col, row);
+    }
+}
+
+static void
+gtk_column_store_finalize (GObject *object)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (object);
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  gtk_column_store_release_rows (column_store, 0, priv->n_rows);
+
+  for (i = 0; i < priv->n_columns; i++)
+    g_free (priv->columns[i].data);
+  g_free (priv->columns);
+
+  g_hash_table_destroy (priv->strings);
+
+  if (priv->sort_list)
+    _gtk_tree_data_list_header_free (priv->sort_list);
+
+  if (priv->default_sort_destroy)
+    {
+      GtkDestroyNotify d = priv->default_sort_destroy;
+
+      priv->default_sort_destroy = NULL;
+      d (priv->default_sort_data);
+      priv->default_sort_data = NULL;
+    }
+
+  /* must chain up */
+  (* G_OBJECT_CLASS (gtk_column_store_parent_class)->finalize) (object);
+}
+
+/* Fulfill the GtkTreeModel requirements */
+static GtkTreeModelFlags
+gtk_column_store_get_flags (GtkTreeModel *tree_model)
+{
+  return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint
+gtk_column_store_get_n_columns (GtkTreeModel *tree_model)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+
+  return column_store->priv->n_columns;
+}
+
+static GType
+gtk_column_store_get_column_type (GtkTreeModel *tree_model,
+				  gint          index)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+
+  g_return_val_if_fail (index < column_store->priv->n_columns,
+			G_TYPE_INVALID);
+
+  return column_store->priv->columns[index].type;
+}
+
+static gboolean
+gtk_column_store_get_iter (GtkTreeModel *tree_model,
+			   GtkTreeIter  *iter,
+			   GtkTreePath  *path)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+  gint i;
+
+  i = gtk_tree_path_get_indices (path)[0];
+
+  if (i >= column_store->priv->n_rows)
+    return FALSE;
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (i);
+
+  return TRUE;
+}
+
+static GtkTreePath *
+gtk_column_store_get_path (GtkTreeModel *tree_model,
+			   GtkTreeIter  *iter)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+  GtkTreePath *path;
+
+  g_return_val_if_fail (iter->stamp == column_store->priv->stamp, NULL);
+
+  if (ITER_ROW (iter) >= column_store->priv->n_rows)
+    return NULL;
+
+  path = gtk_tree_path_new ();
+  gtk_tree_path_append_index (path, ITER_ROW (iter));
+
+  return path;
+}
+
+static void
+gtk_column_store_get_value (GtkTreeModel *tree_model,
+			    GtkTreeIter  *iter,
+			    gint          column,
+			    GValue       *value)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+  ColumnData *col;
+  guchar *cell;
+
+  g_return_if_fail (column < column_store->priv->n_columns);
+  g_return_if_fail (VALID_ITER (iter, column_store));
+
+  col = &column_store->priv->columns[column];
+  cell = CELL (col, ITER_ROW (iter));
+
+  g_value_init (value, col->type);
+
+  switch (col->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      g_value_set_boolean (value, *(gboolean *) cell);
+      break;
+    case G_TYPE_CHAR:
+      g_value_set_char (value, *(gchar *) cell);
+      break;
+    case G_TYPE_UCHAR:
+      g_value_set_uchar (value, *(guchar *) cell);
+      break;
+    case G_TYPE_INT:
+      g_value_set_int (value, *(gint *) cell);
+      break;
+    case G_TYPE_UINT:
+      g_value_set_uint (value, *(guint *) cell);
+      break;
+    case G_TYPE_LONG:
+      g_value_set_long (value, *(glong *) cell);
+      break;
+    case G_TYPE_ULONG:
+      g_value_set_ulong (value, *(gulong *) cell);
+      break;
+    case G_TYPE_INT64:
+      g_value_set_int64 (value, *(gint64 *) cell);
+      break;
+    case G_TYPE_UINT64:
+      g_value_set_uint64 (value, *(guint64 *) cell);
+      break;
+    case G_TYPE_ENUM:
+      g_value_set_enum (value, *(gint *) cell);
+      break;
+    case G_TYPE_FLAGS:
+      g_value_set_flags (value, *(guint *) cell);
+      break;
+    case G_TYPE_FLOAT:
+      g_value_set_float (value, *(gfloat *) cell);
+      break;
+    case G_TYPE_DOUBLE:
+      g_value_set_double (value, *(gdouble *) cell);
+      break;
+    case G_TYPE_STRING:
+      g_value_set_string (value, *(gchar **) cell);
+      break;
+    case G_TYPE_POINTER:
+      g_value_set_pointer (value, *(gpointer *) cell);
+      break;
+    case G_TYPE_BOXED:
+      g_value_set_boxed (value, *(gpointer *) cell);
+      break;
+    case G_TYPE_OBJECT:
+      g_value_set_object (value, *(GObject **) cell);
+      break;
+    default:
+      g_warning ("%s: Unsupported type (%s) retrieved.", G_STRLOC, g_type_name (value->g_type));
+      break;
+    }
+}
+
+static gboolean
+gtk_column_store_iter_next (GtkTreeModel  *tree_model,
+			    GtkTreeIter   *iter)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+
+  g_return_val_if_fail (column_store->priv->stamp == iter->stamp, FALSE);
+
+  if (ITER_ROW (iter) + 1 >= column_store->priv->n_rows)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->user_data = GINT_TO_POINTER (ITER_ROW (iter) + 1);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_children (GtkTreeModel *tree_model,
+				GtkTreeIter  *iter,
+				GtkTreeIter  *parent)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+
+  /* this is a list, nodes have no children */
+  if (parent)
+    return FALSE;
+
+  if (column_store->priv->n_rows > 0)
+    {
+      iter->stamp = column_store->priv->stamp;
+      iter->user_data = GINT_TO_POINTER (0);
+      return TRUE;
+    }
+  else
+    return FALSE;
+}
+
+static gboolean
+gtk_column_store_iter_has_child (GtkTreeModel *tree_model,
+				 GtkTreeIter  *iter)
+{
+  return FALSE;
+}
+
+static gint
+gtk_column_store_iter_n_children (GtkTreeModel *tree_model,
+				  GtkTreeIter  *iter)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+
+  if (iter == NULL)
+    return column_store->priv->n_rows;
+
+  g_return_val_if_fail (column_store->priv->stamp == iter->stamp, -1);
+
+  return 0;
+}
+
+static gboolean
+gtk_column_store_iter_nth_child (GtkTreeModel *tree_model,
+				 GtkTreeIter  *iter,
+				 GtkTreeIter  *parent,
+				 gint          n)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+
+  if (parent)
+    return FALSE;
+
+  if (n < 0 || n >= column_store->priv->n_rows)
+    return FALSE;
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (n);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_parent (GtkTreeModel *tree_model,
+			      GtkTreeIter  *iter,
+			      GtkTreeIter  *child)
+{
+  return FALSE;
+}
+
+static void
+gtk_column_store_increment_stamp (GtkColumnStore *column_store)
+{
+  do
+    {
+      column_store->priv->stamp++;
+    }
+  while (column_store->priv->stamp == 0);
+}
+
+/* Row storage */
+
+static void
+gtk_column_store_grow (GtkColumnStore *column_store,
+		       gint            n_rows)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint n_allocated;
+  gint i;
+
+  if (n_rows <= priv->n_allocated)
+    return;
+
+  n_allocated = MAX (priv->n_allocated * 2, 16);
+  n_allocated = MAX (n_allocated, n_rows);
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      ColumnData *col = &priv->columns[i];
+
+      col->data = g_realloc (col->data, (gsize) n_allocated * col->elt_size);
+    }
+
+  priv->n_allocated = n_allocated;
+}
+
+/* Makes room for @n_rows empty rows at @position */
+static void
+gtk_column_store_insert_rows (GtkColumnStore *column_store,
+			      gint            position,
+			      gint            n_rows)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  gtk_column_store_grow (column_store, priv->n_rows + n_rows);
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      ColumnData *col = &priv->columns[i];
+
+      if (position < priv->n_rows)
+	g_memmove (CELL (col, position + n_rows), CELL (col, position),
+		   (gsize) (priv->n_rows - position) * col->elt_size);
+      memset (CELL (col, position), 0, (gsize) n_rows * col->elt_size);
+    }
+
+  priv->n_rows += n_rows;
+}
+
+static void
+gtk_column_store_remove_row (GtkColumnStore *column_store,
+			     gint            row)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  gtk_column_store_release_rows (column_store, row, 1);
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      ColumnData *col = &priv->columns[i];
+
+      g_memmove (CELL (col, row), CELL (col, row + 1),
+		 (gsize) (priv->n_rows - row - 1) * col->elt_size);
+    }
+
+  priv->n_rows--;
+}
+
+/* Moves row @from to @to, shifting the rows in between by one */
+static void
+gtk_column_store_move_row (GtkColumnStore *column_store,
+			   gint            from,
+			   gint            to)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  guchar tmp[16];
+  gint i;
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      ColumnData *col = &priv->columns[i];
+
+      memcpy (tmp, CELL (col, from), col->elt_size);
+      if (from < to)
+	g_memmove (CELL (col, from), CELL (col, from + 1),
+		   (gsize) (to - from) * col->elt_size);
+      else
+	g_memmove (CELL (col, to + 1), CELL (col, to),
+		   (gsize) (from - to) * col->elt_size);
+      memcpy (CELL (col, to), tmp, col->elt_size);
+    }
+}
+
+/* Stores @value, which holds the type of the column, in a cell */
+static void
+gtk_column_store_value_to_cell (GtkColumnStore *column_store,
+				ColumnData     *col,
+				gint            row,
+				const GValue   *value)
+{
+  guchar *cell = CELL (col, row);
+
+  switch (col->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      *(gboolean *) cell = g_value_get_boolean (value);
+      break;
+    case G_TYPE_CHAR:
+      *(gchar *) cell = g_value_get_char (value);
+      break;
+    case G_TYPE_UCHAR:
+      *(guchar *) cell = g_value_get_uchar (value);
+      break;
+    case G_TYPE_INT:
+      *(gint *) cell = g_value_get_int (value);
+      break;
+    case G_TYPE_UINT:
+      *(guint *) cell = g_value_get_uint (value);
+      break;
+    case G_TYPE_LONG:
+      *(glong *) cell = g_value_get_long (value);
+      break;
+    case G_TYPE_ULONG:
+      *(gulong *) cell = g_value_get_ulong (value);
+      break;
+    case G_TYPE_INT64:
+      *(gint64 *) cell = g_value_get_int64 (value);
+      break;
+    case G_TYPE_UINT64:
+      *(guint64 *) cell = g_value_get_uint64 (value);
+      break;
+    case G_TYPE_ENUM:
+      *(gint *) cell = g_value_get_enum (value);
+      break;
+    case G_TYPE_FLAGS:
+      *(guint *) cell = g_value_get_flags (value);
+      break;
+    case G_TYPE_FLOAT:
+      *(gfloat *) cell = g_value_get_float (value);
+      break;
+    case G_TYPE_DOUBLE:
+      *(gdouble *) cell = g_value_get_double (value);
+      break;
+    case G_TYPE_STRING:
+      {
+	gchar *str = gtk_column_store_intern (column_store,
+					      g_value_get_string (value));
+
+	gtk_column_store_release_cell (column_store, col, row);
+	*(gchar **) cell = str;
+      }
+      break;
+    case G_TYPE_POINTER:
+      *(gpointer *) cell = g_value_get_pointer (value);
+      break;
+    case G_TYPE_BOXED:
+      {
+	gpointer copy = g_value_dup_boxed (value);
+
+	gtk_column_store_release_cell (column_store, col, row);
+	*(gpointer *) cell = copy;
+      }
+      break;
+    case G_TYPE_OBJECT:
+      {
+	gpointer object = g_value_dup_object (value);
+
+	gtk_column_store_release_cell (column_store, col, row);
+	*(gpointer *) cell = object;
+      }
+      break;
+    default:
+      g_warning ("%s: Unsupported type (%s) stored.", G_STRLOC, g_type_name (G_VALUE_TYPE (value)));
+      break;
+    }
+}
+
+/* Compares two rows of a column like _gtk_tree_data_list_compare_func()
+ * does, without going through GValues.
+ */
+static gint
+gtk_column_store_compare_cells (ColumnData *col,
+				gint        a,
+				gint        b)
+{
+#define COMPARE_CELLS(ctype) G_STMT_START {		\
+    ctype va = *(ctype *) CELL (col, a);		\
+    ctype vb = *(ctype *) CELL (col, b);		\
+    return va < vb ? -1 : (va == vb ? 0 : 1);		\
+  } G_STMT_END
+
+  const gchar *stra, *strb;
+
+  switch (col->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      COMPARE_CELLS (gboolean);
+    case G_TYPE_CHAR:
+      COMPARE_CELLS (gchar);
+    case G_TYPE_UCHAR:
+      COMPARE_CELLS (guchar);
+    case G_TYPE_INT:
+    case G_TYPE_ENUM:
+      COMPARE_CELLS (gint);
+    case G_TYPE_UINT:
+    case G_TYPE_FLAGS:
+      COMPARE_CELLS (guint);
+    case G_TYPE_LONG:
+      COMPARE_CELLS (glong);
+    case G_TYPE_ULONG:
+      COMPARE_CELLS (gulong);
+    case G_TYPE_INT64:
+      COMPARE_CELLS (gint64);
+    case G_TYPE_UINT64:
+      COMPARE_CELLS (guint64);
+    case G_TYPE_FLOAT:
+      COMPARE_CELLS (gfloat);
+    case G_TYPE_DOUBLE:
+      COMPARE_CELLS (gdouble);
+    case G_TYPE_STRING:
+      stra = *(const gchar **) CELL (col, a);
+      strb = *(const gchar **) CELL (col, b);
+      if (stra == strb)
+	return 0;
+      if (stra == NULL) stra = "";
+      if (strb == NULL) strb = "";
+      return g_utf8_collate (stra, strb);
+    case G_TYPE_POINTER:
+    case G_TYPE_BOXED:
+    case G_TYPE_OBJECT:
+    default:
+      g_warning ("Attempting to sort on invalid type %s\n", g_type_name (col->type));
+      return 0;
+    }
+
+#undef COMPARE_CELLS
+}
+
+static gboolean
+gtk_column_store_real_set_value (GtkColumnStore *column_store,
+				 gint            row,
+				 gint            column,
+				 GValue         *value)
+{
+  ColumnData *col = &column_store->priv->columns[column];
+  GValue real_value = {0, };
+
+  if (! g_type_is_a (G_VALUE_TYPE (value), col->type))
+    {
+      if (! (g_value_type_compatible (G_VALUE_TYPE (value), col->type) &&
+	     g_value_type_compatible (col->type, G_VALUE_TYPE (value))))
+	{
+	  g_warning ("%s: Unable to convert from %s to %s\n",
+		     G_STRLOC,
+		     g_type_name (G_VALUE_TYPE (value)),
+		     g_type_name (col->type));
+	  return FALSE;
+	}
+      g_value_init (&real_value, col->type);
+      if (!g_value_transform (value, &real_value))
+	{
+	  g_warning ("%s: Unable to make conversion from %s to %s\n",
+		     G_STRLOC,
+		     g_type_name (G_VALUE_TYPE (value)),
+		     g_type_name (col->type));
+	  g_value_unset (&real_value);
+	  return FALSE;
+	}
+
+      gtk_column_store_value_to_cell (column_store, col, row, &real_value);
+      g_value_unset (&real_value);
+    }
+  else
+    gtk_column_store_value_to_cell (column_store, col, row, value);
+
+  return TRUE;
+}
+
+static GtkTreeIterCompareFunc
+gtk_column_store_get_compare_func (GtkColumnStore *column_store,
+				   gpointer       *data)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  if (!GTK_COLUMN_STORE_IS_SORTED (column_store))
+    return NULL;
+
+  if (priv->sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+    {
+      GtkTreeDataSortHeader *header;
+
+      header = _gtk_tree_data_list_get_header (priv->sort_list,
+					       priv->sort_column_id);
+      g_return_val_if_fail (header != NULL, NULL);
+      g_return_val_if_fail (header->func != NULL, NULL);
+
+      if (data)
+	*data = header->data;
+      return header->func;
+    }
+
+  if (data)
+    *data = priv->default_sort_data;
+  return priv->default_sort_func;
+}
+
+/* Whether changing @column may move a row in the sort order */
+static gboolean
+gtk_column_store_column_affects_sort (GtkColumnStore *column_store,
+				      gint            column)
+{
+  GtkTreeIterCompareFunc func;
+
+  func = gtk_column_store_get_compare_func (column_store, NULL);
+
+  if (func == NULL)
+    return FALSE;
+
+  if (func != _gtk_tree_data_list_compare_func)
+    return TRUE;
+
+  return column == column_store->priv->sort_column_id;
+}
+
+static void
+gtk_column_store_row_changed (GtkColumnStore *column_store,
+			      GtkTreeIter    *iter,
+			      gboolean        resort)
+{
+  GtkTreePath *path;
+
+  if (resort)
+    {
+      gtk_column_store_sort_iter_changed (column_store, iter);
+      return;
+    }
+
+  path = gtk_column_store_get_path (GTK_TREE_MODEL (column_store), iter);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (column_store), path, iter);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_column_store_set_value:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @column: column number to modify
+ * @value: new value for the cell
+ *
+ * Sets the data in the cell specified by @iter and @column.
+ * The type of @value must be convertible to the type of the
+ * column.  If the store is sorted and the row moves, @iter is
+ * updated to point to its new position.
+ *
+ * Since: 2.12
+ **/
+void
+gtk_column_store_set_value (GtkColumnStore *column_store,
+			    GtkTreeIter    *iter,
+			    gint            column,
+			    GValue         *value)
+{
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (VALID_ITER (iter, column_store));
+  g_return_if_fail (column >= 0 && column < column_store->priv->n_columns);
+  g_return_if_fail (G_IS_VALUE (value));
+
+  if (gtk_column_store_real_set_value (column_store, ITER_ROW (iter), column, value))
+    gtk_column_store_row_changed (column_store, iter,
+				  gtk_column_store_column_affects_sort (column_store, column));
+}
+
+/**
+ * gtk_column_store_set_valist:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @var_args: va_list of column/value pairs
+ *
+ * See gtk_column_store_set(); this version takes a va_list for use by
+ * language bindings.
+ *
+ * Since: 2.12
+ **/
+void
+gtk_column_store_set_valist (GtkColumnStore *column_store,
+			     GtkTreeIter    *iter,
+			     va_list         var_args)
+{
+  gboolean emit_signal = FALSE;
+  gboolean need_sort = FALSE;
+  gint column;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (VALID_ITER (iter, column_store));
+
+  column = va_arg (var_args, gint);
+
+  while (column != -1)
+    {
+      GValue value = { 0, };
+      gchar *error = NULL;
+
+      if (column < 0 || column >= column_store->priv->n_columns)
+	{
+	  g_warning ("%s: Invalid column number %d added to iter (remember to end your list of columns with a -1)", G_STRLOC, column);
+	  break;
+	}
+      g_value_init (&value, column_store->priv->columns[column].type);
+
+      G_VALUE_COLLECT (&value, var_args, 0, &error);
+      if (error)
+	{
+	  g_warning ("%s: %s", G_STRLOC, error);
+	  g_free (error);
+
+ 	  /* we purposely leak the value here, it might not be
+	   * in a sane state if an error condition occoured
+	   */
+	  break;
+	}
+
+      if (gtk_column_store_real_set_value (column_store, ITER_ROW (iter),
+					   column, &value))
+	{
+	  emit_signal = TRUE;
+	  need_sort = need_sort ||
+	    gtk_column_store_column_affects_sort (column_store, column);
+	}
+
+      g_value_unset (&value);
+
+      column = va_arg (var_args, gint);
+    }
+
+  if (emit_signal)
+    gtk_column_store_row_changed (column_store, iter, need_sort);
+}
+
+/**
+ * gtk_column_store_set:
+ * @column_store: a #GtkColumnStore
+ * @iter: row iterator
+ * @Varargs: pairs of column number and value, terminated with -1
+ *
+ * Sets the value of one or more cells in the row referenced by @iter.
+ * The variable argument list should contain integer column numbers,
+ * each column number followed by the value to be set.
+ * The list is terminated by a -1.
+ *
+ * Since: 2.12
+ **/
+void
+gtk_column_store_set (GtkColumnStore *column_store,
+		      GtkTreeIter    *iter,
+		      ...)
+{
+  va_list var_args;
+
+  va_start (var_args, iter);
+  gtk_column_store_set_valist (column_store, iter, var_args);
+  va_end (var_args);
+}
+
+/**
+ * gtk_column_store_set_column_from_array:
+ * @column_store: A #GtkColumnStore
+ * @column: column number to modify
+ * @first_row: the first row to modify
+ * @n_rows: the number of rows to modify
+ * @values: an array of @n_rows values
+ *
+ * Sets the cells of @column in the rows from @first_row to
+ * @first_row + @n_rows - 1 to the values in @values.  The elements of
+ * @values have the C type that g_value_get_<type>() returns for the
+ * column type, e.g. #gint for %G_TYPE_INT, #gdouble for %G_TYPE_DOUBLE,
+ * a <type>const gchar *</type> for %G_TYPE_STRING, or a #GObject pointer
+ * for object columns.  Strings are copied, or shared with the cells
+ * holding an equal string; objects are referenced and boxed values
+ * are copied.
+ *
+ * Together with gtk_column_store_append_rows(), this is the fastest way
+ * to fill a large store; numeric columns are copied in one go. If the
+ * store is sorted on @column, it is sorted once afterwards.
+ *
+ * Since: 2.12
+ **/
+void
+gtk_column_store_set_column_from_array (GtkColumnStore *column_store,
+					gint            column,
+					gint            first_row,
+					gint            n_rows,
+					gconstpointer   values)
+{
+  GtkColumnStorePrivate *priv;
+  ColumnData *col;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  const guchar *src;
+  gint i;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  priv = column_store->priv;
+
+  g_return_if_fail (column >= 0 && column < priv->n_columns);
+  g_return_if_fail (first_row >= 0 && n_rows >= 0);
+  g_return_if_fail (first_row + n_rows <= priv->n_rows);
+  g_return_if_fail (values != NULL || n_rows == 0);
+
+  if (n_rows == 0)
+    return;
+
+  col = &priv->columns[column];
+  src = values;
+
+  switch (col->fundamental)
+    {
+    case G_TYPE_STRING:
+      for (i = 0; i < n_rows; i++)
+	{
+	  gchar *str = gtk_column_store_intern (column_store,
+						((const gchar * const *) src)[i]);
+
+	  gtk_column_store_release_cell (column_store, col, first_row + i);
+	  *(gchar **) CELL (col, first_row + i) = str;
+	}
+      break;
+    case G_TYPE_BOXED:
+    case G_TYPE_OBJECT:
+      for (i = 0; i < n_rows; i++)
+	{
+	  gpointer p = ((const gpointer *) src)[i];
+
+	  if (p)
+	    p = col->fundamental == G_TYPE_OBJECT ?
+	      g_object_ref (p) : g_boxed_copy (col->type, p);
+
+	  gtk_column_store_release_cell (column_store, col, first_row + i);
+	  *(gpointer *) CELL (col, first_row + i) = p;
+	}
+      break;
+    default:
+      memcpy (CELL (col, first_row), src, (gsize) n_rows * col->elt_size);
+      break;
+    }
+
+  path = gtk_tree_path_new ();
+  gtk_tree_path_append_index (path, first_row);
+  iter.stamp = priv->stamp;
+
+  for (i = first_row; i < first_row + n_rows; i++)
+    {
+      iter.user_data = GINT_TO_POINTER (i);
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (column_store), path, &iter);
+      gtk_tree_path_next (path);
+    }
+
+  gtk_tree_path_free (path);
+
+  if (gtk_column_store_column_affects_sort (column_store, column))
+    gtk_column_store_sort (column_store);
+}
+
+/**
+ * gtk_column_store_remove:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter
+ *
+ * Removes the given row from the column store.  After being removed,
+ * @iter is set to be the next valid row, or invalidated if it pointed
+ * to the last row in @column_store.  All other iters become invalid.
+ *
+ * Return value: %TRUE if @iter is valid, %FALSE if not.
+ *
+ * Since: 2.12
+ **/
+gboolean
+gtk_column_store_remove (GtkColumnStore *column_store,
+			 GtkTreeIter    *iter)
+{
+  GtkTreePath *path;
+  gint row;
+
+  g_return_val_if_fail (GTK_IS_COLUMN_STORE (column_store), FALSE);
+  g_return_val_if_fail (VALID_ITER (iter, column_store), FALSE);
+
+  row = ITER_ROW (iter);
+  path = gtk_column_store_get_path (GTK_TREE_MODEL (column_store), iter);
+
+  gtk_column_store_remove_row (column_store, row);
+  gtk_column_store_increment_stamp (column_store);
+
+  gtk_tree_model_row_deleted (GTK_TREE_MODEL (column_store), path);
+  gtk_tree_path_free (path);
+
+  if (row >= column_store->priv->n_rows)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+  else
+    {
+      iter->stamp = column_store->priv->stamp;
+      iter->user_data = GINT_TO_POINTER (row);
+      return TRUE;
+    }
+}
+
+/**
+ * gtk_column_store_insert:
+ * @column_store: A #GtkColumnStore
+ * @iter: An unset #GtkTreeIter to set to the new row
+ * @position: position to insert the new row
+ *
+ * Creates a new row at @position.  @iter will be changed to point to
+ * this new row.  If @position is larger than the number of rows in the
+ * store, then the new row will be appended.  The cells of the new row
+ * are zero, %FALSE or %NULL.  Inserting before the last row moves the
+ * rows after it and invalidates all other iters.
+ *
+ * Since: 2.12
+ **/
+void
+gtk_column_store_insert (GtkColumnStore *column_store,
+			 GtkTreeIter    *iter,
+			 gint            position)
+{
+  GtkTreePath *path;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (position >= 0);
+
+  if (position > column_store->priv->n_rows)
+    position = column_store->priv->n_rows;
+  else if (position < column_store->priv->n_rows)
+    gtk_column_store_increment_stamp (column_store);
+
+  gtk_column_store_insert_rows (column_store, position, 1);
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (position);
+
+  path = gtk_tree_path_new ();
+  gtk_tree_path_append_index (path, position);
+  gtk_tree_model_row_inserted (GTK_TREE_MODEL (column_store), path, iter);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_column_store_append:
+ * @column_store: A #GtkColumnStore
+ * @iter: An unset #GtkTreeIter to set to the appended row
+ *
+ * Appends a new row to @column_store.  @iter will be changed to point
+ * to this new row.  The cells of the new row are zero, %FALSE or %NULL.
+ *
+ * Since: 2.12
+ **/
+void
+gtk_column_store_append (GtkColumnStore *column_store,
+			 GtkTreeIter    *iter)
+{
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (iter != NULL);
+
+  gtk_column_store_insert (column_store, iter, column_store->priv->n_rows);
+}
+
+/**
+ * gtk_column_store_append_rows:
+ * @column_store: A #GtkColumnStore
+ * @n_rows: the number of rows to append
+ *
+ * Appends @n_rows empty rows to @column_store, allocating space for
+ * all of them at once.  Use gtk_column_store_set_column_from_array()
+ * to fill them in.
+ *
+ * Since: 2.12
+ **/
+void
+gtk_column_store_append_rows (GtkColumnStore *column_store,
+			      gint            n_rows)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  gint first_row, i;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (n_rows >= 0);
+
+  first_row = column_store->priv->n_rows;
+  gtk_column_store_insert_rows (column_store, first_row, n_rows);
+
+  path = gtk_tree_path_new ();
+  gtk_tree_path_append_index (path, first_row);
+  iter.stamp = column_store->priv->stamp;
+
+  for (i = first_row; i < first_row + n_rows; i++)
+    {
+      iter.user_data = GINT_TO_POINTER (i);
+      gtk_tree_model_row_inserted (GTK_TREE_MODEL (column_store), path, &iter);
+      gtk_tree_path_next (path);
+    }
+
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_column_store_clear:
+ * @column_store: a #GtkColumnStore.
+ *
+ * Removes all rows from the column store, and frees the memory used
+ * for them.
+ *
+ * Since: 2.12
+ **/
+void
+gtk_column_store_clear (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv;
+  GtkTreePath *path;
+  gint i;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  priv = column_store->priv;
+
+  /* remove the rows from the end, so nothing needs to be moved */
+  while (priv->n_rows > 0)
+    {
+      gtk_column_store_release_rows (column_store, priv->n_rows - 1, 1);
+      priv->n_rows--;
+
+      path = gtk_tree_path_new ();
+      gtk_tree_path_append_index (path, priv->n_rows);
+      gtk_tree_model_row_deleted (GTK_TREE_MODEL (column_store), path);
+      gtk_tree_path_free (path);
+    }
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      g_free (priv->columns[i].data);
+      priv->columns[i].data = NULL;
+    }
+  priv->n_allocated = 0;
+
+  gtk_column_store_increment_stamp (column_store);
+}
+
+/**
+ * gtk_column_store_iter_is_valid:
+ * @column_store: A #GtkColumnStore.
+ * @iter: A #GtkTreeIter.
+ *
+ * Checks if the given iter is a valid iter for this #GtkColumnStore.
+ * Unlike for #GtkListStore, this is cheap.
+ *
+ * Return value: %TRUE if the iter is valid, %FALSE if the iter is invalid.
+ *
+ * Since: 2.12
+ **/
+gboolean
+gtk_column_store_iter_is_valid (GtkColumnStore *column_store,
+				GtkTreeIter    *iter)
+{
+  g_return_val_if_fail (GTK_IS_COLUMN_STORE (column_store), FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  return VALID_ITER (iter, column_store);
+}
+
+
+/* Sorting */
+static gint
+gtk_column_store_compare_rows (GtkColumnStore *column_store,
+			       gint            a,
+			       gint            b)
+{
+  GtkTreeIterCompareFunc func;
+  gpointer data = NULL;
+  gint retval;
+
+  func = gtk_column_store_get_compare_func (column_store, &data);
+  g_return_val_if_fail (func != NULL, 0);
+
+  if (func == _gtk_tree_data_list_compare_func)
+    retval = gtk_column_store_compare_cells (&column_store->priv->columns[GPOINTER_TO_INT (data)],
+					     a, b);
+  else
+    {
+      GtkTreeIter iter_a;
+      GtkTreeIter iter_b;
+
+      iter_a.stamp = column_store->priv->stamp;
+      iter_a.user_data = GINT_TO_POINTER (a);
+      iter_b.stamp = column_store->priv->stamp;
+      iter_b.user_data = GINT_TO_POINTER (b);
+
+      retval = (* func) (GTK_TREE_MODEL (column_store), &iter_a, &iter_b, data);
+    }
+
+  if (column_store->priv->order == GTK_SORT_DESCENDING)
+    {
+      if (retval > 0)
+	retval = -1;
+      else if (retval < 0)
+	retval = 1;
+    }
+
+  return retval;
+}
+
+static gint
+gtk_column_store_compare_func (gconstpointer a,
+			       gconstpointer b,
+			       gpointer      user_data)
+{
+  return gtk_column_store_compare_rows (user_data,
+					*(const gint *) a, *(const gint *) b);
+}
+
+/* Sorts a permutation of the row indices, then moves the cells of
+ * each column into place in one pass.  The permutation is also the
+ * new_order for ::rows-reordered.
+ */
+static void
+gtk_column_store_sort (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkTreePath *path;
+  gint *new_order;
+  gint i, j;
+
+  if (!GTK_COLUMN_STORE_IS_SORTED (column_store) || priv->n_rows <= 1)
+    return;
+
+  new_order = g_new (gint, priv->n_rows);
+  for (i = 0; i < priv->n_rows; i++)
+    new_order[i] = i;
+
+  g_qsort_with_data (new_order, priv->n_rows, sizeof (gint),
+		     gtk_column_store_compare_func, column_store);
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      ColumnData *col = &priv->columns[i];
+      guchar *data;
+
+      data = g_malloc ((gsize) priv->n_allocated * col->elt_size);
+      for (j = 0; j < priv->n_rows; j++)
+	memcpy (data + (gsize) j * col->elt_size, CELL (col, new_order[j]),
+		col->elt_size);
+
+      g_free (col->data);
+      col->data = data;
+    }
+
+  gtk_column_store_increment_stamp (column_store);
+
+  /* Let the world know about our new order */
+  path = gtk_tree_path_new ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (column_store),
+				 path, NULL, new_order);
+  gtk_tree_path_free (path);
+  g_free (new_order);
+}
+
+static void
+gtk_column_store_sort_iter_changed (GtkColumnStore *column_store,
+				    GtkTreeIter    *iter)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkTreePath *path;
+  gint *new_order;
+  gint row, lo, hi, i;
+
+  gtk_column_store_row_changed (column_store, iter, FALSE);
+
+  row = ITER_ROW (iter);
+
+  if ((row == 0 ||
+       gtk_column_store_compare_rows (column_store, row - 1, row) <= 0) &&
+      (row == priv->n_rows - 1 ||
+       gtk_column_store_compare_rows (column_store, row, row + 1) <= 0))
+    return;
+
+  /* find the new position among the other rows */
+  lo = 0;
+  hi = priv->n_rows - 1;
+  while (lo < hi)
+    {
+      gint mid = (lo + hi) / 2;
+
+      if (gtk_column_store_compare_rows (column_store, row,
+					 mid < row ? mid : mid + 1) < 0)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
+
+  gtk_column_store_move_row (column_store, row, lo);
+
+  new_order = g_new (gint, priv->n_rows);
+  for (i = 0; i < priv->n_rows; i++)
+    {
+      if (i == lo)
+	new_order[i] = row;
+      else if (lo < row && i > lo && i <= row)
+	new_order[i] = i - 1;
+      else if (lo > row && i >= row && i < lo)
+	new_order[i] = i + 1;
+      else
+	new_order[i] = i;
+    }
+
+  gtk_column_store_increment_stamp (column_store);
+  iter->stamp = priv->stamp;
+  iter->user_data = GINT_TO_POINTER (lo);
+
+  path = gtk_tree_path_new ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (column_store),
+				 path, NULL, new_order);
+  gtk_tree_path_free (path);
+  g_free (new_order);
+}
+
+static gboolean
+gtk_column_store_get_sort_column_id (GtkTreeSortable  *sortable,
+				     gint             *sort_column_id,
+				     GtkSortType      *order)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) sortable;
+
+  if (sort_column_id)
+    * sort_column_id = column_store->priv->sort_column_id;
+  if (order)
+    * order = column_store->priv->order;
+
+  if (column_store->priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID ||
+      column_store->priv->sort_column_id == GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+gtk_column_store_set_sort_column_id (GtkTreeSortable  *sortable,
+				     gint              sort_column_id,
+				     GtkSortType       order)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) sortable;
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  if ((priv->sort_column_id == sort_column_id) &&
+      (priv->order == order))
+    return;
+
+  if (sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+    {
+      if (sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+	{
+	  GtkTreeDataSortHeader *header = NULL;
+
+	  header = _gtk_tree_data_list_get_header (priv->sort_list,
+						   sort_column_id);
+
+	  /* We want to make sure that we have a function */
+	  g_return_if_fail (header != NULL);
+	  g_return_if_fail (header->func != NULL);
+	}
+      else
+	{
+	  g_return_if_fail (priv->default_sort_func != NULL);
+	}
+    }
+
+  priv->sort_column_id = sort_column_id;
+  priv->order = order;
+
+  gtk_tree_sortable_sort_column_changed (sortable);
+
+  gtk_column_store_sort (column_store);
+}
+
+static void
+gtk_column_store_set_sort_func (GtkTreeSortable        *sortable,
+				gint                    sort_column_id,
+				GtkTreeIterCompareFunc  func,
+				gpointer                data,
+				GtkDestroyNotify        destroy)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) sortable;
+
+  column_store->priv->sort_list =
+    _gtk_tree_data_list_set_header (column_store->priv->sort_list,
+				    sort_column_id,
+				    func, data, destroy);
+
+  if (column_store->priv->sort_column_id == sort_column_id)
+    gtk_column_store_sort (column_store);
+}
+
+static void
+gtk_column_store_set_default_sort_func (GtkTreeSortable        *sortable,
+					GtkTreeIterCompareFunc  func,
+					gpointer                data,
+					GtkDestroyNotify        destroy)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) sortable;
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  if (priv->default_sort_destroy)
+    {
+      GtkDestroyNotify d = priv->default_sort_destroy;
+
+      priv->default_sort_destroy = NULL;
+      d (priv->default_sort_data);
+    }
+
+  priv->default_sort_func = func;
+  priv->default_sort_data = data;
+  priv->default_sort_destroy = destroy;
+
+  if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+    gtk_column_store_sort (column_store);
+}
+
+static gboolean
+gtk_column_store_has_default_sort_func (GtkTreeSortable *sortable)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) sortable;
+
+  return (column_store->priv->default_sort_func != NULL);
+}
+
+#define __GTK_COLUMN_STORE_C__
+#include "gtkaliasdef.c"
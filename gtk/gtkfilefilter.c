@@ -385,13 +385,20 @@ gtk_file_filter_filter (GtkFileFilter           *filter,
       switch (rule->type)
 	{
 	case FILTER_RULE_MIME_TYPE:
-	  if (filter_info->mime_type != NULL
+	  if (filter_info->mime_type != NULL)
+	    {
+	      gboolean matches;
+
 #ifdef G_OS_UNIX
-	      && xdg_mime_mime_type_subclass (filter_info->mime_type, rule->u.mime_type))
+	      G_LOCK (_gtk_xdgmime);
+	      matches = xdg_mime_mime_type_subclass (filter_info->mime_type, rule->u.mime_type);
+	      G_UNLOCK (_gtk_xdgmime);
 #else
-	      && strcmp (rule->u.mime_type, filter_info->mime_type) == 0)
+	      matches = strcmp (rule->u.mime_type, filter_info->mime_type) == 0;
 #endif
-	    return TRUE;
+	      if (matches)
+		return TRUE;
+	    }
 	  break;
 	case FILTER_RULE_PATTERN:
 	  if (filter_info->display_name != NULL &&
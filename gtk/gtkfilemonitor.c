@@ -0,0 +1,385 @@
+/* gtkfilemonitor.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Watches directories for changes so that the icon theme, the file
+ * chooser and the recent manager don't have to poll them.  All watches
+ * share a single inotify descriptor, which is read from a GIOChannel
+ * source in the main loop; a directory watched by several subscribers
+ * is only registered with the kernel once.
+ *
+ * Where inotify isn't available _gtk_file_monitor_add() returns 0 and
+ * callers keep polling as before.
+ */
+
+#include <config.h>
+
+#include "gtkfilemonitor.h"
+#include "gtkdebug.h"
+#include "gdk/gdk.h"
+#include "gtkalias.h"
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+#include <sys/inotify.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+/* IN_MODIFY is left out on purpose: it fires on every write (), and
+ * the IN_CLOSE_WRITE at the end tells subscribers all they need.
+ */
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | \
+		    IN_CLOSE_WRITE | IN_ATTRIB |			  \
+		    IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+typedef struct
+{
+  gchar *path;
+  gint wd;		/* -1 once the kernel watch is gone */
+  GSList *subscriptions;
+} MonitoredDir;
+
+typedef struct
+{
+  guint id;
+  MonitoredDir *dir;
+  GtkFileMonitorFunc func;
+  gpointer data;
+} Subscription;
+
+static gint inotify_fd = -1;
+static gboolean inotify_failed = FALSE;
+static GIOChannel *inotify_channel = NULL;
+
+static GHashTable *dirs_by_path = NULL;		/* path -> MonitoredDir */
+static GHashTable *dirs_by_wd = NULL;		/* wd -> MonitoredDir */
+static GHashTable *subscriptions = NULL;	/* id -> Subscription */
+static guint next_id = 1;
+
+static gboolean inotify_read (GIOChannel   *source,
+			      GIOCondition  condition,
+			      gpointer      data);
+
+static gboolean
+ensure_inotify (void)
+{
+  if (inotify_fd >= 0)
+    return TRUE;
+
+  if (inotify_failed)
+    return FALSE;
+
+  inotify_fd = inotify_init ();
+  if (inotify_fd < 0)
+    {
+      GTK_NOTE (MISC, g_print ("inotify_init failed: %s\n", g_strerror (errno)));
+      inotify_failed = TRUE;
+      return FALSE;
+    }
+
+  fcntl (inotify_fd, F_SETFL, O_NONBLOCK);
+  fcntl (inotify_fd, F_SETFD, FD_CLOEXEC);
+
+  dirs_by_path = g_hash_table_new (g_str_hash, g_str_equal);
+  dirs_by_wd = g_hash_table_new (g_direct_hash, g_direct_equal);
+  subscriptions = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  inotify_channel = g_io_channel_unix_new (inotify_fd);
+  g_io_add_watch (inotify_channel, G_IO_IN, inotify_read, NULL);
+
+  return TRUE;
+}
+
+/* Forgets the kernel watch of @dir; the subscriptions stay until
+ * their owners remove them, but no longer receive events.
+ */
+static void
+dir_detach (MonitoredDir *dir,
+	    gboolean      remove_watch)
+{
+  if (dir->wd < 0)
+    return;
+
+  if (remove_watch)
+    inotify_rm_watch (inotify_fd, dir->wd);
+
+  g_hash_table_remove (dirs_by_wd, GINT_TO_POINTER (dir->wd));
+  if (g_hash_table_lookup (dirs_by_path, dir->path) == dir)
+    g_hash_table_remove (dirs_by_path, dir->path);
+
+  dir->wd = -1;
+}
+
+static void
+dir_free (MonitoredDir *dir)
+{
+  dir_detach (dir, TRUE);
+  g_free (dir->path);
+  g_slice_free (MonitoredDir, dir);
+}
+
+/* Callbacks may add or remove subscriptions, including the ones we are
+ * about to notify, so take a copy of the ids up front and look each of
+ * them up again right before calling it.
+ */
+static GSList *
+collect_ids (MonitoredDir *dir)
+{
+  GSList *ids = NULL;
+  GSList *l;
+
+  for (l = dir->subscriptions; l; l = l->next)
+    {
+      Subscription *sub = l->data;
+      ids = g_slist_prepend (ids, GUINT_TO_POINTER (sub->id));
+    }
+
+  return ids;
+}
+
+static void
+collect_all_ids (gpointer key,
+		 gpointer value,
+		 gpointer user_data)
+{
+  GSList **ids = user_data;
+
+  *ids = g_slist_prepend (*ids, key);
+}
+
+static void
+dispatch (GSList              *ids,
+	  const gchar         *basename,
+	  GtkFileMonitorEvent  event)
+{
+  GSList *l;
+
+  for (l = ids; l; l = l->next)
+    {
+      Subscription *sub = g_hash_table_lookup (subscriptions, l->data);
+
+      if (sub)
+	sub->func (basename, event, sub->data);
+    }
+}
+
+static void
+handle_event (struct inotify_event *ev)
+{
+  MonitoredDir *dir;
+  GtkFileMonitorEvent event;
+  const gchar *basename;
+  GSList *ids;
+
+  if (ev->mask & IN_Q_OVERFLOW)
+    {
+      GTK_NOTE (MISC, g_print ("inotify queue overflowed, rescanning everything\n"));
+
+      ids = NULL;
+      g_hash_table_foreach (subscriptions, collect_all_ids, &ids);
+      dispatch (ids, NULL, GTK_FILE_MONITOR_EVENT_CHANGED);
+      g_slist_free (ids);
+      return;
+    }
+
+  dir = g_hash_table_lookup (dirs_by_wd, GINT_TO_POINTER (ev->wd));
+  if (!dir)
+    return;
+
+  if (ev->mask & IN_IGNORED)
+    {
+      dir_detach (dir, FALSE);
+      return;
+    }
+
+  basename = ev->len > 0 ? ev->name : NULL;
+
+  if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT))
+    {
+      /* Detach first so that a subscriber re-adding the path gets
+       * a fresh watch instead of this dead one.
+       */
+      ids = collect_ids (dir);
+      dir_detach (dir, TRUE);
+      dispatch (ids, NULL, GTK_FILE_MONITOR_EVENT_GONE);
+      g_slist_free (ids);
+      return;
+    }
+
+  if (!basename)
+    return;
+
+  if (ev->mask & (IN_CREATE | IN_MOVED_TO))
+    event = GTK_FILE_MONITOR_EVENT_CREATED;
+  else if (ev->mask & (IN_DELETE | IN_MOVED_FROM))
+    event = GTK_FILE_MONITOR_EVENT_DELETED;
+  else
+    event = GTK_FILE_MONITOR_EVENT_CHANGED;
+
+  ids = collect_ids (dir);
+  dispatch (ids, basename, event);
+  g_slist_free (ids);
+}
+
+static gboolean
+inotify_read (GIOChannel   *source,
+	      GIOCondition  condition,
+	      gpointer      data)
+{
+  union {
+    struct inotify_event ev;	/* for alignment */
+    gchar data[16 * (sizeof (struct inotify_event) + NAME_MAX + 1)];
+  } buf;
+  gssize len, i;
+
+  GDK_THREADS_ENTER ();
+
+  while (TRUE)
+    {
+      len = read (inotify_fd, buf.data, sizeof (buf.data));
+      if (len <= 0)
+	{
+	  if (len < 0 && errno == EINTR)
+	    continue;
+	  break;
+	}
+
+      i = 0;
+      while (i < len)
+	{
+	  struct inotify_event *ev = (struct inotify_event *) &buf.data[i];
+
+	  handle_event (ev);
+	  i += sizeof (struct inotify_event) + ev->len;
+	}
+    }
+
+  GDK_THREADS_LEAVE ();
+
+  return TRUE;
+}
+
+/**
+ * _gtk_file_monitor_add:
+ * @dirname: the directory to watch
+ * @func: function called for each change in @dirname
+ * @data: data to pass to @func
+ *
+ * Starts watching @dirname.  @func is called from the main loop, with
+ * the GDK lock held, whenever a child of @dirname is created, removed
+ * or rewritten, or when @dirname itself goes away.
+ *
+ * Return value: an id to pass to _gtk_file_monitor_remove(), or 0 if
+ *   @dirname cannot be monitored; the caller then has to poll it.
+ **/
+guint
+_gtk_file_monitor_add (const gchar        *dirname,
+		       GtkFileMonitorFunc  func,
+		       gpointer            data)
+{
+  MonitoredDir *dir;
+  Subscription *sub;
+
+  g_return_val_if_fail (dirname != NULL, 0);
+  g_return_val_if_fail (func != NULL, 0);
+
+  if (!ensure_inotify ())
+    return 0;
+
+  dir = g_hash_table_lookup (dirs_by_path, dirname);
+  if (!dir)
+    {
+      gint wd;
+
+      wd = inotify_add_watch (inotify_fd, dirname, WATCH_MASK);
+      if (wd < 0)
+	return 0;
+
+      /* The same directory reached through another path */
+      dir = g_hash_table_lookup (dirs_by_wd, GINT_TO_POINTER (wd));
+      if (!dir)
+	{
+	  dir = g_slice_new (MonitoredDir);
+	  dir->path = g_strdup (dirname);
+	  dir->wd = wd;
+	  dir->subscriptions = NULL;
+
+	  g_hash_table_insert (dirs_by_path, dir->path, dir);
+	  g_hash_table_insert (dirs_by_wd, GINT_TO_POINTER (wd), dir);
+	}
+    }
+
+  sub = g_slice_new (Subscription);
+  sub->id = next_id++;
+  sub->dir = dir;
+  sub->func = func;
+  sub->data = data;
+
+  dir->subscriptions = g_slist_prepend (dir->subscriptions, sub);
+  g_hash_table_insert (subscriptions, GUINT_TO_POINTER (sub->id), sub);
+
+  return sub->id;
+}
+
+/**
+ * _gtk_file_monitor_remove:
+ * @id: an id returned by _gtk_file_monitor_add()
+ *
+ * Stops the notifications set up by _gtk_file_monitor_add().  It is
+ * safe to call this from within the callback.
+ **/
+void
+_gtk_file_monitor_remove (guint id)
+{
+  Subscription *sub;
+  MonitoredDir *dir;
+
+  if (!subscriptions)
+    return;
+
+  sub = g_hash_table_lookup (subscriptions, GUINT_TO_POINTER (id));
+  if (!sub)
+    return;
+
+  g_hash_table_remove (subscriptions, GUINT_TO_POINTER (id));
+
+  dir = sub->dir;
+  dir->subscriptions = g_slist_remove (dir->subscriptions, sub);
+  if (!dir->subscriptions)
+    dir_free (dir);
+
+  g_slice_free (Subscription, sub);
+}
+
+#else /* !HAVE_SYS_INOTIFY_H */
+
+guint
+_gtk_file_monitor_add (const gchar        *dirname,
+		       GtkFileMonitorFunc  func,
+		       gpointer            data)
+{
+  return 0;
+}
+
+void
+_gtk_file_monitor_remove (guint id)
+{
+}
+
+#endif /* HAVE_SYS_INOTIFY_H */
@@ -0,0 +1,48 @@
+/* gtkfilemonitor.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef __GTK_FILE_MONITOR_H__
+#define __GTK_FILE_MONITOR_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  GTK_FILE_MONITOR_EVENT_CHANGED,  /* a child was rewritten or its attributes changed */
+  GTK_FILE_MONITOR_EVENT_CREATED,  /* a child was created or moved in */
+  GTK_FILE_MONITOR_EVENT_DELETED,  /* a child was removed or moved away */
+  GTK_FILE_MONITOR_EVENT_GONE      /* the directory itself was removed or moved */
+} GtkFileMonitorEvent;
+
+/* @basename is the child the event is about.  It is %NULL for
+ * %GTK_FILE_MONITOR_EVENT_GONE, and for a %GTK_FILE_MONITOR_EVENT_CHANGED
+ * sent when events were lost and the whole directory must be rescanned.
+ */
+typedef void (* GtkFileMonitorFunc) (const gchar         *basename,
+				     GtkFileMonitorEvent  event,
+				     gpointer             data);
+
+guint _gtk_file_monitor_add    (const gchar        *dirname,
+				GtkFileMonitorFunc  func,
+				gpointer            data);
+void  _gtk_file_monitor_remove (guint               id);
+
+G_END_DECLS
+
+#endif /* __GTK_FILE_MONITOR_H__ */
@@ -27,15 +27,19 @@
 
 #include "gtkfilesystem.h"
 #include "gtkfilesystemunix.h"
+#include "gtkfilemonitor.h"
 #include "gtkicontheme.h"
 #include "gtkintl.h"
+#include "gtkprivate.h"
 #include "gtkstock.h"
 #include "gtkalias.h"
 
 #define XDG_PREFIX _gtk_xdg
 #include "xdgmime/xdgmime.h"
 
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -52,6 +56,19 @@
 
 #define FOLDER_CACHE_LIFETIME 2 /* seconds */
 
+/* A folder loading thread hands over what it has read every
+ * LOAD_BATCH_SIZE children, or every LOAD_BATCH_MSEC if that is sooner.
+ */
+#define LOAD_BATCH_SIZE 500
+#define LOAD_BATCH_MSEC 100
+
+/* The MIME types of the children are looked up this many at a time.
+ * Those that need sniffing are read without holding the _gtk_xdgmime
+ * lock, at most SNIFF_MAX_BYTES of them at a time.
+ */
+#define MIME_BATCH_SIZE 64
+#define SNIFF_MAX_BYTES (256 * 1024)
+
 typedef struct _GtkFileSystemUnixClass GtkFileSystemUnixClass;
 
 #define GTK_FILE_SYSTEM_UNIX_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GTK_TYPE_FILE_SYSTEM_UNIX, GtkFileSystemUnixClass))
@@ -107,6 +124,7 @@ typedef enum {
 
 typedef struct _GtkFileFolderUnix      GtkFileFolderUnix;
 typedef struct _GtkFileFolderUnixClass GtkFileFolderUnixClass;
+typedef struct _FolderLoadJob          FolderLoadJob;
 
 struct _GtkFileFolderUnixClass
 {
@@ -122,6 +140,8 @@ struct _GtkFileFolderUnix
   gchar *filename;
   GHashTable *stat_info;
   guint load_folder_id;
+  guint monitor_id;
+  FolderLoadJob *load_job;
   guint have_stat : 1;
   guint have_mime_type : 1;
   guint is_network_dir : 1;
@@ -137,6 +157,36 @@ struct stat_info_entry {
   gboolean hidden;
 };
 
+/* A folder being read by a thread.  The thread queues what it reads in
+ * @pending, and an idle in the main loop moves it into the stat_info of
+ * @folder_unix.  @folder_unix is only used from the main loop, and is
+ * cleared if the folder is finalized before the thread is done.
+ * @deleted, also only used from the main loop, holds the names of the
+ * children the file monitor reported as deleted while the thread was
+ * running, which the thread may still have read before they went away.
+ */
+struct _FolderLoadJob
+{
+  gint ref_count;
+  GtkFileFolderUnix *folder_unix;
+  char *filename;
+  GtkFileInfoType types;
+  gboolean is_network_dir;
+  volatile gint cancelled;
+  GHashTable *deleted;
+
+  GMutex *mutex;
+  GSList *pending;		/* struct loaded_file, newest first */
+  gboolean idle_queued;
+  gboolean done;
+  gboolean failed;
+};
+
+struct loaded_file {
+  char *basename;
+  struct stat_info_entry *entry;
+};
+
 static const GtkFileInfoType STAT_NEEDED_MASK = (GTK_FILE_INFO_IS_FOLDER |
 						 GTK_FILE_INFO_MODIFICATION_TIME |
 						 GTK_FILE_INFO_SIZE |
@@ -253,16 +303,26 @@ static GtkFileInfo *create_file_info              (GtkFileFolderUnix *folder_uni
 						   GtkFileInfoType types,
 						   struct stat *statbuf,
 						   const char *mime_type);
+static char *       get_mime_type_for_file        (const char *filename,
+						   struct stat *statbuf);
 
 static gboolean execute_callbacks_idle (gpointer data);
 static void execute_callbacks (gpointer data);
 
+static gboolean folder_load_job_start  (GtkFileFolderUnix *folder_unix);
+static void     folder_load_job_cancel (FolderLoadJob     *job);
+static void     free_stat_info_entry   (struct stat_info_entry *entry);
+
 static gboolean fill_in_names     (GtkFileFolderUnix  *folder_unix,
 				   GError            **error);
 static void     fill_in_stats     (GtkFileFolderUnix  *folder_unix);
 static void     fill_in_mime_type (GtkFileFolderUnix  *folder_unix);
 static void     fill_in_hidden    (GtkFileFolderUnix  *folder_unix);
 
+static void     folder_monitor_changed (const gchar         *basename,
+					GtkFileMonitorEvent  event,
+					gpointer             data);
+
 static gboolean cb_fill_in_stats     (gpointer key,
 				      gpointer value,
 				      gpointer user_data);
@@ -827,7 +887,7 @@ gtk_file_system_unix_get_info (GtkFileSystem                *file_system,
   GtkFileInfo *info;
   gchar *basename;
   struct stat statbuf;
-  const char *mime_type;
+  char *mime_type;
 
   system_unix = GTK_FILE_SYSTEM_UNIX (file_system);
   handle = create_handle (file_system);
@@ -844,7 +904,7 @@ gtk_file_system_unix_get_info (GtkFileSystem                *file_system,
     }
 
   if ((types & GTK_FILE_INFO_MIME_TYPE) != 0)
-    mime_type = xdg_mime_get_mime_type_for_file (filename, &statbuf);
+    mime_type = get_mime_type_for_file (filename, &statbuf);
   else
     mime_type = NULL;
 
@@ -852,6 +912,7 @@ gtk_file_system_unix_get_info (GtkFileSystem                *file_system,
 
   info = create_file_info (NULL, filename, basename, types, &statbuf,
                            mime_type);
+  g_free (mime_type);
   g_free (basename);
   g_object_ref (handle);
   queue_get_info_callback (callback, handle, info, NULL, data);
@@ -859,6 +920,473 @@ gtk_file_system_unix_get_info (GtkFileSystem                *file_system,
   return handle;
 }
 
+static void
+free_loaded_file (struct loaded_file *file)
+{
+  g_free (file->basename);
+  free_stat_info_entry (file->entry);
+  g_slice_free (struct loaded_file, file);
+}
+
+static FolderLoadJob *
+folder_load_job_ref (FolderLoadJob *job)
+{
+  g_atomic_int_inc (&job->ref_count);
+
+  return job;
+}
+
+static void
+folder_load_job_unref (FolderLoadJob *job)
+{
+  GSList *l;
+
+  if (!g_atomic_int_dec_and_test (&job->ref_count))
+    return;
+
+  for (l = job->pending; l; l = l->next)
+    free_loaded_file (l->data);
+  g_slist_free (job->pending);
+
+  g_hash_table_destroy (job->deleted);
+  g_mutex_free (job->mutex);
+  g_free (job->filename);
+  g_slice_free (FolderLoadJob, job);
+}
+
+/* Moves what the thread has read so far into the folder, in the main loop */
+static gboolean
+folder_load_job_idle (gpointer data)
+{
+  FolderLoadJob *job = data;
+  GtkFileFolderUnix *folder_unix;
+  GSList *files, *paths, *l;
+  gboolean done, failed;
+
+  GDK_THREADS_ENTER ();
+
+  g_mutex_lock (job->mutex);
+  files = g_slist_reverse (job->pending);
+  job->pending = NULL;
+  job->idle_queued = FALSE;
+  done = job->done;
+  failed = job->failed;
+  g_mutex_unlock (job->mutex);
+
+  folder_unix = job->folder_unix;
+  paths = NULL;
+
+  for (l = files; l; l = l->next)
+    {
+      struct loaded_file *file = l->data;
+
+      /* folder_monitor_changed() may have added it already, or seen
+       * it being deleted after the thread read it.
+       */
+      if (folder_unix &&
+	  !g_hash_table_lookup (folder_unix->stat_info, file->basename) &&
+	  !g_hash_table_lookup (job->deleted, file->basename))
+	{
+	  char *fullname;
+
+	  fullname = g_build_filename (folder_unix->filename, file->basename, NULL);
+	  paths = g_slist_prepend (paths, filename_to_path (fullname));
+	  g_free (fullname);
+
+	  g_hash_table_insert (folder_unix->stat_info, file->basename, file->entry);
+	  g_slice_free (struct loaded_file, file);
+	}
+      else
+	free_loaded_file (file);
+    }
+  g_slist_free (files);
+
+  if (folder_unix)
+    {
+      g_object_ref (folder_unix);
+
+      if (paths)
+	{
+	  paths = g_slist_reverse (paths);
+	  g_signal_emit_by_name (folder_unix, "files-added", paths);
+	  gtk_file_paths_free (paths);
+	}
+
+      if (done && folder_unix->load_job == job)
+	{
+	  folder_unix->load_job = NULL;
+
+	  if (failed)
+	    {
+	      g_hash_table_destroy (folder_unix->stat_info);
+	      folder_unix->stat_info = NULL;
+	    }
+	  else
+	    {
+	      folder_unix->have_stat = TRUE;
+	      folder_unix->have_mime_type = (job->types & GTK_FILE_INFO_MIME_TYPE) != 0;
+	    }
+	  folder_unix->is_finished_loading = TRUE;
+	  folder_load_job_unref (job);
+
+	  g_signal_emit_by_name (folder_unix, "finished-loading", 0);
+	}
+
+      g_object_unref (folder_unix);
+    }
+
+  GDK_THREADS_LEAVE ();
+
+  return FALSE;
+}
+
+/* Called from the thread; takes ownership of @files */
+static void
+folder_load_job_push (FolderLoadJob *job,
+		      GSList        *files,
+		      gboolean       done,
+		      gboolean       failed)
+{
+  g_mutex_lock (job->mutex);
+
+  job->pending = g_slist_concat (files, job->pending);
+  job->done = done;
+  job->failed = failed;
+
+  if (!job->idle_queued)
+    {
+      job->idle_queued = TRUE;
+      g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+		       folder_load_job_idle,
+		       folder_load_job_ref (job),
+		       (GDestroyNotify) folder_load_job_unref);
+    }
+
+  g_mutex_unlock (job->mutex);
+}
+
+/* Like cb_fill_in_stats(), but relative to the open directory where
+ * fstatat() is available, which saves resolving the full path again
+ * for every child.
+ */
+static gboolean
+stat_in_folder (int          dir_fd,
+		const char  *dirname,
+		const char  *basename,
+		struct stat *statbuf)
+{
+#ifdef HAVE_FSTATAT
+  if (fstatat (dir_fd, basename, statbuf, 0) == 0)
+    return TRUE;
+
+  return errno == ENOENT &&
+	 fstatat (dir_fd, basename, statbuf, AT_SYMLINK_NOFOLLOW) == 0;
+#else
+  char *fullname;
+  gboolean result;
+
+  fullname = g_build_filename (dirname, basename, NULL);
+  result = (stat (fullname, statbuf) == 0 ||
+	    (errno == ENOENT && lstat (fullname, statbuf) == 0));
+  g_free (fullname);
+
+  return result;
+#endif
+}
+
+#if defined (HAVE_OPENAT) && defined (HAVE_FSTATAT)
+/* Reads up to @len bytes from the start of @basename, relative to
+ * @dir_fd, into @buffer.  Returns the number of bytes read, or -1 if
+ * it isn't a regular file or can't be read.
+ */
+static gssize
+read_file_header (int          dir_fd,
+		  const char  *basename,
+		  struct stat *statbuf,
+		  guchar      *buffer,
+		  gsize        len)
+{
+  gssize bytes_read;
+  int fd;
+
+  if (!S_ISREG (statbuf->st_mode))
+    return -1;
+
+  fd = openat (dir_fd, basename, O_RDONLY | O_NOCTTY);
+  if (fd < 0)
+    return -1;
+
+  do
+    bytes_read = pread (fd, buffer, len, 0);
+  while (bytes_read < 0 && errno == EINTR);
+
+  close (fd);
+
+  return bytes_read;
+}
+#endif
+
+/* Fills in the MIME types of @files, children of @dirname that are
+ * still missing one.  Where the *at() functions are available they are
+ * looked up in batches: the globs first, then the files they don't
+ * settle are read relative to @dir_fd, outside the _gtk_xdgmime lock,
+ * and sniffed together.
+ */
+static void
+fill_in_loaded_mime_types (int          dir_fd,
+			   const char  *dirname,
+			   GSList      *files)
+{
+#if defined (HAVE_OPENAT) && defined (HAVE_FSTATAT)
+  const char *names[MIME_BATCH_SIZE];
+  struct stat *statbufs[MIME_BATCH_SIZE];
+  const char *mime_types[MIME_BATCH_SIZE];
+  int need_data[MIME_BATCH_SIZE];
+  struct stat_info_entry *entries[MIME_BATCH_SIZE];
+  const void *data[MIME_BATCH_SIZE];
+  gsize lens[MIME_BATCH_SIZE];
+  guchar *buffer;
+  gsize buffer_size;
+  GSList *l;
+  int max_extent, max_files;
+  int n, n_sniff, i, j, k;
+
+  buffer = NULL;
+  buffer_size = 0;
+
+  l = files;
+  while (l)
+    {
+      for (n = 0; l && n < MIME_BATCH_SIZE; l = l->next)
+	{
+	  struct loaded_file *file = l->data;
+
+	  if (file->entry->mime_type)
+	    continue;
+
+	  names[n] = file->basename;
+	  statbufs[n] = &file->entry->statbuf;
+	  entries[n] = file->entry;
+	  n++;
+	}
+
+      if (n == 0)
+	continue;
+
+      /* The globs settle most of them; keep the others */
+      G_LOCK (_gtk_xdgmime);
+      xdg_mime_get_mime_types_from_file_names (names, mime_types, need_data, n);
+      max_extent = xdg_mime_get_max_buffer_extents ();
+      for (i = 0, n_sniff = 0; i < n; i++)
+	{
+	  if (need_data[i])
+	    {
+	      names[n_sniff] = names[i];
+	      statbufs[n_sniff] = statbufs[i];
+	      entries[n_sniff] = entries[i];
+	      n_sniff++;
+	    }
+	  else
+	    entries[i]->mime_type = g_strdup (mime_types[i]);
+	}
+      G_UNLOCK (_gtk_xdgmime);
+
+      if (n_sniff == 0)
+	continue;
+
+      max_extent = MAX (max_extent, 1);
+      max_files = CLAMP (SNIFF_MAX_BYTES / max_extent, 1, n_sniff);
+      if (buffer_size < (gsize) max_files * max_extent)
+	{
+	  g_free (buffer);
+	  buffer_size = (gsize) max_files * max_extent;
+	  buffer = g_malloc (buffer_size);
+	}
+
+      for (i = 0; i < n_sniff; i += k)
+	{
+	  k = MIN (max_files, n_sniff - i);
+
+	  for (j = 0; j < k; j++)
+	    {
+	      guchar *p = buffer + (gsize) j * max_extent;
+	      gssize len;
+
+	      len = read_file_header (dir_fd, names[i + j], statbufs[i + j],
+				      p, max_extent);
+	      data[j] = len >= 0 ? p : NULL;
+	      lens[j] = len >= 0 ? len : 0;
+	    }
+
+	  G_LOCK (_gtk_xdgmime);
+	  xdg_mime_get_mime_types_for_data (names + i, data, lens, mime_types, k);
+	  for (j = 0; j < k; j++)
+	    entries[i + j]->mime_type = g_strdup (mime_types[j]);
+	  G_UNLOCK (_gtk_xdgmime);
+	}
+    }
+
+  g_free (buffer);
+#else
+  GSList *l;
+
+  for (l = files; l; l = l->next)
+    {
+      struct loaded_file *file = l->data;
+      char *fullname;
+
+      if (file->entry->mime_type)
+	continue;
+
+      fullname = g_build_filename (dirname, file->basename, NULL);
+      file->entry->mime_type = get_mime_type_for_file (fullname, &file->entry->statbuf);
+      g_free (fullname);
+    }
+#endif
+}
+
+static gpointer
+folder_load_thread (gpointer data)
+{
+  FolderLoadJob *job = data;
+  gboolean need_mime;
+  struct dirent *ent;
+  GSList *files;
+  guint n_files;
+  GTimer *timer;
+  DIR *dir;
+  int dir_fd;
+
+  dir = opendir (job->filename);
+  if (!dir)
+    {
+      folder_load_job_push (job, NULL, TRUE, TRUE);
+      folder_load_job_unref (job);
+      return NULL;
+    }
+
+#ifdef HAVE_FSTATAT
+  dir_fd = dirfd (dir);
+#else
+  dir_fd = -1;
+#endif
+
+  need_mime = (job->types & GTK_FILE_INFO_MIME_TYPE) != 0;
+  files = NULL;
+  n_files = 0;
+  timer = g_timer_new ();
+
+  while (!g_atomic_int_get (&job->cancelled) &&
+	 (ent = readdir (dir)) != NULL)
+    {
+      const char *basename = ent->d_name;
+      struct stat_info_entry *entry;
+      struct loaded_file *file;
+
+      if (strcmp (basename, ".") == 0 || strcmp (basename, "..") == 0)
+	continue;
+
+      entry = g_new0 (struct stat_info_entry, 1);
+
+      if (job->is_network_dir)
+	{
+	  entry->statbuf.st_mode = S_IFDIR;
+	  entry->mime_type = g_strdup ("x-directory/normal");
+	}
+      else
+	{
+	  if (!stat_in_folder (dir_fd, job->filename, basename, &entry->statbuf))
+	    {
+	      free_stat_info_entry (entry);
+	      continue;
+	    }
+	}
+
+      file = g_slice_new (struct loaded_file);
+      file->basename = g_strdup (basename);
+      file->entry = entry;
+      files = g_slist_prepend (files, file);
+
+      if (++n_files >= LOAD_BATCH_SIZE ||
+	  g_timer_elapsed (timer, NULL) * 1000 >= LOAD_BATCH_MSEC)
+	{
+	  if (need_mime)
+	    fill_in_loaded_mime_types (dir_fd, job->filename, files);
+
+	  folder_load_job_push (job, files, FALSE, FALSE);
+	  files = NULL;
+	  n_files = 0;
+	  g_timer_start (timer);
+	}
+    }
+
+  if (need_mime && !g_atomic_int_get (&job->cancelled))
+    fill_in_loaded_mime_types (dir_fd, job->filename, files);
+
+  g_timer_destroy (timer);
+  closedir (dir);
+
+  folder_load_job_push (job, files, TRUE, FALSE);
+  folder_load_job_unref (job);
+
+  return NULL;
+}
+
+/* Starts reading the children of @folder_unix, with their stat and,
+ * if requested, MIME type information, in a thread.  The children are
+ * reported through "files-added" in batches as they come in, followed
+ * by "finished-loading".  Returns FALSE if threads aren't available.
+ */
+static gboolean
+folder_load_job_start (GtkFileFolderUnix *folder_unix)
+{
+  FolderLoadJob *job;
+  GError *error = NULL;
+
+  if (!g_thread_supported ())
+    return FALSE;
+
+  job = g_slice_new0 (FolderLoadJob);
+  job->ref_count = 2; /* the folder's and the thread's */
+  job->folder_unix = folder_unix;
+  job->filename = g_strdup (folder_unix->filename);
+  job->types = folder_unix->types;
+  job->is_network_dir = folder_unix->is_network_dir;
+  job->deleted = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  job->mutex = g_mutex_new ();
+
+  if (!g_thread_create (folder_load_thread, job, FALSE, &error))
+    {
+      g_warning ("Could not create a thread to read %s: %s",
+		 folder_unix->filename, error->message);
+      g_error_free (error);
+
+      job->ref_count = 1;
+      folder_load_job_unref (job);
+      return FALSE;
+    }
+
+  folder_unix->stat_info = g_hash_table_new_full (g_str_hash, g_str_equal,
+						  (GDestroyNotify) g_free,
+						  (GDestroyNotify) free_stat_info_entry);
+  folder_unix->asof = time (NULL);
+  folder_unix->is_finished_loading = FALSE;
+  folder_unix->load_job = job;
+
+  return TRUE;
+}
+
+/* Stops the thread reading the folder the next time it looks, and
+ * drops the folder's reference to @job.
+ */
+static void
+folder_load_job_cancel (FolderLoadJob *job)
+{
+  g_atomic_int_set (&job->cancelled, TRUE);
+  job->folder_unix = NULL;
+  folder_load_job_unref (job);
+}
+
 static gboolean
 load_folder (gpointer data)
 {
@@ -867,6 +1395,20 @@ load_folder (gpointer data)
 
   GDK_THREADS_ENTER ();
 
+  /* Read folders that aren't cached yet in a thread, so that large or
+   * slow ones don't block the main loop.
+   */
+  if (!folder_unix->stat_info &&
+      (folder_unix->types & STAT_NEEDED_MASK) != 0 &&
+      folder_load_job_start (folder_unix))
+    {
+      folder_unix->load_folder_id = 0;
+
+      GDK_THREADS_LEAVE ();
+
+      return FALSE;
+    }
+
   if ((folder_unix->types & STAT_NEEDED_MASK) != 0)
     fill_in_stats (folder_unix);
 
@@ -918,7 +1460,11 @@ gtk_file_system_unix_get_folder (GtkFileSystem                  *file_system,
   if (folder_unix)
     {
       g_free (filename_copy);
+
+      /* A monitored folder is kept up to date by folder_monitor_changed() */
       if (folder_unix->stat_info &&
+	  !folder_unix->monitor_id &&
+	  !folder_unix->load_job &&
 	  time (NULL) - folder_unix->asof >= FOLDER_CACHE_LIFETIME)
 	{
 #if 0
@@ -990,6 +1536,8 @@ gtk_file_system_unix_get_folder (GtkFileSystem                  *file_system,
       folder_unix->types = types;
       folder_unix->stat_info = NULL;
       folder_unix->load_folder_id = 0;
+      folder_unix->monitor_id = 0;
+      folder_unix->load_job = NULL;
       folder_unix->have_mime_type = FALSE;
       folder_unix->have_stat = FALSE;
       folder_unix->have_hidden = FALSE;
@@ -1006,6 +1554,12 @@ gtk_file_system_unix_get_folder (GtkFileSystem                  *file_system,
       else
 	folder_unix->is_network_dir = FALSE;
 
+      /* inotify doesn't see changes made by other hosts */
+      if (!folder_unix->is_network_dir)
+	folder_unix->monitor_id = _gtk_file_monitor_add (folder_unix->filename,
+							 folder_monitor_changed,
+							 folder_unix);
+
       g_hash_table_insert (system_unix->folder_hash,
 			   folder_unix->filename,
 			   folder_unix);
@@ -1018,7 +1572,7 @@ gtk_file_system_unix_get_folder (GtkFileSystem                  *file_system,
   queue_get_folder_callback (callback, handle, GTK_FILE_FOLDER (folder_unix), NULL, data);
 
   /* Start loading the folder contents in an idle */
-  if (!folder_unix->load_folder_id)
+  if (!folder_unix->load_folder_id && !folder_unix->load_job)
     folder_unix->load_folder_id =
       g_idle_add ((GSourceFunc) load_folder, folder_unix);
 
@@ -1629,14 +2183,14 @@ get_icon_name_for_directory (const char *path)
   return NULL;
 }
 
-/* Computes our internal icon type based on a path name; also returns the MIME
- * type in case we come up with ICON_REGULAR.
+/* Computes our internal icon type based on a path name; also returns a
+ * newly allocated MIME type in case we come up with ICON_REGULAR.
  */
 static IconType
 get_icon_type_from_path (GtkFileFolderUnix *folder_unix,
 			 struct stat       *statbuf,
 			 const char        *filename,
-			 const char       **mime_type)
+			 char             **mime_type)
 {
   IconType icon_type;
 
@@ -1663,7 +2217,7 @@ get_icon_type_from_path (GtkFileFolderUnix *folder_unix,
 	  if (icon_type == ICON_REGULAR)
 	    {
 	      fill_in_mime_type (folder_unix);
-	      *mime_type = entry->mime_type;
+	      *mime_type = g_strdup (entry->mime_type);
 	    }
 
 	  return icon_type;
@@ -1675,7 +2229,7 @@ get_icon_type_from_path (GtkFileFolderUnix *folder_unix,
 
   icon_type = get_icon_type (filename, NULL);
   if (icon_type == ICON_REGULAR)
-    *mime_type = xdg_mime_get_mime_type_for_file (filename, NULL);
+    *mime_type = get_mime_type_for_file (filename, NULL);
 
   return icon_type;
 }
@@ -2177,6 +2731,18 @@ gtk_file_folder_unix_finalize (GObject *object)
       folder_unix->load_folder_id = 0;
     }
 
+  if (folder_unix->monitor_id)
+    {
+      _gtk_file_monitor_remove (folder_unix->monitor_id);
+      folder_unix->monitor_id = 0;
+    }
+
+  if (folder_unix->load_job)
+    {
+      folder_load_job_cancel (folder_unix->load_job);
+      folder_unix->load_job = NULL;
+    }
+
   g_hash_table_remove (folder_unix->system_unix->folder_hash, folder_unix->filename);
 
   if (folder_unix->stat_info)
@@ -2259,6 +2825,20 @@ stat_with_error (const char   *filename,
   return TRUE;
 }
 
+/* Returns a newly allocated string; see _gtk_xdgmime in gtkprivate.h */
+static char *
+get_mime_type_for_file (const char  *filename,
+			struct stat *statbuf)
+{
+  char *mime_type;
+
+  G_LOCK (_gtk_xdgmime);
+  mime_type = g_strdup (xdg_mime_get_mime_type_for_file (filename, statbuf));
+  G_UNLOCK (_gtk_xdgmime);
+
+  return mime_type;
+}
+
 /* Creates a new GtkFileInfo from the specified data */
 static GtkFileInfo *
 create_file_info (GtkFileFolderUnix *folder_unix,
@@ -2310,7 +2890,7 @@ create_file_info (GtkFileFolderUnix *folder_unix,
       IconType icon_type;
       gboolean free_icon_name = FALSE;
       const char *icon_name;
-      const char *icon_mime_type;
+      char *icon_mime_type;
 
       icon_type = get_icon_type_from_path (folder_unix, statbuf, filename, &icon_mime_type);
 
@@ -2337,6 +2917,8 @@ create_file_info (GtkFileFolderUnix *folder_unix,
 
       if (free_icon_name)
 	g_free ((char *) icon_name);
+
+      g_free (icon_mime_type);
     }
 
   return info;
@@ -2358,7 +2940,7 @@ create_stat_info_entry_and_emit_add (GtkFileFolderUnix *folder_unix,
     entry->statbuf = *statbuf;
 
   if ((folder_unix->types & GTK_FILE_INFO_MIME_TYPE) != 0)
-    entry->mime_type = g_strdup (xdg_mime_get_mime_type_for_file (filename, statbuf));
+    entry->mime_type = get_mime_type_for_file (filename, statbuf);
 
   g_hash_table_insert (folder_unix->stat_info,
 		       g_strdup (basename),
@@ -2384,7 +2966,7 @@ gtk_file_folder_unix_get_info (GtkFileFolder      *folder,
   const char *filename;
   GtkFileInfoType types;
   struct stat statbuf;
-  const char *mime_type;
+  char *mime_type;
 
   /* Get_info for "/" */
   if (!path)
@@ -2437,11 +3019,12 @@ gtk_file_folder_unix_get_info (GtkFileFolder      *folder,
 	}
 
       if ((types & GTK_FILE_INFO_MIME_TYPE) != 0)
-	mime_type = xdg_mime_get_mime_type_for_file (filename, &statbuf);
+	mime_type = get_mime_type_for_file (filename, &statbuf);
       else
 	mime_type = NULL;
 
       info = create_file_info (folder_unix, filename, basename, types, &statbuf, mime_type);
+      g_free (mime_type);
       g_free (basename);
       return info;
     }
@@ -2583,13 +3166,12 @@ cb_fill_in_mime_type (gpointer key, gpointer value, gpointer user_data)
   GtkFileFolderUnix *folder_unix = user_data;
   char *fullname = g_build_filename (folder_unix->filename, basename, NULL);
   struct stat *statbuf = NULL;
-  const char *mime_type;
 
   if (folder_unix->have_stat)
     statbuf = &entry->statbuf;
 
-  mime_type = xdg_mime_get_mime_type_for_file (fullname, statbuf);
-  entry->mime_type = g_strdup (mime_type);
+  g_free (entry->mime_type);
+  entry->mime_type = get_mime_type_for_file (fullname, statbuf);
 
   g_free (fullname);
 
@@ -2667,6 +3249,128 @@ fill_in_hidden (GtkFileFolderUnix *folder_unix)
   folder_unix->have_hidden = TRUE;
 }
 
+static void
+cb_clear_hidden (gpointer key, gpointer value, gpointer user_data)
+{
+  struct stat_info_entry *entry = value;
+
+  entry->hidden = FALSE;
+}
+
+static void
+emit_for_file (GtkFileFolderUnix *folder_unix,
+	       const char        *signal_name,
+	       const char        *filename)
+{
+  GtkFilePath *path;
+  GSList *paths;
+
+  path = filename_to_path (filename);
+  paths = g_slist_append (NULL, path);
+  g_signal_emit_by_name (folder_unix, signal_name, paths);
+  gtk_file_path_free (path);
+  g_slist_free (paths);
+}
+
+/* Keeps the cached stat_info of a folder in sync with the disk, instead
+ * of throwing it away after FOLDER_CACHE_LIFETIME.  Before load_folder()
+ * has run only the cache is updated, since it will report every child
+ * in its files-added anyway.  While a thread is reading the folder,
+ * changes are reported right away and the thread's copy of the same
+ * child is dropped, as is its copy of a child that was deleted.
+ */
+static void
+folder_monitor_changed (const gchar         *basename,
+			GtkFileMonitorEvent  event,
+			gpointer             data)
+{
+  GtkFileFolderUnix *folder_unix = data;
+  struct stat_info_entry *entry;
+  struct stat statbuf;
+  const char *signal_name;
+  char *filename;
+
+  if (event == GTK_FILE_MONITOR_EVENT_GONE || !basename)
+    {
+      /* The folder itself went away, or events were lost; in either
+       * case go back to re-reading it after FOLDER_CACHE_LIFETIME.
+       */
+      _gtk_file_monitor_remove (folder_unix->monitor_id);
+      folder_unix->monitor_id = 0;
+      folder_unix->asof = 0;
+
+      if (event == GTK_FILE_MONITOR_EVENT_GONE)
+	g_signal_emit_by_name (folder_unix, "deleted");
+      return;
+    }
+
+  if (!folder_unix->stat_info)
+    return;
+
+  g_object_ref (folder_unix);
+
+  if (folder_unix->have_hidden && strcmp (basename, HIDDEN_FILENAME) == 0)
+    {
+      g_hash_table_foreach (folder_unix->stat_info, cb_clear_hidden, NULL);
+      folder_unix->have_hidden = FALSE;
+    }
+
+  filename = g_build_filename (folder_unix->filename, basename, NULL);
+  entry = g_hash_table_lookup (folder_unix->stat_info, basename);
+  signal_name = NULL;
+
+  if (event != GTK_FILE_MONITOR_EVENT_DELETED &&
+      stat (filename, &statbuf) == -1 &&
+      (errno != ENOENT || lstat (filename, &statbuf) == -1))
+    event = GTK_FILE_MONITOR_EVENT_DELETED;
+
+  if (folder_unix->load_job)
+    {
+      if (event == GTK_FILE_MONITOR_EVENT_DELETED)
+	g_hash_table_insert (folder_unix->load_job->deleted,
+			     g_strdup (basename), GINT_TO_POINTER (TRUE));
+      else
+	g_hash_table_remove (folder_unix->load_job->deleted, basename);
+    }
+
+  if (event == GTK_FILE_MONITOR_EVENT_DELETED)
+    {
+      if (entry)
+	{
+	  g_hash_table_remove (folder_unix->stat_info, basename);
+	  signal_name = "files-removed";
+	}
+    }
+  else
+    {
+      if (entry)
+	signal_name = "files-changed";
+      else
+	{
+	  entry = g_new0 (struct stat_info_entry, 1);
+	  g_hash_table_insert (folder_unix->stat_info,
+			       g_strdup (basename),
+			       entry);
+	  signal_name = "files-added";
+	}
+
+      entry->statbuf = statbuf;
+
+      if ((folder_unix->types & GTK_FILE_INFO_MIME_TYPE) != 0)
+	{
+	  g_free (entry->mime_type);
+	  entry->mime_type = get_mime_type_for_file (filename, &statbuf);
+	}
+    }
+
+  if (signal_name &&
+      (folder_unix->is_finished_loading || folder_unix->load_job))
+    emit_for_file (folder_unix, signal_name, filename);
+
+  g_free (filename);
+  g_object_unref (folder_unix);
+}
+
 static GtkFilePath *
 filename_to_path (const char *filename)
 {
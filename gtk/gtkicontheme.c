@@ -38,6 +38,7 @@
 #include "gtkicontheme.h"
 #include "gtkiconfactory.h"
 #include "gtkiconcache.h"
+#include "gtkfilemonitor.h"
 #include "gtkbuiltincache.h"
 #include "gtkintl.h"
 #include "gtkmain.h"
@@ -74,6 +75,7 @@ struct _GtkIconThemePrivate
   guint themes_valid        : 1;
   guint check_reload        : 1;
   guint loading_themes      : 1;
+  guint dirs_monitored      : 1;
   
   char *current_theme;
   char *fallback_theme;
@@ -100,8 +102,29 @@ struct _GtkIconThemePrivate
   GList *dir_mtimes;
 
   gulong reset_styles_idle;
+
+  /* Icons loaded by gtk_icon_theme_load_icon(); PixbufCacheEntry ->
+   * GList link in pixbuf_lru, most recently used first.
+   */
+  GHashTable *pixbuf_cache;
+  GQueue *pixbuf_lru;
+  gsize pixbuf_cache_bytes;
+  guint pixbuf_cache_builtin_serial;
 };
 
+/* The most memory the icons in the pixbuf cache of a theme may take */
+#define PIXBUF_CACHE_MAX_BYTES (2 * 1024 * 1024)
+
+typedef struct
+{
+  gchar *icon_name;
+  gint size;
+  GtkIconLookupFlags flags;
+
+  GdkPixbuf *pixbuf;
+  gsize n_bytes;
+} PixbufCacheEntry;
+
 struct _GtkIconInfo
 {
   /* Information about the source
@@ -186,6 +209,7 @@ typedef struct
   time_t mtime; /* 0 == not existing or not a dir */
 
   GtkIconCache *cache;
+  guint monitor;
 } IconThemeDirMtime;
 
 static void  gtk_icon_theme_finalize   (GObject              *object);
@@ -207,6 +231,7 @@ static void         theme_subdir_load (GtkIconTheme     *icon_theme,
 static void         do_theme_change   (GtkIconTheme     *icon_theme);
 
 static void     blow_themes               (GtkIconTheme    *icon_themes);
+static void     pixbuf_cache_clear        (GtkIconTheme    *icon_theme);
 static gboolean rescan_themes             (GtkIconTheme    *icon_themes);
 
 static void  icon_data_free            (GtkIconData     *icon_data);
@@ -232,6 +257,8 @@ static BuiltinIcon *find_builtin_icon (const gchar *icon_name,
 static guint signal_changed = 0;
 
 static GHashTable *icon_theme_builtin_icons;
+/* bumped when a builtin icon is added, which may change lookups */
+static guint icon_theme_builtin_serial = 0;
 
 /* also used in gtkiconfactory.c */
 GtkIconCache *_builtin_cache = NULL;
@@ -540,6 +567,34 @@ pixbuf_supports_svg (void)
   return found_svg;
 }
 
+static guint
+pixbuf_cache_entry_hash (gconstpointer key)
+{
+  const PixbufCacheEntry *entry = key;
+
+  return g_str_hash (entry->icon_name) ^ (entry->size << 8) ^ entry->flags;
+}
+
+static gboolean
+pixbuf_cache_entry_equal (gconstpointer a,
+			  gconstpointer b)
+{
+  const PixbufCacheEntry *ea = a;
+  const PixbufCacheEntry *eb = b;
+
+  return ea->size == eb->size &&
+    ea->flags == eb->flags &&
+    strcmp (ea->icon_name, eb->icon_name) == 0;
+}
+
+static void
+pixbuf_cache_entry_free (PixbufCacheEntry *entry)
+{
+  g_free (entry->icon_name);
+  g_object_unref (entry->pixbuf);
+  g_free (entry);
+}
+
 static void
 gtk_icon_theme_init (GtkIconTheme *icon_theme)
 {
@@ -575,11 +630,19 @@ gtk_icon_theme_init (GtkIconTheme *icon_theme)
   priv->unthemed_icons = NULL;
   
   priv->pixbuf_supports_svg = pixbuf_supports_svg ();
+
+  priv->pixbuf_cache = g_hash_table_new (pixbuf_cache_entry_hash,
+					 pixbuf_cache_entry_equal);
+  priv->pixbuf_lru = g_queue_new ();
+  priv->pixbuf_cache_builtin_serial = icon_theme_builtin_serial;
 }
 
 static void
 free_dir_mtime (IconThemeDirMtime *dir_mtime)
 {
+  if (dir_mtime->monitor)
+    _gtk_file_monitor_remove (dir_mtime->monitor);
+
   if (dir_mtime->cache)
     _gtk_icon_cache_unref (dir_mtime->cache);
 
@@ -636,6 +699,8 @@ blow_themes (GtkIconTheme *icon_theme)
 {
   GtkIconThemePrivate *priv = icon_theme->priv;
   
+  pixbuf_cache_clear (icon_theme);
+
   if (priv->themes_valid)
     {
       g_hash_table_destroy (priv->all_icons);
@@ -650,6 +715,7 @@ blow_themes (GtkIconTheme *icon_theme)
   priv->dir_mtimes = NULL;
   priv->all_icons = NULL;
   priv->themes_valid = FALSE;
+  priv->dirs_monitored = FALSE;
 }
 
 static void
@@ -681,6 +747,9 @@ gtk_icon_theme_finalize (GObject *object)
 
   blow_themes (icon_theme);
 
+  g_hash_table_destroy (priv->pixbuf_cache);
+  g_queue_free (priv->pixbuf_lru);
+
   G_OBJECT_CLASS (gtk_icon_theme_parent_class)->finalize (object);  
 }
 
@@ -909,6 +978,7 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
 			       NULL);
       dir_mtime = g_slice_new (IconThemeDirMtime);
       dir_mtime->cache = NULL;
+      dir_mtime->monitor = 0;
       dir_mtime->dir = path;
       if (g_stat (path, &stat_buf) == 0 && S_ISDIR (stat_buf.st_mode))
 	dir_mtime->mtime = stat_buf.st_mtime;
@@ -1025,6 +1095,67 @@ strip_suffix (const char *filename)
   return g_strndup (filename, dot - filename);
 }
 
+static void
+theme_dir_changed (const gchar         *basename,
+		   GtkFileMonitorEvent  event,
+		   gpointer             data)
+{
+  GtkIconTheme *icon_theme = data;
+
+  /* rescan_themes() only looks at directory mtimes, which don't
+   * change when a file is merely rewritten in place.
+   */
+  if (event == GTK_FILE_MONITOR_EVENT_CHANGED && basename)
+    return;
+
+  if (rescan_themes (icon_theme))
+    do_theme_change (icon_theme);
+}
+
+/* Watches the directories whose mtimes rescan_themes() compares, so
+ * that ensure_valid_themes() doesn't have to stat them every few
+ * seconds.  A directory that doesn't exist yet is covered by watching
+ * its closest existing ancestor.  If any of them can't be watched, we
+ * fall back to polling.
+ */
+static void
+monitor_theme_dirs (GtkIconTheme *icon_theme)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  IconThemeDirMtime *dir_mtime;
+  GList *d;
+  gchar *path, *parent;
+
+  priv->dirs_monitored = TRUE;
+
+  for (d = priv->dir_mtimes; d != NULL; d = d->next)
+    {
+      dir_mtime = d->data;
+
+      path = g_strdup (dir_mtime->dir);
+      while (TRUE)
+	{
+	  dir_mtime->monitor = _gtk_file_monitor_add (path, theme_dir_changed,
+						      icon_theme);
+	  if (dir_mtime->monitor || dir_mtime->mtime != 0)
+	    break;
+
+	  parent = g_path_get_dirname (path);
+	  if (strcmp (parent, path) == 0)
+	    {
+	      g_free (parent);
+	      break;
+	    }
+	  g_free (path);
+	  path = parent;
+	}
+      g_free (path);
+
+      if (!dir_mtime->monitor)
+	priv->dirs_monitored = FALSE;
+    }
+}
+
 static void
 load_themes (GtkIconTheme *icon_theme)
 {
@@ -1066,6 +1197,7 @@ load_themes (GtkIconTheme *icon_theme)
       dir_mtime->dir = g_strdup (dir);
       dir_mtime->mtime = 0;
       dir_mtime->cache = NULL;
+      dir_mtime->monitor = 0;
 
       if (g_stat (dir, &stat_buf) != 0 || !S_ISDIR (stat_buf.st_mode))
 	continue;
@@ -1141,6 +1273,8 @@ load_themes (GtkIconTheme *icon_theme)
     }
 
   priv->themes_valid = TRUE;
+
+  monitor_theme_dirs (icon_theme);
   
   g_get_current_time(&tv);
   priv->last_stat_time = tv.tv_sec;
@@ -1194,7 +1328,8 @@ ensure_valid_themes (GtkIconTheme *icon_theme)
     {
       g_get_current_time (&tv);
 
-      if (ABS (tv.tv_sec - priv->last_stat_time) > 5 &&
+      if (!priv->dirs_monitored &&
+	  ABS (tv.tv_sec - priv->last_stat_time) > 5 &&
 	  rescan_themes (icon_theme))
 	blow_themes (icon_theme);
     }
@@ -1357,6 +1492,93 @@ gtk_icon_theme_error_quark (void)
   return g_quark_from_static_string ("gtk-icon-theme-error-quark");
 }
 
+static void
+pixbuf_cache_clear (GtkIconTheme *icon_theme)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  PixbufCacheEntry *entry;
+
+  g_hash_table_remove_all (priv->pixbuf_cache);
+  while ((entry = g_queue_pop_head (priv->pixbuf_lru)) != NULL)
+    pixbuf_cache_entry_free (entry);
+  priv->pixbuf_cache_bytes = 0;
+}
+
+/* Returns a new reference to the icon that gtk_icon_theme_load_icon()
+ * returned for the same arguments before, or %NULL.
+ */
+static GdkPixbuf *
+pixbuf_cache_lookup (GtkIconTheme       *icon_theme,
+		     const gchar        *icon_name,
+		     gint                size,
+		     GtkIconLookupFlags  flags)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  PixbufCacheEntry key;
+  PixbufCacheEntry *entry;
+  GList *link;
+
+  if (priv->pixbuf_cache_builtin_serial != icon_theme_builtin_serial)
+    {
+      pixbuf_cache_clear (icon_theme);
+      priv->pixbuf_cache_builtin_serial = icon_theme_builtin_serial;
+      return NULL;
+    }
+
+  key.icon_name = (gchar *) icon_name;
+  key.size = size;
+  key.flags = flags;
+
+  link = g_hash_table_lookup (priv->pixbuf_cache, &key);
+  if (!link)
+    return NULL;
+
+  g_queue_unlink (priv->pixbuf_lru, link);
+  g_queue_push_head_link (priv->pixbuf_lru, link);
+
+  entry = link->data;
+
+  return g_object_ref (entry->pixbuf);
+}
+
+static void
+pixbuf_cache_insert (GtkIconTheme       *icon_theme,
+		     const gchar        *icon_name,
+		     gint                size,
+		     GtkIconLookupFlags  flags,
+		     GdkPixbuf          *pixbuf)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  PixbufCacheEntry *entry;
+  gsize n_bytes;
+
+  n_bytes = gdk_pixbuf_get_rowstride (pixbuf) * gdk_pixbuf_get_height (pixbuf);
+
+  /* don't let one huge icon push out all others */
+  if (n_bytes > PIXBUF_CACHE_MAX_BYTES / 8)
+    return;
+
+  entry = g_new (PixbufCacheEntry, 1);
+  entry->icon_name = g_strdup (icon_name);
+  entry->size = size;
+  entry->flags = flags;
+  entry->pixbuf = g_object_ref (pixbuf);
+  entry->n_bytes = n_bytes;
+
+  g_queue_push_head (priv->pixbuf_lru, entry);
+  g_hash_table_insert (priv->pixbuf_cache, entry, priv->pixbuf_lru->head);
+  priv->pixbuf_cache_bytes += n_bytes;
+
+  while (priv->pixbuf_cache_bytes > PIXBUF_CACHE_MAX_BYTES)
+    {
+      PixbufCacheEntry *old = g_queue_pop_tail (priv->pixbuf_lru);
+
+      g_hash_table_remove (priv->pixbuf_cache, old);
+      priv->pixbuf_cache_bytes -= old->n_bytes;
+      pixbuf_cache_entry_free (old);
+    }
+}
+
 /**
  * gtk_icon_theme_load_icon:
  * @icon_theme: a #GtkIconTheme
@@ -1371,6 +1593,10 @@ gtk_icon_theme_error_quark (void)
  * if more details about the icon are needed, use
  * gtk_icon_theme_lookup_icon() followed by gtk_icon_info_load_icon().
  *
+ * Recently loaded icons are kept in a cache, so loading the same
+ * icon at the same size again returns another reference to the same
+ * pixbuf. The cache is emptied when the icon theme changes.
+ *
  * Note that you probably want to listen for icon theme changes and
  * update the icon. This is usually done by connecting to the 
  * GtkWidget::style-set signal. If for some reason you do not want to
@@ -1402,6 +1628,13 @@ gtk_icon_theme_load_icon (GtkIconTheme         *icon_theme,
 			(flags & GTK_ICON_LOOKUP_FORCE_SVG) == 0, NULL);
   g_return_val_if_fail (error == NULL || *error == NULL, NULL);
   
+  /* this notices changes to the theme, which clear the cache */
+  ensure_valid_themes (icon_theme);
+
+  pixbuf = pixbuf_cache_lookup (icon_theme, icon_name, size, flags);
+  if (pixbuf)
+    return pixbuf;
+
   icon_info  = gtk_icon_theme_lookup_icon (icon_theme, icon_name, size,
 					   flags | GTK_ICON_LOOKUP_USE_BUILTIN);
   if (!icon_info)
@@ -1414,6 +1647,9 @@ gtk_icon_theme_load_icon (GtkIconTheme         *icon_theme,
   pixbuf = gtk_icon_info_load_icon (icon_info, error);
   gtk_icon_info_free (icon_info);
 
+  if (pixbuf)
+    pixbuf_cache_insert (icon_theme, icon_name, size, flags, pixbuf);
+
   return pixbuf;
 }
 
@@ -3012,6 +3248,8 @@ gtk_icon_theme_add_builtin_icon (const gchar *icon_name,
   /* Replaces value, leaves key untouched
    */
   g_hash_table_insert (icon_theme_builtin_icons, key, icons);
+
+  icon_theme_builtin_serial++;
 }
 
 /* Look up a builtin icon; the min_difference_p and
@@ -48,6 +48,9 @@
 
 #define SCROLL_EDGE_SIZE 15
 
+/* Number of items laid out per idle in incremental mode */
+#define LAYOUT_BATCH_SIZE 200
+
 #define GTK_ICON_VIEW_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_ICON_VIEW, GtkIconViewPrivate))
 
 typedef struct _GtkIconViewItem GtkIconViewItem;
@@ -77,6 +80,17 @@ struct _GtkIconViewItem
 
 };
 
+/* A row of items, as laid out by gtk_icon_view_layout() */
+typedef struct _GtkIconViewRow GtkIconViewRow;
+struct _GtkIconViewRow
+{
+  /* Index of the first item of the row in priv->layout_items */
+  gint first;
+
+  /* Vertical extent of the items in the row */
+  gint y1, y2;
+};
+
 typedef struct _GtkIconViewCellInfo GtkIconViewCellInfo;
 struct _GtkIconViewCellInfo
 {
@@ -116,6 +130,24 @@ struct _GtkIconViewPrivate
   GtkTreeModel *model;
   
   GList *items;
+
+  /* The items in an array and their rows, as of the last layout.
+   * Rows are sorted by position, so that the items in an area can be
+   * found by binary search. Both are NULL while a layout is pending.
+   */
+  GPtrArray *layout_items;
+  GArray *layout_rows;
+
+  /* State of a layout that is done in idle batches. layout_next is
+   * the first item of the next row to lay out, or NULL once all rows
+   * are in the row index.
+   */
+  GList *layout_next;
+  gint layout_y;
+  gint layout_row;
+  gint layout_item_width;
+  gint layout_max_width;
+  gint layout_n_items;
   
   GtkAdjustment *hadjustment;
   GtkAdjustment *vadjustment;
@@ -186,6 +218,9 @@ struct _GtkIconViewPrivate
 
   guint ctrl_pressed : 1;
   guint shift_pressed : 1;  
+
+  guint fixed_item_size : 1;
+  guint incremental_layout : 1;
 };
 
 /* Signals */
@@ -218,7 +253,9 @@ enum
   PROP_ROW_SPACING,
   PROP_COLUMN_SPACING,
   PROP_MARGIN,
-  PROP_REORDERABLE
+  PROP_REORDERABLE,
+  PROP_FIXED_ITEM_SIZE,
+  PROP_INCREMENTAL_LAYOUT
 };
 
 /* GObject vfuncs */
@@ -297,6 +334,9 @@ static void                 gtk_icon_view_queue_draw_path                (GtkIco
 static void                 gtk_icon_view_queue_draw_item                (GtkIconView            *icon_view,
 									  GtkIconViewItem        *item);
 static void                 gtk_icon_view_queue_layout                   (GtkIconView            *icon_view);
+static void                 gtk_icon_view_free_row_index                 (GtkIconView            *icon_view);
+static gint                 gtk_icon_view_find_row                       (GtkIconView            *icon_view,
+									  gint                    y);
 static void                 gtk_icon_view_set_cursor_item                (GtkIconView            *icon_view,
 									  GtkIconViewItem        *item,
 									  gint                    cursor_cell);
@@ -317,6 +357,12 @@ static void                 gtk_icon_view_calculate_item_size            (GtkIco
 static void                 gtk_icon_view_calculate_item_size2           (GtkIconView            *icon_view,
 									  GtkIconViewItem        *item,
 									  gint                   *max_height);
+static void                 gtk_icon_view_size_item                      (GtkIconView            *icon_view,
+									  GtkIconViewItem        *item);
+static void                 gtk_icon_view_copy_item_layout               (GtkIconView            *icon_view,
+									  GtkIconViewItem        *template,
+									  GtkIconViewItem        *item);
+static void                 gtk_icon_view_layout_incremental             (GtkIconView            *icon_view);
 static void                 gtk_icon_view_update_rubberband              (gpointer                data);
 static void                 gtk_icon_view_item_invalidate_size           (GtkIconViewItem        *item);
 static void                 gtk_icon_view_invalidate_sizes               (GtkIconView            *icon_view);
@@ -719,6 +765,43 @@ gtk_icon_view_class_init (GtkIconViewClass *klass)
 							 FALSE,
 							 G_PARAM_READWRITE));
 
+  /**
+   * GtkIconView:fixed-item-size:
+   *
+   * Setting the ::fixed-item-size property to %TRUE speeds up 
+   * #GtkIconView by assuming that all items have the same size. 
+   * Only the first item is measured by the cell renderers; all other
+   * items are given its size and cell positions.
+   *
+   * Since: 2.12
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_FIXED_ITEM_SIZE,
+                                   g_param_spec_boolean ("fixed-item-size",
+							 P_("Fixed Item Size"),
+							 P_("Speeds up GtkIconView by assuming that all items have the same size"),
+							 FALSE,
+							 GTK_PARAM_READWRITE));
+
+  /**
+   * GtkIconView:incremental-layout:
+   *
+   * If the ::incremental-layout property is %TRUE, the items are 
+   * laid out a few rows at a time when the view is idle instead of 
+   * all at once, starting with the rows that are visible. Until 
+   * all rows are done, the size of the view is estimated from the 
+   * rows laid out so far.
+   *
+   * Since: 2.12
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_INCREMENTAL_LAYOUT,
+                                   g_param_spec_boolean ("incremental-layout",
+							 P_("Incremental Layout"),
+							 P_("Whether items are laid out in batches when idle"),
+							 FALSE,
+							 GTK_PARAM_READWRITE));
+
   /* Style properties */
   gtk_widget_class_install_style_property (widget_class,
                                            g_param_spec_boxed ("selection-box-color",
@@ -1036,6 +1119,12 @@ gtk_icon_view_set_property (GObject      *object,
     case PROP_REORDERABLE:
       gtk_icon_view_set_reorderable (icon_view, g_value_get_boolean (value));
       break;
+    case PROP_FIXED_ITEM_SIZE:
+      gtk_icon_view_set_fixed_item_size (icon_view, g_value_get_boolean (value));
+      break;
+    case PROP_INCREMENTAL_LAYOUT:
+      gtk_icon_view_set_incremental_layout (icon_view, g_value_get_boolean (value));
+      break;
       
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -1094,6 +1183,12 @@ gtk_icon_view_get_property (GObject      *object,
     case PROP_REORDERABLE:
       g_value_set_boolean (value, icon_view->priv->reorderable);
       break;
+    case PROP_FIXED_ITEM_SIZE:
+      g_value_set_boolean (value, icon_view->priv->fixed_item_size);
+      break;
+    case PROP_INCREMENTAL_LAYOUT:
+      g_value_set_boolean (value, icon_view->priv->incremental_layout);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -1270,7 +1365,9 @@ gtk_icon_view_size_allocate (GtkWidget      *widget,
   GtkIconView *icon_view = GTK_ICON_VIEW (widget);
 
   GtkAdjustment *hadjustment, *vadjustment;
+  gint old_width;
 
+  old_width = widget->allocation.width;
   widget->allocation = *allocation;
   
   if (GTK_WIDGET_REALIZED (widget))
@@ -1283,7 +1380,11 @@ gtk_icon_view_size_allocate (GtkWidget      *widget,
 			 MAX (icon_view->priv->height, allocation->height));
     }
 
-  gtk_icon_view_layout (icon_view);
+  if (!icon_view->priv->incremental_layout)
+    gtk_icon_view_layout (icon_view);
+  else if (icon_view->priv->layout_rows == NULL || 
+	   allocation->width != old_width)
+    gtk_icon_view_layout_incremental (icon_view);
   
   gtk_icon_view_allocate_children (icon_view);
 
@@ -1329,6 +1430,32 @@ gtk_icon_view_size_allocate (GtkWidget      *widget,
     }
 }
 
+static void
+gtk_icon_view_expose_item (GtkIconView      *icon_view,
+			   cairo_t          *cr,
+			   GdkEventExpose   *expose,
+			   GtkIconViewItem  *item,
+			   gint              dest_index,
+			   GtkIconViewItem **dest_item)
+{
+  GdkRectangle area;
+      
+  area.x = item->x;
+  area.y = item->y;
+  area.width = item->width;
+  area.height = item->height;
+	
+  if (gdk_region_rect_in (expose->region, &area) == GDK_OVERLAP_RECTANGLE_OUT)
+    return;
+      
+  gtk_icon_view_paint_item (icon_view, cr, item, &expose->area, 
+			    icon_view->priv->bin_window,
+			    item->x, item->y, TRUE); 
+ 
+  if (dest_index == item->index)
+    *dest_item = item;
+}
+
 static gboolean
 gtk_icon_view_expose (GtkWidget *widget,
 		      GdkEventExpose *expose)
@@ -1359,25 +1486,39 @@ gtk_icon_view_expose (GtkWidget *widget,
   else
     dest_index = -1;
 
-  for (icons = icon_view->priv->items; icons; icons = icons->next) 
+  if (icon_view->priv->layout_rows)
     {
-      GtkIconViewItem *item = icons->data;
-      GdkRectangle area;
-      
-      area.x = item->x;
-      area.y = item->y;
-      area.width = item->width;
-      area.height = item->height;
-	
-      if (gdk_region_rect_in (expose->region, &area) == GDK_OVERLAP_RECTANGLE_OUT)
-	continue;
-      
-      gtk_icon_view_paint_item (icon_view, cr, item, &expose->area, 
-				icon_view->priv->bin_window,
-				item->x, item->y, TRUE); 
- 
-      if (dest_index == item->index)
-	dest_item = item;
+      GPtrArray *items = icon_view->priv->layout_items;
+      GArray *rows = icon_view->priv->layout_rows;
+      gint row, i;
+
+      /* Only look at the rows that intersect the exposed area */
+      for (row = gtk_icon_view_find_row (icon_view, expose->area.y);
+	   row < rows->len &&
+	     g_array_index (rows, GtkIconViewRow, row).y1 < expose->area.y + expose->area.height;
+	   row++)
+	{
+	  gint last;
+
+	  if (row + 1 < rows->len)
+	    last = g_array_index (rows, GtkIconViewRow, row + 1).first;
+	  else
+	    last = items->len;
+
+	  for (i = g_array_index (rows, GtkIconViewRow, row).first; i < last; i++)
+	    {
+	      GtkIconViewItem *item = g_ptr_array_index (items, i);
+
+	      gtk_icon_view_expose_item (icon_view, cr, expose, item,
+					 dest_index, &dest_item);
+	    }
+	}
+    }
+  else
+    {
+      for (icons = icon_view->priv->items; icons; icons = icons->next) 
+	gtk_icon_view_expose_item (icon_view, cr, expose, icons->data,
+				   dest_index, &dest_item);
     }
 
   if (dest_item)
@@ -2442,7 +2583,7 @@ gtk_icon_view_layout_single_row (GtkIconView *icon_view,
     {
       GtkIconViewItem *item = items->data;
 
-      gtk_icon_view_calculate_item_size (icon_view, item);
+      gtk_icon_view_size_item (icon_view, item);
       colspan = 1 + (item->width - 1) / (item_width + icon_view->priv->column_spacing);
 
       item->width = colspan * item_width + (colspan - 1) * icon_view->priv->column_spacing;
@@ -2483,7 +2624,12 @@ gtk_icon_view_layout_single_row (GtkIconView *icon_view,
     {
       GtkIconViewItem *item = items->data;
 
-      gtk_icon_view_calculate_item_size2 (icon_view, item, max_height);
+      if (icon_view->priv->fixed_item_size && 
+	  items != icon_view->priv->items)
+	gtk_icon_view_copy_item_layout (icon_view, 
+					icon_view->priv->items->data, item);
+      else
+	gtk_icon_view_calculate_item_size2 (icon_view, item, max_height);
 
       /* We may want to readjust the new y coordinate. */
       if (item->y + item->height + focus_width + icon_view->priv->row_spacing > *y)
@@ -2522,58 +2668,110 @@ gtk_icon_view_set_adjustment_upper (GtkAdjustment *adj,
     }
 }
 
+/* Sets up the row index and the layout state for laying out all
+ * items from the top.
+ */
 static void
-gtk_icon_view_layout (GtkIconView *icon_view)
+gtk_icon_view_layout_start (GtkIconView *icon_view)
 {
-  gint y = 0, maximum_width = 0;
   GList *icons;
-  GtkWidget *widget;
-  gint row;
   gint item_width;
-
-  if (icon_view->priv->layout_idle_id != 0)
-    {
-      g_source_remove (icon_view->priv->layout_idle_id);
-      icon_view->priv->layout_idle_id = 0;
-    }
-  
-  if (icon_view->priv->model == NULL)
-    return;
-
-  widget = GTK_WIDGET (icon_view);
+  gint n;
 
   item_width = icon_view->priv->item_width;
 
-  if (item_width < 0)
+  if (item_width < 0 && icon_view->priv->items)
     {
-      for (icons = icon_view->priv->items; icons; icons = icons->next)
+      if (icon_view->priv->fixed_item_size)
+	{
+	  /* All items have the size of the first one */
+	  gtk_icon_view_size_item (icon_view, icon_view->priv->items->data);
+	  item_width = ((GtkIconViewItem *)icon_view->priv->items->data)->width;
+	}
+      else
 	{
-	  GtkIconViewItem *item = icons->data;
-	  gtk_icon_view_calculate_item_size (icon_view, item);
-	  item_width = MAX (item_width, item->width);
+	  /* In incremental mode, the item width is guessed from the
+	   * first batch of items; wider items later on simply span
+	   * several columns.
+	   */
+	  for (icons = icon_view->priv->items, n = 0; 
+	       icons && (!icon_view->priv->incremental_layout || n < LAYOUT_BATCH_SIZE); 
+	       icons = icons->next, n++)
+	    {
+	      GtkIconViewItem *item = icons->data;
+	      gtk_icon_view_calculate_item_size (icon_view, item);
+	      item_width = MAX (item_width, item->width);
+	    }
 	}
     }
 
-  icons = icon_view->priv->items;
-  y += icon_view->priv->margin;
-  row = 0;
-  
-  do
+  gtk_icon_view_free_row_index (icon_view);
+  icon_view->priv->layout_items = g_ptr_array_new ();
+  icon_view->priv->layout_rows = g_array_new (FALSE, FALSE, sizeof (GtkIconViewRow));
+
+  /* Items that are not laid out yet must not be found by row and column */
+  n = 0;
+  for (icons = icon_view->priv->items; icons; icons = icons->next, n++)
     {
-      icons = gtk_icon_view_layout_single_row (icon_view, icons, 
-					       item_width, row,
-					       &y, &maximum_width);
-      row++;
+      GtkIconViewItem *item = icons->data;
+
+      item->row = -1;
+      item->col = -1;
     }
-  while (icons != NULL);
 
-  if (maximum_width != icon_view->priv->width)
-    icon_view->priv->width = maximum_width;
+  icon_view->priv->layout_next = icon_view->priv->items;
+  icon_view->priv->layout_y = icon_view->priv->margin;
+  icon_view->priv->layout_row = 0;
+  icon_view->priv->layout_item_width = item_width;
+  icon_view->priv->layout_max_width = 0;
+  icon_view->priv->layout_n_items = n;
+}
 
-  y += icon_view->priv->margin;
-  
-  if (y != icon_view->priv->height)
-    icon_view->priv->height = y;
+/* Lays out the next row of items and adds it to the row index.
+ * Returns the number of items in the row.
+ */
+static gint
+gtk_icon_view_layout_next_row (GtkIconView *icon_view)
+{
+  GList *first, *l;
+  GtkIconViewRow row_info;
+
+  first = icon_view->priv->layout_next;
+  icon_view->priv->layout_next = 
+    gtk_icon_view_layout_single_row (icon_view, first,
+				     icon_view->priv->layout_item_width, 
+				     icon_view->priv->layout_row,
+				     &icon_view->priv->layout_y, 
+				     &icon_view->priv->layout_max_width);
+  icon_view->priv->layout_row++;
+
+  row_info.first = icon_view->priv->layout_items->len;
+  row_info.y1 = G_MAXINT;
+  row_info.y2 = G_MININT;
+
+  for (l = first; l != icon_view->priv->layout_next; l = l->next)
+    {
+      GtkIconViewItem *item = l->data;
+
+      g_ptr_array_add (icon_view->priv->layout_items, item);
+      row_info.y1 = MIN (row_info.y1, item->y);
+      row_info.y2 = MAX (row_info.y2, item->y + item->height);
+    }
+
+  g_array_append_val (icon_view->priv->layout_rows, row_info);
+
+  return icon_view->priv->layout_items->len - row_info.first;
+}
+
+static void
+gtk_icon_view_layout_set_size (GtkIconView *icon_view,
+			       gint         width,
+			       gint         height)
+{
+  GtkWidget *widget = GTK_WIDGET (icon_view);
+
+  icon_view->priv->width = width;
+  icon_view->priv->height = height;
 
   gtk_icon_view_set_adjustment_upper (icon_view->priv->hadjustment, 
 				      icon_view->priv->width);
@@ -2588,6 +2786,14 @@ gtk_icon_view_layout (GtkIconView *icon_view)
     gdk_window_resize (icon_view->priv->bin_window,
 		       MAX (icon_view->priv->width, widget->allocation.width),
 		       MAX (icon_view->priv->height, widget->allocation.height));
+}
+
+static void
+gtk_icon_view_layout_finish (GtkIconView *icon_view)
+{
+  gtk_icon_view_layout_set_size (icon_view, 
+				 icon_view->priv->layout_max_width,
+				 icon_view->priv->layout_y + icon_view->priv->margin);
 
   if (icon_view->priv->scroll_to_path)
     {
@@ -2604,7 +2810,79 @@ gtk_icon_view_layout (GtkIconView *icon_view)
       gtk_tree_path_free (path);
     }
   
-  gtk_widget_queue_draw (widget);
+  gtk_widget_queue_draw (GTK_WIDGET (icon_view));
+}
+
+static void
+gtk_icon_view_layout (GtkIconView *icon_view)
+{
+  if (icon_view->priv->layout_idle_id != 0)
+    {
+      g_source_remove (icon_view->priv->layout_idle_id);
+      icon_view->priv->layout_idle_id = 0;
+    }
+  
+  if (icon_view->priv->model == NULL)
+    return;
+
+  gtk_icon_view_layout_start (icon_view);
+
+  while (icon_view->priv->layout_next)
+    gtk_icon_view_layout_next_row (icon_view);
+
+  gtk_icon_view_layout_finish (icon_view);
+}
+
+/* Lays out a batch of rows, continuing an incremental layout or 
+ * starting a new one. The batch extends at least to the bottom of 
+ * the visible area. Until the last row is done, the height of the 
+ * view is estimated from the average height of the rows so far.
+ *
+ * Returns %TRUE if there are more rows to lay out.
+ */
+static gboolean
+gtk_icon_view_layout_step (GtkIconView *icon_view)
+{
+  GtkAdjustment *vadj = icon_view->priv->vadjustment;
+  gint n_laid_out, n_rows, n_remaining;
+  gint row_height, per_row;
+  gint bottom, n;
+
+  if (icon_view->priv->model == NULL)
+    return FALSE;
+
+  if (icon_view->priv->layout_rows == NULL)
+    gtk_icon_view_layout_start (icon_view);
+  else if (icon_view->priv->layout_next == NULL)
+    return FALSE;
+
+  bottom = vadj->value + vadj->page_size;
+  n = 0;
+  while (icon_view->priv->layout_next &&
+	 (n < LAYOUT_BATCH_SIZE || icon_view->priv->layout_y < bottom))
+    n += gtk_icon_view_layout_next_row (icon_view);
+
+  if (icon_view->priv->layout_next == NULL)
+    {
+      gtk_icon_view_layout_finish (icon_view);
+      return FALSE;
+    }
+
+  n_laid_out = icon_view->priv->layout_items->len;
+  n_rows = icon_view->priv->layout_rows->len;
+  n_remaining = icon_view->priv->layout_n_items - n_laid_out;
+  per_row = MAX (1, n_laid_out / n_rows);
+  row_height = (icon_view->priv->layout_y - icon_view->priv->margin) / n_rows;
+
+  gtk_icon_view_layout_set_size (icon_view,
+				 icon_view->priv->layout_max_width,
+				 icon_view->priv->layout_y
+				 + (n_remaining + per_row - 1) / per_row * row_height
+				 + icon_view->priv->margin);
+
+  gtk_widget_queue_draw (GTK_WIDGET (icon_view));
+
+  return TRUE;
 }
 
 static void 
@@ -2676,15 +2954,9 @@ adjust_wrap_width (GtkIconView     *icon_view,
 }
 
 static void
-gtk_icon_view_calculate_item_size (GtkIconView     *icon_view,
-				   GtkIconViewItem *item)
+gtk_icon_view_item_ensure_cells (GtkIconView     *icon_view,
+				 GtkIconViewItem *item)
 {
-  gint spacing;
-  GList *l;
-
-  if (item->width != -1 && item->height != -1) 
-    return;
-
   if (item->n_cells != icon_view->priv->n_cells)
     {
       g_free (item->before);
@@ -2697,6 +2969,19 @@ gtk_icon_view_calculate_item_size (GtkIconView     *icon_view,
 
       item->n_cells = icon_view->priv->n_cells;
     }
+}
+
+static void
+gtk_icon_view_calculate_item_size (GtkIconView     *icon_view,
+				   GtkIconViewItem *item)
+{
+  gint spacing;
+  GList *l;
+
+  if (item->width != -1 && item->height != -1) 
+    return;
+
+  gtk_icon_view_item_ensure_cells (icon_view, item);
 
   gtk_icon_view_set_cell_data (icon_view, item);
 
@@ -2817,6 +3102,62 @@ gtk_icon_view_calculate_item_size2 (GtkIconView     *icon_view,
     }	
 }
 
+/* Computes the size of @item, or in fixed-item-size mode copies
+ * the size of the first item, which is always sized first.
+ */
+static void
+gtk_icon_view_size_item (GtkIconView     *icon_view,
+			 GtkIconViewItem *item)
+{
+  GtkIconViewItem *template;
+  gint i;
+
+  template = icon_view->priv->items->data;
+
+  if (!icon_view->priv->fixed_item_size || item == template)
+    {
+      gtk_icon_view_calculate_item_size (icon_view, item);
+      return;
+    }
+
+  gtk_icon_view_item_ensure_cells (icon_view, item);
+
+  item->width = template->width;
+  item->height = template->height;
+  for (i = 0; i < icon_view->priv->n_cells; i++)
+    {
+      item->box[i].width = template->box[i].width;
+      item->box[i].height = template->box[i].height;
+    }
+}
+
+/* Used instead of gtk_icon_view_calculate_item_size2() in 
+ * fixed-item-size mode: gives @item the cell positions of 
+ * @template, moved to the position of @item.
+ */
+static void
+gtk_icon_view_copy_item_layout (GtkIconView     *icon_view,
+				GtkIconViewItem *template,
+				GtkIconViewItem *item)
+{
+  gint dx, dy;
+  gint i;
+
+  dx = item->x - template->x;
+  dy = item->y - template->y;
+
+  item->width = template->width;
+  item->height = template->height;
+  for (i = 0; i < icon_view->priv->n_cells; i++)
+    {
+      item->box[i] = template->box[i];
+      item->box[i].x += dx;
+      item->box[i].y += dy;
+      item->before[i] = template->before[i];
+      item->after[i] = template->after[i];
+    }
+}
+
 static void
 gtk_icon_view_invalidate_sizes (GtkIconView *icon_view)
 {
@@ -3080,18 +3421,83 @@ layout_callback (gpointer user_data)
 
   icon_view = GTK_ICON_VIEW (user_data);
   
+  if (icon_view->priv->incremental_layout &&
+      gtk_icon_view_layout_step (icon_view))
+    {
+      GDK_THREADS_LEAVE ();
+
+      return TRUE;
+    }
+
   icon_view->priv->layout_idle_id = 0;
 
-  gtk_icon_view_layout (icon_view);
+  if (!icon_view->priv->incremental_layout)
+    gtk_icon_view_layout (icon_view);
   
   GDK_THREADS_LEAVE();
 
   return FALSE;
 }
 
+/* Restarts an incremental layout, doing the first batch right away
+ * and the rest when idle.
+ */
+static void
+gtk_icon_view_layout_incremental (GtkIconView *icon_view)
+{
+  gtk_icon_view_free_row_index (icon_view);
+
+  if (gtk_icon_view_layout_step (icon_view) &&
+      icon_view->priv->layout_idle_id == 0)
+    icon_view->priv->layout_idle_id = g_idle_add (layout_callback, icon_view);
+}
+
+static void
+gtk_icon_view_free_row_index (GtkIconView *icon_view)
+{
+  if (icon_view->priv->layout_rows)
+    {
+      g_ptr_array_free (icon_view->priv->layout_items, TRUE);
+      g_array_free (icon_view->priv->layout_rows, TRUE);
+      icon_view->priv->layout_items = NULL;
+      icon_view->priv->layout_rows = NULL;
+    }
+
+  icon_view->priv->layout_next = NULL;
+}
+
+/* Returns the index of the first row in the row index whose items
+ * extend below @y, or the number of rows if there is none.
+ */
+static gint
+gtk_icon_view_find_row (GtkIconView *icon_view,
+			gint         y)
+{
+  GArray *rows = icon_view->priv->layout_rows;
+  gint low, high;
+
+  low = 0;
+  high = rows->len;
+
+  while (low < high)
+    {
+      gint mid = (low + high) / 2;
+
+      if (g_array_index (rows, GtkIconViewRow, mid).y2 <= y)
+	low = mid + 1;
+      else
+	high = mid;
+    }
+
+  return low;
+}
+
 static void
 gtk_icon_view_queue_layout (GtkIconView *icon_view)
 {
+  /* Items may have been added, removed or reordered */
+  gtk_icon_view_free_row_index (icon_view);
+
   if (icon_view->priv->layout_idle_id != 0)
     return;
 
@@ -3157,6 +3563,16 @@ gtk_icon_view_item_free (GtkIconViewItem *item)
 }
 
 
+static gboolean
+gtk_icon_view_item_at_coords (GtkIconView     *icon_view,
+			      GtkIconViewItem *item,
+			      gint             x,
+			      gint             y)
+{
+  return x >= item->x - icon_view->priv->column_spacing/2 && x <= item->x + item->width + icon_view->priv->column_spacing/2 &&
+    y >= item->y - icon_view->priv->row_spacing/2 && y <= item->y + item->height + icon_view->priv->row_spacing/2;
+}
+
 static GtkIconViewItem *
 gtk_icon_view_get_item_at_coords (GtkIconView          *icon_view,
 				  gint                  x,
@@ -3164,55 +3580,94 @@ gtk_icon_view_get_item_at_coords (GtkIconView          *icon_view,
 				  gboolean              only_in_cell,
 				  GtkIconViewCellInfo **cell_at_pos)
 {
+  GtkIconViewItem *item = NULL;
   GList *items, *l;
   GdkRectangle box;
 
-  for (items = icon_view->priv->items; items; items = items->next)
+  if (icon_view->priv->layout_rows)
     {
-      GtkIconViewItem *item = items->data;
+      GPtrArray *layout_items = icon_view->priv->layout_items;
+      GArray *rows = icon_view->priv->layout_rows;
+      gint half_spacing = icon_view->priv->row_spacing/2;
+      gint row, i;
 
-      if (x >= item->x - icon_view->priv->column_spacing/2 && x <= item->x + item->width + icon_view->priv->column_spacing/2 &&
-	  y >= item->y - icon_view->priv->row_spacing/2 && y <= item->y + item->height + icon_view->priv->row_spacing/2)
+      /* Only rows that extend to within half the row spacing
+       * of y can contain the item.
+       */
+      for (row = gtk_icon_view_find_row (icon_view, y - half_spacing - 1);
+	   row < rows->len && item == NULL &&
+	     g_array_index (rows, GtkIconViewRow, row).y1 - half_spacing <= y;
+	   row++)
 	{
-	  if (only_in_cell || cell_at_pos)
-	    {
-	      gtk_icon_view_set_cell_data (icon_view, item);
+	  gint last;
+
+	  if (row + 1 < rows->len)
+	    last = g_array_index (rows, GtkIconViewRow, row + 1).first;
+	  else
+	    last = layout_items->len;
 
-	      for (l = icon_view->priv->cell_list; l; l = l->next)
+	  for (i = g_array_index (rows, GtkIconViewRow, row).first; i < last; i++)
+	    {
+	      if (gtk_icon_view_item_at_coords (icon_view,
+						g_ptr_array_index (layout_items, i),
+						x, y))
 		{
-		  GtkIconViewCellInfo *info = (GtkIconViewCellInfo *)l->data;
+		  item = g_ptr_array_index (layout_items, i);
+		  break;
+		}
+	    }
+	}
+    }
+  else
+    {
+      for (items = icon_view->priv->items; items; items = items->next)
+	{
+	  if (gtk_icon_view_item_at_coords (icon_view, items->data, x, y))
+	    {
+	      item = items->data;
+	      break;
+	    }
+	}
+    }
+
+  if (item == NULL)
+    return NULL;
+
+  if (only_in_cell || cell_at_pos)
+    {
+      gtk_icon_view_set_cell_data (icon_view, item);
+
+      for (l = icon_view->priv->cell_list; l; l = l->next)
+	{
+	  GtkIconViewCellInfo *info = (GtkIconViewCellInfo *)l->data;
 		  
-		  if (!info->cell->visible)
-		    continue;
+	  if (!info->cell->visible)
+	    continue;
 		  
-		  gtk_icon_view_get_cell_box (icon_view, item, info, &box);
+	  gtk_icon_view_get_cell_box (icon_view, item, info, &box);
 		  
-		  if ((x >= box.x && x <= box.x + box.width &&
-		       y >= box.y && y <= box.y + box.height) ||
-		      (x >= box.x  &&
-		       x <= box.x + box.width &&
-		       y >= box.y &&
-		       y <= box.y + box.height))
-		    {
-		      if (cell_at_pos)
-			*cell_at_pos = info;
-		      
-		      return item;
-		    }
-		}
-
-	      if (only_in_cell)
-		return NULL;
-	      
+	  if ((x >= box.x && x <= box.x + box.width &&
+	       y >= box.y && y <= box.y + box.height) ||
+	      (x >= box.x  &&
+	       x <= box.x + box.width &&
+	       y >= box.y &&
+	       y <= box.y + box.height))
+	    {
 	      if (cell_at_pos)
-		*cell_at_pos = NULL;
+		*cell_at_pos = info;
+		      
+	      return item;
 	    }
-
-	  return item;
 	}
+
+      if (only_in_cell)
+	return NULL;
+	      
+      if (cell_at_pos)
+	*cell_at_pos = NULL;
     }
 
-  return NULL;
+  return item;
 }
 
 static void
@@ -4036,7 +4491,8 @@ gtk_icon_view_scroll_to_path (GtkIconView *icon_view,
     item = g_list_nth_data (icon_view->priv->items,
 			    gtk_tree_path_get_indices(path)[0]);
   
-  if (!GTK_WIDGET_REALIZED (icon_view) || !item || item->width < 0)
+  if (!GTK_WIDGET_REALIZED (icon_view) || !item || item->width < 0 ||
+      item->row < 0)
     {
       if (icon_view->priv->scroll_to_path)
 	gtk_tree_row_reference_free (icon_view->priv->scroll_to_path);
@@ -4713,6 +5169,7 @@ gtk_icon_view_set_model (GtkIconView *icon_view,
       g_list_foreach (icon_view->priv->items, (GFunc)gtk_icon_view_item_free, NULL);
       g_list_free (icon_view->priv->items);
       icon_view->priv->items = NULL;
+      gtk_icon_view_free_row_index (icon_view);
       icon_view->priv->anchor_item = NULL;
       icon_view->priv->cursor_item = NULL;
       icon_view->priv->last_single_clicked = NULL;
@@ -6845,6 +7302,107 @@ gtk_icon_view_set_reorderable (GtkIconView *icon_view,
   g_object_notify (G_OBJECT (icon_view), "reorderable");
 }
 
+/**
+ * gtk_icon_view_set_fixed_item_size:
+ * @icon_view: a #GtkIconView
+ * @setting: %TRUE to assume all items have the same size
+ *
+ * Enables or disables the fixed item size mode of @icon_view. 
+ * Fixed item size mode speeds up #GtkIconView by assuming that all 
+ * items have the same size as the first one, so that the cell 
+ * renderers need not be asked for the size of every item. 
+ *
+ * Since: 2.12
+ **/
+void
+gtk_icon_view_set_fixed_item_size (GtkIconView *icon_view,
+				   gboolean     setting)
+{
+  g_return_if_fail (GTK_IS_ICON_VIEW (icon_view));
+
+  setting = setting != FALSE;
+
+  if (icon_view->priv->fixed_item_size == setting)
+    return;
+
+  icon_view->priv->fixed_item_size = setting;
+
+  gtk_icon_view_stop_editing (icon_view, TRUE);
+  gtk_icon_view_invalidate_sizes (icon_view);
+  gtk_icon_view_queue_layout (icon_view);
+
+  g_object_notify (G_OBJECT (icon_view), "fixed-item-size");
+}
+
+/**
+ * gtk_icon_view_get_fixed_item_size:
+ * @icon_view: a #GtkIconView
+ * 
+ * Returns whether fixed item size mode is turned on for @icon_view.
+ * 
+ * Return value: %TRUE if @icon_view is in fixed item size mode
+ *
+ * Since: 2.12
+ **/
+gboolean
+gtk_icon_view_get_fixed_item_size (GtkIconView *icon_view)
+{
+  g_return_val_if_fail (GTK_IS_ICON_VIEW (icon_view), FALSE);
+
+  return icon_view->priv->fixed_item_size;
+}
+
+/**
+ * gtk_icon_view_set_incremental_layout:
+ * @icon_view: a #GtkIconView
+ * @setting: %TRUE to lay out items in batches when idle
+ *
+ * Enables or disables incremental layout for @icon_view. With 
+ * incremental layout, the items are laid out a batch at a time 
+ * when the main loop is idle, starting from the top and always 
+ * covering the visible area first. Until the layout is complete, 
+ * the size of the view is an estimate, and items that are not laid 
+ * out yet are not drawn.
+ *
+ * This is useful for models with many thousands of items, where
+ * laying out all items at once would block the user interface.
+ *
+ * Since: 2.12
+ **/
+void
+gtk_icon_view_set_incremental_layout (GtkIconView *icon_view,
+				      gboolean     setting)
+{
+  g_return_if_fail (GTK_IS_ICON_VIEW (icon_view));
+
+  setting = setting != FALSE;
+
+  if (icon_view->priv->incremental_layout == setting)
+    return;
+
+  icon_view->priv->incremental_layout = setting;
+
+  g_object_notify (G_OBJECT (icon_view), "incremental-layout");
+}
+
+/**
+ * gtk_icon_view_get_incremental_layout:
+ * @icon_view: a #GtkIconView
+ * 
+ * Returns whether incremental layout is turned on for @icon_view.
+ * 
+ * Return value: %TRUE if @icon_view lays out items incrementally
+ *
+ * Since: 2.12
+ **/
+gboolean
+gtk_icon_view_get_incremental_layout (GtkIconView *icon_view)
+{
+  g_return_val_if_fail (GTK_IS_ICON_VIEW (icon_view), FALSE);
+
+  return icon_view->priv->incremental_layout;
+}
+
 
 /* Accessibility Support */
 
@@ -178,6 +178,12 @@ void                   gtk_icon_view_unset_model_drag_dest    (GtkIconView
 void                   gtk_icon_view_set_reorderable          (GtkIconView              *icon_view,
 							       gboolean                  reorderable);
 gboolean               gtk_icon_view_get_reorderable          (GtkIconView              *icon_view);
+void                   gtk_icon_view_set_fixed_item_size      (GtkIconView              *icon_view,
+							       gboolean                  setting);
+gboolean               gtk_icon_view_get_fixed_item_size      (GtkIconView              *icon_view);
+void                   gtk_icon_view_set_incremental_layout   (GtkIconView              *icon_view,
+							       gboolean                  setting);
+gboolean               gtk_icon_view_get_incremental_layout   (GtkIconView              *icon_view);
 
 
 /* These are useful to implement your own custom stuff. */
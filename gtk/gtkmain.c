@@ -147,6 +147,8 @@ static GList *quit_functions = NULL;	   /* A list of quit functions.
 					    */
 static GSList *key_snoopers = NULL;
 
+G_LOCK_DEFINE (_gtk_xdgmime);
+
 guint gtk_debug_flags = 0;		   /* Global GTK debug flag */
 
 #ifdef G_ENABLE_DEBUG
@@ -100,6 +100,13 @@ gboolean _gtk_fnmatch (const char *pattern,
 		       const char *string,
 		       gboolean    no_leading_period);
 
+/* Held around every call into xdgmime, which isn't thread safe and
+ * may reload its tables on any call; strings it returns have to be
+ * copied before the lock is released.  The Unix file system backend
+ * sniffs MIME types from its folder loading thread.
+ */
+G_LOCK_EXTERN (_gtk_xdgmime);
+
 #define GTK_PARAM_READABLE G_PARAM_READABLE|G_PARAM_STATIC_NAME|G_PARAM_STATIC_NICK|G_PARAM_STATIC_BLURB
 #define GTK_PARAM_WRITABLE G_PARAM_WRITABLE|G_PARAM_STATIC_NAME|G_PARAM_STATIC_NICK|G_PARAM_STATIC_BLURB
 #define GTK_PARAM_READWRITE G_PARAM_READWRITE|G_PARAM_STATIC_NAME|G_PARAM_STATIC_NICK|G_PARAM_STATIC_BLURB
@@ -53,6 +53,7 @@
 #include "gtkmain.h"
 #include "gtkmodules.h"
 #include "gtkprivate.h"
+#include "gtkrccache.h"
 #include "gtksettings.h"
 #include "gtkwindow.h"
 
@@ -128,9 +129,30 @@ struct _GtkRcContext
 
   GHashTable *color_hash;
 
+  /* GtkRcStyleMemo -> GtkStyle, see gtk_rc_get_style() */
+  GHashTable *style_memo;
+
   guint reloading : 1;
 };
 
+/* The styles gtk_rc_get_style() found for widgets of a given type and
+ * widget and class paths, so that other widgets in the same place don't
+ * have to match their paths against every rc set again.  The paths are
+ * NULL when the context has no sets of that kind.
+ */
+typedef struct _GtkRcStyleMemo GtkRcStyleMemo;
+
+struct _GtkRcStyleMemo
+{
+  GType type;
+  gchar *path;
+  gchar *class_path;
+  guint hash;
+};
+
+/* Memoized styles per context before the memo is emptied again */
+#define GTK_RC_STYLE_MEMO_MAX 4096
+
 #define GTK_RC_STYLE_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_RC_STYLE, GtkRcStylePrivate))
 
 typedef struct _GtkRcStylePrivate GtkRcStylePrivate;
@@ -146,6 +168,7 @@ static guint       gtk_rc_style_hash                 (const gchar     *name);
 static gboolean    gtk_rc_style_equal                (const gchar     *a,
                                                       const gchar     *b);
 static guint       gtk_rc_styles_hash                (const GSList    *rc_styles);
+static void        gtk_rc_context_clear_style_memo   (GtkRcContext    *context);
 static gboolean    gtk_rc_styles_equal               (const GSList    *a,
                                                       const GSList    *b);
 static GtkRcStyle* gtk_rc_style_find                 (GtkRcContext    *context,
@@ -175,6 +198,9 @@ static guint       gtk_rc_parse_statement            (GtkRcContext    *context,
 						      GScanner        *scanner);
 static guint       gtk_rc_parse_style                (GtkRcContext    *context,
 						      GScanner        *scanner);
+static guint       gtk_rc_parse_style_body           (GtkRcContext    *context,
+						      GScanner        *scanner,
+                                                      GtkRcStyle     **rc_style);
 static guint       gtk_rc_parse_assignment           (GScanner        *scanner,
                                                       GtkRcStyle      *style,
 						      GtkRcProperty   *prop);
@@ -221,6 +247,12 @@ static guint       gtk_rc_parse_logical_color        (GScanner        *scanner,
 static guint       gtk_rc_parse_color_full           (GScanner        *scanner,
                                                       GtkRcStyle      *style,
                                                       GdkColor        *color);
+static void        gtk_rc_parse_cached               (GtkRcContext    *context,
+						      const gchar     *input_name,
+						      GtkRcCache      *cache,
+						      const gchar     *contents,
+						      gsize            length,
+						      guint32          code);
 
 static void        gtk_rc_clear_hash_node            (gpointer         key,
                                                       gpointer         data,
@@ -377,6 +409,11 @@ static gchar **gtk_rc_default_files = NULL;
  */
 static GSList *current_files_stack = NULL;
 
+/* The cache for the outermost of these files, if it has an up to date
+ * one; all the files it includes are read from there.
+ */
+static GtkRcCache *current_cache = NULL;
+
 /* RC files and strings that are parsed for every context
  */
 static GSList *global_rc_files = NULL;
@@ -678,6 +715,7 @@ gtk_rc_context_get (GtkSettings *settings)
       context->rc_sets_class = NULL;
       context->rc_files = NULL;
       context->default_style = NULL;
+      context->style_memo = NULL;
       context->reloading = FALSE;
 
       g_object_get (settings,
@@ -961,6 +999,10 @@ gtk_rc_context_parse_one_file (GtkRcContext *context,
   GtkRcFile *rc_file;
   struct stat statbuf;
   gint saved_priority;
+  const gchar *contents;
+  gsize length;
+  guint32 code;
+  time_t mtime;
 
   g_return_if_fail (filename != NULL);
 
@@ -992,7 +1034,22 @@ gtk_rc_context_parse_one_file (GtkRcContext *context,
   if (g_slist_find (current_files_stack, rc_file))
     return;
 
-  if (!g_lstat (rc_file->canonical_name, &statbuf))
+  if (current_cache &&
+      _gtk_rc_cache_lookup (current_cache, rc_file->canonical_name,
+			    &contents, &length, &code, &mtime))
+    {
+      if (contents)
+	{
+	  rc_file->mtime = mtime;
+
+	  current_files_stack = g_slist_prepend (current_files_stack, rc_file);
+	  gtk_rc_parse_cached (context, filename, current_cache,
+			       contents, length, code);
+	  current_files_stack = g_slist_delete_link (current_files_stack,
+						     current_files_stack);
+	}
+    }
+  else if (!g_lstat (rc_file->canonical_name, &statbuf))
     {
       gint fd;
       
@@ -1017,6 +1074,21 @@ gtk_rc_context_parse_one_file (GtkRcContext *context,
   context->default_priority = saved_priority;
 }
 
+/* Only for RC files; the cache doesn't know about pixmaps or modules,
+ * and would claim that those in the directories it covers don't exist.
+ */
+static gboolean
+gtk_rc_file_exists (const gchar *filename)
+{
+  const gchar *contents;
+
+  if (current_cache &&
+      _gtk_rc_cache_lookup (current_cache, filename, &contents, NULL, NULL, NULL))
+    return contents != NULL;
+
+  return g_file_test (filename, G_FILE_TEST_EXISTS);
+}
+
 static gchar *
 strchr_len (const gchar *str, gint len, char c)
 {
@@ -1043,6 +1115,11 @@ gtk_rc_context_parse_file (GtkRcContext *context,
   gchar *locale;
   gint length, j;
   gboolean found = FALSE;
+  GtkRcCache *cache = NULL;
+
+  /* Files included from another one are found in its cache, if any */
+  if (!current_files_stack && !current_cache)
+    current_cache = cache = _gtk_rc_cache_new_for_file (filename);
 
   locale = _gtk_get_lc_ctype ();
 
@@ -1078,7 +1155,7 @@ gtk_rc_context_parse_file (GtkRcContext *context,
       if (!found)
 	{
 	  gchar *name = g_strconcat (filename, ".", locale_suffixes[j], NULL);
-	  if (g_file_test (name, G_FILE_TEST_EXISTS))
+	  if (gtk_rc_file_exists (name))
 	    {
 	      gtk_rc_context_parse_one_file (context, name, priority, FALSE);
 	      found = TRUE;
@@ -1089,6 +1166,12 @@ gtk_rc_context_parse_file (GtkRcContext *context,
       
       g_free (locale_suffixes[j]);
     }
+
+  if (cache)
+    {
+      _gtk_rc_cache_free (cache);
+      current_cache = NULL;
+    }
 }
 
 void
@@ -1547,6 +1630,8 @@ gtk_rc_free_rc_sets (GSList *slist)
 static void
 gtk_rc_clear_styles (GtkRcContext *context)
 {
+  gtk_rc_context_clear_style_memo (context);
+
   /* Clear out all old rc_styles */
 
   if (context->rc_style_ht)
@@ -1638,11 +1723,16 @@ void
 gtk_rc_reset_styles (GtkSettings *settings)
 {
   GtkRcContext *context;
+  GSList *tmp_list;
   gboolean reset = FALSE;
 
   g_return_if_fail (GTK_IS_SETTINGS (settings));
 
   context = gtk_rc_context_get (settings);
+
+  /* realized_style_ht is shared by all contexts */
+  for (tmp_list = rc_contexts; tmp_list; tmp_list = tmp_list->next)
+    gtk_rc_context_clear_style_memo (tmp_list->data);
   
   if (context->default_style)
     {
@@ -1886,6 +1976,107 @@ sort_and_dereference_sets (GSList *styles)
   return styles;
 }
 
+static guint
+gtk_rc_style_memo_hash_paths (GType        type,
+			      const gchar *path,
+			      const gchar *class_path)
+{
+  guint hash = type;
+
+  if (path)
+    hash = hash * 31 + g_str_hash (path);
+  if (class_path)
+    hash = hash * 31 + g_str_hash (class_path);
+
+  return hash;
+}
+
+static guint
+gtk_rc_style_memo_hash (const GtkRcStyleMemo *memo)
+{
+  return memo->hash;
+}
+
+static gboolean
+gtk_rc_style_memo_path_equal (const gchar *a,
+			      const gchar *b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  return strcmp (a, b) == 0;
+}
+
+static gboolean
+gtk_rc_style_memo_equal (const GtkRcStyleMemo *a,
+			 const GtkRcStyleMemo *b)
+{
+  return (a->hash == b->hash &&
+	  a->type == b->type &&
+	  gtk_rc_style_memo_path_equal (a->path, b->path) &&
+	  gtk_rc_style_memo_path_equal (a->class_path, b->class_path));
+}
+
+static void
+gtk_rc_style_memo_free (GtkRcStyleMemo *memo)
+{
+  g_free (memo->path);
+  g_free (memo->class_path);
+  g_slice_free (GtkRcStyleMemo, memo);
+}
+
+static GtkStyle *
+gtk_rc_context_lookup_style_memo (GtkRcContext   *context,
+				  GtkRcStyleMemo *memo)
+{
+  if (!context->style_memo)
+    return NULL;
+
+  return g_hash_table_lookup (context->style_memo, memo);
+}
+
+static void
+gtk_rc_context_insert_style_memo (GtkRcContext   *context,
+				  GtkRcStyleMemo *memo,
+				  GtkStyle       *style)
+{
+  GtkRcStyleMemo *new_memo;
+
+  /* A simple bound for programs that keep creating widgets with
+   * new names; the memo fills up again with what is used now.
+   */
+  if (context->style_memo &&
+      g_hash_table_size (context->style_memo) >= GTK_RC_STYLE_MEMO_MAX)
+    gtk_rc_context_clear_style_memo (context);
+
+  if (!context->style_memo)
+    context->style_memo = g_hash_table_new_full ((GHashFunc) gtk_rc_style_memo_hash,
+						 (GEqualFunc) gtk_rc_style_memo_equal,
+						 (GDestroyNotify) gtk_rc_style_memo_free,
+						 (GDestroyNotify) g_object_unref);
+
+  new_memo = g_slice_new (GtkRcStyleMemo);
+  new_memo->type = memo->type;
+  new_memo->path = g_strdup (memo->path);
+  new_memo->class_path = g_strdup (memo->class_path);
+  new_memo->hash = memo->hash;
+
+  g_hash_table_insert (context->style_memo, new_memo, g_object_ref (style));
+}
+
+/* Needs to be called whenever the sets or styles of @context change,
+ * or styles are dropped from realized_style_ht.
+ */
+static void
+gtk_rc_context_clear_style_memo (GtkRcContext *context)
+{
+  if (context->style_memo)
+    {
+      g_hash_table_destroy (context->style_memo);
+      context->style_memo = NULL;
+    }
+}
+
 /**
  * gtk_rc_get_style:
  * @widget: a #GtkWidget
@@ -1907,6 +2098,11 @@ gtk_rc_get_style (GtkWidget *widget)
   GtkRcStyle *widget_rc_style;
   GSList *rc_styles = NULL;
   GtkRcContext *context;
+  GtkStyle *style;
+  GtkRcStyleMemo memo;
+  gchar *path = NULL, *path_reversed = NULL;
+  gchar *class_path = NULL, *class_path_reversed = NULL;
+  guint path_length, class_path_length;
 
   static guint rc_style_key_id = 0;
 
@@ -1920,28 +2116,45 @@ gtk_rc_get_style (GtkWidget *widget)
   if (!rc_style_key_id)
     rc_style_key_id = g_quark_from_static_string ("gtk-rc-style");
 
-  if (context->rc_sets_widget)
-    {
-      gchar *path, *path_reversed;
-      guint path_length;
+  widget_rc_style = g_object_get_qdata (G_OBJECT (widget), rc_style_key_id);
 
-      gtk_widget_path (widget, &path_length, &path, &path_reversed);
-      rc_styles = gtk_rc_styles_match (rc_styles, context->rc_sets_widget, path_length, path, path_reversed);
-      g_free (path);
-      g_free (path_reversed);
-    }
+  if (context->rc_sets_widget)
+    gtk_widget_path (widget, &path_length, &path, &path_reversed);
   
   if (context->rc_sets_widget_class)
+    gtk_widget_class_path (widget, &class_path_length, &class_path, &class_path_reversed);
+
+  /* Widgets with an rc style of their own are rare, and their style
+   * depends on more than the memo key, so they always go the long way.
+   */
+  if (!widget_rc_style)
     {
-      gchar *path, *path_reversed;
-      guint path_length;
+      memo.type = G_TYPE_FROM_INSTANCE (widget);
+      memo.path = path;
+      memo.class_path = class_path;
+      memo.hash = gtk_rc_style_memo_hash_paths (memo.type, path, class_path);
 
-      gtk_widget_class_path (widget, &path_length, &path, &path_reversed);
-      rc_styles = gtk_rc_styles_match (rc_styles, context->rc_sets_widget_class, path_length, path, path_reversed);
-      g_free (path);
-      g_free (path_reversed);
+      style = gtk_rc_context_lookup_style_memo (context, &memo);
+      if (style)
+	{
+	  g_free (path);
+	  g_free (path_reversed);
+	  g_free (class_path);
+	  g_free (class_path_reversed);
+
+	  return style;
+	}
     }
 
+  if (path)
+    rc_styles = gtk_rc_styles_match (rc_styles, context->rc_sets_widget, path_length, path, path_reversed);
+
+  if (class_path)
+    rc_styles = gtk_rc_styles_match (rc_styles, context->rc_sets_widget_class, class_path_length, class_path, class_path_reversed);
+
+  g_free (path_reversed);
+  g_free (class_path_reversed);
+
   if (context->rc_sets_class)
     {
       GType type;
@@ -1968,13 +2181,11 @@ gtk_rc_get_style (GtkWidget *widget)
   
   rc_styles = sort_and_dereference_sets (rc_styles);
   
-  widget_rc_style = g_object_get_qdata (G_OBJECT (widget), rc_style_key_id);
-
   if (widget_rc_style)
     rc_styles = g_slist_prepend (rc_styles, widget_rc_style);
 
   if (rc_styles)
-    return gtk_rc_init_style (context, rc_styles);
+    style = gtk_rc_init_style (context, rc_styles);
   else
     {
       if (!context->default_style)
@@ -1983,8 +2194,16 @@ gtk_rc_get_style (GtkWidget *widget)
 	  _gtk_style_init_for_settings (context->default_style, context->settings);
 	}
 
-      return context->default_style;
+      style = context->default_style;
     }
+
+  if (!widget_rc_style)
+    gtk_rc_context_insert_style_memo (context, &memo, style);
+
+  g_free (path);
+  g_free (class_path);
+
+  return style;
 }
 
 /**
@@ -2144,6 +2363,7 @@ gtk_rc_add_widget_name_style (GtkRcStyle  *rc_style,
 
   context = gtk_rc_context_get (gtk_settings_get_default ());
   
+  gtk_rc_context_clear_style_memo (context);
   context->rc_sets_widget = gtk_rc_add_rc_sets (context->rc_sets_widget, rc_style, pattern, GTK_PATH_WIDGET);
 }
 
@@ -2158,6 +2378,7 @@ gtk_rc_add_widget_class_style (GtkRcStyle  *rc_style,
 
   context = gtk_rc_context_get (gtk_settings_get_default ());
   
+  gtk_rc_context_clear_style_memo (context);
   context->rc_sets_widget_class = gtk_rc_add_rc_sets (context->rc_sets_widget_class, rc_style, pattern, GTK_PATH_WIDGET_CLASS);
 }
 
@@ -2172,6 +2393,7 @@ gtk_rc_add_class_style (GtkRcStyle  *rc_style,
 
   context = gtk_rc_context_get (gtk_settings_get_default ());
   
+  gtk_rc_context_clear_style_memo (context);
   context->rc_sets_class = gtk_rc_add_rc_sets (context->rc_sets_class, rc_style, pattern, GTK_PATH_CLASS);
 }
 
@@ -2181,34 +2403,31 @@ gtk_rc_scanner_new (void)
   return g_scanner_new (&gtk_rc_scanner_config);
 }
 
-static void
-gtk_rc_parse_any (GtkRcContext *context,
-		  const gchar  *input_name,
-		  gint		input_fd,
-		  const gchar  *input_string)
+/* A scanner that knows the keywords of RC files */
+static GScanner *
+gtk_rc_statement_scanner_new (const gchar *input_name)
 {
   GScanner *scanner;
   guint	   i;
-  gboolean done;
 
   scanner = gtk_rc_scanner_new ();
-  
-  if (input_fd >= 0)
-    {
-      g_assert (input_string == NULL);
-      
-      g_scanner_input_file (scanner, input_fd);
-    }
-  else
-    {
-      g_assert (input_string != NULL);
-      
-      g_scanner_input_text (scanner, input_string, strlen (input_string));
-    }
   scanner->input_name = input_name;
 
   for (i = 0; i < G_N_ELEMENTS (symbols); i++)
     g_scanner_scope_add_symbol (scanner, 0, symbol_names + symbols[i].name_offset, GINT_TO_POINTER (symbols[i].token));
+
+  return scanner;
+}
+
+/* Returns FALSE if parsing stopped at an error, after reporting it */
+static gboolean
+gtk_rc_parse_statements (GtkRcContext *context,
+			 GScanner     *scanner)
+{
+  guint	   i;
+  gboolean done;
+  gboolean retval = TRUE;
+
   done = FALSE;
   while (!done)
     {
@@ -2261,9 +2480,41 @@ gtk_rc_parse_any (GtkRcContext *context,
 				     TRUE);
 	      g_free (msg);
 	      done = TRUE;
+	      retval = FALSE;
 	    }
 	}
     }
+
+  return retval;
+}
+
+static void
+gtk_rc_parse_any (GtkRcContext *context,
+		  const gchar  *input_name,
+		  gint		input_fd,
+		  const gchar  *input_string)
+{
+  GScanner *scanner;
+
+  /* The new statements may add rc sets or change existing styles */
+  gtk_rc_context_clear_style_memo (context);
+
+  scanner = gtk_rc_statement_scanner_new (input_name);
+  
+  if (input_fd >= 0)
+    {
+      g_assert (input_string == NULL);
+      
+      g_scanner_input_file (scanner, input_fd);
+    }
+  else
+    {
+      g_assert (input_string != NULL);
+      
+      g_scanner_input_text (scanner, input_string, strlen (input_string));
+    }
+
+  gtk_rc_parse_statements (context, scanner);
   
   g_scanner_destroy (scanner);
 }
@@ -2813,7 +3064,7 @@ parse_include_file (GtkRcContext *context,
 	  GtkRcFile *curfile = tmp_list->data;
 	  gchar *tmpname = g_build_filename (curfile->directory, filename, NULL);
 
-	  if (g_file_test (tmpname, G_FILE_TEST_EXISTS))
+	  if (gtk_rc_file_exists (tmpname))
 	    {
 	      to_parse = tmpname;
 	      break;
@@ -2945,37 +3196,27 @@ fixup_rc_sets (GtkRcContext *context,
   fixup_rc_set (context->rc_sets_class, orig, new);
 }
 
-static guint
-gtk_rc_parse_style (GtkRcContext *context,
-		    GScanner     *scanner)
+/* Returns the style called @name for a style statement to change, or
+ * a new one; @orig_style is set to the existing style, with a reference.
+ */
+static GtkRcStyle *
+gtk_rc_style_begin (GtkRcContext *context,
+		    const gchar  *name,
+		    GtkRcStyle  **orig_style)
 {
   GtkRcStyle *rc_style;
-  GtkRcStyle *orig_style;
-  GtkRcStyle *parent_style = NULL;
-  GtkRcStylePrivate *rc_priv = NULL;
-  guint token;
   gint i;
-  GtkIconFactory *our_factory = NULL;
-  GHashTable *our_hash = NULL;
 
-  token = g_scanner_get_next_token (scanner);
-  if (token != GTK_RC_TOKEN_STYLE)
-    return GTK_RC_TOKEN_STYLE;
-  
-  token = g_scanner_get_next_token (scanner);
-  if (token != G_TOKEN_STRING)
-    return G_TOKEN_STRING;
-  
-  rc_style = gtk_rc_style_find (context, scanner->value.v_string);
+  rc_style = gtk_rc_style_find (context, name);
   if (rc_style)
-    orig_style = g_object_ref (rc_style);
+    *orig_style = g_object_ref (rc_style);
   else
-    orig_style = NULL;
+    *orig_style = NULL;
 
   if (!rc_style)
     {
       rc_style = gtk_rc_style_new ();
-      rc_style->name = g_strdup (scanner->value.v_string);
+      rc_style->name = g_strdup (name);
       
       for (i = 0; i < 5; i++)
 	rc_style->bg_pixmap_name[i] = NULL;
@@ -2984,15 +3225,98 @@ gtk_rc_parse_style (GtkRcContext *context,
 	rc_style->color_flags[i] = 0;
     }
 
-  rc_priv = GTK_RC_STYLE_GET_PRIVATE (rc_style);
+  return rc_style;
+}
 
-  /* If there's a list, its first member is always the factory belonging
-   * to this RcStyle
-   */
-  if (rc_style->icon_factories)
-    our_factory = rc_style->icon_factories->data;
-  if (rc_priv->color_hashes)
-    our_hash = rc_priv->color_hashes->data;
+/* Copies the settings of the style named after the = of a style
+ * statement
+ */
+static void
+gtk_rc_style_inherit (GtkRcStyle *rc_style,
+		      GtkRcStyle *parent_style)
+{
+  gint i;
+
+  for (i = 0; i < 5; i++)
+    {
+      rc_style->color_flags[i] = parent_style->color_flags[i];
+      rc_style->fg[i] = parent_style->fg[i];
+      rc_style->bg[i] = parent_style->bg[i];
+      rc_style->text[i] = parent_style->text[i];
+      rc_style->base[i] = parent_style->base[i];
+    }
+
+  rc_style->xthickness = parent_style->xthickness;
+  rc_style->ythickness = parent_style->ythickness;
+  
+  if (parent_style->font_desc)
+    {
+      if (rc_style->font_desc)
+	pango_font_description_free (rc_style->font_desc);
+      rc_style->font_desc = pango_font_description_copy (parent_style->font_desc);
+    }
+
+  if (parent_style->rc_properties)
+    {
+      guint i;
+
+      for (i = 0; i < parent_style->rc_properties->len; i++)
+	insert_rc_property (rc_style,
+			    &g_array_index (parent_style->rc_properties, GtkRcProperty, i),
+			    TRUE);
+    }
+  
+  for (i = 0; i < 5; i++)
+    {
+      if (rc_style->bg_pixmap_name[i])
+	g_free (rc_style->bg_pixmap_name[i]);
+      rc_style->bg_pixmap_name[i] = g_strdup (parent_style->bg_pixmap_name[i]);
+    }
+}
+
+/* Finishes a style statement that was parsed without errors */
+static void
+gtk_rc_style_end (GtkRcContext *context,
+		  GtkRcStyle   *rc_style,
+		  GtkRcStyle   *orig_style)
+{
+  if (rc_style != orig_style)
+    {
+      if (!context->rc_style_ht)
+	context->rc_style_ht = g_hash_table_new ((GHashFunc) gtk_rc_style_hash,
+						 (GEqualFunc) gtk_rc_style_equal);
+      
+      g_hash_table_replace (context->rc_style_ht, rc_style->name, rc_style);
+
+      /* If we copied the data into a new rc style, fix up references to the old rc style
+       * in bindings that we have.
+       */
+      if (orig_style)
+	fixup_rc_sets (context, orig_style, rc_style);
+    }
+
+  if (orig_style)
+    g_object_unref (orig_style);
+}
+
+static guint
+gtk_rc_parse_style (GtkRcContext *context,
+		    GScanner     *scanner)
+{
+  GtkRcStyle *rc_style;
+  GtkRcStyle *orig_style;
+  GtkRcStyle *parent_style = NULL;
+  guint token;
+
+  token = g_scanner_get_next_token (scanner);
+  if (token != GTK_RC_TOKEN_STYLE)
+    return GTK_RC_TOKEN_STYLE;
+  
+  token = g_scanner_get_next_token (scanner);
+  if (token != G_TOKEN_STRING)
+    return G_TOKEN_STRING;
+  
+  rc_style = gtk_rc_style_begin (context, scanner->value.v_string, &orig_style);
 
   token = g_scanner_peek_next_token (scanner);
   if (token == G_TOKEN_EQUAL_SIGN)
@@ -3008,44 +3332,8 @@ gtk_rc_parse_style (GtkRcContext *context,
       
       parent_style = gtk_rc_style_find (context, scanner->value.v_string);
       if (parent_style)
-	{
-	  for (i = 0; i < 5; i++)
-	    {
-	      rc_style->color_flags[i] = parent_style->color_flags[i];
-	      rc_style->fg[i] = parent_style->fg[i];
-	      rc_style->bg[i] = parent_style->bg[i];
-	      rc_style->text[i] = parent_style->text[i];
-	      rc_style->base[i] = parent_style->base[i];
-	    }
-
-	  rc_style->xthickness = parent_style->xthickness;
-	  rc_style->ythickness = parent_style->ythickness;
-	  
-	  if (parent_style->font_desc)
-	    {
-	      if (rc_style->font_desc)
-		pango_font_description_free (rc_style->font_desc);
-	      rc_style->font_desc = pango_font_description_copy (parent_style->font_desc);
-	    }
-
-	  if (parent_style->rc_properties)
-	    {
-	      guint i;
-
-	      for (i = 0; i < parent_style->rc_properties->len; i++)
-		insert_rc_property (rc_style,
-				    &g_array_index (parent_style->rc_properties, GtkRcProperty, i),
-				    TRUE);
-	    }
-	  
-	  for (i = 0; i < 5; i++)
-	    {
-	      if (rc_style->bg_pixmap_name[i])
-		g_free (rc_style->bg_pixmap_name[i]);
-	      rc_style->bg_pixmap_name[i] = g_strdup (parent_style->bg_pixmap_name[i]);
-	    }
-	}
-    }
+	gtk_rc_style_inherit (rc_style, parent_style);
+    }
 
   /*  get icon_factories and color_hashes from the parent style;
    *  if the parent_style doesn't have color_hashes, initializes
@@ -3053,11 +3341,6 @@ gtk_rc_parse_style (GtkRcContext *context,
    */
   gtk_rc_style_copy_icons_and_colors (rc_style, parent_style, context);
 
-  if (rc_style->icon_factories)
-    our_factory = rc_style->icon_factories->data;
-  if (rc_priv->color_hashes)
-    our_hash = rc_priv->color_hashes->data;
-
   token = g_scanner_get_next_token (scanner);
   if (token != G_TOKEN_LEFT_CURLY)
     {
@@ -3065,55 +3348,104 @@ gtk_rc_parse_style (GtkRcContext *context,
       goto err;
     }
   
+  token = gtk_rc_parse_style_body (context, scanner, &rc_style);
+  if (token != G_TOKEN_NONE)
+    goto err;
+  
+  token = g_scanner_get_next_token (scanner);
+  if (token != G_TOKEN_RIGHT_CURLY)
+    {
+      token = G_TOKEN_RIGHT_CURLY;
+      goto err;
+    }
+  
+  gtk_rc_style_end (context, rc_style, orig_style);
+  
+  return G_TOKEN_NONE;
+
+ err:
+  if (rc_style != orig_style)
+    gtk_rc_style_unref (rc_style);
+
+  if (orig_style)
+    g_object_unref (orig_style);
+  
+  return token;
+}
+
+/* Parses the statements inside the curly braces of a style, up to the
+ * closing brace or the end of the input.  A theme engine section may
+ * replace the style with one of the engine's type.
+ */
+static guint
+gtk_rc_parse_style_body (GtkRcContext *context,
+			 GScanner     *scanner,
+			 GtkRcStyle  **rc_style)
+{
+  GtkRcStylePrivate *rc_priv;
+  GtkIconFactory *our_factory = NULL;
+  GHashTable *our_hash = NULL;
+  guint token;
+
+  rc_priv = GTK_RC_STYLE_GET_PRIVATE (*rc_style);
+
+  /* If there's a list, its first member is always the factory belonging
+   * to this RcStyle
+   */
+  if ((*rc_style)->icon_factories)
+    our_factory = (*rc_style)->icon_factories->data;
+  if (rc_priv->color_hashes)
+    our_hash = rc_priv->color_hashes->data;
+
   token = g_scanner_peek_next_token (scanner);
-  while (token != G_TOKEN_RIGHT_CURLY)
+  while (token != G_TOKEN_RIGHT_CURLY && token != G_TOKEN_EOF)
     {
       switch (token)
 	{
 	case GTK_RC_TOKEN_BG:
-	  token = gtk_rc_parse_bg (scanner, rc_style);
+	  token = gtk_rc_parse_bg (scanner, *rc_style);
 	  break;
 	case GTK_RC_TOKEN_FG:
-	  token = gtk_rc_parse_fg (scanner, rc_style);
+	  token = gtk_rc_parse_fg (scanner, *rc_style);
 	  break;
 	case GTK_RC_TOKEN_TEXT:
-	  token = gtk_rc_parse_text (scanner, rc_style);
+	  token = gtk_rc_parse_text (scanner, *rc_style);
 	  break;
 	case GTK_RC_TOKEN_BASE:
-	  token = gtk_rc_parse_base (scanner, rc_style);
+	  token = gtk_rc_parse_base (scanner, *rc_style);
 	  break;
 	case GTK_RC_TOKEN_XTHICKNESS:
-	  token = gtk_rc_parse_xthickness (scanner, rc_style);
+	  token = gtk_rc_parse_xthickness (scanner, *rc_style);
 	  break;
 	case GTK_RC_TOKEN_YTHICKNESS:
-	  token = gtk_rc_parse_ythickness (scanner, rc_style);
+	  token = gtk_rc_parse_ythickness (scanner, *rc_style);
 	  break;
 	case GTK_RC_TOKEN_BG_PIXMAP:
-	  token = gtk_rc_parse_bg_pixmap (context, scanner, rc_style);
+	  token = gtk_rc_parse_bg_pixmap (context, scanner, *rc_style);
 	  break;
 	case GTK_RC_TOKEN_FONT:
-	  token = gtk_rc_parse_font (scanner, rc_style);
+	  token = gtk_rc_parse_font (scanner, *rc_style);
 	  break;
 	case GTK_RC_TOKEN_FONTSET:
-	  token = gtk_rc_parse_fontset (scanner, rc_style);
+	  token = gtk_rc_parse_fontset (scanner, *rc_style);
 	  break;
 	case GTK_RC_TOKEN_FONT_NAME:
-	  token = gtk_rc_parse_font_name (scanner, rc_style);
+	  token = gtk_rc_parse_font_name (scanner, *rc_style);
 	  break;
 	case GTK_RC_TOKEN_ENGINE:
-	  token = gtk_rc_parse_engine (context, scanner, &rc_style);
+	  token = gtk_rc_parse_engine (context, scanner, rc_style);
 	  break;
         case GTK_RC_TOKEN_STOCK:
           if (our_factory == NULL)
-            gtk_rc_style_prepend_empty_icon_factory (rc_style);
-          our_factory = rc_style->icon_factories->data;
-          token = gtk_rc_parse_stock (context, scanner, rc_style, our_factory);
+            gtk_rc_style_prepend_empty_icon_factory (*rc_style);
+          our_factory = (*rc_style)->icon_factories->data;
+          token = gtk_rc_parse_stock (context, scanner, *rc_style, our_factory);
           break;
         case GTK_RC_TOKEN_COLOR:
           if (our_hash == NULL)
-            gtk_rc_style_prepend_empty_color_hash (rc_style);
+            gtk_rc_style_prepend_empty_color_hash (*rc_style);
           our_hash = rc_priv->color_hashes->data;
-          token = gtk_rc_parse_logical_color (scanner, rc_style, our_hash);
+          token = gtk_rc_parse_logical_color (scanner, *rc_style, our_hash);
           break;
 	case G_TOKEN_IDENTIFIER:
 	  if (is_c_identifier (scanner->next_value.v_identifier) &&
@@ -3144,11 +3476,11 @@ gtk_rc_parse_style (GtkRcContext *context,
 	      prop.property_name = g_quark_from_string (name);
 	      g_free (name);
 
-	      token = gtk_rc_parse_assignment (scanner, rc_style, &prop);
+	      token = gtk_rc_parse_assignment (scanner, *rc_style, &prop);
 	      if (token == G_TOKEN_NONE)
 		{
 		  g_return_val_if_fail (G_VALUE_TYPE (&prop.value) != 0, G_TOKEN_ERROR);
-		  insert_rc_property (rc_style, &prop, TRUE);
+		  insert_rc_property (*rc_style, &prop, TRUE);
 		}
 	      
 	      g_free (prop.origin);
@@ -3168,46 +3500,12 @@ gtk_rc_parse_style (GtkRcContext *context,
 	}
 
       if (token != G_TOKEN_NONE)
-	goto err;
+	return token;
 
       token = g_scanner_peek_next_token (scanner);
     } /* while (token != G_TOKEN_RIGHT_CURLY) */
-  
-  token = g_scanner_get_next_token (scanner);
-  if (token != G_TOKEN_RIGHT_CURLY)
-    {
-      token = G_TOKEN_RIGHT_CURLY;
-      goto err;
-    }
-  
-  if (rc_style != orig_style)
-    {
-      if (!context->rc_style_ht)
-	context->rc_style_ht = g_hash_table_new ((GHashFunc) gtk_rc_style_hash,
-						 (GEqualFunc) gtk_rc_style_equal);
-      
-      g_hash_table_replace (context->rc_style_ht, rc_style->name, rc_style);
 
-      /* If we copied the data into a new rc style, fix up references to the old rc style
-       * in bindings that we have.
-       */
-      if (orig_style)
-	fixup_rc_sets (context, orig_style, rc_style);
-    }
-
-  if (orig_style)
-    g_object_unref (orig_style);
-  
   return G_TOKEN_NONE;
-
- err:
-  if (rc_style != orig_style)
-    gtk_rc_style_unref (rc_style);
-
-  if (orig_style)
-    g_object_unref (orig_style);
-  
-  return token;
 }
 
 const GtkRcProperty*
@@ -4060,6 +4358,40 @@ gtk_rc_parse_im_module_file (GScanner *scanner)
   return G_TOKEN_NONE;
 }
 
+static void
+gtk_rc_context_add_set (GtkRcContext        *context,
+			GtkPathType          path_type,
+			const gchar         *pattern,
+			GtkRcStyle          *rc_style,
+			GtkPathPriorityType  priority)
+{
+  GtkRcSet *rc_set;
+
+  rc_set = g_new (GtkRcSet, 1);
+  rc_set->type = path_type;
+  
+  if (path_type == GTK_PATH_WIDGET_CLASS)
+    {
+      rc_set->pspec = NULL;
+      rc_set->path = _gtk_rc_parse_widget_class_path (pattern);
+    }
+  else
+    {
+      rc_set->pspec = g_pattern_spec_new (pattern);
+      rc_set->path = NULL;
+    }
+  
+  rc_set->rc_style = rc_style;
+  rc_set->priority = priority;
+
+  if (path_type == GTK_PATH_WIDGET)
+    context->rc_sets_widget = g_slist_prepend (context->rc_sets_widget, rc_set);
+  else if (path_type == GTK_PATH_WIDGET_CLASS)
+    context->rc_sets_widget_class = g_slist_prepend (context->rc_sets_widget_class, rc_set);
+  else
+    context->rc_sets_class = g_slist_prepend (context->rc_sets_class, rc_set);
+}
+
 static guint
 gtk_rc_parse_path_pattern (GtkRcContext *context,
 			   GScanner     *scanner)
@@ -4135,7 +4467,6 @@ gtk_rc_parse_path_pattern (GtkRcContext *context,
   else
     {
       GtkRcStyle *rc_style;
-      GtkRcSet *rc_set;
 
       rc_style = gtk_rc_style_find (context, scanner->value.v_string);
       
@@ -4145,29 +4476,7 @@ gtk_rc_parse_path_pattern (GtkRcContext *context,
 	  return G_TOKEN_STRING;
 	}
 
-      rc_set = g_new (GtkRcSet, 1);
-      rc_set->type = path_type;
-      
-      if (path_type == GTK_PATH_WIDGET_CLASS)
-        {
-          rc_set->pspec = NULL;
-          rc_set->path = _gtk_rc_parse_widget_class_path (pattern);
-        }
-      else
-        {
-          rc_set->pspec = g_pattern_spec_new (pattern);
-          rc_set->path = NULL;
-        }
-      
-      rc_set->rc_style = rc_style;
-      rc_set->priority = priority;
-
-      if (path_type == GTK_PATH_WIDGET)
-	context->rc_sets_widget = g_slist_prepend (context->rc_sets_widget, rc_set);
-      else if (path_type == GTK_PATH_WIDGET_CLASS)
-	context->rc_sets_widget_class = g_slist_prepend (context->rc_sets_widget_class, rc_set);
-      else
-	context->rc_sets_class = g_slist_prepend (context->rc_sets_class, rc_set);
+      gtk_rc_context_add_set (context, path_type, pattern, rc_style, priority);
     }
 
   g_free (pattern);
@@ -4504,6 +4813,589 @@ gtk_rc_parse_logical_color (GScanner   *scanner,
 }
 
 
+/****************
+ * Cached files *
+ ****************/
+
+static gboolean
+gtk_rc_read_cached_color (GtkRcCache *cache,
+			  guint32    *code,
+			  GtkRcStyle *style,
+			  GdkColor   *color)
+{
+  guint32 kind, red, green, blue;
+  const gchar *string;
+  GdkColor c1, c2;
+  gdouble l;
+
+  if (!_gtk_rc_cache_read_uint (cache, code, &kind))
+    return FALSE;
+
+  switch (kind)
+    {
+    case GTK_RC_CACHE_COLOR_RGB:
+      if (!_gtk_rc_cache_read_uint (cache, code, &red) ||
+	  !_gtk_rc_cache_read_uint (cache, code, &green) ||
+	  !_gtk_rc_cache_read_uint (cache, code, &blue))
+	return FALSE;
+
+      color->red = MIN (red, 65535);
+      color->green = MIN (green, 65535);
+      color->blue = MIN (blue, 65535);
+      return TRUE;
+
+    case GTK_RC_CACHE_COLOR_NAME:
+      return (_gtk_rc_cache_read_string (cache, code, &string) && string &&
+	      gdk_color_parse (string, color));
+
+    case GTK_RC_CACHE_COLOR_SYMBOLIC:
+      return (_gtk_rc_cache_read_string (cache, code, &string) && string &&
+	      style && lookup_color (style, string, color));
+
+    case GTK_RC_CACHE_COLOR_MIX:
+      if (!_gtk_rc_cache_read_string (cache, code, &string) || !string ||
+	  !gtk_rc_read_cached_color (cache, code, style, &c1) ||
+	  !gtk_rc_read_cached_color (cache, code, style, &c2))
+	return FALSE;
+
+      l = g_ascii_strtod (string, NULL);
+      color->red   = l * c1.red   + (1.0 - l) * c2.red;
+      color->green = l * c1.green + (1.0 - l) * c2.green;
+      color->blue  = l * c1.blue  + (1.0 - l) * c2.blue;
+      return TRUE;
+
+    case GTK_RC_CACHE_COLOR_SHADE:
+      if (!_gtk_rc_cache_read_string (cache, code, &string) || !string ||
+	  !gtk_rc_read_cached_color (cache, code, style, &c1))
+	return FALSE;
+
+      _gtk_style_shade (&c1, color, g_ascii_strtod (string, NULL));
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+static gboolean
+gtk_rc_read_cached_value (GtkRcCache *cache,
+			  guint32    *code,
+			  GValue     *value)
+{
+  guint32 kind, n;
+  const gchar *string = NULL;
+
+  if (!_gtk_rc_cache_read_uint (cache, code, &kind))
+    return FALSE;
+
+  if (kind == GTK_RC_CACHE_VALUE_LONG)
+    {
+      if (!_gtk_rc_cache_read_uint (cache, code, &n))
+	return FALSE;
+
+      g_value_init (value, G_TYPE_LONG);
+      g_value_set_long (value, (gint32) n);
+
+      return TRUE;
+    }
+
+  if (!_gtk_rc_cache_read_string (cache, code, &string) || !string)
+    return FALSE;
+
+  switch (kind)
+    {
+    case GTK_RC_CACHE_VALUE_DOUBLE:
+      g_value_init (value, G_TYPE_DOUBLE);
+      g_value_set_double (value, g_ascii_strtod (string, NULL));
+      return TRUE;
+    case GTK_RC_CACHE_VALUE_STRING:
+      g_value_init (value, G_TYPE_STRING);
+      g_value_set_string (value, string);
+      return TRUE;
+    case GTK_RC_CACHE_VALUE_GSTRING:
+      g_value_init (value, G_TYPE_GSTRING);
+      g_value_take_boxed (value, g_string_new (string));
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+static gboolean
+gtk_rc_read_cached_icon_source (GtkRcContext *context,
+				GScanner     *scanner,
+				GtkRcCache   *cache,
+				guint32      *code,
+				GtkIconSet   *icon_set,
+				gboolean     *icon_set_valid)
+{
+  guint32 line, is_icon_name, direction, state;
+  const gchar *name, *size_name;
+  GtkIconSource *source;
+
+  if (!_gtk_rc_cache_read_uint (cache, code, &line) ||
+      !_gtk_rc_cache_read_uint (cache, code, &is_icon_name) ||
+      !_gtk_rc_cache_read_string (cache, code, &name) || !name ||
+      !_gtk_rc_cache_read_uint (cache, code, &direction) ||
+      !_gtk_rc_cache_read_uint (cache, code, &state) ||
+      !_gtk_rc_cache_read_string (cache, code, &size_name) ||
+      (direction != GTK_RC_CACHE_ANY &&
+       direction != GTK_TEXT_DIR_LTR && direction != GTK_TEXT_DIR_RTL) ||
+      (state != GTK_RC_CACHE_ANY && state > GTK_STATE_INSENSITIVE))
+    return FALSE;
+
+  source = gtk_icon_source_new ();
+
+  if (is_icon_name)
+    gtk_icon_source_set_icon_name (source, name);
+  else
+    {
+      gchar *full_filename;
+
+      scanner->line = line;
+      full_filename = gtk_rc_find_pixmap_in_path (context->settings, scanner, name);
+      if (full_filename)
+	{
+	  gtk_icon_source_set_filename (source, full_filename);
+	  g_free (full_filename);
+	}
+    }
+
+  if (direction != GTK_RC_CACHE_ANY)
+    {
+      gtk_icon_source_set_direction_wildcarded (source, FALSE);
+      gtk_icon_source_set_direction (source, direction);
+    }
+
+  if (state != GTK_RC_CACHE_ANY)
+    {
+      gtk_icon_source_set_state_wildcarded (source, FALSE);
+      gtk_icon_source_set_state (source, state);
+    }
+
+  if (size_name)
+    {
+      GtkIconSize size;
+
+      size = gtk_icon_size_from_name (size_name);
+
+      if (size != GTK_ICON_SIZE_INVALID)
+	{
+	  gtk_icon_source_set_size_wildcarded (source, FALSE);
+	  gtk_icon_source_set_size (source, size);
+	}
+    }
+
+  if (gtk_icon_source_get_filename (source) ||
+      gtk_icon_source_get_icon_name (source))
+    {
+      gtk_icon_set_add_source (icon_set, source);
+      *icon_set_valid = TRUE;
+    }
+  gtk_icon_source_free (source);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_rc_read_cached_stock (GtkRcContext   *context,
+			  GScanner       *scanner,
+			  GtkRcCache     *cache,
+			  guint32        *code,
+			  GtkIconFactory *factory)
+{
+  GtkIconSet *icon_set;
+  gboolean icon_set_valid = FALSE;
+  const gchar *stock_id;
+  guint32 n_sources, i;
+
+  if (!_gtk_rc_cache_read_string (cache, code, &stock_id) || !stock_id ||
+      !_gtk_rc_cache_read_uint (cache, code, &n_sources))
+    return FALSE;
+
+  icon_set = gtk_icon_set_new ();
+
+  for (i = 0; i < n_sources; i++)
+    if (!gtk_rc_read_cached_icon_source (context, scanner, cache, code,
+					 icon_set, &icon_set_valid))
+      {
+	gtk_icon_set_unref (icon_set);
+	return FALSE;
+      }
+
+  if (icon_set_valid)
+    gtk_icon_factory_add (factory, stock_id, icon_set);
+
+  gtk_icon_set_unref (icon_set);
+
+  return TRUE;
+}
+
+/* Parses a part of a cached file from its contents */
+static gboolean
+gtk_rc_parse_cached_source (GtkRcContext *context,
+			    const gchar  *input_name,
+			    const gchar  *contents,
+			    gsize         length,
+			    guint32       start,
+			    guint32       end,
+			    guint32       line,
+			    GtkRcStyle  **rc_style)
+{
+  GScanner *scanner;
+  gboolean retval;
+
+  if (start > end || end > length)
+    return FALSE;
+
+  scanner = gtk_rc_statement_scanner_new (input_name);
+  g_scanner_input_text (scanner, contents + start, end - start);
+  scanner->line = line;
+
+  if (rc_style)
+    retval = (gtk_rc_parse_style_body (context, scanner, rc_style) == G_TOKEN_NONE &&
+	      g_scanner_peek_next_token (scanner) == G_TOKEN_EOF);
+  else
+    retval = gtk_rc_parse_statements (context, scanner);
+
+  g_scanner_destroy (scanner);
+
+  return retval;
+}
+
+/* Follows gtk_rc_parse_style_body() */
+static gboolean
+gtk_rc_read_cached_style_body (GtkRcContext *context,
+			       GScanner     *scanner,
+			       GtkRcCache   *cache,
+			       guint32      *code,
+			       const gchar  *contents,
+			       gsize         length,
+			       GtkRcStyle  **rc_style)
+{
+  GtkRcStylePrivate *rc_priv;
+  GtkIconFactory *our_factory = NULL;
+  GHashTable *our_hash = NULL;
+  guint32 kind, line, state, n, start, end;
+  const gchar *string, *string2;
+  GtkRcProperty prop = { 0, 0, NULL, { 0, }, };
+  GdkColor color;
+  gchar *pixmap_file;
+
+  rc_priv = GTK_RC_STYLE_GET_PRIVATE (*rc_style);
+
+  if ((*rc_style)->icon_factories)
+    our_factory = (*rc_style)->icon_factories->data;
+  if (rc_priv->color_hashes)
+    our_hash = rc_priv->color_hashes->data;
+
+  while (_gtk_rc_cache_read_uint (cache, code, &kind) &&
+	 _gtk_rc_cache_read_uint (cache, code, &line))
+    {
+      switch (kind)
+	{
+	case GTK_RC_CACHE_ITEM_END:
+	  return TRUE;
+
+	case GTK_RC_CACHE_ITEM_SOURCE:
+	  if (!_gtk_rc_cache_read_uint (cache, code, &start) ||
+	      !_gtk_rc_cache_read_uint (cache, code, &end) ||
+	      !gtk_rc_parse_cached_source (context, scanner->input_name,
+					   contents, length, start, end, line,
+					   rc_style))
+	    return FALSE;
+
+	  /* An engine section replaces the style */
+	  rc_priv = GTK_RC_STYLE_GET_PRIVATE (*rc_style);
+	  our_factory = (*rc_style)->icon_factories ? (*rc_style)->icon_factories->data : NULL;
+	  our_hash = rc_priv->color_hashes ? rc_priv->color_hashes->data : NULL;
+	  break;
+
+	case GTK_RC_CACHE_ITEM_FG:
+	case GTK_RC_CACHE_ITEM_BG:
+	case GTK_RC_CACHE_ITEM_TEXT:
+	case GTK_RC_CACHE_ITEM_BASE:
+	  if (!_gtk_rc_cache_read_uint (cache, code, &state) ||
+	      state > GTK_STATE_INSENSITIVE ||
+	      !gtk_rc_read_cached_color (cache, code, *rc_style, &color))
+	    return FALSE;
+
+	  if (kind == GTK_RC_CACHE_ITEM_FG)
+	    {
+	      (*rc_style)->color_flags[state] |= GTK_RC_FG;
+	      (*rc_style)->fg[state] = color;
+	    }
+	  else if (kind == GTK_RC_CACHE_ITEM_BG)
+	    {
+	      (*rc_style)->color_flags[state] |= GTK_RC_BG;
+	      (*rc_style)->bg[state] = color;
+	    }
+	  else if (kind == GTK_RC_CACHE_ITEM_TEXT)
+	    {
+	      (*rc_style)->color_flags[state] |= GTK_RC_TEXT;
+	      (*rc_style)->text[state] = color;
+	    }
+	  else
+	    {
+	      (*rc_style)->color_flags[state] |= GTK_RC_BASE;
+	      (*rc_style)->base[state] = color;
+	    }
+	  break;
+
+	case GTK_RC_CACHE_ITEM_XTHICKNESS:
+	case GTK_RC_CACHE_ITEM_YTHICKNESS:
+	  if (!_gtk_rc_cache_read_uint (cache, code, &n))
+	    return FALSE;
+
+	  if (kind == GTK_RC_CACHE_ITEM_XTHICKNESS)
+	    (*rc_style)->xthickness = n;
+	  else
+	    (*rc_style)->ythickness = n;
+	  break;
+
+	case GTK_RC_CACHE_ITEM_BG_PIXMAP:
+	  if (!_gtk_rc_cache_read_uint (cache, code, &state) ||
+	      state > GTK_STATE_INSENSITIVE ||
+	      !_gtk_rc_cache_read_string (cache, code, &string) || !string)
+	    return FALSE;
+
+	  if ((strcmp (string, "<parent>") == 0) ||
+	      (strcmp (string, "<none>") == 0))
+	    pixmap_file = g_strdup (string);
+	  else
+	    {
+	      scanner->line = line;
+	      pixmap_file = gtk_rc_find_pixmap_in_path (context->settings,
+							scanner, string);
+	    }
+
+	  if (pixmap_file)
+	    {
+	      g_free ((*rc_style)->bg_pixmap_name[state]);
+	      (*rc_style)->bg_pixmap_name[state] = pixmap_file;
+	    }
+	  break;
+
+	case GTK_RC_CACHE_ITEM_FONT_NAME:
+	  if (!_gtk_rc_cache_read_string (cache, code, &string) || !string)
+	    return FALSE;
+
+	  if ((*rc_style)->font_desc)
+	    pango_font_description_free ((*rc_style)->font_desc);
+
+	  (*rc_style)->font_desc = pango_font_description_from_string (string);
+	  break;
+
+	case GTK_RC_CACHE_ITEM_COLOR:
+	  if (our_hash == NULL)
+	    gtk_rc_style_prepend_empty_color_hash (*rc_style);
+	  our_hash = rc_priv->color_hashes->data;
+
+	  if (!_gtk_rc_cache_read_string (cache, code, &string) || !string ||
+	      !gtk_rc_read_cached_color (cache, code, *rc_style, &color))
+	    return FALSE;
+
+	  g_hash_table_insert (our_hash, g_strdup (string), gdk_color_copy (&color));
+	  break;
+
+	case GTK_RC_CACHE_ITEM_PROPERTY:
+	  if (!_gtk_rc_cache_read_string (cache, code, &string) || !string ||
+	      !_gtk_rc_cache_read_string (cache, code, &string2) || !string2 ||
+	      !gtk_rc_read_cached_value (cache, code, &prop.value))
+	    return FALSE;
+
+	  prop.type_name = g_quark_from_string (string);
+	  prop.property_name = g_quark_from_string (string2);
+	  if (g_getenv ("GTK_DEBUG"))
+	    prop.origin = g_strdup_printf ("%s:%u", scanner->input_name, line);
+	  else
+	    prop.origin = NULL;
+
+	  insert_rc_property (*rc_style, &prop, TRUE);
+
+	  g_free (prop.origin);
+	  g_value_unset (&prop.value);
+	  break;
+
+	case GTK_RC_CACHE_ITEM_STOCK:
+	  if (our_factory == NULL)
+	    gtk_rc_style_prepend_empty_icon_factory (*rc_style);
+	  our_factory = (*rc_style)->icon_factories->data;
+
+	  if (!gtk_rc_read_cached_stock (context, scanner, cache, code, our_factory))
+	    return FALSE;
+	  break;
+
+	default:
+	  return FALSE;
+	}
+    }
+
+  return FALSE;
+}
+
+/* Follows gtk_rc_parse_statement() */
+static gboolean
+gtk_rc_read_cached_statement (GtkRcContext *context,
+			      GScanner     *scanner,
+			      GtkRcCache   *cache,
+			      guint32      *code,
+			      guint32       kind,
+			      const gchar  *contents,
+			      gsize         length)
+{
+  GtkRcStyle *rc_style, *orig_style, *parent_style = NULL;
+  const gchar *string, *string2;
+  guint32 n, path_type, priority;
+
+  switch (kind)
+    {
+    case GTK_RC_CACHE_INCLUDE:
+      if (!_gtk_rc_cache_read_string (cache, code, &string) || !string)
+	return FALSE;
+
+      parse_include_file (context, scanner, string);
+      return TRUE;
+
+    case GTK_RC_CACHE_PIXMAP_PATH:
+      if (!_gtk_rc_cache_read_string (cache, code, &string) || !string)
+	return FALSE;
+
+      gtk_rc_parse_pixmap_path_string (context, scanner, string);
+      return TRUE;
+
+    case GTK_RC_CACHE_SETTING:
+      {
+	GtkSettingsValue svalue = { NULL, { 0, }, };
+
+	if (!_gtk_rc_cache_read_string (cache, code, &string) || !string ||
+	    !_gtk_rc_cache_read_uint (cache, code, &n) ||
+	    !gtk_rc_read_cached_value (cache, code, &svalue.value))
+	  return FALSE;
+
+	if (g_getenv ("GTK_DEBUG"))
+	  svalue.origin = g_strdup_printf ("%s:%u", scanner->input_name, n);
+
+	_gtk_settings_set_property_value_from_rc (context->settings,
+						  string, &svalue);
+
+	g_free (svalue.origin);
+	g_value_unset (&svalue.value);
+	return TRUE;
+      }
+
+    case GTK_RC_CACHE_SET:
+      if (!_gtk_rc_cache_read_uint (cache, code, &path_type) ||
+	  !_gtk_rc_cache_read_uint (cache, code, &priority) ||
+	  !_gtk_rc_cache_read_string (cache, code, &string) || !string ||
+	  !_gtk_rc_cache_read_string (cache, code, &string2) || !string2 ||
+	  path_type > GTK_PATH_CLASS ||
+	  (priority != GTK_RC_CACHE_ANY && priority > GTK_PATH_PRIO_HIGHEST))
+	return FALSE;
+
+      rc_style = gtk_rc_style_find (context, string2);
+      if (!rc_style)
+	return FALSE;
+
+      if (priority == GTK_RC_CACHE_ANY)
+	priority = context->default_priority;
+
+      gtk_rc_context_add_set (context, path_type, string, rc_style, priority);
+      return TRUE;
+
+    case GTK_RC_CACHE_STYLE:
+      if (!_gtk_rc_cache_read_string (cache, code, &string) || !string ||
+	  !_gtk_rc_cache_read_string (cache, code, &string2))
+	return FALSE;
+
+      rc_style = gtk_rc_style_begin (context, string, &orig_style);
+
+      if (string2)
+	{
+	  parent_style = gtk_rc_style_find (context, string2);
+	  if (parent_style)
+	    gtk_rc_style_inherit (rc_style, parent_style);
+	}
+
+      gtk_rc_style_copy_icons_and_colors (rc_style, parent_style, context);
+
+      if (!gtk_rc_read_cached_style_body (context, scanner, cache, code,
+					  contents, length, &rc_style))
+	{
+	  if (rc_style != orig_style)
+	    gtk_rc_style_unref (rc_style);
+
+	  if (orig_style)
+	    g_object_unref (orig_style);
+
+	  return FALSE;
+	}
+
+      gtk_rc_style_end (context, rc_style, orig_style);
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+/* Runs the statements gtk-update-rc-cache compiled @contents to.  If
+ * one of them fails, or the cache is damaged, the rest of the file is
+ * parsed from @contents instead.
+ */
+static void
+gtk_rc_parse_cached (GtkRcContext *context,
+		     const gchar  *input_name,
+		     GtkRcCache   *cache,
+		     const gchar  *contents,
+		     gsize         length,
+		     guint32       code)
+{
+  GScanner *scanner;
+  guint32 kind, offset, line, end;
+  guint32 resume = 0, resume_line = 1;
+
+  /* The new statements may add rc sets or change existing styles */
+  gtk_rc_context_clear_style_memo (context);
+
+  /* For the messages of the functions that are shared with the parser */
+  scanner = gtk_rc_scanner_new ();
+  scanner->input_name = input_name;
+
+  while (_gtk_rc_cache_read_uint (cache, &code, &kind) &&
+	 _gtk_rc_cache_read_uint (cache, &code, &offset) &&
+	 _gtk_rc_cache_read_uint (cache, &code, &line) &&
+	 offset <= length)
+    {
+      resume = offset;
+      resume_line = line;
+      scanner->line = line;
+
+      if (kind == GTK_RC_CACHE_END)
+	goto out;
+
+      if (kind == GTK_RC_CACHE_SOURCE)
+	{
+	  if (!_gtk_rc_cache_read_uint (cache, &code, &end) || end < offset || end > length)
+	    break;
+
+	  /* Errors in the contents are reported by the parser */
+	  if (!gtk_rc_parse_cached_source (context, input_name, contents, length,
+					   offset, end, line, NULL))
+	    goto out;
+	}
+      else if (!gtk_rc_read_cached_statement (context, scanner, cache, &code, kind,
+					      contents, length))
+	break;
+    }
+
+  gtk_rc_parse_cached_source (context, input_name, contents, length,
+			      resume, length, resume_line, NULL);
+
+ out:
+  g_scanner_destroy (scanner);
+}
+
 GSList *
 _gtk_rc_parse_widget_class_path (const gchar *pattern)
 {
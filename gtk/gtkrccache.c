@@ -0,0 +1,411 @@
+/* gtkrccache.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Reads the FILE.cache files that gtk-update-rc-cache writes next to an
+ * RC file.  A cache bundles the RC file with everything it includes and
+ * its locale specific variants, so that parsing a theme needs a single
+ * mapped file instead of opening and probing for each of them.
+ *
+ * The layout, all numbers big endian:
+ *
+ * Header:
+ * 0   CARD16  MAJOR_VERSION
+ * 2   CARD16  MINOR_VERSION
+ * 4   CARD32  number of directories
+ * 8   CARD32  offset of the directory list
+ * 12  CARD32  number of files
+ * 16  CARD32  offset of the file list
+ *
+ * Directory:
+ * 0   CARD32  offset of the path
+ * 4   CARD32  mtime
+ * 8   CARD32  nanoseconds of the mtime
+ *
+ * File:
+ * 0   CARD32  offset of the path
+ * 4   CARD32  mtime
+ * 8   CARD32  nanoseconds of the mtime
+ * 12  CARD32  size
+ * 16  CARD32  mtime of the file, or of the symbolic link if it is one
+ * 20  CARD32  offset of the contents, followed by a nul byte
+ * 24  CARD32  offset of the compiled statements
+ *
+ * The directories are the ones the tool looked for files in; a file in
+ * one of them that isn't in the file list did not exist.  A cache whose
+ * files or directories changed since it was written is ignored.  The
+ * nanoseconds are 0 where struct stat doesn't have them, and a change
+ * within the second the cache was written in then goes unnoticed.
+ *
+ * The compiled statements of a file are CARD32s.  Each statement starts
+ * with a GtkRcCacheStatement, the offset in the contents it starts at
+ * and its line, followed by:
+ *
+ * END          nothing
+ * SOURCE       the offset it ends at; the contents in between are parsed
+ * INCLUDE      file name
+ * PIXMAP_PATH  path
+ * SETTING      name, line of the assignment, value
+ * SET          GtkPathType, GtkPathPriorityType or ANY, pattern, style
+ * STYLE        name, name of the parent or 0, items up to ITEM_END
+ *
+ * Each item of a style starts with a GtkRcCacheItem and a line:
+ *
+ * ITEM_END                 nothing
+ * ITEM_SOURCE              offsets it starts and ends at, as for SOURCE
+ * ITEM_FG, _BG, _TEXT, _BASE  GtkStateType, color
+ * ITEM_XTHICKNESS, _YTHICKNESS  number
+ * ITEM_BG_PIXMAP           GtkStateType, file name
+ * ITEM_FONT_NAME           font name
+ * ITEM_COLOR               name, color
+ * ITEM_PROPERTY            type name, property name, value
+ * ITEM_STOCK               stock id, number of icon sources, icon sources
+ *
+ * An icon source is a line, 0 for a file name or 1 for an icon name,
+ * the name, a GtkTextDirection, a GtkStateType and the name of a size,
+ * with ANY, or 0 for the size, for wildcards.  A color is an RGB triple,
+ * a NAME or SYMBOLIC name, a factor and two colors to MIX, or a factor
+ * and a color to SHADE.  A value is a LONG number, or a DOUBLE, STRING or
+ * GSTRING string.  Factors and doubles are strings for g_ascii_strtod().
+ * Strings are offsets of nul-terminated strings.
+ *
+ * Engine sections and bindings depend on modules and the code that
+ * parses them, so they stay SOURCE, as do values with floats or symbolic
+ * colors in compounds; so does everything after something
+ * gtk-update-rc-cache can't compile.  If a compiled statement fails when
+ * it is run, the file is parsed from there, which reports the error the
+ * same way.  Pixmaps and engines are still looked for on the file system.
+ */
+
+#include <config.h>
+
+#include "gtkdebug.h"
+#include "gtkrccache.h"
+#include "gtkalias.h"
+
+#include <glib/gstdio.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string.h>
+
+#define MAJOR_VERSION 2
+#define MINOR_VERSION 0
+
+#define HEADER_SIZE     20
+#define DIR_ENTRY_SIZE  12
+#define FILE_ENTRY_SIZE 28
+
+#define GET_UINT16(cache, offset) (GUINT16_FROM_BE (*(guint16 *)((cache) + (offset))))
+#define GET_UINT32(cache, offset) (GUINT32_FROM_BE (*(guint32 *)((cache) + (offset))))
+
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+#define ST_MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)
+#else
+#define ST_MTIME_NSEC(st) 0
+#endif
+
+struct _GtkRcCache
+{
+  GMappedFile *map;
+  const gchar *buffer;
+  gsize length;
+
+  guint n_dirs;
+  guint32 dir_list_offset;
+  guint n_files;
+  guint32 file_list_offset;
+};
+
+static gboolean
+check_string (GtkRcCache *cache,
+	      guint32     offset)
+{
+  return (offset < cache->length &&
+	  memchr (cache->buffer + offset, '\0', cache->length - offset) != NULL);
+}
+
+static gboolean
+check_list (GtkRcCache *cache,
+	    guint32     offset,
+	    guint       n_entries,
+	    guint       entry_size)
+{
+  return (offset % 4 == 0 &&
+	  offset <= cache->length &&
+	  n_entries <= (cache->length - offset) / entry_size);
+}
+
+/* Makes sure that reading the cache can't go past its end, and that
+ * it still describes what is on disk.
+ */
+static gboolean
+validate_cache (GtkRcCache *cache)
+{
+  struct stat st;
+  guint i;
+
+  if (!check_list (cache, cache->dir_list_offset, cache->n_dirs, DIR_ENTRY_SIZE) ||
+      !check_list (cache, cache->file_list_offset, cache->n_files, FILE_ENTRY_SIZE))
+    return FALSE;
+
+  for (i = 0; i < cache->n_dirs; i++)
+    {
+      guint32 entry = cache->dir_list_offset + i * DIR_ENTRY_SIZE;
+      guint32 path_offset = GET_UINT32 (cache->buffer, entry);
+      time_t mtime = GET_UINT32 (cache->buffer, entry + 4);
+      guint32 mtime_nsec = GET_UINT32 (cache->buffer, entry + 8);
+
+      if (!check_string (cache, path_offset))
+	return FALSE;
+
+      /* gtk-update-rc-cache records the mtime of the directory the
+       * cache is in after moving the cache there.
+       */
+      if (g_stat (cache->buffer + path_offset, &st) < 0 ||
+	  st.st_mtime != mtime || ST_MTIME_NSEC (&st) != mtime_nsec)
+	{
+	  GTK_NOTE (MISC, g_print ("rc cache: %s changed\n", cache->buffer + path_offset));
+	  return FALSE;
+	}
+    }
+
+  for (i = 0; i < cache->n_files; i++)
+    {
+      guint32 entry = cache->file_list_offset + i * FILE_ENTRY_SIZE;
+      guint32 path_offset = GET_UINT32 (cache->buffer, entry);
+      time_t mtime = GET_UINT32 (cache->buffer, entry + 4);
+      guint32 mtime_nsec = GET_UINT32 (cache->buffer, entry + 8);
+      guint32 size = GET_UINT32 (cache->buffer, entry + 12);
+      guint32 data_offset = GET_UINT32 (cache->buffer, entry + 20);
+      guint32 code_offset = GET_UINT32 (cache->buffer, entry + 24);
+
+      /* The statements are checked as they are read */
+      if (!check_string (cache, path_offset) ||
+	  data_offset >= cache->length ||
+	  size >= cache->length - data_offset ||
+	  cache->buffer[data_offset + size] != '\0' ||
+	  code_offset % 4 != 0)
+	return FALSE;
+
+      if (g_stat (cache->buffer + path_offset, &st) < 0 ||
+	  st.st_mtime != mtime || ST_MTIME_NSEC (&st) != mtime_nsec ||
+	  st.st_size != (off_t) size)
+	{
+	  GTK_NOTE (MISC, g_print ("rc cache: %s changed\n", cache->buffer + path_offset));
+	  return FALSE;
+	}
+    }
+
+  return TRUE;
+}
+
+/**
+ * _gtk_rc_cache_new_for_file:
+ * @filename: an RC file
+ *
+ * Loads the cache that gtk-update-rc-cache wrote for @filename, if
+ * there is one and none of the files it was made from have changed.
+ *
+ * Return value: the cache, or %NULL if @filename has to be parsed
+ *   from the file system.
+ **/
+GtkRcCache *
+_gtk_rc_cache_new_for_file (const gchar *filename)
+{
+  GtkRcCache *cache = NULL;
+  GMappedFile *map;
+  gchar *cache_filename;
+  struct stat st;
+
+  cache_filename = g_strconcat (filename, ".cache", NULL);
+
+  if (g_stat (cache_filename, &st) < 0 || st.st_size < HEADER_SIZE)
+    goto out;
+
+  map = g_mapped_file_new (cache_filename, FALSE, NULL);
+  if (!map)
+    goto out;
+
+  cache = g_new (GtkRcCache, 1);
+  cache->map = map;
+  cache->buffer = g_mapped_file_get_contents (map);
+  cache->length = g_mapped_file_get_length (map);
+
+  if (cache->length < HEADER_SIZE ||
+      GET_UINT16 (cache->buffer, 0) != MAJOR_VERSION ||
+      GET_UINT16 (cache->buffer, 2) != MINOR_VERSION)
+    {
+      GTK_NOTE (MISC, g_print ("rc cache: %s has the wrong version\n", cache_filename));
+      _gtk_rc_cache_free (cache);
+      cache = NULL;
+      goto out;
+    }
+
+  cache->n_dirs = GET_UINT32 (cache->buffer, 4);
+  cache->dir_list_offset = GET_UINT32 (cache->buffer, 8);
+  cache->n_files = GET_UINT32 (cache->buffer, 12);
+  cache->file_list_offset = GET_UINT32 (cache->buffer, 16);
+
+  if (!validate_cache (cache))
+    {
+      _gtk_rc_cache_free (cache);
+      cache = NULL;
+      goto out;
+    }
+
+  GTK_NOTE (MISC, g_print ("rc cache: using %s\n", cache_filename));
+
+ out:
+  g_free (cache_filename);
+
+  return cache;
+}
+
+void
+_gtk_rc_cache_free (GtkRcCache *cache)
+{
+  g_mapped_file_free (cache->map);
+  g_free (cache);
+}
+
+/**
+ * _gtk_rc_cache_lookup:
+ * @cache: a #GtkRcCache
+ * @filename: the absolute name of a file
+ * @contents: return location for the contents of @filename, or %NULL
+ *   if it doesn't exist
+ * @length: return location for the length of the contents, or %NULL
+ * @code: return location for the position of the compiled statements
+ *   of @filename, for _gtk_rc_cache_read_uint(), or %NULL
+ * @mtime: return location for the mtime of @filename, or %NULL; like
+ *   the one gtk_rc_reparse_all() compares with, it is that of the
+ *   symbolic link if @filename is one
+ *
+ * Looks @filename up in @cache.  The contents are nul-terminated and
+ * stay valid until @cache is freed.
+ *
+ * Return value: %TRUE if @cache knows whether @filename exists,
+ *   %FALSE if it has to be looked for on the file system.
+ **/
+gboolean
+_gtk_rc_cache_lookup (GtkRcCache   *cache,
+		      const gchar  *filename,
+		      const gchar **contents,
+		      gsize        *length,
+		      guint32      *code,
+		      time_t       *mtime)
+{
+  gchar *dirname;
+  gboolean known = FALSE;
+  guint i;
+
+  /* Caches hold a handful of files, so there is no index */
+  for (i = 0; i < cache->n_files; i++)
+    {
+      guint32 entry = cache->file_list_offset + i * FILE_ENTRY_SIZE;
+
+      if (strcmp (cache->buffer + GET_UINT32 (cache->buffer, entry), filename) == 0)
+	{
+	  *contents = cache->buffer + GET_UINT32 (cache->buffer, entry + 20);
+	  if (length)
+	    *length = GET_UINT32 (cache->buffer, entry + 12);
+	  if (code)
+	    *code = GET_UINT32 (cache->buffer, entry + 24);
+	  if (mtime)
+	    *mtime = GET_UINT32 (cache->buffer, entry + 16);
+
+	  return TRUE;
+	}
+    }
+
+  dirname = g_path_get_dirname (filename);
+
+  for (i = 0; i < cache->n_dirs && !known; i++)
+    {
+      guint32 entry = cache->dir_list_offset + i * DIR_ENTRY_SIZE;
+
+      if (strcmp (cache->buffer + GET_UINT32 (cache->buffer, entry), dirname) == 0)
+	known = TRUE;
+    }
+
+  g_free (dirname);
+
+  if (known)
+    *contents = NULL;
+
+  return known;
+}
+
+/**
+ * _gtk_rc_cache_read_uint:
+ * @cache: a #GtkRcCache
+ * @code: the position of the next number of compiled statements, which
+ *   is advanced past it
+ * @value: return location for the number
+ *
+ * Reads a number of the compiled statements of a file.
+ *
+ * Return value: %FALSE if @code is past the end of @cache.
+ **/
+gboolean
+_gtk_rc_cache_read_uint (GtkRcCache *cache,
+			 guint32    *code,
+			 guint32    *value)
+{
+  if (cache->length < 4 || *code > cache->length - 4)
+    return FALSE;
+
+  *value = GET_UINT32 (cache->buffer, *code);
+  *code += 4;
+
+  return TRUE;
+}
+
+/**
+ * _gtk_rc_cache_read_string:
+ * @cache: a #GtkRcCache
+ * @code: the position of the next number of compiled statements, which
+ *   is advanced past it
+ * @string: return location for the string that number is the offset
+ *   of, or %NULL if it is 0
+ *
+ * Reads a string of the compiled statements of a file.  It stays valid
+ * until @cache is freed.
+ *
+ * Return value: %FALSE if @code is past the end of @cache, or the
+ *   offset is.
+ **/
+gboolean
+_gtk_rc_cache_read_string (GtkRcCache   *cache,
+			   guint32      *code,
+			   const gchar **string)
+{
+  guint32 offset;
+
+  if (!_gtk_rc_cache_read_uint (cache, code, &offset))
+    return FALSE;
+
+  if (offset == 0)
+    *string = NULL;
+  else if (check_string (cache, offset))
+    *string = cache->buffer + offset;
+  else
+    return FALSE;
+
+  return TRUE;
+}
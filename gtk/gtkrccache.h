@@ -0,0 +1,96 @@
+/* gtkrccache.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef __GTK_RC_CACHE_H__
+#define __GTK_RC_CACHE_H__
+
+#include <glib.h>
+#include <time.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GtkRcCache GtkRcCache;
+
+/* The statements gtk-update-rc-cache compiles RC files to; see
+ * gtkrccache.c for what follows each of them.
+ */
+typedef enum
+{
+  GTK_RC_CACHE_END,
+  GTK_RC_CACHE_SOURCE,
+  GTK_RC_CACHE_INCLUDE,
+  GTK_RC_CACHE_PIXMAP_PATH,
+  GTK_RC_CACHE_SETTING,
+  GTK_RC_CACHE_SET,
+  GTK_RC_CACHE_STYLE
+} GtkRcCacheStatement;
+
+typedef enum
+{
+  GTK_RC_CACHE_ITEM_END,
+  GTK_RC_CACHE_ITEM_SOURCE,
+  GTK_RC_CACHE_ITEM_FG,
+  GTK_RC_CACHE_ITEM_BG,
+  GTK_RC_CACHE_ITEM_TEXT,
+  GTK_RC_CACHE_ITEM_BASE,
+  GTK_RC_CACHE_ITEM_XTHICKNESS,
+  GTK_RC_CACHE_ITEM_YTHICKNESS,
+  GTK_RC_CACHE_ITEM_BG_PIXMAP,
+  GTK_RC_CACHE_ITEM_FONT_NAME,
+  GTK_RC_CACHE_ITEM_COLOR,
+  GTK_RC_CACHE_ITEM_PROPERTY,
+  GTK_RC_CACHE_ITEM_STOCK
+} GtkRcCacheItem;
+
+typedef enum
+{
+  GTK_RC_CACHE_COLOR_RGB,
+  GTK_RC_CACHE_COLOR_NAME,
+  GTK_RC_CACHE_COLOR_SYMBOLIC,
+  GTK_RC_CACHE_COLOR_MIX,
+  GTK_RC_CACHE_COLOR_SHADE
+} GtkRcCacheColor;
+
+typedef enum
+{
+  GTK_RC_CACHE_VALUE_LONG,
+  GTK_RC_CACHE_VALUE_DOUBLE,
+  GTK_RC_CACHE_VALUE_STRING,
+  GTK_RC_CACHE_VALUE_GSTRING
+} GtkRcCacheValue;
+
+/* A default priority, or a wildcard in an icon source */
+#define GTK_RC_CACHE_ANY 0xffffffff
+
+GtkRcCache *_gtk_rc_cache_new_for_file (const gchar  *filename);
+void        _gtk_rc_cache_free         (GtkRcCache   *cache);
+gboolean    _gtk_rc_cache_lookup       (GtkRcCache   *cache,
+					const gchar  *filename,
+					const gchar **contents,
+					gsize        *length,
+					guint32      *code,
+					time_t       *mtime);
+gboolean    _gtk_rc_cache_read_uint    (GtkRcCache   *cache,
+					guint32      *code,
+					guint32      *value);
+gboolean    _gtk_rc_cache_read_string  (GtkRcCache   *cache,
+					guint32      *code,
+					const gchar **string);
+
+G_END_DECLS
+
+#endif /* __GTK_RC_CACHE_H__ */
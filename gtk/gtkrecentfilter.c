@@ -494,13 +494,20 @@ gtk_recent_filter_filter (GtkRecentFilter           *filter,
       switch (rule->type)
         {
         case FILTER_RULE_MIME_TYPE:
-          if ((filter_info->mime_type != NULL)
+          if (filter_info->mime_type != NULL)
+            {
+              gboolean matches;
+
 #ifdef G_OS_UNIX
-              && (xdg_mime_mime_type_subclass (filter_info->mime_type, rule->u.mime_type)))
+              G_LOCK (_gtk_xdgmime);
+              matches = xdg_mime_mime_type_subclass (filter_info->mime_type, rule->u.mime_type);
+              G_UNLOCK (_gtk_xdgmime);
 #else
-	      && (strcmp (filter_info->mime_type, rule->u.mime_type) == 0))
+              matches = (strcmp (filter_info->mime_type, rule->u.mime_type) == 0);
 #endif
-            return TRUE;
+              if (matches)
+                return TRUE;
+            }
           break;
         case FILTER_RULE_APPLICATION:
           if (filter_info->applications)
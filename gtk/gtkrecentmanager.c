@@ -38,9 +38,13 @@
 #include "gtktypebuiltins.h"
 #include "gtkprivate.h"
 #include "gtkmarshalers.h"
+#include "gtkmain.h"
+#include "gtkfilemonitor.h"
 #include "gtkalias.h"
 
 #ifdef G_OS_UNIX
+#include <fcntl.h>
+
 #define XDG_PREFIX _gtk_xdg
 #include "xdgmime/xdgmime.h"
 #endif
@@ -48,6 +52,21 @@
 /* the file where we store the recently used items */
 #define GTK_RECENTLY_USED_FILE	".recently-used.xbel"
 
+/* changes are appended to a log next to the file, and folded back
+ * into the file once the log grows larger than LOG_COMPACT_SIZE, or
+ * COMPACT_DELAY milliseconds after it stopped being empty, so that
+ * programs reading only the file don't miss them for long.
+ */
+#define GTK_RECENTLY_USED_LOG_SUFFIX	".log"
+#define LOG_COMPACT_SIZE	(64 * 1024)
+#define COMPACT_DELAY		(5 * 60 * 1000)
+
+/* the key file group of each record in the log */
+#define LOG_GROUP	"Change"
+
+/* changes made within a quarter of a second are notified together */
+#define CHANGED_DELAY	250
+
 /* a poll every two seconds should be enough */
 #define POLL_DELTA	2000
 
@@ -109,7 +128,15 @@ struct _GtkRecentManagerPrivate
   GBookmarkFile *recent_items;
   
   time_t last_mtime;
+  ino_t last_ino;
   guint poll_timeout;
+  guint monitor_id;
+
+  gchar *log_filename;
+  off_t log_offset;	/* how much of the log we have applied */
+  GString *pending;	/* records not yet appended to the log */
+  guint changed_timeout;
+  guint compact_timeout;
 };
 
 enum
@@ -135,9 +162,16 @@ static void           gtk_recent_manager_changed      (GtkRecentManager      *ma
 
 static void           gtk_recent_manager_real_changed (GtkRecentManager      *manager);
 static gboolean       gtk_recent_manager_poll_timeout (gpointer               data);
+static void           gtk_recent_manager_start_watch  (GtkRecentManager      *manager);
+static void           gtk_recent_manager_stop_watch   (GtkRecentManager      *manager);
 static void           gtk_recent_manager_set_filename (GtkRecentManager      *manager,
 						       const gchar           *filename);
 
+static void           gtk_recent_manager_flush        (GtkRecentManager      *manager,
+						       gboolean               compact);
+static void           gtk_recent_manager_cancel_changed (GtkRecentManager    *manager);
+static void           gtk_recent_manager_schedule_compact (GtkRecentManager  *manager);
+
 static void           build_recent_items_list         (GtkRecentManager      *manager);
 static void           purge_recent_items_list         (GtkRecentManager      *manager,
 						       GError               **error);
@@ -256,7 +290,8 @@ gtk_recent_manager_class_init (GtkRecentManagerClass *klass)
    * @recent_manager: the recent manager
    *
    * Emitted when the current recently used resources manager changes its
-   * contents.
+   * contents.  Changes made through @recent_manager itself in quick
+   * succession are reported by a single emission.
    *
    * Since: 2.10
    */
@@ -296,9 +331,17 @@ gtk_recent_manager_init (GtkRecentManager *manager)
   priv->filename = g_build_filename (g_get_home_dir (),
 				     GTK_RECENTLY_USED_FILE,
 				     NULL);
-  priv->poll_timeout = g_timeout_add (POLL_DELTA,
-		  		      gtk_recent_manager_poll_timeout,
-				      manager);
+#ifdef G_OS_UNIX
+  priv->log_filename = g_strconcat (priv->filename,
+				    GTK_RECENTLY_USED_LOG_SUFFIX,
+				    NULL);
+#endif
+  priv->pending = g_string_new (NULL);
+  priv->poll_timeout = 0;
+  priv->monitor_id = 0;
+  priv->changed_timeout = 0;
+  priv->compact_timeout = 0;
+  gtk_recent_manager_start_watch (manager);
 
   build_recent_items_list (manager);
 }
@@ -356,12 +399,17 @@ gtk_recent_manager_finalize (GObject *object)
   GtkRecentManager *manager = GTK_RECENT_MANAGER (object);
   GtkRecentManagerPrivate *priv = manager->priv;
 
-  /* remove the poll timeout */
-  if (priv->poll_timeout)
-    g_source_remove (priv->poll_timeout);
+  gtk_recent_manager_stop_watch (manager);
+  gtk_recent_manager_cancel_changed (manager);
+
+  if (priv->compact_timeout)
+    g_source_remove (priv->compact_timeout);
   
   if (priv->filename)
     g_free (priv->filename);
+
+  g_free (priv->log_filename);
+  g_string_free (priv->pending, TRUE);
   
   if (priv->recent_items)
     g_bookmark_file_free (priv->recent_items);
@@ -370,234 +418,819 @@ gtk_recent_manager_finalize (GObject *object)
   G_OBJECT_CLASS (gtk_recent_manager_parent_class)->finalize (object);
 }
 
+/* The log holds one record for each change made since the file was
+ * last rewritten.  A record is its length in bytes as a decimal number,
+ * a newline, and a key file with a single LOG_GROUP group.  Records
+ * carry the resulting state rather than the operation, so applying
+ * one more than once gives the same result.
+ */
+static GKeyFile *
+log_record_new (const gchar *action,
+		const gchar *uri)
+{
+  GKeyFile *record;
+
+  record = g_key_file_new ();
+  g_key_file_set_string (record, LOG_GROUP, "Action", action);
+  if (uri)
+    g_key_file_set_string (record, LOG_GROUP, "URI", uri);
+
+  return record;
+}
+
 static void
-gtk_recent_manager_real_changed (GtkRecentManager *manager)
+log_record_set_time (GKeyFile    *record,
+		     const gchar *key,
+		     time_t       value)
+{
+  gchar *str;
+
+  str = g_strdup_printf ("%ld", (glong) value);
+  g_key_file_set_value (record, LOG_GROUP, key, str);
+  g_free (str);
+}
+
+static time_t
+log_record_get_time (GKeyFile    *record,
+		     const gchar *key)
+{
+  gchar *str;
+  time_t value;
+
+  str = g_key_file_get_value (record, LOG_GROUP, key, NULL);
+  if (!str)
+    return (time_t) -1;
+
+  value = (time_t) g_ascii_strtoll (str, NULL, 10);
+  g_free (str);
+
+  return value;
+}
+
+static void
+apply_add_record (GBookmarkFile *items,
+		  const gchar   *uri,
+		  GKeyFile      *record)
+{
+  gchar *mime_type, *app_name, *app_exec, *str;
+  gchar **groups;
+  gint count;
+  gsize i;
+
+  mime_type = g_key_file_get_string (record, LOG_GROUP, "MimeType", NULL);
+  app_name = g_key_file_get_string (record, LOG_GROUP, "Application", NULL);
+  app_exec = g_key_file_get_string (record, LOG_GROUP, "Exec", NULL);
+
+  if (!mime_type || !app_name || !app_exec)
+    goto out;
+
+  /* this one creates the item if needed, so it goes first */
+  g_bookmark_file_set_mime_type (items, uri, mime_type);
+
+  str = g_key_file_get_string (record, LOG_GROUP, "Name", NULL);
+  if (str)
+    g_bookmark_file_set_title (items, uri, str);
+  g_free (str);
+
+  str = g_key_file_get_string (record, LOG_GROUP, "Description", NULL);
+  if (str)
+    g_bookmark_file_set_description (items, uri, str);
+  g_free (str);
+
+  groups = g_key_file_get_string_list (record, LOG_GROUP, "Groups", NULL, NULL);
+  for (i = 0; groups && groups[i] != NULL; i++)
+    g_bookmark_file_add_group (items, uri, groups[i]);
+  g_strfreev (groups);
+
+  count = g_key_file_get_integer (record, LOG_GROUP, "Count", NULL);
+  g_bookmark_file_set_app_info (items, uri, app_name, app_exec,
+				MAX (count, 1),
+				log_record_get_time (record, "Stamp"),
+				NULL);
+
+  g_bookmark_file_set_is_private (items, uri,
+				  g_key_file_get_boolean (record, LOG_GROUP, "Private", NULL));
+
+  /* the setters above touch the modification time, so restore it last */
+  g_bookmark_file_set_added (items, uri, log_record_get_time (record, "Added"));
+  g_bookmark_file_set_visited (items, uri, log_record_get_time (record, "Visited"));
+  g_bookmark_file_set_modified (items, uri, log_record_get_time (record, "Modified"));
+
+ out:
+  g_free (mime_type);
+  g_free (app_name);
+  g_free (app_exec);
+}
+
+static void
+apply_log_record (GtkRecentManager *manager,
+		  GKeyFile         *record)
 {
   GtkRecentManagerPrivate *priv = manager->priv;
+  gchar *action, *uri, *new_uri;
 
-  g_object_freeze_notify (G_OBJECT (manager));
+  action = g_key_file_get_string (record, LOG_GROUP, "Action", NULL);
+  uri = g_key_file_get_string (record, LOG_GROUP, "URI", NULL);
 
-  if (priv->is_dirty)
+  if (!action)
+    goto out;
+
+  if (strcmp (action, "clear") == 0)
     {
-      GError *write_error;
-      struct stat stat_buf;
-      
-      /* we are marked as dirty, so we dump the content of our
-       * recently used items list
-       */
-      g_assert (priv->filename != NULL);
+      g_bookmark_file_free (priv->recent_items);
+      priv->recent_items = g_bookmark_file_new ();
+    }
+  else if (uri && strcmp (action, "add") == 0)
+    apply_add_record (priv->recent_items, uri, record);
+  else if (uri && strcmp (action, "remove") == 0)
+    g_bookmark_file_remove_item (priv->recent_items, uri, NULL);
+  else if (uri && strcmp (action, "move") == 0)
+    {
+      new_uri = g_key_file_get_string (record, LOG_GROUP, "NewURI", NULL);
+      if (g_bookmark_file_has_item (priv->recent_items, uri))
+        g_bookmark_file_move_item (priv->recent_items, uri, new_uri, NULL);
+      g_free (new_uri);
+    }
 
-      priv->write_in_progress = TRUE;
+ out:
+  g_free (action);
+  g_free (uri);
+}
 
-      /* if no container object has been defined, we create a new
-       * empty container, and dump it
-       */
-      if (!priv->recent_items)
-        {
-          priv->recent_items = g_bookmark_file_new ();
-	  priv->size = 0;
-	}
+/* applies the complete records in @data to the items list, and returns
+ * the number of bytes they took; a record that is still being written
+ * is left for the next time.
+ */
+static gsize
+apply_log (GtkRecentManager *manager,
+	   const gchar      *data,
+	   gsize             length)
+{
+  gsize pos = 0;
+
+  while (pos < length)
+    {
+      const gchar *newline;
+      gchar *end;
+      guint64 record_len;
+      GKeyFile *record;
 
-      write_error = NULL;
-      g_bookmark_file_to_file (priv->recent_items,
-		               priv->filename,
-			       &write_error);
+      newline = memchr (data + pos, '\n', length - pos);
+      if (!newline)
+        break;
 
-      if (write_error)
-        {
-          filename_warning ("Attempting to store changes into `%s', "
-			    "but failed: %s",
-			    priv->filename,
-			    write_error->message);
-	  g_error_free (write_error);
-	}
+      record_len = g_ascii_strtoull (data + pos, &end, 10);
+      if (end == data + pos || end != newline ||
+          record_len > length - (newline + 1 - data))
+        break;
 
-      priv->write_in_progress = FALSE;
-	  
-      /* we have sync'ed our list with the storage file, so we
-       * update the file mtime in order to skip the timed check
-       * and spare us from a re-read.
-       */
-      if (g_stat (priv->filename, &stat_buf) < 0)
-	{
-          filename_warning ("Unable to stat() the recently used resources file "
-			    "at `%s': %s.",
-			    priv->filename,
-			    g_strerror (errno));
+      record = g_key_file_new ();
+      if (g_key_file_load_from_data (record, newline + 1, record_len,
+				     G_KEY_FILE_NONE, NULL))
+        apply_log_record (manager, record);
+      g_key_file_free (record);
 
-	  g_object_thaw_notify (G_OBJECT (manager));
+      pos = (newline + 1 - data) + record_len;
+    }
 
-	  return;
-	}
-      
-      priv->last_mtime = stat_buf.st_mtime;
+  return pos;
+}
+
+/* appends @record to the log, and takes ownership of it.  the write
+ * happens right away, so that the change isn't lost if the program
+ * exits before the "changed" signal is emitted.
+ */
+static void
+gtk_recent_manager_add_record (GtkRecentManager *manager,
+			       GKeyFile         *record)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  gchar *data;
+  gsize length;
+
+  data = g_key_file_to_data (record, &length, NULL);
+  g_string_append_printf (priv->pending, "%" G_GSIZE_FORMAT "\n", length);
+  g_string_append_len (priv->pending, data, length);
+
+  g_free (data);
+  g_key_file_free (record);
+
+  gtk_recent_manager_flush (manager, FALSE);
+
+  /* mark us as dirty, so that when emitting the "changed" signal we
+   * will check whether the log needs to be folded into the file
+   */
+  priv->is_dirty = TRUE;
+}
+
+static void
+update_size (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  gint size;
+
+  size = priv->recent_items ? g_bookmark_file_get_size (priv->recent_items) : 0;
+  if (priv->size != size)
+    {
+      priv->size = size;
       
-      /* mark us as clean */
-      priv->is_dirty = FALSE;
+      g_object_notify (G_OBJECT (manager), "size");
+    }
+}
+
+/* reads whatever follows @offset in the log */
+static gchar *
+read_log (gint   log_fd,
+	  off_t  offset,
+	  gsize *length)
+{
+  struct stat stat_buf;
+  gchar *data;
+  gssize res;
+  gsize pos;
+
+  *length = 0;
+
+  if (fstat (log_fd, &stat_buf) < 0 || stat_buf.st_size <= offset)
+    return NULL;
+
+  if (lseek (log_fd, offset, SEEK_SET) < 0)
+    return NULL;
+
+  data = g_malloc (stat_buf.st_size - offset);
+  pos = 0;
+  while (pos < (gsize) (stat_buf.st_size - offset))
+    {
+      res = read (log_fd, data + pos, stat_buf.st_size - offset - pos);
+      if (res < 0 && errno == EINTR)
+        continue;
+      if (res <= 0)
+        break;
+
+      pos += res;
+    }
+
+  *length = pos;
+
+  return data;
+}
+
+/* loads the recently used resources file into a new items list, without
+ * the log.  we keep the items list inside the parser object, and build
+ * the RecentInfo object only on user's demand to avoid useless
+ * replication.
+ */
+static void
+load_items (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  GBookmarkFile *items;
+  struct stat stat_buf;
+  GError *read_error;
+
+  items = g_bookmark_file_new ();
+
+  if (g_stat (priv->filename, &stat_buf) < 0)
+    {
+      /* the file doesn't exists, so we wait for the first write
+       * operation
+       */
+      if (errno != ENOENT)
+        filename_warning ("Attempting to read the recently used resources file "
+			  "at `%s', but an error occurred: %s. Aborting.",
+			  priv->filename,
+			  g_strerror (errno));
+
+      priv->last_mtime = 0;
+      priv->last_ino = 0;
     }
   else
     {
-      /* we are not marked as dirty, so we have been called
-       * because the recently used resources file has been
-       * changed (and not from us).
+      /* record the last mtime, for later use */
+      priv->last_mtime = stat_buf.st_mtime;
+      priv->last_ino = stat_buf.st_ino;
+
+      /* the file exists, and it's valid (we hope); if not, start from
+       * an empty list and hope for a better result the next time.
        */
-      build_recent_items_list (manager);
+      read_error = NULL;
+      g_bookmark_file_load_from_file (items, priv->filename, &read_error);
+      if (read_error)
+        {
+          filename_warning ("Attempting to read the recently used resources file "
+			    "at `%s', but the parser failed: %s.",
+			    priv->filename,
+			    read_error->message);
+
+          g_bookmark_file_free (items);
+          items = g_bookmark_file_new ();
+
+          g_error_free (read_error);
+        }
     }
 
-  g_object_thaw_notify (G_OBJECT (manager));
+  if (priv->recent_items)
+    g_bookmark_file_free (priv->recent_items);
+
+  priv->recent_items = items;
+  priv->log_offset = 0;
 }
 
-/* timed poll()-ing of the recently used resources file.
- * an event-based system would be more efficient.
+/* brings the items list up to date with the recently used resources
+ * file and the log, keeping the changes we didn't write yet on top;
+ * the whole file is only parsed again when it was rewritten, or if
+ * @reload is set.  returns whether anything changed.
  */
 static gboolean
-gtk_recent_manager_poll_timeout (gpointer data)
+gtk_recent_manager_sync (GtkRecentManager *manager,
+			 gint              log_fd,
+			 gboolean          reload)
 {
-  GtkRecentManager *manager = GTK_RECENT_MANAGER (data);
   GtkRecentManagerPrivate *priv = manager->priv;
   struct stat stat_buf;
-  int stat_res;
+  gchar *data = NULL;
+  gsize length = 0, used;
+  gboolean changed;
 
-  /* wait for the next timeout if we have a read/write in progress */
-  if (priv->write_in_progress || priv->read_in_progress)
-    return TRUE;
+  g_assert (priv->filename != NULL);
+
+  priv->read_in_progress = TRUE;
 
-  stat_res = g_stat (priv->filename, &stat_buf);
-  if (stat_res < 0)
+  if (!priv->recent_items)
+    reload = TRUE;
+
+  if (log_fd >= 0 && !reload)
+    {
+      /* a shorter log has been folded into the file by someone else */
+      if (fstat (log_fd, &stat_buf) == 0 && stat_buf.st_size < priv->log_offset)
+        reload = TRUE;
+      else
+        data = read_log (log_fd, priv->log_offset, &length);
+    }
+
+  /* the log is truncated only after the file has been rewritten, so
+   * checking the file after reading the log catches a log that was
+   * truncated and appended to again in between.
+   */
+  if (!reload && g_stat (priv->filename, &stat_buf) == 0)
+    reload = (stat_buf.st_mtime != priv->last_mtime ||
+	      stat_buf.st_ino != priv->last_ino);
+
+  if (reload)
+    {
+      g_free (data);
+
+      load_items (manager);
+      data = log_fd >= 0 ? read_log (log_fd, 0, &length) : NULL;
+    }
+
+  changed = reload;
+
+  if (length > 0)
+    {
+      used = apply_log (manager, data, length);
+      priv->log_offset += used;
+
+      changed = changed || used > 0;
+    }
+
+  g_free (data);
+
+  if (changed && priv->pending->len > 0)
+    apply_log (manager, priv->pending->str, priv->pending->len);
+
+  priv->read_in_progress = FALSE;
+
+  return changed;
+}
+
+static gboolean
+gtk_recent_manager_read_changes (GtkRecentManager *manager,
+				 gboolean          reload)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  gint log_fd = -1;
+  gboolean changed;
+
+#ifdef G_OS_UNIX
+  if (priv->log_filename)
+    log_fd = g_open (priv->log_filename, O_RDONLY, 0);
+#endif
+
+  changed = gtk_recent_manager_sync (manager, log_fd, reload);
+
+  if (log_fd >= 0)
+    close (log_fd);
+
+  update_size (manager);
+  gtk_recent_manager_schedule_compact (manager);
+
+  return changed;
+}
+
+/* dumps the whole items list into the recently used resources file */
+static gboolean
+write_items (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  GError *write_error;
+  struct stat stat_buf;
+
+  write_error = NULL;
+  g_bookmark_file_to_file (priv->recent_items,
+			   priv->filename,
+			   &write_error);
+
+  if (write_error)
+    {
+      filename_warning ("Attempting to store changes into `%s', "
+			"but failed: %s",
+			priv->filename,
+			write_error->message);
+      g_error_free (write_error);
+
+      return FALSE;
+    }
+
+  /* we have sync'ed our list with the storage file, so we
+   * update the file mtime in order to skip the timed check
+   * and spare us from a re-read.
+   */
+  if (g_stat (priv->filename, &stat_buf) < 0)
     {
-      /* the file does not exist, yet, so we wait */
-      if (errno == ENOENT)
-        return TRUE;
-      
       filename_warning ("Unable to stat() the recently used resources file "
 			"at `%s': %s.",
 			priv->filename,
 			g_strerror (errno));
-      
-      return TRUE;
+
+      return FALSE;
     }
 
-  /* the file didn't change from the last poll(), so we bail out */
-  if (stat_buf.st_mtime == priv->last_mtime)
-    return TRUE;
+  priv->last_mtime = stat_buf.st_mtime;
+  priv->last_ino = stat_buf.st_ino;
 
-  /* the file has been changed, hence we emit the "changed" signal */
-  gtk_recent_manager_changed (manager);
+  return TRUE;
+}
+
+#ifdef G_OS_UNIX
+/* keeps other writers from appending while we fold the log into the
+ * file; the lock goes away when @log_fd is closed.
+ */
+static void
+lock_log (gint log_fd)
+{
+  struct flock lock;
+
+  lock.l_type = F_WRLCK;
+  lock.l_whence = SEEK_SET;
+  lock.l_start = 0;
+  lock.l_len = 0;
+
+  /* not every file system supports locks; we do without them there */
+  while (fcntl (log_fd, F_SETLKW, &lock) < 0 && errno == EINTR)
+    ;
+}
+
+static gboolean
+write_log (gint           log_fd,
+	   const GString *records)
+{
+  gssize res;
+  gsize pos = 0;
+
+  while (pos < records->len)
+    {
+      res = write (log_fd, records->str + pos, records->len - pos);
+      if (res < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          return FALSE;
+        }
+
+      pos += res;
+    }
 
   return TRUE;
 }
+#endif /* G_OS_UNIX */
 
 static void
-gtk_recent_manager_set_filename (GtkRecentManager *manager,
-				 const gchar      *filename)
+gtk_recent_manager_cancel_changed (GtkRecentManager *manager)
 {
-  GtkRecentManagerPrivate *priv;
-  
-  g_assert (GTK_IS_RECENT_MANAGER (manager));
-  priv = manager->priv;
-  
-  if (!filename || filename[0] == '\0')
-    return;
-  
-  g_free (manager->priv->filename);
+  GtkRecentManagerPrivate *priv = manager->priv;
 
-  if (manager->priv->poll_timeout)
+  if (priv->changed_timeout)
     {
-      g_source_remove (manager->priv->poll_timeout);
-      manager->priv->poll_timeout = 0;
+      g_source_remove (priv->changed_timeout);
+      priv->changed_timeout = 0;
     }
+}
 
-  priv->filename = g_strdup (filename);
-  priv->poll_timeout = g_timeout_add (POLL_DELTA,
-		  		      gtk_recent_manager_poll_timeout,
-				      manager);
+static gboolean
+gtk_recent_manager_compact_timeout (gpointer data)
+{
+  GtkRecentManager *recent_manager;
 
-  /* mark us clean, so that we can re-read the list
-   * of recently used resources
-   */
-  priv->is_dirty = FALSE;
-  build_recent_items_list (manager);
+  GDK_THREADS_ENTER ();
+
+  recent_manager = GTK_RECENT_MANAGER (data);
+  recent_manager->priv->compact_timeout = 0;
+
+  g_object_freeze_notify (G_OBJECT (recent_manager));
+
+  gtk_recent_manager_flush (recent_manager, TRUE);
+  update_size (recent_manager);
+
+  g_object_thaw_notify (G_OBJECT (recent_manager));
+
+  GDK_THREADS_LEAVE ();
+
+  return FALSE;
 }
 
-/* reads the recently used resources file and builds the items list.
- * we keep the items list inside the parser object, and build the
- * RecentInfo object only on user's demand to avoid useless replication.
- * this function resets the dirty bit of the manager.
+/* makes sure that a log which isn't empty is folded into the recently
+ * used resources file within COMPACT_DELAY milliseconds.
  */
 static void
-build_recent_items_list (GtkRecentManager *manager)
+gtk_recent_manager_schedule_compact (GtkRecentManager *manager)
 {
-  GtkRecentManagerPrivate *priv;
-  struct stat stat_buf;
-  int stat_res;
-  gboolean res;
-  GError *read_error;
-  gint size;
+  GtkRecentManagerPrivate *priv = manager->priv;
+
+  if (priv->log_offset > 0 && !priv->compact_timeout)
+    priv->compact_timeout = g_timeout_add (COMPACT_DELAY,
+					   gtk_recent_manager_compact_timeout,
+					   manager);
+  else if (priv->log_offset == 0 && priv->compact_timeout)
+    {
+      g_source_remove (priv->compact_timeout);
+      priv->compact_timeout = 0;
+    }
+}
+
+/* writes out the changes we made.  they are appended to the log, which
+ * is folded back into the recently used resources file, the one other
+ * programs read, if @compact is set or appending isn't possible.
+ */
+static void
+gtk_recent_manager_flush (GtkRecentManager *manager,
+			  gboolean          compact)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  gint log_fd = -1;
 
-  priv = manager->priv;
   g_assert (priv->filename != NULL);
-  
+
+  priv->write_in_progress = TRUE;
+
+  /* if no container object has been defined, we create a new
+   * empty container, and dump it
+   */
   if (!priv->recent_items)
     {
       priv->recent_items = g_bookmark_file_new ();
       priv->size = 0;
     }
 
-  stat_res = g_stat (priv->filename, &stat_buf);
-  if (stat_res < 0)
+#ifdef G_OS_UNIX
+  if (priv->log_filename)
+    log_fd = g_open (priv->log_filename, O_RDWR | O_APPEND | O_CREAT, 0600);
+
+  if (log_fd >= 0)
     {
-      /* the file doesn't exists, so we bail out and wait for the first
-       * write operation
+      struct stat stat_buf;
+
+      lock_log (log_fd);
+
+      /* records appended by others since we last looked come before
+       * ours in the log, so apply them before ours as well
        */
+      gtk_recent_manager_sync (manager, log_fd, FALSE);
 
-      if (errno == ENOENT)
-        return;
-      else
-        {
-          filename_warning ("Attempting to read the recently used resources file "
-			    "at `%s', but an error occurred: %s. Aborting.",
-			    priv->filename,
-			    g_strerror (errno));
+      /* anything we could not read is left over from a failed write */
+      if (fstat (log_fd, &stat_buf) < 0 ||
+	  stat_buf.st_size != priv->log_offset ||
+	  !g_file_test (priv->filename, G_FILE_TEST_EXISTS))
+        compact = TRUE;
+      else if (stat_buf.st_size == 0 && priv->pending->len == 0)
+        compact = FALSE;	/* someone else folded it already */
 
-          return;
+      if (!compact && priv->pending->len > 0)
+        {
+          if (write_log (log_fd, priv->pending))
+            priv->log_offset += priv->pending->len;
+          else
+            compact = TRUE;
         }
     }
+  else
+#endif
+    compact = TRUE;
 
-  /* record the last mtime, for later use */
-  priv->last_mtime = stat_buf.st_mtime;
-  
-  priv->read_in_progress = TRUE;
+  if (compact && write_items (manager) && log_fd >= 0)
+    {
+#ifdef G_OS_UNIX
+      if (ftruncate (log_fd, 0) == 0)
+        priv->log_offset = 0;
+#endif
+    }
 
-  /* the file exists, and it's valid (we hope); if not, destroy the container
-   * object and hope for a better result when the next "changed" signal is
-   * fired. */
-  read_error = NULL;
-  res = g_bookmark_file_load_from_file (priv->recent_items,
-		  			priv->filename,
-					&read_error);
-  if (read_error)
-    {
-      filename_warning ("Attempting to read the recently used resources file "
-			"at `%s', but the parser failed: %s.",
-			priv->filename,
-			read_error->message);
+  if (log_fd >= 0)
+    close (log_fd);
 
-      g_bookmark_file_free (priv->recent_items);
-      priv->recent_items = NULL;
+  g_string_truncate (priv->pending, 0);
+
+  priv->write_in_progress = FALSE;
+
+  gtk_recent_manager_schedule_compact (manager);
+}
+
+static void
+gtk_recent_manager_real_changed (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+
+  /* whoever emits the signal has told everyone about our changes */
+  gtk_recent_manager_cancel_changed (manager);
+
+  /* changes made by someone else have been read before emitting the
+   * signal, and ours are in the log already; we only have to fold the
+   * log into the file if it grew too large.
+   */
+  if (priv->is_dirty)
+    {
+      g_object_freeze_notify (G_OBJECT (manager));
+
+      if (priv->log_offset > LOG_COMPACT_SIZE)
+        gtk_recent_manager_flush (manager, TRUE);
+      update_size (manager);
+
+      g_object_thaw_notify (G_OBJECT (manager));
 
-      g_error_free (read_error);
+      /* mark us as clean */
+      priv->is_dirty = FALSE;
     }
+}
 
-  size = g_bookmark_file_get_size (priv->recent_items);
-  if (priv->size != size)
+/* checks whether the recently used resources file or its log were
+ * changed by someone else since we last read or wrote them.
+ */
+static void
+gtk_recent_manager_check_file (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+
+  /* wait for the next check if we have a read/write in progress */
+  if (priv->write_in_progress || priv->read_in_progress)
+    return;
+
+  if (gtk_recent_manager_read_changes (manager, FALSE))
+    g_signal_emit (manager, signal_changed, 0);
+}
+
+/* timed poll()-ing of the recently used resources file, used
+ * when the directory containing it cannot be monitored.
+ */
+static gboolean
+gtk_recent_manager_poll_timeout (gpointer data)
+{
+  gtk_recent_manager_check_file (GTK_RECENT_MANAGER (data));
+
+  return TRUE;
+}
+
+static gboolean
+is_basename_of (const gchar *basename,
+		const gchar *filename)
+{
+  gchar *file_basename;
+  gboolean retval;
+
+  if (!filename)
+    return FALSE;
+
+  file_basename = g_path_get_basename (filename);
+  retval = (strcmp (basename, file_basename) == 0);
+  g_free (file_basename);
+
+  return retval;
+}
+
+/* the file is replaced with a rename() on every save, so we watch
+ * the directory containing it rather than the file itself.
+ */
+static void
+gtk_recent_manager_monitor_changed (const gchar         *basename,
+				    GtkFileMonitorEvent  event,
+				    gpointer             data)
+{
+  GtkRecentManager *manager = GTK_RECENT_MANAGER (data);
+  GtkRecentManagerPrivate *priv = manager->priv;
+
+  if (event == GTK_FILE_MONITOR_EVENT_GONE)
     {
-      priv->size = size;
-      
-      g_object_notify (G_OBJECT (manager), "size");
+      /* the directory went away; fall back to polling */
+      gtk_recent_manager_stop_watch (manager);
+      priv->poll_timeout = g_timeout_add (POLL_DELTA,
+					  gtk_recent_manager_poll_timeout,
+					  manager);
+      return;
     }
 
-  priv->read_in_progress = FALSE;
-  priv->is_dirty = FALSE;
+  if (event == GTK_FILE_MONITOR_EVENT_DELETED)
+    return;
+
+  if (basename &&
+      !is_basename_of (basename, priv->filename) &&
+      !is_basename_of (basename, priv->log_filename))
+    return;
+
+  gtk_recent_manager_check_file (manager);
+}
+
+static void
+gtk_recent_manager_start_watch (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  gchar *dirname;
+
+  g_assert (priv->filename != NULL);
+
+  dirname = g_path_get_dirname (priv->filename);
+  priv->monitor_id = _gtk_file_monitor_add (dirname,
+					    gtk_recent_manager_monitor_changed,
+					    manager);
+  g_free (dirname);
+
+  if (!priv->monitor_id)
+    priv->poll_timeout = g_timeout_add (POLL_DELTA,
+					gtk_recent_manager_poll_timeout,
+					manager);
+}
+
+static void
+gtk_recent_manager_stop_watch (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+
+  if (priv->monitor_id)
+    {
+      _gtk_file_monitor_remove (priv->monitor_id);
+      priv->monitor_id = 0;
+    }
+
+  if (priv->poll_timeout)
+    {
+      g_source_remove (priv->poll_timeout);
+      priv->poll_timeout = 0;
+    }
+}
+
+static void
+gtk_recent_manager_set_filename (GtkRecentManager *manager,
+				 const gchar      *filename)
+{
+  GtkRecentManagerPrivate *priv;
+  
+  g_assert (GTK_IS_RECENT_MANAGER (manager));
+  priv = manager->priv;
+  
+  if (!filename || filename[0] == '\0')
+    return;
+
+  /* the log of the new file gets its own compaction timeout */
+  if (priv->compact_timeout)
+    {
+      g_source_remove (priv->compact_timeout);
+      priv->compact_timeout = 0;
+    }
+  
+  g_free (manager->priv->filename);
+
+  gtk_recent_manager_stop_watch (manager);
+
+  priv->filename = g_strdup (filename);
+
+#ifdef G_OS_UNIX
+  g_free (priv->log_filename);
+  priv->log_filename = g_strconcat (priv->filename,
+				    GTK_RECENTLY_USED_LOG_SUFFIX,
+				    NULL);
+#endif
+
+  gtk_recent_manager_start_watch (manager);
+
+  build_recent_items_list (manager);
+}
+
+/* reads the recently used resources file and its log from scratch,
+ * and builds the items list.
+ */
+static void
+build_recent_items_list (GtkRecentManager *manager)
+{
+  gtk_recent_manager_read_changes (manager, TRUE);
 }
 
 
@@ -855,9 +1488,11 @@ gtk_recent_manager_add_item (GtkRecentManager  *manager,
       filename = g_filename_from_uri (uri, NULL, NULL);
       if (filename)
         {
+          G_LOCK (_gtk_xdgmime);
           mime_type = xdg_mime_get_mime_type_for_file (filename, NULL);
           if (mime_type && *mime_type)
             recent_data.mime_type = g_strdup (mime_type);
+          G_UNLOCK (_gtk_xdgmime);
 
           g_free (filename);
         }
@@ -920,6 +1555,9 @@ gtk_recent_manager_add_full (GtkRecentManager     *manager,
 			     const GtkRecentData  *data)
 {
   GtkRecentManagerPrivate *priv;
+  GKeyFile *record;
+  guint count;
+  time_t stamp;
   
   g_return_val_if_fail (GTK_IS_RECENT_MANAGER (manager), FALSE);
   g_return_val_if_fail (uri != NULL, FALSE);
@@ -1007,11 +1645,43 @@ gtk_recent_manager_add_full (GtkRecentManager     *manager,
   
   g_bookmark_file_set_is_private (priv->recent_items, uri,
 		  		  data->is_private);
-  
-  /* mark us as dirty, so that when emitting the "changed" signal we
-   * will dump our changes
+
+  /* log the resulting state of the item, so that replaying the
+   * record doesn't register the application once more
    */
-  priv->is_dirty = TRUE;
+  record = log_record_new ("add", uri);
+
+  if (data->display_name)
+    g_key_file_set_string (record, LOG_GROUP, "Name", data->display_name);
+
+  if (data->description)
+    g_key_file_set_string (record, LOG_GROUP, "Description", data->description);
+
+  g_key_file_set_string (record, LOG_GROUP, "MimeType", data->mime_type);
+
+  if (data->groups && data->groups[0] != NULL)
+    g_key_file_set_string_list (record, LOG_GROUP, "Groups",
+				(const gchar * const *) data->groups,
+				g_strv_length (data->groups));
+
+  count = 1;
+  stamp = (time_t) -1;
+  g_bookmark_file_get_app_info (priv->recent_items, uri, data->app_name,
+				NULL, &count, &stamp, NULL);
+
+  g_key_file_set_string (record, LOG_GROUP, "Application", data->app_name);
+  g_key_file_set_string (record, LOG_GROUP, "Exec", data->app_exec);
+  g_key_file_set_integer (record, LOG_GROUP, "Count", count);
+  log_record_set_time (record, "Stamp", stamp);
+  g_key_file_set_boolean (record, LOG_GROUP, "Private", data->is_private);
+  log_record_set_time (record, "Added",
+		       g_bookmark_file_get_added (priv->recent_items, uri, NULL));
+  log_record_set_time (record, "Visited",
+		       g_bookmark_file_get_visited (priv->recent_items, uri, NULL));
+  log_record_set_time (record, "Modified",
+		       g_bookmark_file_get_modified (priv->recent_items, uri, NULL));
+
+  gtk_recent_manager_add_record (manager, record);
   
   gtk_recent_manager_changed (manager);
   
@@ -1067,7 +1737,7 @@ gtk_recent_manager_remove_item (GtkRecentManager  *manager,
       return FALSE;
     }
 
-  priv->is_dirty = TRUE;
+  gtk_recent_manager_add_record (manager, log_record_new ("remove", uri));
 
   gtk_recent_manager_changed (manager);
   
@@ -1260,6 +1930,7 @@ gtk_recent_manager_move_item (GtkRecentManager  *recent_manager,
 {
   GtkRecentManagerPrivate *priv;
   GError *move_error;
+  GKeyFile *record;
   gboolean res;
   
   g_return_val_if_fail (GTK_IS_RECENT_MANAGER (recent_manager), FALSE);
@@ -1286,8 +1957,12 @@ gtk_recent_manager_move_item (GtkRecentManager  *recent_manager,
       g_propagate_error (error, move_error);
       return FALSE;
     }
-  
-  priv->is_dirty = TRUE;
+
+  record = log_record_new ("move", uri);
+  if (new_uri && new_uri[0] != '\0')
+    g_key_file_set_string (record, LOG_GROUP, "NewURI", new_uri);
+
+  gtk_recent_manager_add_record (recent_manager, record);
 
   gtk_recent_manager_changed (recent_manager);
   
@@ -1381,7 +2056,8 @@ purge_recent_items_list (GtkRecentManager  *manager,
       
   priv->recent_items = g_bookmark_file_new ();
   priv->size = 0;
-  priv->is_dirty = TRUE;
+
+  gtk_recent_manager_add_record (manager, log_record_new ("clear", NULL));
       
   /* emit the changed signal, to ensure that the purge is written */
   gtk_recent_manager_changed (manager);
@@ -1423,10 +2099,43 @@ gtk_recent_manager_purge_items (GtkRecentManager  *manager,
   return purged;
 }
 
+static gboolean
+gtk_recent_manager_changed_timeout (gpointer data)
+{
+  GtkRecentManager *recent_manager;
+
+  GDK_THREADS_ENTER ();
+
+  recent_manager = GTK_RECENT_MANAGER (data);
+  recent_manager->priv->changed_timeout = 0;
+
+  g_signal_emit (recent_manager, signal_changed, 0);
+
+  GDK_THREADS_LEAVE ();
+
+  return FALSE;
+}
+
+/* emits the "changed" signal CHANGED_DELAY milliseconds after the first
+ * of our changes; adding a batch of items then notifies the views, and
+ * checks the size of the log, only once.
+ */
 static void
 gtk_recent_manager_changed (GtkRecentManager *recent_manager)
 {
-  g_signal_emit (recent_manager, signal_changed, 0);
+  GtkRecentManagerPrivate *priv = recent_manager->priv;
+
+  /* without a main loop the timeout would never run */
+  if (gtk_main_level () == 0)
+    {
+      g_signal_emit (recent_manager, signal_changed, 0);
+      return;
+    }
+
+  if (!priv->changed_timeout)
+    priv->changed_timeout = g_timeout_add (CHANGED_DELAY,
+					   gtk_recent_manager_changed_timeout,
+					   recent_manager);
 }
 
 /*****************
@@ -56,6 +56,9 @@ struct _GtkTextBufferPrivate
   GtkTargetList  *paste_target_list;
   GtkTargetEntry *paste_target_entries;
   gint            n_paste_target_entries;
+
+  /* Lines kept by gtk_text_buffer_append_lines(), 0 for no limit */
+  gint            max_lines;
 };
 
 
@@ -97,7 +100,8 @@ enum {
   PROP_HAS_SELECTION,
   PROP_CURSOR_POSITION,
   PROP_COPY_TARGET_LIST,
-  PROP_PASTE_TARGET_LIST
+  PROP_PASTE_TARGET_LIST,
+  PROP_MAX_LINES
 };
 
 static void gtk_text_buffer_finalize   (GObject            *object);
@@ -262,6 +266,23 @@ gtk_text_buffer_class_init (GtkTextBufferClass *klass)
                                                        GTK_TYPE_TARGET_LIST,
                                                        GTK_PARAM_READABLE));
 
+  /**
+   * GtkTextBuffer:max-lines:
+   *
+   * The maximum number of lines the buffer keeps when text is added
+   * with gtk_text_buffer_append_lines(), or 0 for no limit. See
+   * gtk_text_buffer_set_max_lines().
+   *
+   * Since: 2.12
+   */
+  g_object_class_install_property (object_class,
+                                   PROP_MAX_LINES,
+                                   g_param_spec_int ("max-lines",
+                                                     P_("Maximum lines"),
+                                                     P_("The maximum number of lines kept when appending lines, or 0 for no limit"),
+                                                     0, G_MAXINT, 0,
+                                                     GTK_PARAM_READWRITE));
+
   /**
    * GtkTextBuffer::insert-text:
    * @textbuffer: the object which received the signal
@@ -643,6 +664,10 @@ gtk_text_buffer_set_property (GObject         *object,
 				g_value_get_string (value), -1);
       break;
 
+    case PROP_MAX_LINES:
+      gtk_text_buffer_set_max_lines (text_buffer, g_value_get_int (value));
+      break;
+
     default:
       break;
     }
@@ -696,6 +721,10 @@ gtk_text_buffer_get_property (GObject         *object,
       g_value_set_boxed (value, gtk_text_buffer_get_paste_target_list (text_buffer));
       break;
 
+    case PROP_MAX_LINES:
+      g_value_set_int (value, gtk_text_buffer_get_max_lines (text_buffer));
+      break;
+
     default:
       break;
     }
@@ -931,6 +960,150 @@ gtk_text_buffer_insert_at_cursor (GtkTextBuffer *buffer,
   gtk_text_buffer_insert (buffer, &iter, text, len);
 }
 
+/* Deletes lines from the start of the buffer until it holds
+ * no more than max_lines lines.
+ */
+static void
+gtk_text_buffer_trim_lines (GtkTextBuffer *buffer)
+{
+  GtkTextBufferPrivate *priv;
+  GtkTextIter start, end;
+  gint n_lines;
+
+  priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
+
+  if (priv->max_lines == 0)
+    return;
+
+  n_lines = gtk_text_buffer_get_line_count (buffer);
+  if (n_lines <= priv->max_lines)
+    return;
+
+  gtk_text_buffer_get_start_iter (buffer, &start);
+  gtk_text_buffer_get_iter_at_line (buffer, &end, n_lines - priv->max_lines);
+
+  gtk_text_buffer_delete (buffer, &start, &end);
+}
+
+/**
+ * gtk_text_buffer_append_lines:
+ * @buffer: a #GtkTextBuffer
+ * @lines: an array of UTF-8 strings
+ * @n_lines: the number of strings in @lines, or -1 if @lines
+ *   is %NULL-terminated
+ *
+ * Appends each string in @lines, followed by a newline, to the end
+ * of @buffer. All lines are added with a single emission of the
+ * "insert_text" signal, which is a lot cheaper than inserting them
+ * one by one when a buffer is used to display a stream of log
+ * messages or similar output.
+ *
+ * If a maximum line count has been set with
+ * gtk_text_buffer_set_max_lines(), lines are removed from the
+ * start of the buffer afterwards until it is no longer exceeded.
+ *
+ * Since: 2.12
+ **/
+void
+gtk_text_buffer_append_lines (GtkTextBuffer       *buffer,
+                              const gchar * const *lines,
+                              gint                 n_lines)
+{
+  GtkTextBufferPrivate *priv;
+  GtkTextIter iter;
+  GString *text;
+  gint i;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (lines != NULL || n_lines == 0);
+
+  priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
+
+  if (n_lines < 0)
+    for (n_lines = 0; lines[n_lines] != NULL; n_lines++)
+      ;
+
+  if (n_lines == 0)
+    return;
+
+  /* Lines that would be trimmed right away aren't worth inserting */
+  if (priv->max_lines > 0 && n_lines >= priv->max_lines)
+    {
+      lines += n_lines - priv->max_lines + 1;
+      n_lines = priv->max_lines - 1;
+    }
+
+  text = g_string_new (NULL);
+  for (i = 0; i < n_lines; i++)
+    {
+      g_string_append (text, lines[i]);
+      g_string_append_c (text, '\n');
+    }
+
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  gtk_text_buffer_emit_insert (buffer, &iter, text->str, text->len);
+
+  g_string_free (text, TRUE);
+
+  gtk_text_buffer_trim_lines (buffer);
+}
+
+/**
+ * gtk_text_buffer_set_max_lines:
+ * @buffer: a #GtkTextBuffer
+ * @max_lines: the maximum number of lines, or 0 for no limit
+ *
+ * Turns @buffer into a ring buffer of at most @max_lines lines, as
+ * counted by gtk_text_buffer_get_line_count(). Whenever
+ * gtk_text_buffer_append_lines() makes the buffer longer than that,
+ * the oldest lines are deleted from its start. Other insertion
+ * functions don't trim the buffer, since callers may rely on the
+ * offsets of existing text staying the same.
+ *
+ * If the buffer already has more than @max_lines lines, it is
+ * trimmed right away.
+ *
+ * Since: 2.12
+ **/
+void
+gtk_text_buffer_set_max_lines (GtkTextBuffer *buffer,
+                               gint           max_lines)
+{
+  GtkTextBufferPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (max_lines >= 0);
+
+  priv = GTK_TEXT_BUFFER_GET_PRIVATE (buffer);
+
+  if (priv->max_lines == max_lines)
+    return;
+
+  priv->max_lines = max_lines;
+  gtk_text_buffer_trim_lines (buffer);
+
+  g_object_notify (G_OBJECT (buffer), "max-lines");
+}
+
+/**
+ * gtk_text_buffer_get_max_lines:
+ * @buffer: a #GtkTextBuffer
+ *
+ * Gets the maximum number of lines set with
+ * gtk_text_buffer_set_max_lines().
+ *
+ * Return value: the maximum number of lines, or 0 if there is no limit
+ *
+ * Since: 2.12
+ **/
+gint
+gtk_text_buffer_get_max_lines (GtkTextBuffer *buffer)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), 0);
+
+  return GTK_TEXT_BUFFER_GET_PRIVATE (buffer)->max_lines;
+}
+
 /**
  * gtk_text_buffer_insert_interactive:
  * @buffer: a #GtkTextBuffer
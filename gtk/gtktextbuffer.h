@@ -174,6 +174,13 @@ void gtk_text_buffer_insert_at_cursor  (GtkTextBuffer *buffer,
                                         const gchar   *text,
                                         gint           len);
 
+void gtk_text_buffer_append_lines      (GtkTextBuffer       *buffer,
+                                        const gchar * const *lines,
+                                        gint                 n_lines);
+void gtk_text_buffer_set_max_lines     (GtkTextBuffer *buffer,
+                                        gint           max_lines);
+gint gtk_text_buffer_get_max_lines     (GtkTextBuffer *buffer);
+
 gboolean gtk_text_buffer_insert_interactive           (GtkTextBuffer *buffer,
                                                        GtkTextIter   *iter,
                                                        const gchar   *text,
@@ -4453,11 +4453,50 @@ forward_chars_with_skipping (GtkTextIter *iter,
     }
 }
 
+/* Appends @len bytes of @str to @dest, with every character mapped to
+ * lower case. Each character maps to exactly one character, so that
+ * character offsets into the folded text are valid for the original.
+ */
+static void
+string_append_folded (GString     *dest,
+                      const gchar *str,
+                      gint         len)
+{
+  const gchar *end = str + len;
+
+  while (str < end)
+    {
+      if ((guchar) *str < 0x80)
+        {
+          g_string_append_c (dest, g_ascii_tolower (*str));
+          str++;
+        }
+      else
+        {
+          g_string_append_unichar (dest, g_unichar_tolower (g_utf8_get_char (str)));
+          str = g_utf8_next_char (str);
+        }
+    }
+}
+
+static gchar *
+utf8_fold (gchar *str)
+{
+  GString *folded;
+
+  folded = g_string_sized_new (strlen (str));
+  string_append_folded (folded, str, strlen (str));
+  g_free (str);
+
+  return g_string_free (folded, FALSE);
+}
+
 static gboolean
 lines_match (const GtkTextIter *start,
              const gchar **lines,
              gboolean visible_only,
              gboolean slice,
+             gboolean case_insensitive,
              GtkTextIter *match_start,
              GtkTextIter *match_end)
 {
@@ -4500,6 +4539,9 @@ lines_match (const GtkTextIter *start,
         line_text = gtk_text_iter_get_text (start, &next);
     }
 
+  if (case_insensitive)
+    line_text = utf8_fold (line_text);
+
   if (match_start) /* if this is the first line we're matching */
     found = strstr (line_text, *lines);
   else
@@ -4551,7 +4593,8 @@ lines_match (const GtkTextIter *start,
   /* pass NULL for match_start, since we don't need to find the
    * start again.
    */
-  return lines_match (&next, lines, visible_only, slice, NULL, match_end);
+  return lines_match (&next, lines, visible_only, slice, case_insensitive,
+                      NULL, match_end);
 }
 
 /* strsplit () that retains the delimiter as part of the string. */
@@ -4610,6 +4653,372 @@ strbreakup (const char *string,
   return str_array;
 }
 
+/* State for searching a single-line needle in the character
+ * segments of the buffer with the Boyer-Moore-Horspool algorithm,
+ * without copying lines that are made of a single segment.
+ */
+typedef struct _SearchPattern SearchPattern;
+
+struct _SearchPattern
+{
+  const gchar *needle;
+  gint needle_len;
+  gint skip[256];         /* shift for the byte under the last needle byte */
+  gint rskip[256];        /* shift for the byte under the first needle byte */
+  gboolean case_insensitive;
+  GString *line_text;     /* lines spread over several segments */
+  GString *folded_text;
+};
+
+static void
+search_pattern_init (SearchPattern *pattern,
+                     const gchar   *needle,
+                     gboolean       case_insensitive)
+{
+  const guchar *n = (const guchar *) needle;
+  gint m, i;
+
+  m = strlen (needle);
+
+  pattern->needle = needle;
+  pattern->needle_len = m;
+  pattern->case_insensitive = case_insensitive;
+
+  for (i = 0; i < 256; i++)
+    {
+      pattern->skip[i] = m;
+      pattern->rskip[i] = m;
+    }
+
+  for (i = 0; i < m - 1; i++)
+    pattern->skip[n[i]] = m - 1 - i;
+
+  for (i = m - 1; i > 0; i--)
+    pattern->rskip[n[i]] = i;
+
+  pattern->line_text = g_string_new (NULL);
+  pattern->folded_text = case_insensitive ? g_string_new (NULL) : NULL;
+}
+
+static void
+search_pattern_free (SearchPattern *pattern)
+{
+  g_string_free (pattern->line_text, TRUE);
+  if (pattern->folded_text)
+    g_string_free (pattern->folded_text, TRUE);
+}
+
+/* Returns the byte offset of the first match at or after @from, or -1 */
+static gint
+search_pattern_find (SearchPattern *pattern,
+                     const gchar   *text,
+                     gint           len,
+                     gint           from)
+{
+  const guchar *t = (const guchar *) text;
+  const guchar *n = (const guchar *) pattern->needle;
+  gint m = pattern->needle_len;
+  gint pos = from;
+
+  while (pos + m <= len)
+    {
+      guchar last = t[pos + m - 1];
+
+      if (last == n[m - 1] &&
+          memcmp (t + pos, n, m - 1) == 0)
+        return pos;
+
+      pos += pattern->skip[last];
+    }
+
+  return -1;
+}
+
+/* Returns the byte offset of the last match that ends at or before
+ * @before, or -1
+ */
+static gint
+search_pattern_rfind (SearchPattern *pattern,
+                      const gchar   *text,
+                      gint           before)
+{
+  const guchar *t = (const guchar *) text;
+  const guchar *n = (const guchar *) pattern->needle;
+  gint m = pattern->needle_len;
+  gint pos = before - m;
+
+  while (pos >= 0)
+    {
+      guchar first = t[pos];
+
+      if (first == n[0] &&
+          memcmp (t + pos + 1, n + 1, m - 1) == 0)
+        return pos;
+
+      pos -= pattern->rskip[first];
+    }
+
+  return -1;
+}
+
+/* Returns the text of @line as it appears in a slice, i.e. with
+ * 0xFFFC for pixbufs and child widgets. Lines that consist of a single
+ * character segment are returned without copying.
+ */
+static const gchar *
+search_pattern_get_line (SearchPattern *pattern,
+                         GtkTextLine   *line,
+                         gint          *len)
+{
+  GtkTextLineSegment *seg;
+  GtkTextLineSegment *indexable = NULL;
+  gint n_indexable = 0;
+  const gchar *text;
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->byte_count > 0)
+        {
+          indexable = seg;
+          n_indexable++;
+        }
+    }
+
+  if (n_indexable == 1 && indexable->type == &gtk_text_char_type)
+    {
+      text = indexable->body.chars;
+      *len = indexable->byte_count;
+    }
+  else
+    {
+      g_string_truncate (pattern->line_text, 0);
+
+      for (seg = line->segments; seg != NULL; seg = seg->next)
+        {
+          if (seg->type == &gtk_text_char_type)
+            g_string_append_len (pattern->line_text,
+                                 seg->body.chars, seg->byte_count);
+          else if (seg->byte_count > 0)
+            g_string_append (pattern->line_text, "\357\277\274");
+        }
+
+      text = pattern->line_text->str;
+      *len = pattern->line_text->len;
+    }
+
+  if (pattern->case_insensitive)
+    {
+      g_string_truncate (pattern->folded_text, 0);
+      string_append_folded (pattern->folded_text, text, *len);
+
+      text = pattern->folded_text->str;
+      *len = pattern->folded_text->len;
+    }
+
+  return text;
+}
+
+/* Converts a position in @text as returned by search_pattern_get_line()
+ * into an iterator.
+ */
+static void
+search_pattern_get_iter (SearchPattern *pattern,
+                         GtkTextBTree  *tree,
+                         GtkTextLine   *line,
+                         const gchar   *text,
+                         gint           len,
+                         gint           pos,
+                         GtkTextIter   *iter)
+{
+  if (pos >= len)
+    {
+      line = _gtk_text_line_next_excluding_last (line);
+
+      if (line)
+        _gtk_text_btree_get_iter_at_line (tree, iter, line, 0);
+      else
+        _gtk_text_btree_get_end_iter (tree, iter);
+    }
+  else if (pattern->case_insensitive)
+    {
+      _gtk_text_btree_get_iter_at_line (tree, iter, line, 0);
+      gtk_text_iter_set_line_offset (iter, g_utf8_strlen (text, pos));
+    }
+  else
+    _gtk_text_btree_get_iter_at_line (tree, iter, line, pos);
+}
+
+/* Converts the position of @iter on its line into a byte offset
+ * into @text as returned by search_pattern_get_line().
+ */
+static gint
+search_pattern_get_pos (SearchPattern     *pattern,
+                        const GtkTextIter *iter,
+                        const gchar       *text)
+{
+  if (pattern->case_insensitive)
+    return g_utf8_offset_to_pointer (text, gtk_text_iter_get_line_offset (iter)) - text;
+  else
+    return gtk_text_iter_get_line_index (iter);
+}
+
+/* Forward search for searches that match exact slices. Only the
+ * first line of the needle is searched for with @pattern; the
+ * others are checked with lines_match() where it was found.
+ */
+static gboolean
+forward_search_fast (const GtkTextIter *iter,
+                     const gchar      **lines,
+                     SearchPattern     *pattern,
+                     GtkTextIter       *match_start,
+                     GtkTextIter       *match_end,
+                     const GtkTextIter *limit)
+{
+  GtkTextBTree *tree;
+  GtkTextLine *line;
+  gint line_num, first_line_num;
+  gint limit_line_num = 0;
+  gboolean limit_at_line_start = FALSE;
+
+  tree = _gtk_text_iter_get_btree (iter);
+  line = _gtk_text_iter_get_text_line (iter);
+  line_num = first_line_num = gtk_text_iter_get_line (iter);
+
+  if (limit)
+    {
+      limit_line_num = gtk_text_iter_get_line (limit);
+      limit_at_line_start = gtk_text_iter_starts_line (limit);
+    }
+
+  while (line != NULL)
+    {
+      const gchar *text;
+      gint len, from, pos;
+
+      if (limit && line_num != first_line_num &&
+          (line_num > limit_line_num ||
+           (line_num == limit_line_num && limit_at_line_start)))
+        break;
+
+      text = search_pattern_get_line (pattern, line, &len);
+      from = line_num == first_line_num ? search_pattern_get_pos (pattern, iter, text) : 0;
+
+      pos = search_pattern_find (pattern, text, len, from);
+      if (pos >= 0)
+        {
+          GtkTextIter start, end;
+          gboolean found = TRUE;
+
+          search_pattern_get_iter (pattern, tree, line, text, len, pos, &start);
+          search_pattern_get_iter (pattern, tree, line, text, len,
+                                   pos + pattern->needle_len, &end);
+
+          /* The first line of a multi-line needle ends in '\n', so
+           * it only matched at the end of this line.
+           */
+          if (lines[1] != NULL)
+            found = lines_match (&end, lines + 1, FALSE, TRUE,
+                                 pattern->case_insensitive, NULL, &end);
+
+          if (found)
+            {
+              if (limit && gtk_text_iter_compare (&end, limit) > 0)
+                return FALSE;
+
+              if (match_start)
+                *match_start = start;
+              if (match_end)
+                *match_end = end;
+
+              return TRUE;
+            }
+        }
+
+      line = _gtk_text_line_next_excluding_last (line);
+      line_num++;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+forward_search_slow (const GtkTextIter *iter,
+                     const gchar      **lines,
+                     gboolean           visible_only,
+                     gboolean           slice,
+                     gboolean           case_insensitive,
+                     GtkTextIter       *match_start,
+                     GtkTextIter       *match_end,
+                     const GtkTextIter *limit)
+{
+  GtkTextIter match;
+  GtkTextIter search;
+  gboolean retval = FALSE;
+
+  search = *iter;
+
+  do
+    {
+      /* This loop has an inefficient worst-case, where
+       * gtk_text_iter_get_text () is called repeatedly on
+       * a single line.
+       */
+      GtkTextIter end;
+
+      if (limit &&
+          gtk_text_iter_compare (&search, limit) >= 0)
+        break;
+      
+      if (lines_match (&search, lines,
+                       visible_only, slice, case_insensitive, &match, &end))
+        {
+          if (limit == NULL ||
+              (limit &&
+               gtk_text_iter_compare (&end, limit) <= 0))
+            {
+              retval = TRUE;
+              
+              if (match_start)
+                *match_start = match;
+              
+              if (match_end)
+                *match_end = end;
+            }
+          
+          break;
+        }
+    }
+  while (gtk_text_iter_forward_line (&search));
+
+  return retval;
+}
+
+/* Splits @str into lines for searching, case folded if needed */
+static gchar **
+search_lines_new (const gchar        *str,
+                  GtkTextSearchFlags  flags)
+{
+  gchar **lines;
+
+  if (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE)
+    {
+      gchar *folded = utf8_fold (g_strdup (str));
+
+      lines = strbreakup (folded, "\n", -1);
+      g_free (folded);
+    }
+  else
+    lines = strbreakup (str, "\n", -1);
+
+  return lines;
+}
+
+/* Whether the needle can be searched for in the character segments
+ * directly, rather than in text extracted from the buffer.
+ */
+#define SEARCH_IS_FAST(flags) \
+  (((flags) & (GTK_TEXT_SEARCH_VISIBLE_ONLY | GTK_TEXT_SEARCH_TEXT_ONLY)) == 0)
+
 /**
  * gtk_text_iter_forward_search:
  * @iter: start of search
@@ -4633,6 +5042,12 @@ strbreakup (const char *string,
  * pixbufs or child widgets mixed inside the matched range. If these
  * flags are not given, the match must be exact; the special 0xFFFC
  * character in @str will match embedded pixbufs or child widgets.
+ * If #GTK_TEXT_SEARCH_CASE_INSENSITIVE is given, characters are
+ * compared after converting them to lower case.
+ *
+ * Searches without #GTK_TEXT_SEARCH_VISIBLE_ONLY and
+ * #GTK_TEXT_SEARCH_TEXT_ONLY are considerably faster, since they
+ * don't need to extract the text of each line from the buffer.
  *
  * Return value: whether a match was found
  **/
@@ -4646,10 +5061,10 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
 {
   gchar **lines = NULL;
   GtkTextIter match;
-  gboolean retval = FALSE;
-  GtkTextIter search;
+  gboolean retval;
   gboolean visible_only;
   gboolean slice;
+  gboolean case_insensitive;
   
   g_return_val_if_fail (iter != NULL, FALSE);
   g_return_val_if_fail (str != NULL, FALSE);
@@ -4681,49 +5096,121 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
 
   visible_only = (flags & GTK_TEXT_SEARCH_VISIBLE_ONLY) != 0;
   slice = (flags & GTK_TEXT_SEARCH_TEXT_ONLY) == 0;
+  case_insensitive = (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE) != 0;
   
   /* locate all lines */
 
-  lines = strbreakup (str, "\n", -1);
+  lines = search_lines_new (str, flags);
+
+  if (SEARCH_IS_FAST (flags))
+    {
+      SearchPattern pattern;
+
+      search_pattern_init (&pattern, lines[0], case_insensitive);
+      retval = forward_search_fast (iter, (const gchar **)lines, &pattern,
+                                    match_start, match_end, limit);
+      search_pattern_free (&pattern);
+    }
+  else
+    retval = forward_search_slow (iter, (const gchar **)lines,
+                                  visible_only, slice, case_insensitive,
+                                  match_start, match_end, limit);
+
+  g_strfreev (lines);
+
+  return retval;
+}
+
+/**
+ * gtk_text_iter_forward_search_all:
+ * @iter: start of search
+ * @str: a search string, which must not be empty
+ * @flags: flags affecting how the search is done
+ * @limit: bound for the search, or %NULL for the end of the buffer
+ * @func: function to call for each match
+ * @user_data: data to pass to @func
+ *
+ * Finds all non-overlapping matches of @str between @iter and
+ * @limit, as gtk_text_iter_forward_search() would find them one
+ * after the other, and calls @func for each of them in order. This is
+ * faster than repeated calls to gtk_text_iter_forward_search(),
+ * e.g. for highlighting all occurrences of a search string.
+ *
+ * @func is only called once all matches have been found. It may
+ * apply or remove tags, but must not change the text of the buffer.
+ *
+ * Return value: the number of matches
+ *
+ * Since: 2.12
+ **/
+gint
+gtk_text_iter_forward_search_all (const GtkTextIter  *iter,
+                                  const gchar        *str,
+                                  GtkTextSearchFlags  flags,
+                                  const GtkTextIter  *limit,
+                                  GtkTextSearchFunc   func,
+                                  gpointer            user_data)
+{
+  gchar **lines;
+  GArray *matches;
+  GtkTextIter search, match_start, match_end;
+  SearchPattern pattern;
+  gboolean visible_only;
+  gboolean slice;
+  gboolean case_insensitive;
+  gint n_matches, i;
+
+  g_return_val_if_fail (iter != NULL, 0);
+  g_return_val_if_fail (str != NULL && *str != '\0', 0);
+  g_return_val_if_fail (func != NULL, 0);
+
+  visible_only = (flags & GTK_TEXT_SEARCH_VISIBLE_ONLY) != 0;
+  slice = (flags & GTK_TEXT_SEARCH_TEXT_ONLY) == 0;
+  case_insensitive = (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE) != 0;
 
+  lines = search_lines_new (str, flags);
+
+  if (SEARCH_IS_FAST (flags))
+    search_pattern_init (&pattern, lines[0], case_insensitive);
+
+  matches = g_array_new (FALSE, FALSE, sizeof (GtkTextIter));
   search = *iter;
 
-  do
+  while (limit == NULL || gtk_text_iter_compare (&search, limit) < 0)
     {
-      /* This loop has an inefficient worst-case, where
-       * gtk_text_iter_get_text () is called repeatedly on
-       * a single line.
-       */
-      GtkTextIter end;
+      gboolean found;
 
-      if (limit &&
-          gtk_text_iter_compare (&search, limit) >= 0)
+      if (SEARCH_IS_FAST (flags))
+        found = forward_search_fast (&search, (const gchar **)lines, &pattern,
+                                     &match_start, &match_end, limit);
+      else
+        found = forward_search_slow (&search, (const gchar **)lines,
+                                     visible_only, slice, case_insensitive,
+                                     &match_start, &match_end, limit);
+
+      if (!found)
         break;
-      
-      if (lines_match (&search, (const gchar**)lines,
-                       visible_only, slice, &match, &end))
-        {
-          if (limit == NULL ||
-              (limit &&
-               gtk_text_iter_compare (&end, limit) <= 0))
-            {
-              retval = TRUE;
-              
-              if (match_start)
-                *match_start = match;
-              
-              if (match_end)
-                *match_end = end;
-            }
-          
-          break;
-        }
+
+      g_array_append_val (matches, match_start);
+      g_array_append_val (matches, match_end);
+
+      search = match_end;
     }
-  while (gtk_text_iter_forward_line (&search));
 
-  g_strfreev ((gchar**)lines);
+  if (SEARCH_IS_FAST (flags))
+    search_pattern_free (&pattern);
+  g_strfreev (lines);
 
-  return retval;
+  /* Tagging the matches doesn't invalidate the other iterators */
+  n_matches = matches->len / 2;
+  for (i = 0; i < n_matches; i++)
+    (* func) (&g_array_index (matches, GtkTextIter, 2 * i),
+              &g_array_index (matches, GtkTextIter, 2 * i + 1),
+              user_data);
+
+  g_array_free (matches, TRUE);
+
+  return n_matches;
 }
 
 static gboolean
@@ -4784,6 +5271,7 @@ struct _LinesWindow
   GtkTextIter first_line_end;
   gboolean slice;
   gboolean visible_only;
+  gboolean case_insensitive;
 };
 
 static void
@@ -4843,6 +5331,9 @@ lines_window_init (LinesWindow       *win,
             line_text = gtk_text_iter_get_text (&line_start, &line_end);
         }
 
+      if (win->case_insensitive)
+        line_text = utf8_fold (line_text);
+
       win->lines[i] = line_text;
 
       line_end = line_start;
@@ -4889,6 +5380,9 @@ lines_window_back (LinesWindow *win)
                                             &win->first_line_end);
     }
 
+  if (win->case_insensitive)
+    line_text = utf8_fold (line_text);
+
   /* Move lines to make room for first line. */
   g_memmove (win->lines + 1, win->lines, win->n_lines * sizeof (gchar*));
 
@@ -4907,6 +5401,79 @@ lines_window_free (LinesWindow *win)
   g_strfreev (win->lines);
 }
 
+/* Backward search for single-line needles that match exact slices */
+static gboolean
+backward_search_fast (const GtkTextIter *iter,
+                      SearchPattern     *pattern,
+                      GtkTextIter       *match_start,
+                      GtkTextIter       *match_end,
+                      const GtkTextIter *limit)
+{
+  GtkTextBTree *tree;
+  GtkTextLine *line;
+  gint line_num, first_line_num;
+  gint limit_line_num = 0;
+  gboolean limit_at_line_start = FALSE;
+
+  if (gtk_text_iter_is_start (iter))
+    return FALSE;
+
+  tree = _gtk_text_iter_get_btree (iter);
+  line = _gtk_text_iter_get_text_line (iter);
+  line_num = first_line_num = gtk_text_iter_get_line (iter);
+
+  if (gtk_text_iter_starts_line (iter))
+    {
+      line = _gtk_text_line_previous (line);
+      line_num--;
+    }
+
+  if (limit)
+    {
+      limit_line_num = gtk_text_iter_get_line (limit);
+      limit_at_line_start = gtk_text_iter_starts_line (limit);
+    }
+
+  while (line != NULL)
+    {
+      const gchar *text;
+      gint len, before, pos;
+
+      /* Stop once the limit is past the end of this line */
+      if (limit && line_num < first_line_num &&
+          (limit_line_num > line_num + 1 ||
+           (limit_line_num == line_num + 1 && !limit_at_line_start)))
+        break;
+
+      text = search_pattern_get_line (pattern, line, &len);
+      before = line_num == first_line_num ? search_pattern_get_pos (pattern, iter, text) : len;
+
+      pos = search_pattern_rfind (pattern, text, before);
+      if (pos >= 0)
+        {
+          GtkTextIter start;
+
+          search_pattern_get_iter (pattern, tree, line, text, len, pos, &start);
+
+          if (limit && gtk_text_iter_compare (limit, &start) > 0)
+            return FALSE;
+
+          if (match_start)
+            *match_start = start;
+          if (match_end)
+            search_pattern_get_iter (pattern, tree, line, text, len,
+                                     pos + pattern->needle_len, match_end);
+
+          return TRUE;
+        }
+
+      line = _gtk_text_line_previous (line);
+      line_num--;
+    }
+
+  return FALSE;
+}
+
 /**
  * gtk_text_iter_backward_search:
  * @iter: a #GtkTextIter where the search begins
@@ -4935,6 +5502,7 @@ gtk_text_iter_backward_search (const GtkTextIter *iter,
   gboolean retval = FALSE;
   gboolean visible_only;
   gboolean slice;
+  gboolean case_insensitive;
   
   g_return_val_if_fail (iter != NULL, FALSE);
   g_return_val_if_fail (str != NULL, FALSE);
@@ -4965,10 +5533,25 @@ gtk_text_iter_backward_search (const GtkTextIter *iter,
 
   visible_only = (flags & GTK_TEXT_SEARCH_VISIBLE_ONLY) != 0;
   slice = (flags & GTK_TEXT_SEARCH_TEXT_ONLY) == 0;
+  case_insensitive = (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE) != 0;
   
   /* locate all lines */
 
-  lines = strbreakup (str, "\n", -1);
+  lines = search_lines_new (str, flags);
+
+  if (SEARCH_IS_FAST (flags) && lines[1] == NULL)
+    {
+      SearchPattern pattern;
+
+      search_pattern_init (&pattern, lines[0], case_insensitive);
+      retval = backward_search_fast (iter, &pattern,
+                                     match_start, match_end, limit);
+      search_pattern_free (&pattern);
+
+      g_strfreev (lines);
+
+      return retval;
+    }
 
   l = lines;
   n_lines = 0;
@@ -4981,6 +5564,7 @@ gtk_text_iter_backward_search (const GtkTextIter *iter,
   win.n_lines = n_lines;
   win.slice = slice;
   win.visible_only = visible_only;
+  win.case_insensitive = case_insensitive;
 
   lines_window_init (&win, iter);
 
@@ -33,9 +33,10 @@
 G_BEGIN_DECLS
 
 typedef enum {
-  GTK_TEXT_SEARCH_VISIBLE_ONLY = 1 << 0,
-  GTK_TEXT_SEARCH_TEXT_ONLY    = 1 << 1
-  /* Possible future plans: SEARCH_CASE_INSENSITIVE, SEARCH_REGEXP */
+  GTK_TEXT_SEARCH_VISIBLE_ONLY     = 1 << 0,
+  GTK_TEXT_SEARCH_TEXT_ONLY        = 1 << 1,
+  GTK_TEXT_SEARCH_CASE_INSENSITIVE = 1 << 2
+  /* Possible future plans: SEARCH_REGEXP */
 } GtkTextSearchFlags;
 
 /*
@@ -280,6 +281,17 @@ gboolean gtk_text_iter_backward_search (const GtkTextIter *iter,
                                         GtkTextIter       *match_end,
                                         const GtkTextIter *limit);
 
+typedef void (* GtkTextSearchFunc) (const GtkTextIter *match_start,
+                                    const GtkTextIter *match_end,
+                                    gpointer           user_data);
+
+gint     gtk_text_iter_forward_search_all (const GtkTextIter  *iter,
+                                           const gchar        *str,
+                                           GtkTextSearchFlags  flags,
+                                           const GtkTextIter  *limit,
+                                           GtkTextSearchFunc   func,
+                                           gpointer            user_data);
+
 
 /*
  * Comparisons
@@ -90,6 +90,9 @@
 
 #define GTK_TEXT_LAYOUT_GET_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), GTK_TYPE_TEXT_LAYOUT, GtkTextLayoutPrivate))
 
+/* Maximum number of line displays kept around */
+#define DISPLAY_CACHE_SIZE 128
+
 typedef struct _GtkTextLayoutPrivate GtkTextLayoutPrivate;
 
 struct _GtkTextLayoutPrivate
@@ -98,6 +101,17 @@ struct _GtkTextLayoutPrivate
      direction only influences the direction of the cursor line.
   */
   GtkTextLine *cursor_line;
+
+  /* Line displays that have been built recently, most recently
+   * used first, and a map from their lines to their list links.
+   * layout->one_display_cache is the first of them, or NULL.
+   * Entries are dropped by gtk_text_layout_invalidate_cache() like
+   * the single cached display used to be.
+   */
+  GList *display_cache;
+  GList *display_cache_last;
+  guint n_cached_displays;
+  GHashTable *display_cache_lines;
 };
 
 static GtkTextLineData *gtk_text_layout_real_wrap (GtkTextLayout *layout,
@@ -141,6 +155,9 @@ static void gtk_text_layout_buffer_delete_range (GtkTextBuffer     *textbuffer,
 
 static void gtk_text_layout_update_cursor_line (GtkTextLayout *layout);
 
+static void line_display_free           (GtkTextLineDisplay *display);
+static void display_cache_clear         (GtkTextLayout      *layout);
+
 enum {
   INVALIDATED,
   CHANGED,
@@ -216,7 +233,11 @@ gtk_text_layout_class_init (GtkTextLayoutClass *klass)
 static void
 gtk_text_layout_init (GtkTextLayout *text_layout)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (text_layout);
+
   text_layout->cursor_visible = TRUE;
+
+  priv->display_cache_lines = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 GtkTextLayout*
@@ -259,12 +280,8 @@ gtk_text_layout_finalize (GObject *object)
       layout->rtl_context = NULL;
     }
   
-  if (layout->one_display_cache) 
-    {
-      GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-      layout->one_display_cache = NULL;
-      gtk_text_layout_free_line_display (layout, tmp_display);
-    }
+  display_cache_clear (layout);
+  g_hash_table_destroy (GTK_TEXT_LAYOUT_GET_PRIVATE (layout)->display_cache_lines);
 
   if (layout->preedit_string)
     {
@@ -293,6 +310,7 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
     return;
 
   free_style_cache (layout);
+  display_cache_clear (layout);
 
   if (layout->buffer)
     {
@@ -599,18 +617,35 @@ gtk_text_layout_changed (GtkTextLayout *layout,
                          gint           old_height,
                          gint           new_height)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  /* Invalidate the cached displays of the lines in the changed
+   * range; the btree gives us those lines directly, so the cost
+   * depends on the size of the range, not on the size of the cache.
    */
-  if (layout->one_display_cache)
+  if (priv->n_cached_displays > 0)
     {
-      GtkTextLine *line = layout->one_display_cache->line;
-      gint cache_y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
-						    line, layout);
-      gint cache_height = layout->one_display_cache->height;
+      GtkTextBTree *btree = _gtk_text_buffer_get_btree (layout->buffer);
+      GtkTextLine *line;
+      GtkTextLine *last_line;
+
+      line = _gtk_text_btree_find_line_by_y (btree, layout, y, NULL);
 
-      if (cache_y + cache_height > y && cache_y < y + old_height)
-	gtk_text_layout_invalidate_cache (layout, line);
+      /* -1 since y + old_height is one past */
+      last_line = _gtk_text_btree_find_line_by_y (btree, layout,
+                                                  y + MAX (old_height, 1) - 1, NULL);
+      if (last_line == NULL)
+        last_line = _gtk_text_btree_get_end_iter_line (btree);
+
+      while (line != NULL)
+        {
+          gtk_text_layout_invalidate_cache (layout, line);
+
+          if (line == last_line)
+            break;
+
+          line = _gtk_text_line_next_excluding_last (line);
+        }
     }
   
   gtk_text_layout_emit_changed (layout, y, old_height, new_height);
@@ -748,15 +783,101 @@ gtk_text_layout_invalidate_all (GtkTextLayout *layout)
 }
 
 static void
-gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
-                                  GtkTextLine   *line)
+display_cache_remove_link (GtkTextLayout *layout,
+                           GList         *link)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLineDisplay *display = link->data;
+
+  g_hash_table_remove (priv->display_cache_lines, display->line);
+
+  if (link == priv->display_cache_last)
+    priv->display_cache_last = link->prev;
+  priv->display_cache = g_list_delete_link (priv->display_cache, link);
+  priv->n_cached_displays--;
+
+  layout->one_display_cache = priv->display_cache ? priv->display_cache->data : NULL;
+
+  line_display_free (display);
+}
+
+static void
+display_cache_clear (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  while (priv->display_cache)
+    display_cache_remove_link (layout, priv->display_cache);
+}
+
+/* Returns the cached display for @line, if any, and makes it
+ * the most recently used one.
+ */
+static GtkTextLineDisplay *
+display_cache_lookup (GtkTextLayout *layout,
+                      GtkTextLine   *line)
 {
-  if (layout->one_display_cache && line == layout->one_display_cache->line)
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache_lines, line);
+  if (link == NULL)
+    return NULL;
+
+  if (link != priv->display_cache)
     {
-      GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-      layout->one_display_cache = NULL;
-      gtk_text_layout_free_line_display (layout, tmp_display);
+      if (link == priv->display_cache_last)
+        priv->display_cache_last = link->prev;
+      priv->display_cache = g_list_remove_link (priv->display_cache, link);
+      priv->display_cache = g_list_concat (link, priv->display_cache);
+      layout->one_display_cache = link->data;
     }
+
+  return link->data;
+}
+
+static void
+display_cache_insert (GtkTextLayout      *layout,
+                      GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  gtk_text_layout_invalidate_cache (layout, display->line);
+
+  priv->display_cache = g_list_prepend (priv->display_cache, display);
+  if (priv->display_cache_last == NULL)
+    priv->display_cache_last = priv->display_cache;
+  priv->n_cached_displays++;
+  g_hash_table_insert (priv->display_cache_lines, display->line, priv->display_cache);
+
+  layout->one_display_cache = display;
+
+  while (priv->n_cached_displays > DISPLAY_CACHE_SIZE)
+    display_cache_remove_link (layout, priv->display_cache_last);
+}
+
+static gboolean
+display_is_cached (GtkTextLayout      *layout,
+                   GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache_lines, display->line);
+
+  return link != NULL && link->data == display;
+}
+
+static void
+gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
+                                  GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache_lines, line);
+  if (link != NULL)
+    display_cache_remove_link (layout, link);
 }
 
 /* Now invalidate the paragraph containing the cursor
@@ -1812,18 +1933,10 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   
   g_return_val_if_fail (line != NULL, NULL);
 
-  if (layout->one_display_cache)
-    {
-      if (line == layout->one_display_cache->line &&
-          (size_only || !layout->one_display_cache->size_only))
-        return layout->one_display_cache;
-      else
-        {
-          GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-          layout->one_display_cache = NULL;
-          gtk_text_layout_free_line_display (layout, tmp_display);
-        }
-    }
+  display = display_cache_lookup (layout, line);
+  if (display != NULL &&
+      (size_only || !display->size_only))
+    return display;
 
   display = g_new0 (GtkTextLineDisplay, 1);
 
@@ -2136,7 +2249,14 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   g_free (text);
   pango_attr_list_unref (attrs);
 
-  layout->one_display_cache = display;
+  /* Only lines that carry line data for this layout are cached; the
+   * btree tells us about those through gtk_text_layout_free_line_data()
+   * before they go away, so the cache never points at a freed line.
+   */
+  if (_gtk_text_line_get_data (line, layout) != NULL)
+    display_cache_insert (layout, display);
+  else
+    gtk_text_layout_invalidate_cache (layout, line);
 
   if (saw_widget)
     allocate_child_widgets (layout, display);
@@ -2144,27 +2264,31 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   return display;
 }
 
-void
-gtk_text_layout_free_line_display (GtkTextLayout      *layout,
-                                   GtkTextLineDisplay *display)
+static void
+line_display_free (GtkTextLineDisplay *display)
 {
-  if (display != layout->one_display_cache)
+  if (display->layout)
+    g_object_unref (display->layout);
+
+  if (display->cursors)
     {
-      if (display->layout)
-        g_object_unref (display->layout);
+      g_slist_foreach (display->cursors, (GFunc)g_free, NULL);
+      g_slist_free (display->cursors);
+    }
+  g_slist_free (display->shaped_objects);
+  
+  if (display->pg_bg_color)
+    gdk_color_free (display->pg_bg_color);
 
-      if (display->cursors)
-        {
-          g_slist_foreach (display->cursors, (GFunc)g_free, NULL);
-          g_slist_free (display->cursors);
-        }
-      g_slist_free (display->shaped_objects);
-      
-      if (display->pg_bg_color)
-        gdk_color_free (display->pg_bg_color);
+  g_free (display);
+}
 
-      g_free (display);
-    }
+void
+gtk_text_layout_free_line_display (GtkTextLayout      *layout,
+                                   GtkTextLineDisplay *display)
+{
+  if (!display_is_cached (layout, display))
+    line_display_free (display);
 }
 
 /* Functions to convert iter <=> index for the line of a GtkTextLineDisplay
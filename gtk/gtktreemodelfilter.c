@@ -19,6 +19,7 @@
  */
 
 #include <config.h>
+#include "gdk/gdk.h"
 #include "gtktreemodelfilter.h"
 #include "gtkintl.h"
 #include "gtktreednd.h"
@@ -106,6 +107,14 @@ struct _GtkTreeModelFilterPrivate
 
   gboolean in_row_deleted;
 
+  /* queued refilter: visibility of the rows of the root level,
+   * evaluated in slices when idle.
+   */
+  guint refilter_idle_id;
+  guint32 *refilter_visible;
+  gint refilter_n_rows;
+  gint refilter_n_done;
+
   /* signal ids */
   guint changed_id;
   guint inserted_id;
@@ -128,6 +137,15 @@ enum
 #define FILTER_ELT(filter_elt) ((FilterElt *)filter_elt)
 #define FILTER_LEVEL(filter_level) ((FilterLevel *)filter_level)
 
+/* bitmaps of visible rows, indexed by offset in the child model */
+#define VISIBLE_BITMAP_SIZE(n_rows) (((n_rows) + 31) / 32)
+#define VISIBLE_BITMAP_GET(bitmap,i) (((bitmap)[(i) / 32] >> ((i) % 32)) & 1)
+#define VISIBLE_BITMAP_SET(bitmap,i) ((bitmap)[(i) / 32] |= 1u << ((i) % 32))
+#define VISIBLE_BITMAP_CLEAR(bitmap,i) ((bitmap)[(i) / 32] &= ~(1u << ((i) % 32)))
+
+/* how long a queued refilter may run the visible function per idle */
+#define REFILTER_SLICE_TIME 0.01
+
 /* general code (object/interface init, properties, etc) */
 static void         gtk_tree_model_filter_tree_model_init                 (GtkTreeModelIface       *iface);
 static void         gtk_tree_model_filter_drag_source_init                (GtkTreeDragSourceIface  *iface);
@@ -272,6 +290,23 @@ static void         gtk_tree_model_filter_update_children                 (GtkTr
 static FilterElt   *bsearch_elt_with_offset                               (GArray                 *array,
                                                                            gint                   offset,
                                                                            gint                  *index);
+static void         gtk_tree_model_filter_update_row                      (GtkTreeModelFilter     *filter,
+                                                                           GtkTreeModel           *c_model,
+                                                                           GtkTreePath            *c_path,
+                                                                           GtkTreeIter            *c_iter,
+                                                                           gboolean                emit_changed);
+static void         gtk_tree_model_filter_cancel_refilter                 (GtkTreeModelFilter     *filter);
+static void         gtk_tree_model_filter_refilter_row_inserted           (GtkTreeModelFilter     *filter,
+                                                                           GtkTreePath            *c_path,
+                                                                           GtkTreeIter            *c_iter);
+static void         gtk_tree_model_filter_refilter_row_deleted            (GtkTreeModelFilter     *filter,
+                                                                           GtkTreePath            *c_path);
+static void         gtk_tree_model_filter_refilter_rows_reordered         (GtkTreeModelFilter     *filter,
+                                                                           GtkTreePath            *c_path,
+                                                                           gint                   *new_order);
+static gboolean     gtk_tree_model_filter_refilter_offset                 (GtkTreeModelFilter     *filter,
+                                                                           GtkTreePath            *c_path,
+                                                                           gint                   *offset);
 
 
 G_DEFINE_TYPE_WITH_CODE (GtkTreeModelFilter, gtk_tree_model_filter, G_TYPE_OBJECT,
@@ -1159,7 +1194,21 @@ gtk_tree_model_filter_row_changed (GtkTreeModel *c_model,
                                    GtkTreeIter  *c_iter,
                                    gpointer      data)
 {
-  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  gtk_tree_model_filter_update_row (GTK_TREE_MODEL_FILTER (data),
+                                    c_model, c_path, c_iter, TRUE);
+}
+
+/* Brings the row at @c_path in line with the visible function.  If
+ * @emit_changed is %TRUE, ::row-changed is emitted for the row if it
+ * stays visible.
+ */
+static void
+gtk_tree_model_filter_update_row (GtkTreeModelFilter *filter,
+                                  GtkTreeModel       *c_model,
+                                  GtkTreePath        *c_path,
+                                  GtkTreeIter        *c_iter,
+                                  gboolean            emit_changed)
+{
   GtkTreeIter iter;
   GtkTreeIter children;
   GtkTreeIter real_c_iter;
@@ -1194,6 +1243,21 @@ gtk_tree_model_filter_row_changed (GtkTreeModel *c_model,
   /* what's the requested state? */
   requested_state = gtk_tree_model_filter_visible (filter, &real_c_iter);
 
+  /* keep a queued refilter up to date with toplevel rows */
+  if (filter->priv->refilter_visible != NULL)
+    {
+      gint offset;
+
+      if (gtk_tree_model_filter_refilter_offset (filter, c_path, &offset) &&
+          offset < filter->priv->refilter_n_done)
+        {
+          if (requested_state)
+            VISIBLE_BITMAP_SET (filter->priv->refilter_visible, offset);
+          else
+            VISIBLE_BITMAP_CLEAR (filter->priv->refilter_visible, offset);
+        }
+    }
+
   /* now, let's see whether the item is there */
   path = gtk_real_tree_model_filter_convert_child_path_to_path (filter,
                                                                 c_path,
@@ -1226,6 +1290,9 @@ gtk_tree_model_filter_row_changed (GtkTreeModel *c_model,
 
   if (current_state == TRUE && requested_state == TRUE)
     {
+      if (!emit_changed)
+        goto done;
+
       /* propagate the signal; also get a path taking only visible
        * nodes into account.
        */
@@ -1344,6 +1411,8 @@ gtk_tree_model_filter_row_inserted (GtkTreeModel *c_model,
   else
     gtk_tree_model_get_iter (c_model, &real_c_iter, c_path);
 
+  gtk_tree_model_filter_refilter_row_inserted (filter, c_path, &real_c_iter);
+
   /* the row has already been inserted. so we need to fixup the
    * virtual root here first
    */
@@ -1611,6 +1680,8 @@ gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
 
   g_return_if_fail (c_path != NULL);
 
+  gtk_tree_model_filter_refilter_row_deleted (filter, c_path);
+
   /* special case the deletion of an ancestor of the virtual root */
   if (filter->priv->virtual_root &&
       (gtk_tree_path_is_ancestor (c_path, filter->priv->virtual_root) ||
@@ -1862,6 +1933,8 @@ gtk_tree_model_filter_rows_reordered (GtkTreeModel *c_model,
 
   g_return_if_fail (new_order != NULL);
 
+  gtk_tree_model_filter_refilter_rows_reordered (filter, c_path, new_order);
+
   if (c_path == NULL || gtk_tree_path_get_indices (c_path) == NULL)
     {
       length = gtk_tree_model_iter_n_children (c_model, NULL);
@@ -2709,6 +2782,8 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->reordered_id);
 
+      gtk_tree_model_filter_cancel_refilter (filter);
+
       /* reset our state */
       if (filter->priv->root)
         gtk_tree_model_filter_free_level (filter, filter->priv->root);
@@ -3270,24 +3345,364 @@ gtk_tree_model_filter_convert_path_to_child_path (GtkTreeModelFilter *filter,
   return retval;
 }
 
+/* Sets @c_parent to the row in the child model whose children are
+ * in @level, the root level if @level is %NULL.  Returns %FALSE if
+ * they are the toplevel rows of the child model.
+ */
 static gboolean
-gtk_tree_model_filter_refilter_helper (GtkTreeModel *model,
-                                       GtkTreePath  *path,
-                                       GtkTreeIter  *iter,
-                                       gpointer      data)
+gtk_tree_model_filter_get_child_parent (GtkTreeModelFilter *filter,
+                                        FilterLevel        *level,
+                                        GtkTreeIter        *c_parent)
 {
-  /* evil, don't try this at home, but certainly speeds things up */
-  gtk_tree_model_filter_row_changed (model, path, iter, data);
+  if (level && level->parent_elt)
+    {
+      GtkTreeIter parent_iter;
+
+      parent_iter.stamp = filter->priv->stamp;
+      parent_iter.user_data = level->parent_level;
+      parent_iter.user_data2 = level->parent_elt;
+
+      gtk_tree_model_filter_convert_iter_to_child_iter (filter, c_parent,
+                                                        &parent_iter);
+      return TRUE;
+    }
+
+  if (filter->priv->virtual_root)
+    return gtk_tree_model_get_iter (filter->priv->child_model, c_parent,
+                                    filter->priv->virtual_root);
 
   return FALSE;
 }
 
+static void
+gtk_tree_model_filter_bump_stamp (GtkTreeModelFilter *filter)
+{
+  /* unlike gtk_tree_model_filter_increment_stamp(), this doesn't
+   * clear the cache, which could free the level being refiltered.
+   */
+  do
+    {
+      filter->priv->stamp++;
+    }
+  while (filter->priv->stamp == 0);
+}
+
+static void
+gtk_tree_model_filter_level_fixup_parents (FilterLevel *level)
+{
+  gint i;
+
+  for (i = 0; i < level->array->len; i++)
+    {
+      FilterElt *e = &g_array_index (level->array, FilterElt, i);
+      if (e->children)
+        e->children->parent_elt = e;
+    }
+}
+
+/* Refilters all rows of @level, whose parent has the path @path.
+ * The visible function is evaluated for every row in one pass, unless
+ * @visible holds the visibility of the @n_rows rows already.  Rows
+ * that become visible are merged into the level in the same pass;
+ * ::row-deleted and ::row-inserted are then emitted in row order,
+ * and the rows that were hidden are removed from the level at once.
+ * Rows that stay visible get ::row-changed, as they did when refiltering
+ * went through gtk_tree_model_filter_row_changed(), and their child
+ * levels are refiltered as well.
+ */
+static void
+gtk_tree_model_filter_refilter_level (GtkTreeModelFilter *filter,
+                                      FilterLevel        *level,
+                                      GtkTreePath        *path,
+                                      guint32            *visible,
+                                      gint                n_rows)
+{
+  GtkTreeModel *c_model = filter->priv->child_model;
+  GtkTreeIter c_parent, c_iter, iter;
+  gboolean has_parent;
+  guint32 *bitmap;
+  GArray *array;
+  GArray *hidden;
+  FilterLevel *parent_level;
+  FilterElt *parent_elt;
+  gboolean reffed;
+  gint old_visible_nodes;
+  gint n, i, j, index;
+
+  has_parent = gtk_tree_model_filter_get_child_parent (filter, level, &c_parent);
+  if (level->parent_elt && !has_parent)
+    return;
+
+  n = gtk_tree_model_iter_n_children (c_model, has_parent ? &c_parent : NULL);
+  if (!gtk_tree_model_iter_children (c_model, &c_iter, has_parent ? &c_parent : NULL))
+    return;
+
+  if (visible && n_rows == n)
+    bitmap = visible;
+  else
+    bitmap = g_new0 (guint32, VISIBLE_BITMAP_SIZE (n));
+
+  reffed = level->parent_level || filter->priv->virtual_root;
+
+  /* evaluate the rows and pull in the new ones */
+  array = g_array_sized_new (FALSE, FALSE, sizeof (FilterElt), level->array->len);
+  j = 0;
+  for (i = 0; i < n; i++)
+    {
+      if (bitmap != visible && gtk_tree_model_filter_visible (filter, &c_iter))
+        VISIBLE_BITMAP_SET (bitmap, i);
+
+      if (j < level->array->len &&
+          g_array_index (level->array, FilterElt, j).offset == i)
+        {
+          FilterElt *elt = &g_array_index (level->array, FilterElt, j);
+
+          g_array_append_val (array, *elt);
+          j++;
+        }
+      else if (VISIBLE_BITMAP_GET (bitmap, i))
+        {
+          FilterElt elt;
+
+          elt.offset = i;
+          elt.zero_ref_count = 0;
+          elt.ref_count = 0;
+          elt.children = NULL;
+          /* made visible below, when row-inserted is emitted */
+          elt.visible = FALSE;
+
+          if (GTK_TREE_MODEL_FILTER_CACHE_CHILD_ITERS (filter))
+            elt.iter = c_iter;
+
+          g_array_append_val (array, elt);
+        }
+
+      if (!gtk_tree_model_iter_next (c_model, &c_iter))
+        {
+          n = i + 1;
+          break;
+        }
+    }
+
+  for (; j < level->array->len; j++)
+    g_array_append_val (array, g_array_index (level->array, FilterElt, j));
+
+  g_array_free (level->array, TRUE);
+  level->array = array;
+  gtk_tree_model_filter_level_fixup_parents (level);
+  gtk_tree_model_filter_bump_stamp (filter);
+
+  if (reffed)
+    for (i = 0; i < level->array->len; i++)
+      {
+        FilterElt *elt = &g_array_index (level->array, FilterElt, i);
+
+        if (elt->ref_count == 0)
+          {
+            iter.stamp = filter->priv->stamp;
+            iter.user_data = level;
+            iter.user_data2 = elt;
+            gtk_tree_model_filter_ref_node (GTK_TREE_MODEL (filter), &iter);
+          }
+      }
+
+  /* emit the changes in row order; the array doesn't change while
+   * doing so, only the visible flags do.
+   */
+  old_visible_nodes = level->visible_nodes;
+  parent_level = level->parent_level;
+  parent_elt = level->parent_elt;
+  hidden = g_array_new (FALSE, FALSE, sizeof (gint));
+  index = 0;
+
+  for (i = 0; i < level->array->len; i++)
+    {
+      FilterElt *elt = &g_array_index (level->array, FilterElt, i);
+      gboolean requested_state;
+      GtkTreePath *c_path;
+
+      requested_state = elt->offset < n && VISIBLE_BITMAP_GET (bitmap, elt->offset);
+
+      iter.stamp = filter->priv->stamp;
+      iter.user_data = level;
+      iter.user_data2 = elt;
+
+      if (elt->visible && !requested_state)
+        {
+          elt->visible = FALSE;
+          level->visible_nodes--;
+          g_array_append_val (hidden, i);
+
+          c_path = gtk_tree_path_copy (path);
+          gtk_tree_path_append_index (c_path, index);
+          gtk_tree_model_row_deleted (GTK_TREE_MODEL (filter), c_path);
+          gtk_tree_path_free (c_path);
+        }
+      else if (!elt->visible && requested_state)
+        {
+          elt->visible = TRUE;
+          level->visible_nodes++;
+
+          c_path = gtk_tree_path_copy (path);
+          gtk_tree_path_append_index (c_path, index);
+          gtk_tree_model_row_inserted (GTK_TREE_MODEL (filter), c_path, &iter);
+
+          gtk_tree_model_filter_convert_iter_to_child_iter (filter, &c_iter, &iter);
+          if (gtk_tree_model_iter_has_child (c_model, &c_iter))
+            gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (filter),
+                                                  c_path, &iter);
+          gtk_tree_path_free (c_path);
+          index++;
+        }
+      else if (elt->visible)
+        {
+          c_path = gtk_tree_path_copy (path);
+          gtk_tree_path_append_index (c_path, index);
+          gtk_tree_model_row_changed (GTK_TREE_MODEL (filter), c_path, &iter);
+
+          if (elt->children)
+            gtk_tree_model_filter_refilter_level (filter, elt->children,
+                                                  c_path, NULL, 0);
+          gtk_tree_path_free (c_path);
+          index++;
+        }
+    }
+
+  if (bitmap != visible)
+    g_free (bitmap);
+
+  /* get rid of the hidden rows, like gtk_tree_model_filter_remove_node()
+   * does; an empty level keeps one row to get signals for, unless
+   * nobody is interested in it.
+   */
+  if (hidden->len > 0 && hidden->len == level->array->len &&
+      level != filter->priv->root &&
+      !(parent_elt && parent_elt->ref_count > 1))
+    {
+      for (i = 0; i < level->array->len; i++)
+        {
+          iter.stamp = filter->priv->stamp;
+          iter.user_data = level;
+          iter.user_data2 = &g_array_index (level->array, FilterElt, i);
+
+          while (g_array_index (level->array, FilterElt, i).ref_count > 1)
+            gtk_tree_model_filter_real_unref_node (GTK_TREE_MODEL (filter),
+                                                   &iter, FALSE);
+        }
+
+      gtk_tree_model_filter_free_level (filter, level);
+      level = NULL;
+    }
+  else if (hidden->len > 0)
+    {
+      gint keep = -1;
+
+      if (hidden->len == level->array->len)
+        keep = g_array_index (hidden, gint, 0);
+
+      for (j = 0; j < hidden->len; j++)
+        {
+          FilterElt *elt;
+
+          i = g_array_index (hidden, gint, j);
+          if (i == keep)
+            continue;
+
+          elt = &g_array_index (level->array, FilterElt, i);
+          iter.stamp = filter->priv->stamp;
+          iter.user_data = level;
+          iter.user_data2 = elt;
+
+          if (elt->children)
+            gtk_tree_model_filter_free_level (filter, elt->children);
+
+          while (elt->ref_count > 1)
+            gtk_tree_model_filter_real_unref_node (GTK_TREE_MODEL (filter),
+                                                   &iter, FALSE);
+
+          if (reffed)
+            gtk_tree_model_filter_unref_node (GTK_TREE_MODEL (filter), &iter);
+          else if (elt->ref_count > 0)
+            gtk_tree_model_filter_real_unref_node (GTK_TREE_MODEL (filter),
+                                                   &iter, FALSE);
+        }
+
+      /* compact the array */
+      index = 0;
+      for (i = 0, j = 0; i < level->array->len; i++)
+        {
+          if (j < hidden->len && g_array_index (hidden, gint, j) == i)
+            {
+              j++;
+              if (i != keep)
+                continue;
+            }
+
+          if (index != i)
+            g_array_index (level->array, FilterElt, index) =
+              g_array_index (level->array, FilterElt, i);
+          index++;
+        }
+      g_array_set_size (level->array, index);
+
+      gtk_tree_model_filter_level_fixup_parents (level);
+      gtk_tree_model_filter_bump_stamp (filter);
+    }
+
+  g_array_free (hidden, TRUE);
+
+  if (parent_elt && old_visible_nodes > 0 &&
+      (level == NULL || level->visible_nodes == 0))
+    {
+      iter.stamp = filter->priv->stamp;
+      iter.user_data = parent_level;
+      iter.user_data2 = parent_elt;
+
+      gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (filter),
+                                            path, &iter);
+    }
+}
+
+static void
+gtk_tree_model_filter_refilter_root (GtkTreeModelFilter *filter,
+                                     guint32            *visible,
+                                     gint                n_rows)
+{
+  GtkTreePath *path;
+
+  if (!filter->priv->child_model)
+    return;
+
+  if (!filter->priv->root)
+    {
+      FilterLevel *root;
+      gint i;
+
+      /* pull in the rows, but make them appear through row-inserted */
+      gtk_tree_model_filter_build_level (filter, NULL, NULL, FALSE);
+
+      root = FILTER_LEVEL (filter->priv->root);
+      if (!root)
+        return;
+
+      for (i = 0; i < root->array->len; i++)
+        g_array_index (root->array, FilterElt, i).visible = FALSE;
+      root->visible_nodes = 0;
+    }
+
+  path = gtk_tree_path_new ();
+  gtk_tree_model_filter_refilter_level (filter, FILTER_LEVEL (filter->priv->root),
+                                        path, visible, n_rows);
+  gtk_tree_path_free (path);
+}
+
 /**
  * gtk_tree_model_filter_refilter:
  * @filter: A #GtkTreeModelFilter.
  *
- * Emits ::row_changed for each row in the child model, which causes
- * the filter to re-evaluate whether a row is visible or not.
+ * Re-evaluates for each row in the child model whether it is visible
+ * or not.  Emits ::row-inserted and ::row-deleted for the rows whose
+ * visibility changed, and ::row-changed for the rows that stay visible.
  *
  * Since: 2.4
  */
@@ -3296,10 +3711,302 @@ gtk_tree_model_filter_refilter (GtkTreeModelFilter *filter)
 {
   g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
 
-  /* S L O W */
-  gtk_tree_model_foreach (filter->priv->child_model,
-                          gtk_tree_model_filter_refilter_helper,
-                          filter);
+  gtk_tree_model_filter_cancel_refilter (filter);
+  gtk_tree_model_filter_refilter_root (filter, NULL, 0);
+}
+
+/**
+ * gtk_tree_model_filter_refilter_rows:
+ * @filter: A #GtkTreeModelFilter.
+ * @child_paths: A #GList of #GtkTreePath<!-- -->s in the child model.
+ *
+ * Re-evaluates whether the rows at @child_paths are visible or not,
+ * and emits ::row-inserted or ::row-deleted for the rows whose 
+ * visibility changed.  This is much faster than 
+ * gtk_tree_model_filter_refilter() if only a few rows may have 
+ * changed their visibility.
+ *
+ * Since: 2.12
+ */
+void
+gtk_tree_model_filter_refilter_rows (GtkTreeModelFilter *filter,
+                                     GList              *child_paths)
+{
+  GList *l;
+
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+  g_return_if_fail (filter->priv->child_model != NULL);
+
+  for (l = child_paths; l; l = l->next)
+    {
+      GtkTreeIter c_iter;
+
+      if (gtk_tree_model_get_iter (filter->priv->child_model, &c_iter, l->data))
+        gtk_tree_model_filter_update_row (filter, filter->priv->child_model,
+                                          l->data, &c_iter, FALSE);
+    }
+}
+
+/* Runs the visible function for the toplevel rows for a while.
+ * Returns %TRUE when all rows are done.
+ */
+static gboolean
+gtk_tree_model_filter_refilter_slice (GtkTreeModelFilter *filter)
+{
+  GtkTreeModel *c_model = filter->priv->child_model;
+  GtkTreeIter c_parent, c_iter;
+  gboolean has_parent;
+  GTimer *timer;
+  gint n;
+
+  has_parent = gtk_tree_model_filter_get_child_parent (filter, NULL, &c_parent);
+  if (filter->priv->virtual_root && !has_parent)
+    return TRUE;
+
+  n = gtk_tree_model_iter_n_children (c_model, has_parent ? &c_parent : NULL);
+
+  if (filter->priv->refilter_n_done == 0 || n != filter->priv->refilter_n_rows)
+    {
+      g_free (filter->priv->refilter_visible);
+      filter->priv->refilter_visible = g_new0 (guint32, VISIBLE_BITMAP_SIZE (n));
+      filter->priv->refilter_n_rows = n;
+      filter->priv->refilter_n_done = 0;
+    }
+
+  if (!gtk_tree_model_iter_nth_child (c_model, &c_iter,
+                                      has_parent ? &c_parent : NULL,
+                                      filter->priv->refilter_n_done))
+    return TRUE;
+
+  timer = g_timer_new ();
+
+  do
+    {
+      if (gtk_tree_model_filter_visible (filter, &c_iter))
+        VISIBLE_BITMAP_SET (filter->priv->refilter_visible,
+                            filter->priv->refilter_n_done);
+      filter->priv->refilter_n_done++;
+
+      if (!gtk_tree_model_iter_next (c_model, &c_iter))
+        break;
+    }
+  while (filter->priv->refilter_n_done < n &&
+         (filter->priv->refilter_n_done % 64 != 0 ||
+          g_timer_elapsed (timer, NULL) < REFILTER_SLICE_TIME));
+
+  g_timer_destroy (timer);
+
+  return filter->priv->refilter_n_done >= n;
+}
+
+static gboolean
+gtk_tree_model_filter_refilter_idle (gpointer data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  guint32 *visible;
+  gint n_rows;
+
+  GDK_THREADS_ENTER ();
+
+  if (!gtk_tree_model_filter_refilter_slice (filter))
+    {
+      GDK_THREADS_LEAVE ();
+      return TRUE;
+    }
+
+  visible = filter->priv->refilter_visible;
+  n_rows = filter->priv->refilter_n_done;
+
+  filter->priv->refilter_idle_id = 0;
+  filter->priv->refilter_visible = NULL;
+  filter->priv->refilter_n_rows = 0;
+  filter->priv->refilter_n_done = 0;
+
+  gtk_tree_model_filter_refilter_root (filter, visible, n_rows);
+  g_free (visible);
+
+  GDK_THREADS_LEAVE ();
+
+  return FALSE;
+}
+
+/**
+ * gtk_tree_model_filter_queue_refilter:
+ * @filter: A #GtkTreeModelFilter.
+ *
+ * Like gtk_tree_model_filter_refilter(), but the visible function is 
+ * run for the rows a few at a time when the main loop is idle, so 
+ * that the user interface stays responsive while a large model is
+ * refiltered.  The changes are applied when all rows have been looked
+ * at.  Queueing another refilter before that starts over.
+ *
+ * Since: 2.12
+ */
+void
+gtk_tree_model_filter_queue_refilter (GtkTreeModelFilter *filter)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+  g_return_if_fail (filter->priv->child_model != NULL);
+
+  filter->priv->refilter_n_done = 0;
+
+  if (filter->priv->refilter_idle_id == 0)
+    filter->priv->refilter_idle_id = 
+      g_idle_add (gtk_tree_model_filter_refilter_idle, filter);
+}
+
+/* Returns whether @c_path is a row of the level looked at by a
+ * queued refilter, and if so, sets @offset to its position there.
+ */
+static gboolean
+gtk_tree_model_filter_refilter_offset (GtkTreeModelFilter *filter,
+                                       GtkTreePath        *c_path,
+                                       gint               *offset)
+{
+  gint depth = gtk_tree_path_get_depth (c_path);
+
+  if (filter->priv->virtual_root)
+    {
+      if (depth != gtk_tree_path_get_depth (filter->priv->virtual_root) + 1 ||
+          !gtk_tree_path_is_descendant (c_path, filter->priv->virtual_root))
+        return FALSE;
+    }
+  else if (depth != 1)
+    return FALSE;
+
+  *offset = gtk_tree_path_get_indices (c_path)[depth - 1];
+
+  return TRUE;
+}
+
+/* The following keep the rows evaluated so far by a queued refilter
+ * in sync with changes to the child model, so that the refilter
+ * doesn't have to start over.  Bits past refilter_n_done are kept
+ * cleared.
+ */
+static void
+gtk_tree_model_filter_refilter_row_inserted (GtkTreeModelFilter *filter,
+                                             GtkTreePath        *c_path,
+                                             GtkTreeIter        *c_iter)
+{
+  guint32 *visible = filter->priv->refilter_visible;
+  gint offset;
+  gint i;
+
+  if (visible == NULL ||
+      !gtk_tree_model_filter_refilter_offset (filter, c_path, &offset))
+    return;
+
+  if (VISIBLE_BITMAP_SIZE (filter->priv->refilter_n_rows + 1) >
+      VISIBLE_BITMAP_SIZE (filter->priv->refilter_n_rows))
+    {
+      gint size = VISIBLE_BITMAP_SIZE (filter->priv->refilter_n_rows + 1);
+
+      visible = g_renew (guint32, visible, size);
+      visible[size - 1] = 0;
+      filter->priv->refilter_visible = visible;
+    }
+  filter->priv->refilter_n_rows++;
+
+  if (offset >= filter->priv->refilter_n_done)
+    return;
+
+  for (i = filter->priv->refilter_n_done; i > offset; i--)
+    {
+      if (VISIBLE_BITMAP_GET (visible, i - 1))
+        VISIBLE_BITMAP_SET (visible, i);
+      else
+        VISIBLE_BITMAP_CLEAR (visible, i);
+    }
+
+  if (gtk_tree_model_filter_visible (filter, c_iter))
+    VISIBLE_BITMAP_SET (visible, offset);
+  else
+    VISIBLE_BITMAP_CLEAR (visible, offset);
+
+  filter->priv->refilter_n_done++;
+}
+
+static void
+gtk_tree_model_filter_refilter_row_deleted (GtkTreeModelFilter *filter,
+                                            GtkTreePath        *c_path)
+{
+  guint32 *visible = filter->priv->refilter_visible;
+  gint offset;
+  gint i;
+
+  if (visible == NULL ||
+      !gtk_tree_model_filter_refilter_offset (filter, c_path, &offset))
+    return;
+
+  filter->priv->refilter_n_rows--;
+
+  if (offset >= filter->priv->refilter_n_done)
+    return;
+
+  for (i = offset; i < filter->priv->refilter_n_done - 1; i++)
+    {
+      if (VISIBLE_BITMAP_GET (visible, i + 1))
+        VISIBLE_BITMAP_SET (visible, i);
+      else
+        VISIBLE_BITMAP_CLEAR (visible, i);
+    }
+
+  filter->priv->refilter_n_done--;
+  VISIBLE_BITMAP_CLEAR (visible, filter->priv->refilter_n_done);
+}
+
+static void
+gtk_tree_model_filter_refilter_rows_reordered (GtkTreeModelFilter *filter,
+                                               GtkTreePath        *c_path,
+                                               gint               *new_order)
+{
+  guint32 *visible;
+  gint i;
+
+  if (filter->priv->refilter_visible == NULL)
+    return;
+
+  if (filter->priv->virtual_root)
+    {
+      if (c_path == NULL ||
+          gtk_tree_path_compare (c_path, filter->priv->virtual_root) != 0)
+        return;
+    }
+  else if (c_path != NULL && gtk_tree_path_get_depth (c_path) > 0)
+    return;
+
+  /* the rows done are the longest run of rows at the start of the
+   * new order that were all done before.
+   */
+  visible = g_new0 (guint32, VISIBLE_BITMAP_SIZE (filter->priv->refilter_n_rows));
+  for (i = 0; i < filter->priv->refilter_n_rows; i++)
+    {
+      if (new_order[i] >= filter->priv->refilter_n_done)
+        break;
+
+      if (VISIBLE_BITMAP_GET (filter->priv->refilter_visible, new_order[i]))
+        VISIBLE_BITMAP_SET (visible, i);
+    }
+
+  g_free (filter->priv->refilter_visible);
+  filter->priv->refilter_visible = visible;
+  filter->priv->refilter_n_done = i;
+}
+
+static void
+gtk_tree_model_filter_cancel_refilter (GtkTreeModelFilter *filter)
+{
+  if (filter->priv->refilter_idle_id != 0)
+    {
+      g_source_remove (filter->priv->refilter_idle_id);
+      filter->priv->refilter_idle_id = 0;
+    }
+
+  g_free (filter->priv->refilter_visible);
+  filter->priv->refilter_visible = NULL;
+  filter->priv->refilter_n_rows = 0;
+  filter->priv->refilter_n_done = 0;
 }
 
 /**
@@ -97,6 +97,9 @@ GtkTreePath  *gtk_tree_model_filter_convert_path_to_child_path (GtkTreeModelFilt
 
 /* extras */
 void          gtk_tree_model_filter_refilter                   (GtkTreeModelFilter           *filter);
+void          gtk_tree_model_filter_refilter_rows              (GtkTreeModelFilter           *filter,
+                                                                GList                        *child_paths);
+void          gtk_tree_model_filter_queue_refilter             (GtkTreeModelFilter           *filter);
 void          gtk_tree_model_filter_clear_cache                (GtkTreeModelFilter           *filter);
 
 G_END_DECLS
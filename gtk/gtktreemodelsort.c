@@ -66,6 +66,7 @@ struct _SortElt
 struct _SortLevel
 {
   GArray    *array;
+  GArray    *positions; /* index in array of the elt with each offset */
   gint       ref_count;
   SortElt   *parent_elt;
   SortLevel *parent_level;
@@ -224,6 +225,15 @@ static gint         gtk_tree_model_sort_level_find_insert (GtkTreeModelSort *tre
 							   SortLevel        *level,
 							   GtkTreeIter      *iter,
 							   gint             skip_index);
+static gboolean     gtk_tree_model_sort_level_in_order    (GtkTreeModelSort *tree_model_sort,
+							   SortLevel        *level,
+							   GtkTreeIter      *iter,
+							   gint              index);
+static void         gtk_tree_model_sort_level_update_positions (SortLevel   *level,
+								gint         start,
+								gint         end);
+static gint         gtk_tree_model_sort_level_find_offset (SortLevel        *level,
+							   gint              offset);
 static gboolean     gtk_tree_model_sort_insert_value      (GtkTreeModelSort *tree_model_sort,
 							   SortLevel        *level,
 							   GtkTreePath      *s_path,
@@ -413,6 +423,7 @@ gtk_tree_model_sort_row_changed (GtkTreeModel *s_model,
   GtkTreePath *path = NULL;
   GtkTreeIter iter;
   GtkTreeIter tmpiter;
+  GtkTreeIter *child_iter;
 
   SortElt tmp;
   SortElt *elt;
@@ -420,7 +431,7 @@ gtk_tree_model_sort_row_changed (GtkTreeModel *s_model,
 
   gboolean free_s_path = FALSE;
 
-  gint index = 0, old_index, i;
+  gint index = 0, old_index;
 
   g_return_if_fail (start_s_path != NULL || start_s_iter != NULL);
 
@@ -472,40 +483,22 @@ gtk_tree_model_sort_row_changed (GtkTreeModel *s_model,
   memcpy (&tmp, elt, sizeof (SortElt));
 
   if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
-    index = gtk_tree_model_sort_level_find_insert (tree_model_sort,
-						   level,
-						   &tmp.iter,
-						   old_index);
+    child_iter = &tmp.iter;
+  else
+    child_iter = &tmpiter;
+
+  /* Most changes leave the row where it is, which can be seen by
+   * comparing it with its neighbours only.
+   */
+  if (gtk_tree_model_sort_level_in_order (tree_model_sort, level,
+					  child_iter, old_index))
+    index = old_index;
   else
     index = gtk_tree_model_sort_level_find_insert (tree_model_sort,
 						   level,
-						   &tmpiter,
+						   child_iter,
 						   old_index);
 
-  if (index < old_index)
-    {
-      g_memmove (level->array->data + ((index + 1)*sizeof (SortElt)),
-		 level->array->data + ((index)*sizeof (SortElt)),
-		 (old_index - index)* sizeof(SortElt));
-    }
-  else if (index > old_index)
-    {
-      g_memmove (level->array->data + ((old_index)*sizeof (SortElt)),
-		 level->array->data + ((old_index + 1)*sizeof (SortElt)),
-		 (index - old_index)* sizeof(SortElt));
-    }
-  memcpy (level->array->data + ((index)*sizeof (SortElt)),
-	  &tmp, sizeof (SortElt));
-
-  for (i = 0; i < level->array->len; i++)
-    if (g_array_index (level->array, SortElt, i).children)
-      g_array_index (level->array, SortElt, i).children->parent_elt = &g_array_index (level->array, SortElt, i);
-
-  gtk_tree_path_up (path);
-  gtk_tree_path_append_index (path, index);
-
-  gtk_tree_model_sort_increment_stamp (tree_model_sort);
-
   /* if the item moved, then emit rows_reordered */
   if (old_index != index)
     {
@@ -514,6 +507,31 @@ gtk_tree_model_sort_row_changed (GtkTreeModel *s_model,
 
       GtkTreePath *tmppath;
 
+      if (index < old_index)
+	{
+	  g_memmove (level->array->data + ((index + 1)*sizeof (SortElt)),
+		     level->array->data + ((index)*sizeof (SortElt)),
+		     (old_index - index)* sizeof(SortElt));
+	}
+      else
+	{
+	  g_memmove (level->array->data + ((old_index)*sizeof (SortElt)),
+		     level->array->data + ((old_index + 1)*sizeof (SortElt)),
+		     (index - old_index)* sizeof(SortElt));
+	}
+      memcpy (level->array->data + ((index)*sizeof (SortElt)),
+	      &tmp, sizeof (SortElt));
+
+      /* only the elts between the old and the new index have moved */
+      gtk_tree_model_sort_level_update_positions (level,
+						  MIN (index, old_index),
+						  MAX (index, old_index) + 1);
+
+      gtk_tree_path_up (path);
+      gtk_tree_path_append_index (path, index);
+
+      gtk_tree_model_sort_increment_stamp (tree_model_sort);
+
       new_order = g_new (gint, level->array->len);
 
       for (j = 0; j < level->array->len; j++)
@@ -636,15 +654,10 @@ gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
 	  goto done;
 	}
 
-      elt = NULL;
-      for (j = 0; j < level->array->len; j++)
-	if (g_array_index (level->array, SortElt, j).offset == gtk_tree_path_get_indices (s_path)[i])
-	  {
-	    elt = &g_array_index (level->array, SortElt, j);
-	    break;
-	  }
+      j = gtk_tree_model_sort_level_find_offset (level, gtk_tree_path_get_indices (s_path)[i]);
+      g_return_if_fail (j >= 0);
 
-      g_return_if_fail (elt != NULL);
+      elt = &g_array_index (level->array, SortElt, j);
 
       if (!elt->children)
 	{
@@ -771,9 +784,7 @@ gtk_tree_model_sort_row_deleted (GtkTreeModel *s_model,
   gtk_tree_model_sort_increment_stamp (tree_model_sort);
 
   /* Remove the row */
-  for (i = 0; i < level->array->len; i++)
-    if (elt->offset == g_array_index (level->array, SortElt, i).offset)
-      break;
+  i = gtk_tree_model_sort_level_find_offset (level, offset);
 
   g_array_remove_index (level->array, i);
 
@@ -783,10 +794,10 @@ gtk_tree_model_sort_row_deleted (GtkTreeModel *s_model,
       elt = & (g_array_index (level->array, SortElt, i));
       if (elt->offset > offset)
 	elt->offset--;
-      if (elt->children)
-	elt->children->parent_elt = elt;
     }
 
+  gtk_tree_model_sort_level_update_positions (level, 0, level->array->len);
+
   gtk_tree_path_free (path);
 }
 
@@ -839,20 +850,18 @@ gtk_tree_model_sort_rows_reordered (GtkTreeModel *s_model,
       return;
     }
 
+  /* the new offset of the row at old offset new_order[j] is j */
   tmp_array = g_new (int, level->array->len);
-  for (i = 0; i < level->array->len; i++)
-    {
-      for (j = 0; j < level->array->len; j++)
-	{
-	  if (g_array_index (level->array, SortElt, i).offset == new_order[j])
-	    tmp_array[i] = j;
-	}
-    }
+  for (j = 0; j < level->array->len; j++)
+    tmp_array[new_order[j]] = j;
 
   for (i = 0; i < level->array->len; i++)
-    g_array_index (level->array, SortElt, i).offset = tmp_array[i];
+    g_array_index (level->array, SortElt, i).offset = 
+      tmp_array[g_array_index (level->array, SortElt, i).offset];
   g_free (tmp_array);
 
+  gtk_tree_model_sort_level_update_positions (level, 0, level->array->len);
+
   if (tree_model_sort->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID &&
       tree_model_sort->default_sort_func == NO_SORT_FUNC)
     {
@@ -1623,15 +1632,14 @@ gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
       new_order[i] = g_array_index (sort_array, SortTuple, i).offset;
 
       g_array_append_val (new_array, *elt);
-      elt = &g_array_index (new_array, SortElt, i);
-      if (elt->children)
-	elt->children->parent_elt = elt;
     }
 
   g_array_free (level->array, TRUE);
   level->array = new_array;
   g_array_free (sort_array, TRUE);
 
+  gtk_tree_model_sort_level_update_positions (level, 0, level->array->len);
+
   if (emit_reordered)
     {
       gtk_tree_model_sort_increment_stamp (tree_model_sort);
@@ -1679,15 +1687,8 @@ gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
    */
   iter.stamp = tree_model_sort->stamp;
   iter.user_data = level;
-
-  for (i = 0; i < level->array->len; i++)
-    {
-      if (g_array_index (level->array, SortElt, i).offset == ref_offset)
-        {
-	  iter.user_data2 = &g_array_index (level->array, SortElt, i);
-	  break;
-	}
-    }
+  iter.user_data2 = &g_array_index (level->array, SortElt,
+				    gtk_tree_model_sort_level_find_offset (level, ref_offset));
 
   gtk_tree_model_sort_unref_node (GTK_TREE_MODEL (tree_model_sort), &iter);
 }
@@ -1717,20 +1718,11 @@ gtk_tree_model_sort_sort (GtkTreeModelSort *tree_model_sort)
 }
 
 /* signal helpers */
-static gint
-gtk_tree_model_sort_level_find_insert (GtkTreeModelSort *tree_model_sort,
-				       SortLevel        *level,
-				       GtkTreeIter      *iter,
-				       gint             skip_index)
+static gboolean
+gtk_tree_model_sort_get_compare_func (GtkTreeModelSort        *tree_model_sort,
+				      GtkTreeIterCompareFunc  *func,
+				      gpointer                *data)
 {
-  gint start, middle, end;
-  gint cmp;
-  SortElt *tmp_elt;
-  GtkTreeIter tmp_iter;
-
-  GtkTreeIterCompareFunc func;
-  gpointer data;
-
   if (tree_model_sort->sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
     {
       GtkTreeDataSortHeader *header;
@@ -1738,20 +1730,70 @@ gtk_tree_model_sort_level_find_insert (GtkTreeModelSort *tree_model_sort,
       header = _gtk_tree_data_list_get_header (tree_model_sort->sort_list,
 					       tree_model_sort->sort_column_id);
       
-      g_return_val_if_fail (header != NULL, 0);
+      g_return_val_if_fail (header != NULL, FALSE);
       
-      func = header->func;
-      data = header->data;
+      *func = header->func;
+      *data = header->data;
     }
   else
     {
-      func = tree_model_sort->default_sort_func;
-      data = tree_model_sort->default_sort_data;
+      *func = tree_model_sort->default_sort_func;
+      *data = tree_model_sort->default_sort_data;
       
-      g_return_val_if_fail (func != NO_SORT_FUNC, 0);
+      g_return_val_if_fail (*func != NO_SORT_FUNC, FALSE);
+    }
+
+  g_return_val_if_fail (*func != NULL, FALSE);
+
+  return TRUE;
+}
+
+/* Compares @elt with the child row @iter in the sort order of
+ * @tree_model_sort.
+ */
+static gint
+gtk_tree_model_sort_compare_elt (GtkTreeModelSort       *tree_model_sort,
+				 GtkTreeIterCompareFunc  func,
+				 gpointer                data,
+				 SortLevel              *level,
+				 SortElt                *elt,
+				 GtkTreeIter            *iter)
+{
+  GtkTreeIter tmp_iter;
+
+  if (!GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+    {
+      GtkTreePath *path = gtk_tree_model_sort_elt_get_path (level, elt);
+      gtk_tree_model_get_iter (tree_model_sort->child_model,
+			       &tmp_iter, path);
+      gtk_tree_path_free (path);
     }
+  else
+    tmp_iter = elt->iter;
+  
+  if (tree_model_sort->order == GTK_SORT_ASCENDING)
+    return (* func) (GTK_TREE_MODEL (tree_model_sort->child_model),
+		     &tmp_iter, iter, data);
+  else
+    return (* func) (GTK_TREE_MODEL (tree_model_sort->child_model),
+		     iter, &tmp_iter, data);
+}
 
-  g_return_val_if_fail (func != NULL, 0);
+static gint
+gtk_tree_model_sort_level_find_insert (GtkTreeModelSort *tree_model_sort,
+				       SortLevel        *level,
+				       GtkTreeIter      *iter,
+				       gint             skip_index)
+{
+  gint start, middle, end;
+  gint cmp;
+  SortElt *tmp_elt;
+
+  GtkTreeIterCompareFunc func;
+  gpointer data;
+
+  if (!gtk_tree_model_sort_get_compare_func (tree_model_sort, &func, &data))
+    return 0;
 
   start = 0;
   end = level->array->len;
@@ -1772,22 +1814,8 @@ gtk_tree_model_sort_level_find_insert (GtkTreeModelSort *tree_model_sort,
       else
 	tmp_elt = &(g_array_index (level->array, SortElt, middle + 1));
   
-      if (!GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
-	{
-	  GtkTreePath *path = gtk_tree_model_sort_elt_get_path (level, tmp_elt);
-	  gtk_tree_model_get_iter (tree_model_sort->child_model,
-				   &tmp_iter, path);
-	  gtk_tree_path_free (path);
-	}
-      else
-	tmp_iter = tmp_elt->iter;
-  
-      if (tree_model_sort->order == GTK_SORT_ASCENDING)
-	cmp = (* func) (GTK_TREE_MODEL (tree_model_sort->child_model),
-			&tmp_iter, iter, data);
-      else
-	cmp = (* func) (GTK_TREE_MODEL (tree_model_sort->child_model),
-			iter, &tmp_iter, data);
+      cmp = gtk_tree_model_sort_compare_elt (tree_model_sort, func, data,
+					     level, tmp_elt, iter);
 
       if (cmp <= 0)
 	start = middle + 1;
@@ -1801,6 +1829,69 @@ gtk_tree_model_sort_level_find_insert (GtkTreeModelSort *tree_model_sort,
     return middle;
 }
 
+/* Returns whether the elt at @index, whose child row is @iter, 
+ * still sorts between its neighbours.
+ */
+static gboolean
+gtk_tree_model_sort_level_in_order (GtkTreeModelSort *tree_model_sort,
+				    SortLevel        *level,
+				    GtkTreeIter      *iter,
+				    gint              index)
+{
+  GtkTreeIterCompareFunc func;
+  gpointer data;
+
+  if (!gtk_tree_model_sort_get_compare_func (tree_model_sort, &func, &data))
+    return TRUE;
+
+  if (index > 0 &&
+      gtk_tree_model_sort_compare_elt (tree_model_sort, func, data, level,
+				       &g_array_index (level->array, SortElt, index - 1),
+				       iter) > 0)
+    return FALSE;
+
+  if (index < level->array->len - 1 &&
+      gtk_tree_model_sort_compare_elt (tree_model_sort, func, data, level,
+				       &g_array_index (level->array, SortElt, index + 1),
+				       iter) < 0)
+    return FALSE;
+
+  return TRUE;
+}
+
+/* Updates the positions of the elts between @start and @end after
+ * they have been moved around in the array of @level.
+ */
+static void
+gtk_tree_model_sort_level_update_positions (SortLevel *level,
+					    gint       start,
+					    gint       end)
+{
+  gint i;
+
+  g_array_set_size (level->positions, level->array->len);
+
+  for (i = start; i < end; i++)
+    {
+      SortElt *elt = &g_array_index (level->array, SortElt, i);
+
+      g_array_index (level->positions, gint, elt->offset) = i;
+      if (elt->children)
+	elt->children->parent_elt = elt;
+    }
+}
+
+/* Returns the index of the elt with @offset in @level, or -1 */
+static gint
+gtk_tree_model_sort_level_find_offset (SortLevel *level,
+				       gint       offset)
+{
+  if (offset < 0 || offset >= level->positions->len)
+    return -1;
+
+  return g_array_index (level->positions, gint, offset);
+}
+
 static gboolean
 gtk_tree_model_sort_insert_value (GtkTreeModelSort *tree_model_sort,
 				  SortLevel        *level,
@@ -1836,10 +1927,7 @@ gtk_tree_model_sort_insert_value (GtkTreeModelSort *tree_model_sort,
                                                    -1);
 
   g_array_insert_vals (level->array, index, &elt, 1);
-  tmp_elt = SORT_ELT (level->array->data);
-  for (i = 0; i < level->array->len; i++, tmp_elt++)
-    if (tmp_elt->children)
-      tmp_elt->children->parent_elt = tmp_elt;
+  gtk_tree_model_sort_level_update_positions (level, 0, level->array->len);
 
   return TRUE;
 }
@@ -1991,7 +2079,6 @@ gtk_real_tree_model_sort_convert_child_path_to_path (GtkTreeModelSort *tree_mode
   for (i = 0; i < gtk_tree_path_get_depth (child_path); i++)
     {
       gint j;
-      gboolean found_child = FALSE;
 
       if (!level)
 	{
@@ -1999,30 +2086,19 @@ gtk_real_tree_model_sort_convert_child_path_to_path (GtkTreeModelSort *tree_mode
 	  return NULL;
 	}
 
-      if (child_indices[i] >= level->array->len)
+      j = gtk_tree_model_sort_level_find_offset (level, child_indices[i]);
+      if (j < 0)
 	{
 	  gtk_tree_path_free (retval);
 	  return NULL;
 	}
-      for (j = 0; j < level->array->len; j++)
-	{
-	  if ((g_array_index (level->array, SortElt, j)).offset == child_indices[i])
-	    {
-	      gtk_tree_path_append_index (retval, j);
-	      if (g_array_index (level->array, SortElt, j).children == NULL && build_levels)
-		{
-		  gtk_tree_model_sort_build_level (tree_model_sort, level, &g_array_index (level->array, SortElt, j));
-		}
-	      level = g_array_index (level->array, SortElt, j).children;
-	      found_child = TRUE;
-	      break;
-	    }
-	}
-      if (! found_child)
+
+      gtk_tree_path_append_index (retval, j);
+      if (g_array_index (level->array, SortElt, j).children == NULL && build_levels)
 	{
-	  gtk_tree_path_free (retval);
-	  return NULL;
+	  gtk_tree_model_sort_build_level (tree_model_sort, level, &g_array_index (level->array, SortElt, j));
 	}
+      level = g_array_index (level->array, SortElt, j).children;
     }
 
   return retval;
@@ -2225,6 +2301,7 @@ gtk_tree_model_sort_build_level (GtkTreeModelSort *tree_model_sort,
 
   new_level = g_new (SortLevel, 1);
   new_level->array = g_array_sized_new (FALSE, FALSE, sizeof (SortElt), length);
+  new_level->positions = g_array_sized_new (FALSE, FALSE, sizeof (gint), length);
   new_level->ref_count = 0;
   new_level->parent_elt = parent_elt;
   new_level->parent_level = parent_level;
@@ -2260,12 +2337,15 @@ gtk_tree_model_sort_build_level (GtkTreeModelSort *tree_model_sort,
 	      i < length - 1)
 	    {
 	      g_warning ("There is a discrepancy between the sort model and the child model.");
+	      gtk_tree_model_sort_level_update_positions (new_level, 0, i);
 	      return;
 	    }
 	}
       g_array_append_val (new_level->array, sort_elt);
     }
 
+  gtk_tree_model_sort_level_update_positions (new_level, 0, length);
+
   /* sort level */
   gtk_tree_model_sort_sort_level (tree_model_sort, new_level,
 				  FALSE, FALSE);
@@ -2310,6 +2390,8 @@ gtk_tree_model_sort_free_level (GtkTreeModelSort *tree_model_sort,
 
   g_array_free (sort_level->array, TRUE);
   sort_level->array = NULL;
+  g_array_free (sort_level->positions, TRUE);
+  sort_level->positions = NULL;
 
   g_free (sort_level);
   sort_level = NULL;
@@ -0,0 +1,1881 @@
+/* updatercache.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Writes FILE.cache next to an RC file, bundling it with the files it
+ * includes and its locale specific variants.  The format is described
+ * in gtkrccache.c.  The files are looked for the same way gtkrc.c does
+ * it, and every directory looked in is recorded, so that GTK+ can tell
+ * from the cache alone that a file it asks for doesn't exist.
+ *
+ * Each file is also compiled to the statements GTK+ runs instead of
+ * parsing it.  The compiler follows the parser in gtkrc.c; what it
+ * doesn't know, or what doesn't mean the same in every process, is
+ * left for GTK+ to parse.
+ */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <errno.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <glib/gi18n.h>
+
+#include "gtkenums.h"
+#include "gtkrccache.h"
+
+static gboolean quiet = FALSE;
+
+#define MAJOR_VERSION 2
+#define MINOR_VERSION 0
+
+#define HEADER_SIZE     20
+#define DIR_ENTRY_SIZE  12
+#define FILE_ENTRY_SIZE 28
+
+#define ALIGN_VALUE(this, boundary) \
+  (( ((unsigned long)(this)) + (((unsigned long)(boundary)) -1)) & (~(((unsigned long)(boundary))-1)))
+
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+#define ST_MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)
+#else
+#define ST_MTIME_NSEC(st) 0
+#endif
+
+/* This has to split the input into tokens the same way gtkrc.c does */
+static const GScannerConfig scanner_config =
+{
+  (
+   " \t\r\n"
+   )			/* cset_skip_characters */,
+  (
+   "_"
+   G_CSET_a_2_z
+   G_CSET_A_2_Z
+   )			/* cset_identifier_first */,
+  (
+   G_CSET_DIGITS
+   "-_"
+   G_CSET_a_2_z
+   G_CSET_A_2_Z
+   )			/* cset_identifier_nth */,
+  ( "#\n" )		/* cpair_comment_single */,
+
+  TRUE			/* case_sensitive */,
+
+  TRUE			/* skip_comment_multi */,
+  TRUE			/* skip_comment_single */,
+  TRUE			/* scan_comment_multi */,
+  TRUE			/* scan_identifier */,
+  FALSE			/* scan_identifier_1char */,
+  FALSE			/* scan_identifier_NULL */,
+  TRUE			/* scan_symbols */,
+  TRUE			/* scan_binary */,
+  TRUE			/* scan_octal */,
+  TRUE			/* scan_float */,
+  TRUE			/* scan_hex */,
+  TRUE			/* scan_hex_dollar */,
+  TRUE			/* scan_string_sq */,
+  TRUE			/* scan_string_dq */,
+  TRUE			/* numbers_2_int */,
+  FALSE			/* int_2_float */,
+  FALSE			/* identifier_2_string */,
+  TRUE			/* char_2_token */,
+  TRUE			/* symbol_2_token */,
+  FALSE			/* scope_0_fallback */,
+};
+
+/* The keywords of gtkrc.c */
+typedef enum {
+  TOKEN_INVALID = G_TOKEN_LAST,
+  TOKEN_INCLUDE,
+  TOKEN_NORMAL,
+  TOKEN_ACTIVE,
+  TOKEN_PRELIGHT,
+  TOKEN_SELECTED,
+  TOKEN_INSENSITIVE,
+  TOKEN_FG,
+  TOKEN_BG,
+  TOKEN_TEXT,
+  TOKEN_BASE,
+  TOKEN_XTHICKNESS,
+  TOKEN_YTHICKNESS,
+  TOKEN_FONT,
+  TOKEN_FONTSET,
+  TOKEN_FONT_NAME,
+  TOKEN_BG_PIXMAP,
+  TOKEN_PIXMAP_PATH,
+  TOKEN_STYLE,
+  TOKEN_BINDING,
+  TOKEN_BIND,
+  TOKEN_WIDGET,
+  TOKEN_WIDGET_CLASS,
+  TOKEN_CLASS,
+  TOKEN_LOWEST,
+  TOKEN_GTK,
+  TOKEN_APPLICATION,
+  TOKEN_THEME,
+  TOKEN_RC,
+  TOKEN_HIGHEST,
+  TOKEN_ENGINE,
+  TOKEN_MODULE_PATH,
+  TOKEN_IM_MODULE_FILE,
+  TOKEN_STOCK,
+  TOKEN_LTR,
+  TOKEN_RTL,
+  TOKEN_COLOR
+} Token;
+
+static const struct
+{
+  const gchar *name;
+  Token token;
+} symbols[] = {
+  { "include", TOKEN_INCLUDE },
+  { "NORMAL", TOKEN_NORMAL },
+  { "ACTIVE", TOKEN_ACTIVE },
+  { "PRELIGHT", TOKEN_PRELIGHT },
+  { "SELECTED", TOKEN_SELECTED },
+  { "INSENSITIVE", TOKEN_INSENSITIVE },
+  { "fg", TOKEN_FG },
+  { "bg", TOKEN_BG },
+  { "text", TOKEN_TEXT },
+  { "base", TOKEN_BASE },
+  { "xthickness", TOKEN_XTHICKNESS },
+  { "ythickness", TOKEN_YTHICKNESS },
+  { "font", TOKEN_FONT },
+  { "fontset", TOKEN_FONTSET },
+  { "font_name", TOKEN_FONT_NAME },
+  { "bg_pixmap", TOKEN_BG_PIXMAP },
+  { "pixmap_path", TOKEN_PIXMAP_PATH },
+  { "style", TOKEN_STYLE },
+  { "binding", TOKEN_BINDING },
+  { "bind", TOKEN_BIND },
+  { "widget", TOKEN_WIDGET },
+  { "widget_class", TOKEN_WIDGET_CLASS },
+  { "class", TOKEN_CLASS },
+  { "lowest", TOKEN_LOWEST },
+  { "gtk", TOKEN_GTK },
+  { "application", TOKEN_APPLICATION },
+  { "theme", TOKEN_THEME },
+  { "rc", TOKEN_RC },
+  { "highest", TOKEN_HIGHEST },
+  { "engine", TOKEN_ENGINE },
+  { "module_path", TOKEN_MODULE_PATH },
+  { "stock", TOKEN_STOCK },
+  { "im_module_file", TOKEN_IM_MODULE_FILE },
+  { "LTR", TOKEN_LTR },
+  { "RTL", TOKEN_RTL },
+  { "color", TOKEN_COLOR }
+};
+
+typedef struct
+{
+  gchar *path;
+  guint32 mtime;
+  guint32 mtime_nsec;
+} Directory;
+
+typedef struct
+{
+  gchar *path;
+  guint32 mtime;
+  guint32 mtime_nsec;
+  guint32 link_mtime;
+  gchar *contents;
+  gsize length;
+
+  /* The compiled statements; for each number, whether it is a string */
+  GArray *code;
+  GByteArray *is_string;
+} File;
+
+static GHashTable *directory_hash = NULL;
+static GList *directories = NULL;
+static GHashTable *file_hash = NULL;
+static GList *files = NULL;
+
+/* The strings of the compiled statements, each once */
+static GHashTable *string_hash = NULL;
+static GPtrArray *strings = NULL;
+static guint32 strings_size = 0;
+
+static void parse_file   (const gchar *filename,
+			  GSList      *stack);
+static void compile_file (File        *file);
+
+static void
+add_directory (const gchar *path)
+{
+  Directory *dir;
+  struct stat st;
+
+  if (g_hash_table_lookup (directory_hash, path))
+    return;
+
+  /* A directory that doesn't exist can't be validated later; GTK+
+   * looks for files in it on the file system.
+   */
+  if (g_stat (path, &st) < 0)
+    return;
+
+  dir = g_new (Directory, 1);
+  dir->path = g_strdup (path);
+  dir->mtime = st.st_mtime;
+  dir->mtime_nsec = ST_MTIME_NSEC (&st);
+
+  g_hash_table_insert (directory_hash, dir->path, dir);
+  directories = g_list_append (directories, dir);
+}
+
+/* Like g_file_test (filename, G_FILE_TEST_EXISTS), which is what GTK+
+ * uses, but remembers that the directory was looked in.
+ */
+static gboolean
+file_exists (const gchar *filename)
+{
+  gchar *dirname;
+
+  dirname = g_path_get_dirname (filename);
+  add_directory (dirname);
+  g_free (dirname);
+
+  return g_file_test (filename, G_FILE_TEST_EXISTS);
+}
+
+static File *
+add_file (const gchar *filename)
+{
+  File *file;
+  struct stat st, link_st;
+  GError *error = NULL;
+
+  file = g_hash_table_lookup (file_hash, filename);
+  if (file)
+    return file;
+
+  file = g_new (File, 1);
+  file->path = g_strdup (filename);
+
+  if (g_stat (filename, &st) < 0 ||
+      g_lstat (filename, &link_st) < 0 ||
+      !g_file_get_contents (filename, &file->contents, &file->length, &error))
+    {
+      g_printerr (_("Failed to read %s: %s\n"), filename,
+		  error ? error->message : g_strerror (errno));
+      exit (1);
+    }
+
+  /* GTK+ checks the cache against what the file points to, but
+   * gtk_rc_reparse_all() compares the mtime of the link itself.
+   */
+  file->mtime = st.st_mtime;
+  file->mtime_nsec = ST_MTIME_NSEC (&st);
+  file->link_mtime = link_st.st_mtime;
+
+  /* The file changed between the stat and reading it */
+  if (file->length != (gsize) st.st_size)
+    {
+      g_printerr (_("Failed to read %s: %s\n"), filename,
+		  g_strerror (EAGAIN));
+      exit (1);
+    }
+
+  compile_file (file);
+
+  g_hash_table_insert (file_hash, file->path, file);
+  files = g_list_append (files, file);
+
+  return file;
+}
+
+static void
+scanner_msg (GScanner *scanner,
+	     gchar    *message,
+	     gboolean  error)
+{
+  /* GTK+ reports these when it parses the file */
+}
+
+static GSList *
+find_includes (File *file)
+{
+  GScanner *scanner;
+  GSList *includes = NULL;
+  gint depth = 0;
+  GTokenType token;
+
+  scanner = g_scanner_new (&scanner_config);
+  scanner->msg_handler = scanner_msg;
+  g_scanner_input_text (scanner, file->contents, file->length);
+
+  while ((token = g_scanner_get_next_token (scanner)) != G_TOKEN_EOF)
+    {
+      if (token == G_TOKEN_LEFT_CURLY)
+	depth++;
+      else if (token == G_TOKEN_RIGHT_CURLY)
+	depth = MAX (depth - 1, 0);
+      else if (depth == 0 &&
+	       token == G_TOKEN_IDENTIFIER &&
+	       strcmp (scanner->value.v_identifier, "include") == 0 &&
+	       g_scanner_peek_next_token (scanner) == G_TOKEN_STRING)
+	{
+	  g_scanner_get_next_token (scanner);
+	  includes = g_slist_prepend (includes, g_strdup (scanner->value.v_string));
+	}
+    }
+
+  g_scanner_destroy (scanner);
+
+  return g_slist_reverse (includes);
+}
+
+/* Compiling the statements of a file, following gtk_rc_parse_statement()
+ * and the functions it calls.  A compile_ function returns FALSE where
+ * the parser would stop at an error, and for what the compiler doesn't
+ * know; GTK+ then parses the file from the statement it was compiling.
+ */
+typedef struct
+{
+  GScanner *scanner;
+  File *file;
+
+  /* Where the input was before the token that was peeked */
+  guint32 peek_offset;
+  guint peek_line;
+} Compiler;
+
+static void
+emit (Compiler *compiler,
+      guint32   n)
+{
+  guint8 is_string = FALSE;
+
+  g_array_append_val (compiler->file->code, n);
+  g_byte_array_append (compiler->file->is_string, &is_string, 1);
+}
+
+/* The string is stored as its offset among the strings, plus 1 */
+static void
+emit_string (Compiler    *compiler,
+	     const gchar *string)
+{
+  guint8 is_string = TRUE;
+  guint32 n = 0;
+
+  if (string)
+    {
+      n = GPOINTER_TO_UINT (g_hash_table_lookup (string_hash, string));
+      if (n == 0)
+	{
+	  gchar *copy = g_strdup (string);
+
+	  n = strings_size + 1;
+	  strings_size += ALIGN_VALUE (strlen (copy) + 1, 4);
+
+	  g_ptr_array_add (strings, copy);
+	  g_hash_table_insert (string_hash, copy, GUINT_TO_POINTER (n));
+	}
+    }
+
+  g_array_append_val (compiler->file->code, n);
+  g_byte_array_append (compiler->file->is_string, &is_string, 1);
+}
+
+static guint
+get_mark (Compiler *compiler)
+{
+  return compiler->file->code->len;
+}
+
+static void
+rewind_to_mark (Compiler *compiler,
+		guint     mark)
+{
+  g_array_set_size (compiler->file->code, mark);
+  g_byte_array_set_size (compiler->file->is_string, mark);
+}
+
+static void
+patch (Compiler *compiler,
+       guint     mark,
+       guint32   n)
+{
+  g_array_index (compiler->file->code, guint32, mark) = n;
+}
+
+static guint
+peek (Compiler *compiler)
+{
+  GScanner *scanner = compiler->scanner;
+
+  if (scanner->next_token == G_TOKEN_NONE)
+    {
+      compiler->peek_offset = scanner->text - compiler->file->contents;
+      compiler->peek_line = scanner->line;
+    }
+
+  return g_scanner_peek_next_token (scanner);
+}
+
+static guint
+get (Compiler *compiler)
+{
+  return g_scanner_get_next_token (compiler->scanner);
+}
+
+/* Where the tokens read so far end */
+static void
+get_position (Compiler *compiler,
+	      guint32  *offset,
+	      guint    *line)
+{
+  GScanner *scanner = compiler->scanner;
+
+  if (scanner->next_token == G_TOKEN_NONE)
+    {
+      *offset = scanner->text - compiler->file->contents;
+      *line = scanner->line;
+    }
+  else
+    {
+      *offset = compiler->peek_offset;
+      *line = compiler->peek_line;
+    }
+}
+
+/* Where the peeked token starts, if it is a keyword or an identifier;
+ * otherwise where the tokens before it end.
+ */
+static void
+get_token_start (Compiler *compiler,
+		 guint32  *offset,
+		 guint    *line)
+{
+  GScanner *scanner = compiler->scanner;
+  const gchar *name = NULL;
+  guint i;
+
+  if (scanner->next_token == G_TOKEN_IDENTIFIER)
+    name = scanner->next_value.v_identifier;
+  else
+    for (i = 0; i < G_N_ELEMENTS (symbols); i++)
+      if ((guint) scanner->next_token == symbols[i].token)
+	name = symbols[i].name;
+
+  if (name)
+    {
+      *offset = scanner->text - compiler->file->contents - strlen (name);
+      *line = scanner->next_line;
+    }
+  else
+    get_position (compiler, offset, line);
+}
+
+/* A statement from @offset to the current position that GTK+ parses */
+static void
+emit_source (Compiler *compiler,
+	     guint32   offset,
+	     guint     line)
+{
+  guint32 end;
+  guint end_line;
+
+  get_position (compiler, &end, &end_line);
+
+  emit (compiler, GTK_RC_CACHE_SOURCE);
+  emit (compiler, offset);
+  emit (compiler, line);
+  emit (compiler, end);
+}
+
+static void
+emit_item_source (Compiler *compiler,
+		  guint32   offset,
+		  guint     line)
+{
+  guint32 end;
+  guint end_line;
+
+  get_position (compiler, &end, &end_line);
+
+  emit (compiler, GTK_RC_CACHE_ITEM_SOURCE);
+  emit (compiler, line);
+  emit (compiler, offset);
+  emit (compiler, end);
+}
+
+static gboolean
+is_c_identifier (const gchar *string)
+{
+  const gchar *p;
+  gboolean is_varname;
+
+  is_varname = strchr ("_" G_CSET_a_2_z G_CSET_A_2_Z, string[0]) != NULL;
+  for (p = string + 1; *p && is_varname; p++)
+    is_varname &= strchr (G_CSET_DIGITS "-_" G_CSET_a_2_z G_CSET_A_2_Z, *p) != NULL;
+
+  return is_varname;
+}
+
+/* Skips a block in curly braces, for the code that parses it in GTK+ */
+static gboolean
+skip_block (Compiler *compiler)
+{
+  guint token;
+  gint depth = 1;
+
+  if (get (compiler) != G_TOKEN_LEFT_CURLY)
+    return FALSE;
+
+  while (depth > 0)
+    {
+      token = get (compiler);
+
+      if (token == G_TOKEN_EOF || token == G_TOKEN_ERROR)
+	return FALSE;
+      else if (token == G_TOKEN_LEFT_CURLY)
+	depth++;
+      else if (token == G_TOKEN_RIGHT_CURLY)
+	depth--;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+get_state (guint    token,
+	   guint32 *state)
+{
+  switch (token)
+    {
+    case TOKEN_ACTIVE:
+      *state = GTK_STATE_ACTIVE;
+      return TRUE;
+    case TOKEN_INSENSITIVE:
+      *state = GTK_STATE_INSENSITIVE;
+      return TRUE;
+    case TOKEN_NORMAL:
+      *state = GTK_STATE_NORMAL;
+      return TRUE;
+    case TOKEN_PRELIGHT:
+      *state = GTK_STATE_PRELIGHT;
+      return TRUE;
+    case TOKEN_SELECTED:
+      *state = GTK_STATE_SELECTED;
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+/* Follows gtk_rc_parse_state() */
+static gboolean
+compile_state (Compiler *compiler,
+	       guint32  *state)
+{
+  return (get (compiler) == G_TOKEN_LEFT_BRACE &&
+	  get_state (get (compiler), state) &&
+	  get (compiler) == G_TOKEN_RIGHT_BRACE);
+}
+
+/* Follows gtk_rc_parse_priority() */
+static gboolean
+compile_priority (Compiler *compiler,
+		  guint32  *priority)
+{
+  if (get (compiler) != ':')
+    return FALSE;
+
+  switch (get (compiler))
+    {
+    case TOKEN_LOWEST:
+      *priority = GTK_PATH_PRIO_LOWEST;
+      break;
+    case TOKEN_GTK:
+      *priority = GTK_PATH_PRIO_GTK;
+      break;
+    case TOKEN_APPLICATION:
+      *priority = GTK_PATH_PRIO_APPLICATION;
+      break;
+    case TOKEN_THEME:
+      *priority = GTK_PATH_PRIO_THEME;
+      break;
+    case TOKEN_RC:
+      *priority = GTK_PATH_PRIO_RC;
+      break;
+    case TOKEN_HIGHEST:
+      *priority = GTK_PATH_PRIO_HIGHEST;
+      break;
+    default:
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Follows gtk_rc_parse_hash_key() */
+static gboolean
+compile_hash_key (Compiler *compiler)
+{
+  if (get (compiler) != G_TOKEN_LEFT_BRACE ||
+      get (compiler) != G_TOKEN_STRING)
+    return FALSE;
+
+  emit_string (compiler, compiler->scanner->value.v_string);
+
+  return get (compiler) == G_TOKEN_RIGHT_BRACE;
+}
+
+/* The factor of mix() and shade(), as a string that reads back to
+ * exactly the same number.
+ */
+static gboolean
+compile_factor (Compiler *compiler)
+{
+  gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
+  gboolean negate = FALSE;
+  gdouble l;
+
+  if (peek (compiler) == '-')
+    {
+      get (compiler);
+      negate = TRUE;
+    }
+
+  if (get (compiler) != G_TOKEN_FLOAT)
+    return FALSE;
+
+  l = compiler->scanner->value.v_float;
+  emit_string (compiler, g_ascii_dtostr (buffer, sizeof (buffer), negate ? -l : l));
+
+  return TRUE;
+}
+
+/* Follows gtk_rc_parse_color_full() */
+static gboolean
+compile_color (Compiler *compiler)
+{
+  GScanner *scanner = compiler->scanner;
+  guint token;
+  gint token_int;
+  gint i;
+
+  switch (get (compiler))
+    {
+    case G_TOKEN_LEFT_CURLY:
+      emit (compiler, GTK_RC_CACHE_COLOR_RGB);
+
+      for (i = 0; i < 3; i++)
+	{
+	  if (i > 0 && get (compiler) != G_TOKEN_COMMA)
+	    return FALSE;
+
+	  token = get (compiler);
+	  if (token == G_TOKEN_INT)
+	    token_int = scanner->value.v_int;
+	  else if (token == G_TOKEN_FLOAT)
+	    token_int = scanner->value.v_float * 65535.0;
+	  else
+	    return FALSE;
+
+	  emit (compiler, CLAMP (token_int, 0, 65535));
+	}
+
+      return get (compiler) == G_TOKEN_RIGHT_CURLY;
+
+    case G_TOKEN_STRING:
+      emit (compiler, GTK_RC_CACHE_COLOR_NAME);
+      emit_string (compiler, scanner->value.v_string);
+      return TRUE;
+
+    case '@':
+      if (get (compiler) != G_TOKEN_IDENTIFIER)
+	return FALSE;
+
+      emit (compiler, GTK_RC_CACHE_COLOR_SYMBOLIC);
+      emit_string (compiler, scanner->value.v_identifier);
+      return TRUE;
+
+    case G_TOKEN_IDENTIFIER:
+      if (strcmp (scanner->value.v_identifier, "mix") == 0)
+	{
+	  emit (compiler, GTK_RC_CACHE_COLOR_MIX);
+
+	  return (get (compiler) == G_TOKEN_LEFT_PAREN &&
+		  compile_factor (compiler) &&
+		  get (compiler) == G_TOKEN_COMMA &&
+		  compile_color (compiler) &&
+		  get (compiler) == G_TOKEN_COMMA &&
+		  compile_color (compiler) &&
+		  get (compiler) == G_TOKEN_RIGHT_PAREN);
+	}
+      else if (strcmp (scanner->value.v_identifier, "shade") == 0)
+	{
+	  emit (compiler, GTK_RC_CACHE_COLOR_SHADE);
+
+	  return (get (compiler) == G_TOKEN_LEFT_PAREN &&
+		  compile_factor (compiler) &&
+		  get (compiler) == G_TOKEN_COMMA &&
+		  compile_color (compiler) &&
+		  get (compiler) == G_TOKEN_RIGHT_PAREN);
+	}
+      else if (strcmp (scanner->value.v_identifier, "lighter") == 0 ||
+	       strcmp (scanner->value.v_identifier, "darker") == 0)
+	{
+	  emit (compiler, GTK_RC_CACHE_COLOR_SHADE);
+	  emit_string (compiler, scanner->value.v_identifier[0] == 'l' ? "1.3" : "0.7");
+
+	  return (get (compiler) == G_TOKEN_LEFT_PAREN &&
+		  compile_color (compiler) &&
+		  get (compiler) == G_TOKEN_RIGHT_PAREN);
+	}
+      else
+	return FALSE;
+
+    default:
+      return FALSE;
+    }
+}
+
+/* Follows rc_parse_token_or_compound().  Floats are formatted for the
+ * locale of the program, and symbolic colors depend on the style, so
+ * compounds with either are left for GTK+ to parse.
+ */
+static gboolean
+compile_compound (Compiler   *compiler,
+		  gboolean    in_style,
+		  GString    *gstring,
+		  guint       delimiter,
+		  gboolean   *needs_source)
+{
+  GScanner *scanner = compiler->scanner;
+  guint token;
+  gchar *string;
+
+  do
+    {
+      token = get (compiler);
+
+      switch (token)
+	{
+	case G_TOKEN_INT:
+	  g_string_append_printf (gstring, " 0x%lx", scanner->value.v_int);
+	  break;
+	case G_TOKEN_FLOAT:
+	  *needs_source = TRUE;
+	  break;
+	case G_TOKEN_STRING:
+	  string = g_strescape (scanner->value.v_string, NULL);
+	  g_string_append (gstring, " \"");
+	  g_string_append (gstring, string);
+	  g_string_append_c (gstring, '"');
+	  g_free (string);
+	  break;
+	case G_TOKEN_IDENTIFIER:
+	  g_string_append_c (gstring, ' ');
+	  g_string_append (gstring, scanner->value.v_identifier);
+	  break;
+	case G_TOKEN_LEFT_PAREN:
+	case G_TOKEN_LEFT_CURLY:
+	case G_TOKEN_LEFT_BRACE:
+	  g_string_append_c (gstring, ' ');
+	  g_string_append_c (gstring, token);
+	  if (!compile_compound (compiler, in_style, gstring,
+				 token == G_TOKEN_LEFT_PAREN ? G_TOKEN_RIGHT_PAREN :
+				 token == G_TOKEN_LEFT_CURLY ? G_TOKEN_RIGHT_CURLY :
+				 G_TOKEN_RIGHT_BRACE,
+				 needs_source))
+	    return FALSE;
+	  break;
+	case '@':
+	  if (!in_style || peek (compiler) != G_TOKEN_IDENTIFIER)
+	    return FALSE;
+
+	  get (compiler);
+	  *needs_source = TRUE;
+	  break;
+	default:
+	  if (token >= 256 || token < 1)
+	    return FALSE;
+	  g_string_append_c (gstring, ' ');
+	  g_string_append_c (gstring, token);
+	  if (token == delimiter)
+	    return TRUE;
+	  break;
+	}
+    }
+  while (delimiter);
+
+  return TRUE;
+}
+
+/* Follows gtk_rc_parse_assignment(); @line is set to the line that
+ * GTK+ records as the origin of the value.
+ */
+static gboolean
+compile_value (Compiler *compiler,
+	       gboolean  in_style,
+	       guint    *line,
+	       gboolean *needs_source)
+{
+  GScanner *scanner = compiler->scanner;
+  gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
+  gboolean negate = FALSE;
+  gboolean is_color = FALSE;
+  gboolean retval = FALSE;
+  GString *gstring;
+  guint token;
+
+  *needs_source = FALSE;
+
+  if (get (compiler) != G_TOKEN_EQUAL_SIGN)
+    return FALSE;
+
+  /* The only setting gtk_rc_parse_assignment() changes from ours */
+  scanner->config->scan_symbols = FALSE;
+
+  *line = scanner->line;
+
+  if (peek (compiler) == '@')
+    {
+      get (compiler);
+      is_color = TRUE;
+    }
+
+  if (!is_color && peek (compiler) == '-')
+    {
+      get (compiler);
+      negate = TRUE;
+    }
+
+  token = peek (compiler);
+
+  if (is_color && token != G_TOKEN_IDENTIFIER)
+    goto out;
+
+  switch (token)
+    {
+    case G_TOKEN_INT:
+      get (compiler);
+
+      /* A long may not fit into the cache */
+      if (scanner->value.v_int > G_MAXINT32)
+	*needs_source = TRUE;
+      else
+	{
+	  gint32 n = scanner->value.v_int;
+
+	  emit (compiler, GTK_RC_CACHE_VALUE_LONG);
+	  emit (compiler, negate ? -n : n);
+	}
+      retval = TRUE;
+      break;
+    case G_TOKEN_FLOAT:
+      get (compiler);
+      emit (compiler, GTK_RC_CACHE_VALUE_DOUBLE);
+      emit_string (compiler, g_ascii_dtostr (buffer, sizeof (buffer),
+					     negate ? -scanner->value.v_float : scanner->value.v_float));
+      retval = TRUE;
+      break;
+    case G_TOKEN_STRING:
+      get (compiler);
+      if (!negate)
+	{
+	  emit (compiler, GTK_RC_CACHE_VALUE_STRING);
+	  emit_string (compiler, scanner->value.v_string);
+	  retval = TRUE;
+	}
+      break;
+    case G_TOKEN_IDENTIFIER:
+      if (is_color)
+	{
+	  get (compiler);
+	  *needs_source = TRUE;
+	  retval = in_style;
+	  break;
+	}
+      /* fall through */
+    case G_TOKEN_LEFT_PAREN:
+    case G_TOKEN_LEFT_CURLY:
+    case G_TOKEN_LEFT_BRACE:
+      if (negate)
+	break;
+
+      gstring = g_string_new (NULL);
+      retval = TRUE;
+
+      if (token == G_TOKEN_IDENTIFIER)
+	{
+	  get (compiler);
+
+	  g_string_append_c (gstring, ' ');
+	  g_string_append (gstring, scanner->value.v_identifier);
+
+	  /* Peeked with the default settings, as GTK+ does */
+	  scanner->config->scan_symbols = TRUE;
+	  token = peek (compiler);
+	  scanner->config->scan_symbols = FALSE;
+
+	  if (token == G_TOKEN_LEFT_PAREN)
+	    retval = compile_compound (compiler, in_style, gstring, 0, needs_source);
+	}
+      else
+	retval = compile_compound (compiler, in_style, gstring, 0, needs_source);
+
+      if (retval && !*needs_source)
+	{
+	  g_string_append_c (gstring, ' ');
+	  emit (compiler, GTK_RC_CACHE_VALUE_GSTRING);
+	  emit_string (compiler, gstring->str);
+	}
+
+      g_string_free (gstring, TRUE);
+      break;
+    default:
+      break;
+    }
+
+ out:
+  scanner->config->scan_symbols = TRUE;
+
+  return retval;
+}
+
+/* Follows gtk_rc_parse_icon_source() */
+static gboolean
+compile_icon_source (Compiler *compiler)
+{
+  GScanner *scanner = compiler->scanner;
+  guint32 direction = GTK_RC_CACHE_ANY;
+  guint32 state = GTK_RC_CACHE_ANY;
+  gchar *name, *size = NULL;
+  gboolean is_icon_name = FALSE;
+  gboolean retval = FALSE;
+  guint token;
+  guint line;
+
+  if (get (compiler) != G_TOKEN_LEFT_CURLY)
+    return FALSE;
+
+  token = get (compiler);
+  if (token == '@')
+    {
+      is_icon_name = TRUE;
+      token = get (compiler);
+    }
+
+  if (token != G_TOKEN_STRING)
+    return FALSE;
+
+  name = g_strdup (scanner->value.v_string);
+  line = scanner->line;
+
+  token = get (compiler);
+
+  if (token == G_TOKEN_COMMA)
+    {
+      switch (get (compiler))
+	{
+	case TOKEN_RTL:
+	  direction = GTK_TEXT_DIR_RTL;
+	  break;
+	case TOKEN_LTR:
+	  direction = GTK_TEXT_DIR_LTR;
+	  break;
+	case '*':
+	  break;
+	default:
+	  goto out;
+	}
+
+      token = get (compiler);
+    }
+
+  if (token == G_TOKEN_COMMA)
+    {
+      token = get (compiler);
+      if (token != '*' && !get_state (token, &state))
+	goto out;
+
+      token = get (compiler);
+    }
+
+  if (token == G_TOKEN_COMMA)
+    {
+      token = get (compiler);
+      if (token == G_TOKEN_STRING)
+	size = g_strdup (scanner->value.v_string);
+      else if (token != '*')
+	goto out;
+
+      token = get (compiler);
+    }
+
+  if (token != G_TOKEN_RIGHT_CURLY)
+    goto out;
+
+  emit (compiler, line);
+  emit (compiler, is_icon_name);
+  emit_string (compiler, name);
+  emit (compiler, direction);
+  emit (compiler, state);
+  emit_string (compiler, size);
+
+  retval = TRUE;
+
+ out:
+  g_free (name);
+  g_free (size);
+
+  return retval;
+}
+
+/* Follows gtk_rc_parse_style_body() */
+static gboolean
+compile_style_body (Compiler *compiler)
+{
+  GScanner *scanner = compiler->scanner;
+  guint token;
+  guint32 offset, state, n_sources;
+  guint line, value_line, mark;
+  gboolean needs_source;
+  gchar *name;
+
+  token = peek (compiler);
+  while (token != G_TOKEN_RIGHT_CURLY && token != G_TOKEN_EOF)
+    {
+      get_token_start (compiler, &offset, &line);
+      mark = get_mark (compiler);
+
+      switch (token)
+	{
+	case TOKEN_FG:
+	case TOKEN_BG:
+	case TOKEN_TEXT:
+	case TOKEN_BASE:
+	  get (compiler);
+	  if (!compile_state (compiler, &state) ||
+	      get (compiler) != G_TOKEN_EQUAL_SIGN)
+	    return FALSE;
+
+	  emit (compiler,
+		token == TOKEN_FG ? GTK_RC_CACHE_ITEM_FG :
+		token == TOKEN_BG ? GTK_RC_CACHE_ITEM_BG :
+		token == TOKEN_TEXT ? GTK_RC_CACHE_ITEM_TEXT :
+		GTK_RC_CACHE_ITEM_BASE);
+	  emit (compiler, line);
+	  emit (compiler, state);
+	  if (!compile_color (compiler))
+	    return FALSE;
+	  break;
+
+	case TOKEN_XTHICKNESS:
+	case TOKEN_YTHICKNESS:
+	  get (compiler);
+	  if (get (compiler) != G_TOKEN_EQUAL_SIGN ||
+	      get (compiler) != G_TOKEN_INT)
+	    return FALSE;
+
+	  emit (compiler, token == TOKEN_XTHICKNESS ?
+		GTK_RC_CACHE_ITEM_XTHICKNESS : GTK_RC_CACHE_ITEM_YTHICKNESS);
+	  emit (compiler, line);
+	  emit (compiler, scanner->value.v_int);
+	  break;
+
+	case TOKEN_BG_PIXMAP:
+	  get (compiler);
+	  if (!compile_state (compiler, &state) ||
+	      get (compiler) != G_TOKEN_EQUAL_SIGN ||
+	      get (compiler) != G_TOKEN_STRING)
+	    return FALSE;
+
+	  /* The line the pixmap is reported missing at */
+	  emit (compiler, GTK_RC_CACHE_ITEM_BG_PIXMAP);
+	  emit (compiler, scanner->line);
+	  emit (compiler, state);
+	  emit_string (compiler, scanner->value.v_string);
+	  break;
+
+	case TOKEN_FONT:
+	case TOKEN_FONTSET:
+	  /* Ignored */
+	  get (compiler);
+	  if (get (compiler) != G_TOKEN_EQUAL_SIGN ||
+	      get (compiler) != G_TOKEN_STRING)
+	    return FALSE;
+	  break;
+
+	case TOKEN_FONT_NAME:
+	  get (compiler);
+	  if (get (compiler) != G_TOKEN_EQUAL_SIGN ||
+	      get (compiler) != G_TOKEN_STRING)
+	    return FALSE;
+
+	  emit (compiler, GTK_RC_CACHE_ITEM_FONT_NAME);
+	  emit (compiler, line);
+	  emit_string (compiler, scanner->value.v_string);
+	  break;
+
+	case TOKEN_ENGINE:
+	  /* Parsed by the engine */
+	  get (compiler);
+	  if (get (compiler) != G_TOKEN_STRING ||
+	      !skip_block (compiler))
+	    return FALSE;
+
+	  emit_item_source (compiler, offset, line);
+	  break;
+
+	case TOKEN_STOCK:
+	  get (compiler);
+	  emit (compiler, GTK_RC_CACHE_ITEM_STOCK);
+	  emit (compiler, line);
+	  if (!compile_hash_key (compiler) ||
+	      get (compiler) != G_TOKEN_EQUAL_SIGN ||
+	      get (compiler) != G_TOKEN_LEFT_CURLY ||
+	      peek (compiler) == G_TOKEN_RIGHT_CURLY)
+	    return FALSE;
+
+	  mark = get_mark (compiler);
+	  emit (compiler, 0);
+
+	  n_sources = 0;
+	  do
+	    {
+	      if (!compile_icon_source (compiler))
+		return FALSE;
+	      n_sources++;
+
+	      token = get (compiler);
+	    }
+	  while (token == G_TOKEN_COMMA);
+
+	  if (token != G_TOKEN_RIGHT_CURLY)
+	    return FALSE;
+
+	  patch (compiler, mark, n_sources);
+	  break;
+
+	case TOKEN_COLOR:
+	  get (compiler);
+	  emit (compiler, GTK_RC_CACHE_ITEM_COLOR);
+	  emit (compiler, line);
+	  if (!compile_hash_key (compiler) ||
+	      get (compiler) != G_TOKEN_EQUAL_SIGN ||
+	      !compile_color (compiler))
+	    return FALSE;
+	  break;
+
+	case G_TOKEN_IDENTIFIER:
+	  if (!is_c_identifier (scanner->next_value.v_identifier) ||
+	      scanner->next_value.v_identifier[0] < 'A' ||
+	      scanner->next_value.v_identifier[0] > 'Z')
+	    return FALSE;
+
+	  get (compiler);
+	  emit (compiler, GTK_RC_CACHE_ITEM_PROPERTY);
+	  emit (compiler, 0);
+	  emit_string (compiler, scanner->value.v_identifier);
+
+	  if (get (compiler) != ':' ||
+	      get (compiler) != ':' ||
+	      get (compiler) != G_TOKEN_IDENTIFIER ||
+	      !is_c_identifier (scanner->value.v_identifier))
+	    return FALSE;
+
+	  name = g_strdup (scanner->value.v_identifier);
+	  g_strcanon (name, G_CSET_DIGITS "-" G_CSET_a_2_z G_CSET_A_2_Z, '-');
+	  emit_string (compiler, name);
+	  g_free (name);
+
+	  if (!compile_value (compiler, TRUE, &value_line, &needs_source))
+	    return FALSE;
+
+	  if (needs_source)
+	    {
+	      rewind_to_mark (compiler, mark);
+	      emit_item_source (compiler, offset, line);
+	    }
+	  else
+	    patch (compiler, mark + 1, value_line);
+	  break;
+
+	default:
+	  return FALSE;
+	}
+
+      token = peek (compiler);
+    }
+
+  return TRUE;
+}
+
+/* Follows gtk_rc_parse_statement() */
+static gboolean
+compile_statement (Compiler *compiler)
+{
+  GScanner *scanner = compiler->scanner;
+  guint token;
+  guint32 offset, path_type, priority;
+  guint line, value_line, mark;
+  gboolean needs_source;
+  gchar *name;
+
+  token = peek (compiler);
+  get_token_start (compiler, &offset, &line);
+  mark = get_mark (compiler);
+
+  switch (token)
+    {
+    case TOKEN_INCLUDE:
+    case TOKEN_PIXMAP_PATH:
+      get (compiler);
+      if (get (compiler) != G_TOKEN_STRING)
+	return FALSE;
+
+      emit (compiler, token == TOKEN_INCLUDE ?
+	    GTK_RC_CACHE_INCLUDE : GTK_RC_CACHE_PIXMAP_PATH);
+      emit (compiler, offset);
+      emit (compiler, line);
+      emit_string (compiler, scanner->value.v_string);
+      return TRUE;
+
+    case TOKEN_STYLE:
+      get (compiler);
+      if (get (compiler) != G_TOKEN_STRING)
+	return FALSE;
+
+      emit (compiler, GTK_RC_CACHE_STYLE);
+      emit (compiler, offset);
+      emit (compiler, line);
+      emit_string (compiler, scanner->value.v_string);
+
+      if (peek (compiler) == G_TOKEN_EQUAL_SIGN)
+	{
+	  get (compiler);
+	  if (get (compiler) != G_TOKEN_STRING)
+	    return FALSE;
+
+	  emit_string (compiler, scanner->value.v_string);
+	}
+      else
+	emit_string (compiler, NULL);
+
+      if (get (compiler) != G_TOKEN_LEFT_CURLY ||
+	  !compile_style_body (compiler) ||
+	  get (compiler) != G_TOKEN_RIGHT_CURLY)
+	return FALSE;
+
+      emit (compiler, GTK_RC_CACHE_ITEM_END);
+      emit (compiler, scanner->line);
+      return TRUE;
+
+    case TOKEN_WIDGET:
+    case TOKEN_WIDGET_CLASS:
+    case TOKEN_CLASS:
+      if (token == TOKEN_WIDGET)
+	path_type = GTK_PATH_WIDGET;
+      else if (token == TOKEN_WIDGET_CLASS)
+	path_type = GTK_PATH_WIDGET_CLASS;
+      else
+	path_type = GTK_PATH_CLASS;
+
+      get (compiler);
+      if (get (compiler) != G_TOKEN_STRING)
+	return FALSE;
+
+      emit (compiler, GTK_RC_CACHE_SET);
+      emit (compiler, offset);
+      emit (compiler, line);
+      emit (compiler, path_type);
+      emit (compiler, GTK_RC_CACHE_ANY);
+      emit_string (compiler, scanner->value.v_string);
+
+      token = get (compiler);
+      if (token != TOKEN_STYLE && token != TOKEN_BINDING)
+	return FALSE;
+
+      if (peek (compiler) == ':')
+	{
+	  if (!compile_priority (compiler, &priority))
+	    return FALSE;
+
+	  patch (compiler, mark + 4, priority);
+	}
+
+      if (get (compiler) != G_TOKEN_STRING)
+	return FALSE;
+
+      if (token == TOKEN_BINDING)
+	{
+	  /* Binding sets are parsed by gtkbindings.c */
+	  rewind_to_mark (compiler, mark);
+	  emit_source (compiler, offset, line);
+	}
+      else
+	emit_string (compiler, scanner->value.v_string);
+      return TRUE;
+
+    case TOKEN_BINDING:
+      get (compiler);
+      if (get (compiler) != G_TOKEN_STRING ||
+	  !skip_block (compiler))
+	return FALSE;
+
+      emit_source (compiler, offset, line);
+      return TRUE;
+
+    case TOKEN_MODULE_PATH:
+    case TOKEN_IM_MODULE_FILE:
+      get (compiler);
+      if (get (compiler) != G_TOKEN_STRING)
+	return FALSE;
+
+      emit_source (compiler, offset, line);
+      return TRUE;
+
+    case G_TOKEN_IDENTIFIER:
+      if (!is_c_identifier (scanner->next_value.v_identifier))
+	return FALSE;
+
+      get (compiler);
+
+      name = g_strdup (scanner->value.v_identifier);
+      g_strcanon (name, G_CSET_DIGITS "-" G_CSET_a_2_z G_CSET_A_2_Z, '-');
+
+      emit (compiler, GTK_RC_CACHE_SETTING);
+      emit (compiler, offset);
+      emit (compiler, line);
+      emit_string (compiler, name);
+      emit (compiler, 0);
+
+      g_free (name);
+
+      if (!compile_value (compiler, FALSE, &value_line, &needs_source))
+	return FALSE;
+
+      if (needs_source)
+	{
+	  rewind_to_mark (compiler, mark);
+	  emit_source (compiler, offset, line);
+	}
+      else
+	patch (compiler, mark + 4, value_line);
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+static void
+compile_file (File *file)
+{
+  Compiler compiler;
+  GScanner *scanner;
+  guint32 offset;
+  guint line, mark;
+  guint i;
+
+  file->code = g_array_new (FALSE, FALSE, sizeof (guint32));
+  file->is_string = g_byte_array_new ();
+
+  scanner = g_scanner_new (&scanner_config);
+  scanner->msg_handler = scanner_msg;
+  for (i = 0; i < G_N_ELEMENTS (symbols); i++)
+    g_scanner_scope_add_symbol (scanner, 0, symbols[i].name,
+				GUINT_TO_POINTER (symbols[i].token));
+  g_scanner_input_text (scanner, file->contents, file->length);
+
+  compiler.scanner = scanner;
+  compiler.file = file;
+
+  while (TRUE)
+    {
+      /* Including what is skipped before the next token */
+      get_position (&compiler, &offset, &line);
+
+      if (peek (&compiler) == G_TOKEN_EOF)
+	break;
+
+      mark = get_mark (&compiler);
+      if (!compile_statement (&compiler))
+	{
+	  /* GTK+ parses the rest, and reports an error if there is one */
+	  rewind_to_mark (&compiler, mark);
+	  emit (&compiler, GTK_RC_CACHE_SOURCE);
+	  emit (&compiler, offset);
+	  emit (&compiler, line);
+	  emit (&compiler, file->length);
+
+	  offset = file->length;
+	  break;
+	}
+    }
+
+  emit (&compiler, GTK_RC_CACHE_END);
+  emit (&compiler, offset);
+  emit (&compiler, line);
+
+  g_scanner_destroy (scanner);
+}
+
+/* Follows gtk_rc_context_parse_one_file() and parse_include_file() */
+static void
+parse_one_file (const gchar *filename,
+		GSList      *stack)
+{
+  File *file;
+  GSList *includes, *l;
+
+  if (g_slist_find_custom (stack, filename, (GCompareFunc) strcmp))
+    return;
+
+  if (!file_exists (filename))
+    return;
+
+  file = add_file (filename);
+  stack = g_slist_prepend (stack, file->path);
+
+  includes = find_includes (file);
+  for (l = includes; l; l = l->next)
+    {
+      gchar *include = l->data;
+      GSList *s;
+
+      if (g_path_is_absolute (include))
+	{
+	  parse_file (include, stack);
+	  continue;
+	}
+
+      /* Relative includes are looked for next to each of the files
+       * being parsed, innermost first.
+       */
+      for (s = stack; s; s = s->next)
+	{
+	  gchar *dirname = g_path_get_dirname (s->data);
+	  gchar *tmpname = g_build_filename (dirname, include, NULL);
+	  gboolean found;
+
+	  found = file_exists (tmpname);
+	  if (found)
+	    parse_file (tmpname, stack);
+
+	  g_free (tmpname);
+	  g_free (dirname);
+
+	  if (found)
+	    break;
+	}
+    }
+
+  g_slist_foreach (includes, (GFunc) g_free, NULL);
+  g_slist_free (includes);
+
+  g_slist_free_1 (stack);
+}
+
+/* Follows gtk_rc_context_parse_file().  GTK+ picks a variant for the
+ * current locale, so every FILE.suffix that could be one is added.
+ */
+static void
+parse_file (const gchar *filename,
+	    GSList      *stack)
+{
+  gchar *dirname, *basename, *cache_name;
+  GDir *dir;
+  const gchar *name;
+  gsize len;
+
+  parse_one_file (filename, stack);
+
+  dirname = g_path_get_dirname (filename);
+  basename = g_path_get_basename (filename);
+  cache_name = g_strconcat (basename, ".cache", NULL);
+  len = strlen (basename);
+
+  dir = g_dir_open (dirname, 0, NULL);
+  if (dir)
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+	{
+	  gchar *variant;
+
+	  if (strncmp (name, basename, len) != 0 ||
+	      name[len] != '.' || name[len + 1] == '\0' ||
+	      strchr (name + len + 1, '.') != NULL ||
+	      strcmp (name, cache_name) == 0)
+	    continue;
+
+	  variant = g_strconcat (filename, name + len, NULL);
+	  if (g_file_test (variant, G_FILE_TEST_IS_REGULAR))
+	    parse_one_file (variant, stack);
+	  g_free (variant);
+	}
+
+      g_dir_close (dir);
+    }
+
+  g_free (cache_name);
+  g_free (basename);
+  g_free (dirname);
+}
+
+static gboolean
+write_card16 (FILE *cache, guint16 n)
+{
+  int i;
+
+  n = GUINT16_TO_BE (n);
+
+  i = fwrite ((char *)&n, 2, 1, cache);
+
+  return i == 1;
+}
+
+static gboolean
+write_card32 (FILE *cache, guint32 n)
+{
+  int i;
+
+  n = GUINT32_TO_BE (n);
+
+  i = fwrite ((char *)&n, 4, 1, cache);
+
+  return i == 1;
+}
+
+/* Writes @length bytes of @data, nul-terminated and padded to 4 bytes */
+static gboolean
+write_data (FILE *cache, const gchar *data, gsize length)
+{
+  static const gchar padding[4] = { 0, 0, 0, 0 };
+  gsize l;
+
+  l = ALIGN_VALUE (length + 1, 4);
+
+  return ((length == 0 || fwrite (data, length, 1, cache) == 1) &&
+	  fwrite (padding, l - length, 1, cache) == 1);
+}
+
+static gboolean
+write_cache (FILE *cache)
+{
+  GList *l;
+  guint32 offset, strings_offset, code_offset;
+  guint32 n_dirs, n_files;
+  guint i;
+
+  n_dirs = g_list_length (directories);
+  n_files = g_list_length (files);
+
+  if (!write_card16 (cache, MAJOR_VERSION) ||
+      !write_card16 (cache, MINOR_VERSION) ||
+      !write_card32 (cache, n_dirs) ||
+      !write_card32 (cache, HEADER_SIZE) ||
+      !write_card32 (cache, n_files) ||
+      !write_card32 (cache, HEADER_SIZE + n_dirs * DIR_ENTRY_SIZE))
+    return FALSE;
+
+  /* The paths and contents follow the two lists, in the same order,
+   * then the strings of the compiled statements and the statements.
+   */
+  offset = HEADER_SIZE + n_dirs * DIR_ENTRY_SIZE + n_files * FILE_ENTRY_SIZE;
+
+  strings_offset = offset;
+  for (l = directories; l; l = l->next)
+    {
+      Directory *dir = l->data;
+
+      strings_offset += ALIGN_VALUE (strlen (dir->path) + 1, 4);
+    }
+  for (l = files; l; l = l->next)
+    {
+      File *file = l->data;
+
+      strings_offset += ALIGN_VALUE (strlen (file->path) + 1, 4);
+      strings_offset += ALIGN_VALUE (file->length + 1, 4);
+    }
+
+  code_offset = strings_offset + strings_size;
+
+  for (l = directories; l; l = l->next)
+    {
+      Directory *dir = l->data;
+
+      if (!write_card32 (cache, offset) ||
+	  !write_card32 (cache, dir->mtime) ||
+	  !write_card32 (cache, dir->mtime_nsec))
+	return FALSE;
+
+      offset += ALIGN_VALUE (strlen (dir->path) + 1, 4);
+    }
+
+  for (l = files; l; l = l->next)
+    {
+      File *file = l->data;
+      guint32 path_offset = offset;
+
+      offset += ALIGN_VALUE (strlen (file->path) + 1, 4);
+
+      if (!write_card32 (cache, path_offset) ||
+	  !write_card32 (cache, file->mtime) ||
+	  !write_card32 (cache, file->mtime_nsec) ||
+	  !write_card32 (cache, file->length) ||
+	  !write_card32 (cache, file->link_mtime) ||
+	  !write_card32 (cache, offset) ||
+	  !write_card32 (cache, code_offset))
+	return FALSE;
+
+      offset += ALIGN_VALUE (file->length + 1, 4);
+      code_offset += file->code->len * 4;
+    }
+
+  for (l = directories; l; l = l->next)
+    {
+      Directory *dir = l->data;
+
+      if (!write_data (cache, dir->path, strlen (dir->path)))
+	return FALSE;
+    }
+
+  for (l = files; l; l = l->next)
+    {
+      File *file = l->data;
+
+      if (!write_data (cache, file->path, strlen (file->path)) ||
+	  !write_data (cache, file->contents, file->length))
+	return FALSE;
+    }
+
+  for (i = 0; i < strings->len; i++)
+    {
+      const gchar *string = g_ptr_array_index (strings, i);
+
+      if (!write_data (cache, string, strlen (string)))
+	return FALSE;
+    }
+
+  for (l = files; l; l = l->next)
+    {
+      File *file = l->data;
+
+      for (i = 0; i < file->code->len; i++)
+	{
+	  guint32 n = g_array_index (file->code, guint32, i);
+
+	  if (file->is_string->data[i] && n != 0)
+	    n = strings_offset + n - 1;
+
+	  if (!write_card32 (cache, n))
+	    return FALSE;
+	}
+    }
+
+  return TRUE;
+}
+
+/* Makes sure nothing was added to or removed from the directories while
+ * the files were being read, since only the mtimes from before are
+ * written to the cache.
+ */
+static void
+check_directories (void)
+{
+  GList *l;
+  struct stat st;
+
+  for (l = directories; l; l = l->next)
+    {
+      Directory *dir = l->data;
+
+      if (g_stat (dir->path, &st) < 0 ||
+	  st.st_mtime != dir->mtime || ST_MTIME_NSEC (&st) != dir->mtime_nsec)
+	{
+	  g_printerr (_("Failed to read %s: %s\n"), dir->path,
+		      g_strerror (EAGAIN));
+	  exit (1);
+	}
+    }
+}
+
+/* Creating the cache and moving it into place changes the mtime of the
+ * directory it is in, which may be one of the recorded ones; store the
+ * new mtime in the cache, so that GTK+ can compare them exactly.  A file
+ * added in the same second is only noticed where there are nanoseconds.
+ */
+static gboolean
+update_directory_mtime (const gchar *cache_path,
+			const gchar *dirname)
+{
+  Directory *dir;
+  struct stat st;
+  FILE *cache;
+  gint index;
+  gboolean retval;
+
+  dir = g_hash_table_lookup (directory_hash, dirname);
+  if (!dir)
+    return TRUE;
+
+  if (g_stat (dirname, &st) < 0)
+    return FALSE;
+
+  index = g_list_index (directories, dir);
+
+  /* Writing to the file doesn't touch the directory again */
+  cache = g_fopen (cache_path, "r+b");
+  if (!cache)
+    return FALSE;
+
+  retval = (fseek (cache, HEADER_SIZE + index * DIR_ENTRY_SIZE + 4, SEEK_SET) == 0 &&
+	    write_card32 (cache, st.st_mtime) &&
+	    write_card32 (cache, ST_MTIME_NSEC (&st)));
+  if (fclose (cache) != 0)
+    retval = FALSE;
+
+  if (retval)
+    {
+      dir->mtime = st.st_mtime;
+      dir->mtime_nsec = ST_MTIME_NSEC (&st);
+    }
+
+  return retval;
+}
+
+static void
+build_cache (const gchar *filename)
+{
+  gchar *dirname, *basename;
+  gchar *cache_path, *tmp_cache_path;
+  gboolean retval;
+  FILE *cache;
+
+  directory_hash = g_hash_table_new (g_str_hash, g_str_equal);
+  file_hash = g_hash_table_new (g_str_hash, g_str_equal);
+  string_hash = g_hash_table_new (g_str_hash, g_str_equal);
+  strings = g_ptr_array_new ();
+
+  parse_file (filename, NULL);
+
+  if (!g_hash_table_lookup (file_hash, filename))
+    {
+      g_printerr (_("Failed to read %s: %s\n"), filename, g_strerror (ENOENT));
+      exit (1);
+    }
+
+  dirname = g_path_get_dirname (filename);
+  basename = g_path_get_basename (filename);
+  tmp_cache_path = g_strconcat (dirname, G_DIR_SEPARATOR_S ".", basename, ".cache", NULL);
+  cache_path = g_strconcat (filename, ".cache", NULL);
+
+  check_directories ();
+
+  cache = g_fopen (tmp_cache_path, "wb");
+  if (!cache)
+    {
+      g_printerr (_("Failed to write cache file: %s\n"), g_strerror (errno));
+      exit (1);
+    }
+
+  retval = write_cache (cache);
+  if (fclose (cache) != 0)
+    retval = FALSE;
+
+  if (!retval)
+    {
+      g_printerr (_("Failed to write cache file: %s\n"), g_strerror (errno));
+      g_unlink (tmp_cache_path);
+      exit (1);
+    }
+
+  if (g_rename (tmp_cache_path, cache_path) == -1)
+    {
+      g_printerr (_("Could not rename %s to %s: %s\n"),
+		  tmp_cache_path, cache_path,
+		  g_strerror (errno));
+      g_unlink (tmp_cache_path);
+      exit (1);
+    }
+
+  if (!update_directory_mtime (cache_path, dirname))
+    {
+      g_printerr (_("Failed to write cache file: %s\n"), g_strerror (errno));
+      g_unlink (cache_path);
+      exit (1);
+    }
+
+  if (!quiet)
+    g_printerr (_("Cache file created successfully.\n"));
+
+  g_free (cache_path);
+  g_free (tmp_cache_path);
+  g_free (basename);
+  g_free (dirname);
+}
+
+static GOptionEntry args[] = {
+  { "quiet", 'q', 0, G_OPTION_ARG_NONE, &quiet, N_("Turn off verbose output"), NULL },
+  { NULL }
+};
+
+int
+main (int argc, char **argv)
+{
+  gchar *filename;
+  GOptionContext *context;
+
+  bindtextdomain (GETTEXT_PACKAGE, GTK_LOCALEDIR);
+  bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
+
+  context = g_option_context_new ("RCFILE");
+  g_option_context_add_main_entries (context, args, GETTEXT_PACKAGE);
+
+  g_option_context_parse (context, &argc, &argv, NULL);
+
+  if (argc < 2)
+    return 0;
+
+  /* GTK+ looks files up by their absolute name */
+  if (g_path_is_absolute (argv[1]))
+    filename = g_strdup (argv[1]);
+  else
+    {
+      gchar *cwd;
+
+      cwd = g_get_current_dir ();
+      filename = g_build_filename (cwd, argv[1], NULL);
+      g_free (cwd);
+    }
+
+  build_cache (filename);
+
+  g_free (filename);
+
+  return 0;
+}
@@ -536,6 +536,93 @@ xdg_mime_get_mime_type_for_file (const char  *file_name,
   return XDG_MIME_TYPE_UNKNOWN;
 }
 
+void
+xdg_mime_get_mime_types_from_file_names (const char  **file_names,
+					 const char  **mime_types,
+					 int          *need_data,
+					 int           n_files)
+{
+  const char *glob_types[5];
+  int i, n;
+
+  /* Only check the mime database once for the whole batch */
+  xdg_mime_init ();
+
+  if (_caches)
+    {
+      _xdg_mime_cache_get_mime_types_from_file_names (file_names, mime_types,
+						      need_data, n_files);
+      return;
+    }
+
+  for (i = 0; i < n_files; i++)
+    {
+      need_data[i] = FALSE;
+
+      if (file_names[i] == NULL || ! _xdg_utf8_validate (file_names[i]))
+	{
+	  mime_types[i] = NULL;
+	  continue;
+	}
+
+      n = _xdg_glob_hash_lookup_file_name (global_hash, file_names[i], glob_types, 5);
+      if (n == 1)
+	mime_types[i] = glob_types[0];
+      else
+	{
+	  mime_types[i] = XDG_MIME_TYPE_UNKNOWN;
+	  need_data[i] = TRUE;
+	}
+    }
+}
+
+void
+xdg_mime_get_mime_types_for_data (const char  **file_names,
+				  const void  **data,
+				  const size_t *lens,
+				  const char  **mime_types,
+				  int           n_files)
+{
+  const char *mime_type;
+  const char *glob_types[5];
+  int i, n;
+
+  xdg_mime_init ();
+
+  if (_caches)
+    {
+      _xdg_mime_cache_get_mime_types_for_data (file_names, data, lens,
+					       mime_types, n_files);
+      return;
+    }
+
+  for (i = 0; i < n_files; i++)
+    {
+      if (file_names[i] == NULL || ! _xdg_utf8_validate (file_names[i]))
+	{
+	  mime_types[i] = NULL;
+	  continue;
+	}
+
+      n = _xdg_glob_hash_lookup_file_name (global_hash, file_names[i], glob_types, 5);
+      if (n == 1)
+	{
+	  mime_types[i] = glob_types[0];
+	  continue;
+	}
+
+      mime_types[i] = XDG_MIME_TYPE_UNKNOWN;
+
+      if (data[i] == NULL)
+	continue;
+
+      mime_type = _xdg_mime_magic_lookup_data (global_magic, data[i], lens[i],
+					       glob_types, n);
+      if (mime_type)
+	mime_types[i] = mime_type;
+    }
+}
+
 const char *
 xdg_mime_get_mime_type_from_file_name (const char *file_name)
 {
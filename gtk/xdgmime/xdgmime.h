@@ -49,6 +49,8 @@ typedef void (*XdgMimeDestroy)  (void *user_data);
 #ifdef XDG_PREFIX
 #define xdg_mime_get_mime_type_for_data       XDG_ENTRY(get_mime_type_for_data)
 #define xdg_mime_get_mime_type_for_file       XDG_ENTRY(get_mime_type_for_file)
+#define xdg_mime_get_mime_types_from_file_names XDG_ENTRY(get_mime_types_from_file_names)
+#define xdg_mime_get_mime_types_for_data      XDG_ENTRY(get_mime_types_for_data)
 #define xdg_mime_get_mime_type_from_file_name XDG_ENTRY(get_mime_type_from_file_name)
 #define xdg_mime_is_valid_mime_type           XDG_ENTRY(is_valid_mime_type)
 #define xdg_mime_mime_type_equal              XDG_ENTRY(mime_type_equal)
@@ -72,6 +74,28 @@ const char  *xdg_mime_get_mime_type_for_data       (const void *data,
 						    size_t      len);
 const char  *xdg_mime_get_mime_type_for_file       (const char *file_name,
                                                     struct stat *statbuf);
+  /* Looks up the mime types of @n_files files from their base names.
+   * Sets @need_data[i] for the files whose globs don't settle their
+   * type; look those up again with xdg_mime_get_mime_types_for_data().
+   * The results are only valid until the next call into xdg_mime.
+   */
+void         xdg_mime_get_mime_types_from_file_names (const char  **file_names,
+						      const char  **mime_types,
+						      int          *need_data,
+						      int           n_files);
+  /* Looks up the mime types of @n_files files from their base names and
+   * the first xdg_mime_get_max_buffer_extents() bytes of them, like
+   * xdg_mime_get_mime_type_for_file() does.  @data[i] is NULL for files
+   * that are not regular files or could not be read.  Reading the files
+   * is left to the caller, so that it can be done without holding a lock
+   * around xdg_mime.  The results are only valid until the next call
+   * into xdg_mime.
+   */
+void         xdg_mime_get_mime_types_for_data      (const char  **file_names,
+						    const void  **data,
+						    const size_t *lens,
+						    const char  **mime_types,
+						    int           n_files);
 const char  *xdg_mime_get_mime_type_from_file_name (const char *file_name);
 int          xdg_mime_is_valid_mime_type           (const char *mime_type);
 int          xdg_mime_mime_type_equal              (const char *mime_a,
@@ -735,6 +735,197 @@ _xdg_mime_cache_get_mime_type_for_file (const char  *file_name,
   return mime_type;
 }
 
+/* How many files _xdg_mime_cache_get_mime_types_for_data() runs the
+ * magic against together.
+ */
+#define SNIFF_MAX_FILES 64
+
+typedef struct
+{
+  int index;
+  const char *mime_types[2];
+  int n_mime_types;
+  const unsigned char *data;
+  size_t len;
+  const char *match;
+  int priority;
+  int matched;
+} SniffedFile;
+
+/* Runs the magic of @cache against all of @files together, with each
+ * rule tried on every file that didn't match an earlier one, instead of
+ * walking the whole magic list once per file.  The outcome for each file
+ * is the same as from cache_magic_lookup_data().
+ */
+static void
+cache_magic_lookup_files (XdgMimeCache *cache,
+			  SniffedFile  *files,
+			  int           n_files)
+{
+  xdg_uint32_t list_offset;
+  xdg_uint32_t n_entries;
+  xdg_uint32_t offset;
+  int n_left;
+  int f, j, n;
+
+  list_offset = GET_UINT32 (cache->buffer, 24);
+  n_entries = GET_UINT32 (cache->buffer, list_offset);
+  offset = GET_UINT32 (cache->buffer, list_offset + 8);
+
+  for (f = 0; f < n_files; f++)
+    files[f].matched = FALSE;
+  n_left = n_files;
+
+  for (j = 0; j < n_entries && n_left > 0; j++)
+    {
+      xdg_uint32_t mimetype_offset;
+      const char *non_match;
+
+      mimetype_offset = GET_UINT32 (cache->buffer, offset + 16 * j + 4);
+      non_match = cache->buffer + mimetype_offset;
+
+      for (f = 0; f < n_files; f++)
+	{
+	  SniffedFile *file = &files[f];
+	  const char *match;
+	  int prio;
+
+	  if (file->matched)
+	    continue;
+
+	  match = cache_magic_compare_to_data (cache, offset + 16 * j,
+					       file->data, file->len, &prio);
+	  if (match)
+	    {
+	      file->matched = TRUE;
+	      n_left--;
+
+	      if (prio > file->priority)
+		{
+		  file->priority = prio;
+		  file->match = match;
+		}
+	    }
+	  else
+	    {
+	      for (n = 0; n < file->n_mime_types; n++)
+		{
+		  if (file->mime_types[n] &&
+		      xdg_mime_mime_type_equal (file->mime_types[n], non_match))
+		    file->mime_types[n] = NULL;
+		}
+	    }
+	}
+    }
+}
+
+void
+_xdg_mime_cache_get_mime_types_from_file_names (const char  **file_names,
+						const char  **mime_types,
+						int          *need_data,
+						int           n_files)
+{
+  const char *glob_types[2];
+  int i, n;
+
+  for (i = 0; i < n_files; i++)
+    {
+      need_data[i] = FALSE;
+
+      if (file_names[i] == NULL || ! _xdg_utf8_validate (file_names[i]))
+	{
+	  mime_types[i] = NULL;
+	  continue;
+	}
+
+      n = cache_glob_lookup_file_name (file_names[i], glob_types, 2);
+      if (n == 1)
+	mime_types[i] = glob_types[0];
+      else
+	{
+	  mime_types[i] = XDG_MIME_TYPE_UNKNOWN;
+	  need_data[i] = TRUE;
+	}
+    }
+}
+
+void
+_xdg_mime_cache_get_mime_types_for_data (const char  **file_names,
+					 const void  **data,
+					 const size_t *lens,
+					 const char  **mime_types,
+					 int           n_files)
+{
+  SniffedFile files[SNIFF_MAX_FILES];
+  int n_sniffed;
+  int i, f, n;
+
+  i = 0;
+  while (i < n_files)
+    {
+      /* Sort out the files the globs are enough for, and collect
+       * the others.
+       */
+      n_sniffed = 0;
+      for (; i < n_files && n_sniffed < SNIFF_MAX_FILES; i++)
+	{
+	  SniffedFile *file = &files[n_sniffed];
+
+	  if (file_names[i] == NULL || ! _xdg_utf8_validate (file_names[i]))
+	    {
+	      mime_types[i] = NULL;
+	      continue;
+	    }
+
+	  n = cache_glob_lookup_file_name (file_names[i], file->mime_types, 2);
+	  if (n == 1)
+	    {
+	      mime_types[i] = file->mime_types[0];
+	      continue;
+	    }
+
+	  mime_types[i] = XDG_MIME_TYPE_UNKNOWN;
+
+	  if (data[i] == NULL)
+	    continue;
+
+	  file->index = i;
+	  file->n_mime_types = n;
+	  file->data = data[i];
+	  file->len = lens[i];
+	  file->match = NULL;
+	  file->priority = 0;
+	  n_sniffed++;
+	}
+
+      if (n_sniffed == 0)
+	continue;
+
+      for (n = 0; _caches[n]; n++)
+	cache_magic_lookup_files (_caches[n], files, n_sniffed);
+
+      /* Same as the end of cache_get_mime_type_for_data() */
+      for (f = 0; f < n_sniffed; f++)
+	{
+	  SniffedFile *file = &files[f];
+
+	  if (file->priority > 0)
+	    mime_types[file->index] = file->match;
+	  else
+	    {
+	      for (n = 0; n < file->n_mime_types; n++)
+		{
+		  if (file->mime_types[n])
+		    {
+		      mime_types[file->index] = file->mime_types[n];
+		      break;
+		    }
+		}
+	    }
+	}
+    }
+}
+
 const char *
 _xdg_mime_cache_get_mime_type_from_file_name (const char *file_name)
 {
@@ -48,6 +48,15 @@ const char  *_xdg_mime_cache_get_mime_type_for_data       (const void *data,
 		 				           size_t      len);
 const char  *_xdg_mime_cache_get_mime_type_for_file       (const char  *file_name,
 							   struct stat *statbuf);
+void         _xdg_mime_cache_get_mime_types_from_file_names (const char  **file_names,
+							     const char  **mime_types,
+							     int          *need_data,
+							     int           n_files);
+void         _xdg_mime_cache_get_mime_types_for_data      (const char  **file_names,
+							   const void  **data,
+							   const size_t *lens,
+							   const char  **mime_types,
+							   int           n_files);
 const char  *_xdg_mime_cache_get_mime_type_from_file_name (const char *file_name);
 int          _xdg_mime_cache_is_valid_mime_type           (const char *mime_type);
 int          _xdg_mime_cache_mime_type_equal              (const char *mime_a,
@@ -0,0 +1,118 @@
+/* Measures how fast a GtkTextView can be scrolled.
+ *
+ * A log viewer sized window is scrolled through a long buffer one line
+ * at a time, first down and then back up over the same region, and the
+ * whole view is repainted after each step.  The number of frames per
+ * second is printed for both directions; going back up mostly redraws
+ * lines that were laid out recently.
+ *
+ * Usage: testtextscroll [lines] [frames]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <gtk/gtk.h>
+
+static void
+fill_buffer (GtkTextBuffer *buffer, int n_lines)
+{
+  GtkTextIter iter;
+  GString *line;
+  int i;
+
+  line = g_string_new (NULL);
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+
+  for (i = 0; i < n_lines; i++)
+    {
+      g_string_printf (line, "%6d  Jun 14 12:%02d:%02d localhost daemon[%d]: "
+		       "processed request %d in %d ms\n",
+		       i, (i / 60) % 60, i % 60, 1000 + i % 37, i * 7, i % 113);
+      gtk_text_buffer_insert (buffer, &iter, line->str, line->len);
+    }
+
+  g_string_free (line, TRUE);
+}
+
+static void
+wait_for_idle (void)
+{
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+}
+
+static void
+paint (GtkWidget *window)
+{
+  gtk_widget_queue_draw (window);
+  gdk_window_process_all_updates ();
+  gdk_display_sync (gtk_widget_get_display (window));
+}
+
+static double
+scroll (GtkWidget *window, GtkAdjustment *adj, int frames, int step)
+{
+  GTimer *timer;
+  double secs;
+  int i;
+
+  timer = g_timer_new ();
+
+  for (i = 0; i < frames; i++)
+    {
+      gdouble value = adj->value + step * adj->step_increment;
+
+      value = CLAMP (value, adj->lower, adj->upper - adj->page_size);
+      gtk_adjustment_set_value (adj, value);
+      paint (window);
+    }
+
+  secs = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  return frames / secs;
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkWidget *window, *sw, *text_view;
+  GtkAdjustment *adj;
+  int n_lines = 10000;
+  int frames = 500;
+
+  gtk_init (&argc, &argv);
+
+  if (argc > 1)
+    n_lines = atoi (argv[1]);
+  if (argc > 2)
+    frames = atoi (argv[2]);
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 640, 900);
+
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (sw),
+				  GTK_POLICY_AUTOMATIC, GTK_POLICY_ALWAYS);
+  gtk_container_add (GTK_CONTAINER (window), sw);
+
+  text_view = gtk_text_view_new ();
+  gtk_text_view_set_editable (GTK_TEXT_VIEW (text_view), FALSE);
+  gtk_text_view_set_cursor_visible (GTK_TEXT_VIEW (text_view), FALSE);
+  gtk_container_add (GTK_CONTAINER (sw), text_view);
+
+  fill_buffer (gtk_text_view_get_buffer (GTK_TEXT_VIEW (text_view)), n_lines);
+
+  gtk_widget_show_all (window);
+
+  /* Let the text view validate the whole buffer before timing */
+  wait_for_idle ();
+
+  adj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (sw));
+  adj->step_increment = adj->upper / n_lines;
+
+  printf ("%d lines, %d frames\n", n_lines, frames);
+  printf ("scroll down: %.1f frames/sec\n", scroll (window, adj, frames, 1));
+  printf ("scroll up:   %.1f frames/sec\n", scroll (window, adj, frames, -1));
+
+  return 0;
+}
@@ -77,10 +77,76 @@ load_image (gpointer  data,
 static void
 usage (void)
 {
-  g_print ("usage: pixbuf-threads [--verbose] <files>\n");
+  g_print ("usage: pixbuf-threads [--verbose] <files>\n"
+           "       pixbuf-threads --batch [--size=N] <files>\n");
   exit (EXIT_FAILURE);
 }
 
+static void
+batch_loaded (GdkPixbufBatchLoader *batch_loader,
+              const gchar          *filename,
+              GdkPixbuf            *pixbuf,
+              const GError         *error,
+              gpointer              data)
+{
+  GMainLoop *loop = data;
+
+  if (error)
+    g_warning ("Error loading %s: %s", filename, error->message);
+  else if (verbose)
+    g_print ("loaded %s\n", filename);
+
+  if (gdk_pixbuf_batch_loader_get_n_pending (batch_loader) == 0)
+    g_main_loop_quit (loop);
+}
+
+/* Loads all files once with gdk_pixbuf_new_from_file_at_size(), and
+ * once with a GdkPixbufBatchLoader, and compares the times.
+ */
+static void
+batch_benchmark (gchar **files, gint n_files, gint size)
+{
+  GdkPixbufBatchLoader *batch_loader;
+  GMainLoop *loop;
+  GTimer *timer;
+  gdouble sequential, batch;
+  gint i;
+
+  timer = g_timer_new ();
+
+  for (i = 0; i < n_files; i++)
+    {
+      GdkPixbuf *pixbuf;
+      GError *error = NULL;
+
+      pixbuf = gdk_pixbuf_new_from_file_at_size (files[i], size, size, &error);
+      if (pixbuf)
+        g_object_unref (pixbuf);
+      else
+        {
+          g_warning ("Error loading %s: %s", files[i], error->message);
+          g_error_free (error);
+        }
+    }
+  sequential = g_timer_elapsed (timer, NULL);
+
+  loop = g_main_loop_new (NULL, FALSE);
+  batch_loader = gdk_pixbuf_batch_loader_new (batch_loaded, loop, NULL);
+
+  g_timer_start (timer);
+  for (i = 0; i < n_files; i++)
+    gdk_pixbuf_batch_loader_add (batch_loader, files[i], size, size);
+  g_main_loop_run (loop);
+  batch = g_timer_elapsed (timer, NULL);
+
+  g_object_unref (batch_loader);
+  g_main_loop_unref (loop);
+  g_timer_destroy (timer);
+
+  g_print ("%d files at size %d: sequential %.3f s, batch %.3f s\n",
+           n_files, size, sequential, batch);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -103,6 +169,23 @@ main (int argc, char **argv)
       verbose = TRUE;
       start = 2;
     }
+  else if (strcmp (argv[1], "--batch") == 0)
+    {
+      gint size = 128;
+
+      start = 2;
+      if (argc > 2 && strncmp (argv[2], "--size=", 7) == 0)
+        {
+          size = atoi (argv[2] + 7);
+          start = 3;
+        }
+      if (start == argc)
+        usage ();
+
+      batch_benchmark (argv + start, argc - start, size);
+
+      return 0;
+    }
   
   pool = g_thread_pool_new (load_image, NULL, 20, FALSE, NULL);
 
@@ -0,0 +1,285 @@
+/* testcolumnstore.c - test GtkColumnStore
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#include <stdarg.h>
+#include <string.h>
+#include "../gtk/gtk.h"
+
+enum {
+  COLUMN_INT,
+  COLUMN_STRING,
+  COLUMN_DOUBLE,
+  N_COLUMNS
+};
+
+static gint n_reordered = 0;
+
+static void
+rows_reordered (GtkTreeModel *model,
+		GtkTreePath  *path,
+		GtkTreeIter  *iter,
+		gint         *new_order,
+		gpointer      data)
+{
+  n_reordered++;
+}
+
+static GtkColumnStore *
+create_store (void)
+{
+  GtkColumnStore *store;
+
+  store = gtk_column_store_new (N_COLUMNS, G_TYPE_INT, G_TYPE_STRING, G_TYPE_DOUBLE);
+  g_signal_connect (store, "rows-reordered", G_CALLBACK (rows_reordered), NULL);
+
+  return store;
+}
+
+/* Checks that the rows of @store hold the numbers in @ints, with
+ * the matching strings "<n>" and doubles n / 2.
+ */
+static void
+check_rows_array (GtkColumnStore *store,
+		  const gint     *ints,
+		  gint            n_ints)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (store);
+  GtkTreeIter iter;
+  gboolean valid;
+  gint i = 0;
+
+  g_assert (gtk_tree_model_iter_n_children (model, NULL) == n_ints);
+
+  valid = gtk_tree_model_get_iter_first (model, &iter);
+  while (valid)
+    {
+      gint n;
+      gchar *str;
+      gchar *expected;
+      gdouble d;
+
+      g_assert (i < n_ints);
+
+      gtk_tree_model_get (model, &iter,
+			  COLUMN_INT, &n,
+			  COLUMN_STRING, &str,
+			  COLUMN_DOUBLE, &d,
+			  -1);
+
+      expected = g_strdup_printf ("%d", ints[i]);
+      g_assert (n == ints[i]);
+      g_assert (str != NULL && strcmp (str, expected) == 0);
+      g_assert (d == ints[i] / 2.0);
+      g_free (expected);
+      g_free (str);
+
+      valid = gtk_tree_model_iter_next (model, &iter);
+      i++;
+    }
+
+  g_assert (i == n_ints);
+}
+
+/* Like check_rows_array(), with the @n_ints numbers as varargs */
+static void
+check_rows (GtkColumnStore *store,
+	    gint            n_ints,
+	    ...)
+{
+  gint *ints;
+  va_list args;
+  gint i;
+
+  ints = g_new (gint, n_ints);
+
+  va_start (args, n_ints);
+  for (i = 0; i < n_ints; i++)
+    ints[i] = va_arg (args, gint);
+  va_end (args);
+
+  check_rows_array (store, ints, n_ints);
+  g_free (ints);
+}
+
+static void
+set_row (GtkColumnStore *store,
+	 GtkTreeIter    *iter,
+	 gint            n)
+{
+  gchar *str = g_strdup_printf ("%d", n);
+
+  gtk_column_store_set (store, iter,
+			COLUMN_INT, n,
+			COLUMN_STRING, str,
+			COLUMN_DOUBLE, n / 2.0,
+			-1);
+  g_free (str);
+}
+
+static void
+test_set (void)
+{
+  GtkColumnStore *store = create_store ();
+  GtkTreeIter iter;
+  const gchar *strings[] = { "7", "8", "9" };
+  const gint ints[] = { 7, 8, 9 };
+  const gdouble doubles[] = { 3.5, 4.0, 4.5 };
+  gchar *str;
+  gint i;
+
+  /* overwriting a string frees the old one, and the store keeps its
+   * own copy of the new one.
+   */
+  gtk_column_store_append (store, &iter);
+  for (i = 0; i < 100; i++)
+    set_row (store, &iter, i);
+  check_rows (store, 1, 99);
+
+  gtk_column_store_set (store, &iter, COLUMN_STRING, NULL, -1);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, COLUMN_STRING, &str, -1);
+  g_assert (str == NULL);
+
+  gtk_column_store_clear (store);
+  check_rows (store, 0);
+
+  gtk_column_store_append_rows (store, 3);
+  gtk_column_store_set_column_from_array (store, COLUMN_INT, 0, 3, ints);
+  gtk_column_store_set_column_from_array (store, COLUMN_STRING, 0, 3, strings);
+  gtk_column_store_set_column_from_array (store, COLUMN_STRING, 0, 3, strings);
+  gtk_column_store_set_column_from_array (store, COLUMN_DOUBLE, 0, 3, doubles);
+  check_rows_array (store, ints, 3);
+
+  g_object_unref (store);
+}
+
+static void
+test_insert_remove (void)
+{
+  GtkColumnStore *store = create_store ();
+  GtkTreeIter iter;
+  gint i;
+
+  for (i = 0; i < 5; i++)
+    {
+      gtk_column_store_append (store, &iter);
+      set_row (store, &iter, i);
+    }
+
+  gtk_column_store_insert (store, &iter, 0);
+  set_row (store, &iter, 10);
+  gtk_column_store_insert (store, &iter, 3);
+  set_row (store, &iter, 11);
+  gtk_column_store_insert (store, &iter, 100);
+  set_row (store, &iter, 12);
+  check_rows (store, 8, 10, 0, 1, 11, 2, 3, 4, 12);
+
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 3));
+  g_assert (gtk_column_store_remove (store, &iter));
+  g_assert (gtk_column_store_iter_is_valid (store, &iter));
+  check_rows (store, 7, 10, 0, 1, 2, 3, 4, 12);
+
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 6));
+  g_assert (!gtk_column_store_remove (store, &iter));
+  check_rows (store, 6, 10, 0, 1, 2, 3, 4);
+
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  g_assert (gtk_column_store_remove (store, &iter));
+  check_rows (store, 5, 0, 1, 2, 3, 4);
+
+  g_object_unref (store);
+}
+
+static void
+test_sort (void)
+{
+  GtkColumnStore *store = create_store ();
+  GtkTreeSortable *sortable = GTK_TREE_SORTABLE (store);
+  GtkTreeIter iter;
+  const gint values[] = { 5, 3, 9, 1, 7 };
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (values); i++)
+    {
+      gtk_column_store_append (store, &iter);
+      set_row (store, &iter, values[i]);
+    }
+
+  n_reordered = 0;
+  gtk_tree_sortable_set_sort_column_id (sortable, COLUMN_INT, GTK_SORT_ASCENDING);
+  g_assert (n_reordered == 1);
+  check_rows (store, 5, 1, 3, 5, 7, 9);
+
+  gtk_tree_sortable_set_sort_column_id (sortable, COLUMN_DOUBLE, GTK_SORT_DESCENDING);
+  check_rows (store, 5, 9, 7, 5, 3, 1);
+
+  /* strings sort by collation, so "10" goes before "3" */
+  gtk_tree_sortable_set_sort_column_id (sortable, COLUMN_STRING, GTK_SORT_ASCENDING);
+  gtk_column_store_append (store, &iter);
+  set_row (store, &iter, 10);
+  check_rows (store, 6, 1, 10, 3, 5, 7, 9);
+
+  g_object_unref (store);
+}
+
+static void
+test_reorder (void)
+{
+  GtkColumnStore *store = create_store ();
+  GtkTreeSortable *sortable = GTK_TREE_SORTABLE (store);
+  GtkTreeIter iter;
+  gint i;
+
+  for (i = 0; i < 5; i++)
+    {
+      gtk_column_store_append (store, &iter);
+      set_row (store, &iter, i * 10);
+    }
+
+  gtk_tree_sortable_set_sort_column_id (sortable, COLUMN_INT, GTK_SORT_ASCENDING);
+
+  /* changing a sorted cell moves the row to its new place */
+  n_reordered = 0;
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 0));
+  set_row (store, &iter, 25);
+  g_assert (n_reordered > 0);
+  check_rows (store, 5, 10, 20, 25, 30, 40);
+
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 4));
+  set_row (store, &iter, 5);
+  check_rows (store, 5, 5, 10, 20, 25, 30);
+
+  /* inserting into a sorted store puts the row in place once it is set */
+  gtk_column_store_append (store, &iter);
+  set_row (store, &iter, 15);
+  check_rows (store, 6, 5, 10, 15, 20, 25, 30);
+
+  g_object_unref (store);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_type_init ();
+
+  test_set ();
+  test_insert_remove ();
+  test_sort ();
+  test_reorder ();
+
+  return 0;
+}
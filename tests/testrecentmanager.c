@@ -0,0 +1,191 @@
+/* testrecentmanager.c - test sharing a GtkRecentManager file
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include "../gtk/gtk.h"
+
+#define URI_A1		"file:///tmp/testrecentmanager/a1"
+#define URI_A1_MOVED	"file:///tmp/testrecentmanager/a1-moved"
+#define URI_A2		"file:///tmp/testrecentmanager/a2"
+#define URI_A3		"file:///tmp/testrecentmanager/a3"
+#define URI_B1		"file:///tmp/testrecentmanager/b1"
+#define URI_B2		"file:///tmp/testrecentmanager/b2"
+#define URI_B3		"file:///tmp/testrecentmanager/b3"
+
+static gchar *filename = NULL;
+static gchar *log_filename = NULL;
+
+static void
+add (GtkRecentManager *manager,
+     const gchar      *uri)
+{
+  GtkRecentData data;
+
+  data.display_name = (gchar *) uri;
+  data.description = NULL;
+  data.mime_type = "text/plain";
+  data.app_name = "testrecentmanager";
+  data.app_exec = "testrecentmanager %u";
+  data.groups = NULL;
+  data.is_private = FALSE;
+
+  g_assert (gtk_recent_manager_add_full (manager, uri, &data));
+}
+
+static gint
+count_items (GtkRecentManager *manager)
+{
+  GList *items;
+  gint n;
+
+  items = gtk_recent_manager_get_items (manager);
+  n = g_list_length (items);
+
+  g_list_foreach (items, (GFunc) gtk_recent_info_unref, NULL);
+  g_list_free (items);
+
+  return n;
+}
+
+static off_t
+log_size (void)
+{
+  struct stat stat_buf;
+
+  if (g_stat (log_filename, &stat_buf) < 0)
+    return 0;
+
+  return stat_buf.st_size;
+}
+
+static GtkRecentManager *
+create_manager (void)
+{
+  return g_object_new (GTK_TYPE_RECENT_MANAGER, "filename", filename, NULL);
+}
+
+/* Two managers share one file.  Without a main loop neither watches
+ * the file, so each one only sees the changes of the other when it
+ * writes its own, and has to pick them up from the log then.
+ */
+static void
+test_shared_file (void)
+{
+  GtkRecentManager *a, *b;
+  GtkRecentInfo *info;
+  GBookmarkFile *items;
+  gchar *uri;
+  gint i;
+
+  a = create_manager ();
+  b = create_manager ();
+
+  /* the first change creates the file, later ones go to the log */
+  add (a, URI_A1);
+  g_assert (g_file_test (filename, G_FILE_TEST_EXISTS));
+  g_assert (log_size () == 0);
+  add (a, URI_A2);
+  g_assert (log_size () > 0);
+
+  /* b reads the file and replays the log before writing */
+  g_assert (!gtk_recent_manager_has_item (b, URI_A1));
+  add (b, URI_B1);
+  g_assert (gtk_recent_manager_has_item (b, URI_A1));
+  g_assert (gtk_recent_manager_has_item (b, URI_A2));
+  g_assert (gtk_recent_manager_has_item (b, URI_B1));
+  g_assert (count_items (b) == 3);
+
+  /* moves and removals are replayed, keeping the item's data */
+  g_assert (gtk_recent_manager_move_item (b, URI_A1, URI_A1_MOVED, NULL));
+  g_assert (gtk_recent_manager_remove_item (b, URI_A2, NULL));
+  add (a, URI_A3);
+  g_assert (!gtk_recent_manager_has_item (a, URI_A1));
+  g_assert (gtk_recent_manager_has_item (a, URI_A1_MOVED));
+  g_assert (!gtk_recent_manager_has_item (a, URI_A2));
+  g_assert (gtk_recent_manager_has_item (a, URI_A3));
+  g_assert (gtk_recent_manager_has_item (a, URI_B1));
+  g_assert (count_items (a) == 3);
+
+  info = gtk_recent_manager_lookup_item (a, URI_A1_MOVED, NULL);
+  g_assert (info != NULL);
+  g_assert (strcmp (gtk_recent_info_get_display_name (info), URI_A1) == 0);
+  gtk_recent_info_unref (info);
+
+  /* a clear only drops what came before it */
+  g_assert (gtk_recent_manager_purge_items (a, NULL) == 3);
+  add (b, URI_B2);
+  g_assert (!gtk_recent_manager_has_item (b, URI_A3));
+  g_assert (gtk_recent_manager_has_item (b, URI_B2));
+  g_assert (count_items (b) == 1);
+
+  /* a large log is folded into the file once the change is notified */
+  for (i = 0; log_size () > 0 || i == 0; i++)
+    {
+      g_assert (i < 10000);
+
+      uri = g_strdup_printf ("file:///tmp/testrecentmanager/item%d", i);
+      add (a, uri);
+      g_free (uri);
+    }
+
+  items = g_bookmark_file_new ();
+  g_assert (g_bookmark_file_load_from_file (items, filename, NULL));
+  g_assert (g_bookmark_file_has_item (items, URI_B2));
+  g_assert (g_bookmark_file_get_size (items) == i + 1);
+  g_bookmark_file_free (items);
+
+  /* b notices that the log it read has been folded in */
+  add (b, URI_B3);
+  g_assert (gtk_recent_manager_has_item (b, "file:///tmp/testrecentmanager/item0"));
+  g_assert (count_items (b) == i + 2);
+  g_assert (count_items (a) == i + 1);
+
+  add (a, URI_A3);
+  g_assert (gtk_recent_manager_has_item (a, URI_B3));
+  g_assert (count_items (a) == i + 3);
+
+  g_object_unref (a);
+  g_object_unref (b);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  gint fd;
+
+  g_type_init ();
+
+  fd = g_file_open_tmp ("testrecentmanager-XXXXXX", &filename, NULL);
+  g_assert (fd >= 0);
+  close (fd);
+  g_unlink (filename);
+  log_filename = g_strconcat (filename, ".log", NULL);
+
+  test_shared_file ();
+
+  g_unlink (filename);
+  g_unlink (log_filename);
+  g_free (filename);
+  g_free (log_filename);
+
+  return 0;
+}
@@ -0,0 +1,443 @@
+/* testtreemodelfilter.c - test refiltering GtkTreeModelFilter
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#include <stdarg.h>
+#include "../gtk/gtk.h"
+
+/* rows are visible if their number is a multiple of this */
+static gint modulus = 2;
+/* makes the visible function slow, so a queued refilter takes a while */
+static gboolean slow = FALSE;
+
+static gint n_inserted = 0;
+static gint n_deleted = 0;
+static gint n_changed = 0;
+static gint n_toggled = 0;
+
+/* the toplevel rows of the filter, as told by its signals */
+static GArray *mirror = NULL;
+
+static gboolean
+visible_func (GtkTreeModel *model,
+	      GtkTreeIter  *iter,
+	      gpointer      data)
+{
+  gint n;
+
+  if (slow)
+    g_usleep (200);
+
+  gtk_tree_model_get (model, iter, 0, &n, -1);
+
+  /* rows of the first level of a tree are always visible */
+  if (GTK_IS_TREE_STORE (model) && n < 10)
+    return TRUE;
+
+  return n % modulus == 0;
+}
+
+static void
+reset_counts (void)
+{
+  n_inserted = 0;
+  n_deleted = 0;
+  n_changed = 0;
+  n_toggled = 0;
+}
+
+static void
+row_inserted (GtkTreeModel *model,
+	      GtkTreePath  *path,
+	      GtkTreeIter  *iter,
+	      gpointer      data)
+{
+  gint n;
+
+  n_inserted++;
+
+  if (gtk_tree_path_get_depth (path) == 1)
+    {
+      gtk_tree_model_get (model, iter, 0, &n, -1);
+      g_array_insert_val (mirror, gtk_tree_path_get_indices (path)[0], n);
+    }
+}
+
+static void
+row_deleted (GtkTreeModel *model,
+	     GtkTreePath  *path,
+	     gpointer      data)
+{
+  n_deleted++;
+
+  if (gtk_tree_path_get_depth (path) == 1)
+    g_array_remove_index (mirror, gtk_tree_path_get_indices (path)[0]);
+}
+
+static void
+row_changed (GtkTreeModel *model,
+	     GtkTreePath  *path,
+	     GtkTreeIter  *iter,
+	     gpointer      data)
+{
+  n_changed++;
+
+  if (gtk_tree_path_get_depth (path) == 1)
+    gtk_tree_model_get (model, iter, 0,
+			&g_array_index (mirror, gint, gtk_tree_path_get_indices (path)[0]),
+			-1);
+}
+
+static void
+row_has_child_toggled (GtkTreeModel *model,
+		       GtkTreePath  *path,
+		       GtkTreeIter  *iter,
+		       gpointer      data)
+{
+  n_toggled++;
+}
+
+static void
+rows_reordered (GtkTreeModel *model,
+		GtkTreePath  *path,
+		GtkTreeIter  *iter,
+		gint         *new_order,
+		gpointer      data)
+{
+  GArray *old;
+  gint i;
+
+  if (gtk_tree_path_get_depth (path) != 0)
+    return;
+
+  old = mirror;
+  mirror = g_array_sized_new (FALSE, FALSE, sizeof (gint), old->len);
+  for (i = 0; i < old->len; i++)
+    g_array_append_val (mirror, g_array_index (old, gint, new_order[i]));
+  g_array_free (old, TRUE);
+}
+
+static GtkTreeModel *
+create_filter (GtkTreeModel *child_model)
+{
+  GtkTreeModel *filter;
+  GtkTreeIter iter;
+  gboolean valid;
+  gint n;
+
+  filter = gtk_tree_model_filter_new (child_model, NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter),
+					  visible_func, NULL, NULL);
+
+  if (mirror)
+    g_array_free (mirror, TRUE);
+  mirror = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  valid = gtk_tree_model_get_iter_first (filter, &iter);
+  while (valid)
+    {
+      gtk_tree_model_get (filter, &iter, 0, &n, -1);
+      g_array_append_val (mirror, n);
+      valid = gtk_tree_model_iter_next (filter, &iter);
+    }
+
+  g_signal_connect (filter, "row-inserted", G_CALLBACK (row_inserted), NULL);
+  g_signal_connect (filter, "row-deleted", G_CALLBACK (row_deleted), NULL);
+  g_signal_connect (filter, "row-changed", G_CALLBACK (row_changed), NULL);
+  g_signal_connect (filter, "row-has-child-toggled",
+		    G_CALLBACK (row_has_child_toggled), NULL);
+  g_signal_connect (filter, "rows-reordered", G_CALLBACK (rows_reordered), NULL);
+
+  return filter;
+}
+
+static GtkListStore *
+create_list_store (gint n_rows)
+{
+  GtkListStore *store;
+  GtkTreeIter iter;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  for (i = 0; i < n_rows; i++)
+    gtk_list_store_insert_with_values (store, &iter, i, 0, i, -1);
+
+  return store;
+}
+
+/* Checks that the toplevel rows of @filter, and those its signals
+ * told about, are the visible rows of its child model.
+ */
+static void
+check_filter (GtkTreeModel *filter)
+{
+  GtkTreeModel *child_model;
+  GtkTreeIter iter, c_iter;
+  gboolean valid, c_valid;
+  gint i = 0;
+  gint n, c_n;
+
+  child_model = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (filter));
+
+  valid = gtk_tree_model_get_iter_first (filter, &iter);
+  c_valid = gtk_tree_model_get_iter_first (child_model, &c_iter);
+  while (c_valid)
+    {
+      if (visible_func (child_model, &c_iter, NULL))
+	{
+	  g_assert (valid);
+	  g_assert (i < mirror->len);
+
+	  gtk_tree_model_get (filter, &iter, 0, &n, -1);
+	  gtk_tree_model_get (child_model, &c_iter, 0, &c_n, -1);
+	  g_assert (n == c_n);
+	  g_assert (g_array_index (mirror, gint, i) == n);
+
+	  valid = gtk_tree_model_iter_next (filter, &iter);
+	  i++;
+	}
+
+      c_valid = gtk_tree_model_iter_next (child_model, &c_iter);
+    }
+
+  g_assert (!valid);
+  g_assert (i == mirror->len);
+}
+
+/* Checks that the children of the @index'th toplevel row of @filter
+ * hold the @n_ints numbers given as varargs.
+ */
+static void
+check_children (GtkTreeModel *filter,
+		gint          index,
+		gint          n_ints,
+		...)
+{
+  GtkTreeIter parent, iter;
+  gboolean valid;
+  va_list args;
+  gint i = 0;
+  gint n;
+
+  g_assert (gtk_tree_model_iter_nth_child (filter, &parent, NULL, index));
+
+  va_start (args, n_ints);
+  valid = gtk_tree_model_iter_children (filter, &iter, &parent);
+  while (valid)
+    {
+      g_assert (i < n_ints);
+
+      gtk_tree_model_get (filter, &iter, 0, &n, -1);
+      g_assert (n == va_arg (args, gint));
+
+      valid = gtk_tree_model_iter_next (filter, &iter);
+      i++;
+    }
+  va_end (args);
+
+  g_assert (i == n_ints);
+}
+
+static void
+test_refilter_list (void)
+{
+  GtkListStore *store = create_list_store (10);
+  GtkTreeModel *filter;
+
+  modulus = 2;
+  filter = create_filter (GTK_TREE_MODEL (store));
+  check_filter (filter);
+
+  /* 2, 4 and 8 go, 3 and 9 come, 0 and 6 stay */
+  reset_counts ();
+  modulus = 3;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  check_filter (filter);
+  g_assert (n_deleted == 3);
+  g_assert (n_inserted == 2);
+  g_assert (n_changed == 2);
+
+  /* nothing changes, but the rows that stay visible are still told
+   * about, since the data they are filtered by may have changed.
+   */
+  reset_counts ();
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  check_filter (filter);
+  g_assert (n_deleted == 0);
+  g_assert (n_inserted == 0);
+  g_assert (n_changed == 4);
+
+  /* everything but 0 goes */
+  reset_counts ();
+  modulus = 100;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  check_filter (filter);
+  g_assert (n_deleted == 3);
+  g_assert (n_inserted == 0);
+  g_assert (n_changed == 1);
+
+  /* everything comes back */
+  reset_counts ();
+  modulus = 1;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  check_filter (filter);
+  g_assert (n_deleted == 0);
+  g_assert (n_inserted == 9);
+  g_assert (n_changed == 1);
+
+  g_object_unref (filter);
+  g_object_unref (store);
+}
+
+static void
+test_refilter_tree (void)
+{
+  GtkTreeStore *store;
+  GtkTreeModel *filter;
+  GtkTreeIter parent, iter;
+  gint i, j;
+
+  /* toplevel rows 0 to 3, with the children 10 * (n + 1) + 0 to 3 */
+  store = gtk_tree_store_new (1, G_TYPE_INT);
+  for (i = 0; i < 4; i++)
+    {
+      gtk_tree_store_insert_with_values (store, &parent, NULL, i, 0, i, -1);
+      for (j = 0; j < 4; j++)
+	gtk_tree_store_insert_with_values (store, &iter, &parent, j,
+					   0, 10 * (i + 1) + j, -1);
+    }
+
+  modulus = 2;
+  filter = create_filter (GTK_TREE_MODEL (store));
+  check_filter (filter);
+  check_children (filter, 1, 2, 20, 22);
+
+  /* the toplevel rows stay, in the level of 1 that has been looked at
+   * 20 and 22 go and 21 comes.
+   */
+  reset_counts ();
+  modulus = 3;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  check_filter (filter);
+  g_assert (n_changed == 4);
+  g_assert (n_deleted == 2);
+  g_assert (n_inserted == 1);
+  g_assert (n_toggled == 0);
+  check_children (filter, 1, 1, 21);
+
+  /* 1 loses its last visible child */
+  reset_counts ();
+  modulus = 1000;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  check_filter (filter);
+  g_assert (n_changed == 4);
+  g_assert (n_deleted == 1);
+  g_assert (n_inserted == 0);
+  g_assert (n_toggled == 1);
+  check_children (filter, 1, 0);
+
+  g_object_unref (filter);
+  g_object_unref (store);
+}
+
+static void
+run_main_loop (void)
+{
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+}
+
+static void
+test_queue_refilter (void)
+{
+  GtkListStore *store = create_list_store (256);
+  GtkTreeModel *filter;
+  GtkTreeIter iter, iter2;
+
+  modulus = 2;
+  filter = create_filter (GTK_TREE_MODEL (store));
+  check_filter (filter);
+
+  /* the rows are only updated when all of them have been looked at */
+  reset_counts ();
+  slow = TRUE;
+  modulus = 3;
+  gtk_tree_model_filter_queue_refilter (GTK_TREE_MODEL_FILTER (filter));
+  g_main_context_iteration (NULL, FALSE);
+  g_assert (n_inserted == 0);
+  g_assert (n_deleted == 0);
+
+  /* change the child model while the refilter is underway; rows that
+   * have been looked at already, rows that haven't, and the offsets
+   * of both.
+   */
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 0));
+  gtk_list_store_set (store, &iter, 0, 1, -1);
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 250));
+  gtk_list_store_set (store, &iter, 0, 1000, -1);
+
+  gtk_list_store_insert_with_values (store, &iter, 10, 0, 300, -1);
+  gtk_list_store_insert_with_values (store, &iter, 200, 0, 303, -1);
+
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 5));
+  gtk_list_store_remove (store, &iter);
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 180));
+  gtk_list_store_remove (store, &iter);
+
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 2));
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter2, NULL, 220));
+  gtk_list_store_swap (store, &iter, &iter2);
+
+  run_main_loop ();
+  slow = FALSE;
+  check_filter (filter);
+
+  /* queueing twice applies the changes once */
+  reset_counts ();
+  gtk_tree_model_filter_queue_refilter (GTK_TREE_MODEL_FILTER (filter));
+  gtk_tree_model_filter_queue_refilter (GTK_TREE_MODEL_FILTER (filter));
+  run_main_loop ();
+  check_filter (filter);
+  g_assert (n_inserted == 0);
+  g_assert (n_deleted == 0);
+  g_assert (n_changed == mirror->len);
+
+  /* a refilter in between takes over */
+  reset_counts ();
+  modulus = 5;
+  gtk_tree_model_filter_queue_refilter (GTK_TREE_MODEL_FILTER (filter));
+  modulus = 7;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  check_filter (filter);
+  run_main_loop ();
+  check_filter (filter);
+
+  g_object_unref (filter);
+  g_object_unref (store);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_type_init ();
+
+  test_refilter_list ();
+  test_refilter_tree ();
+  test_queue_refilter ();
+
+  return 0;
+}